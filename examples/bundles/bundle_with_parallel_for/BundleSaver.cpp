@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/Backend/Backend.h"
+#include "glow/ExecutionEngine/ExecutionEngine.h"
+#include "glow/Graph/Graph.h"
+#include "glow/Graph/Nodes.h"
+#include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
+#include "llvm/Support/CommandLine.h"
+
+#include <fstream>
+
+using namespace glow;
+
+/// Emit a bundle into the specified output directory.
+llvm::cl::opt<std::string>
+    emitBundle("emit-bundle",
+               llvm::cl::desc("Output directory for the bundle serialization"),
+               llvm::cl::init("."));
+
+/// Fill \p T with values depending only on the index of each element, which
+/// the bundle driver reproduces for the input.
+static void fillTensor(Tensor &T, float scale) {
+  auto H = T.getHandle();
+  for (size_t idx = 0, e = H.size(); idx < e; ++idx) {
+    H.raw(idx) = scale * (float(idx % 17) - 8.0f);
+  }
+}
+
+/// Create in \p M the function "F" of the bundle, which contains a
+/// convolution and big data-parallel kernels split across the parallel-for
+/// callback. \returns its SaveNode.
+static SaveNode *createNetwork(Module &M) {
+  Function *F = M.createFunction("F");
+  auto *input =
+      M.createPlaceholder(ElemKind::FloatTy, {1, 16, 16, 8}, "input", false);
+  auto *filter = M.createConstant(ElemKind::FloatTy, {64, 3, 3, 8}, "filter");
+  auto *bias = M.createConstant(ElemKind::FloatTy, {64}, "bias");
+  fillTensor(filter->getPayloadMutable(), 0.01f);
+  fillTensor(bias->getPayloadMutable(), 0.1f);
+  auto *outTy = M.uniqueType(ElemKind::FloatTy, {1, 16, 16, 64});
+  auto *conv = F->createConv("conv", input, filter, bias, outTy, 3, 1, 1, 1);
+  auto *relu = F->createRELU("relu", conv);
+  auto *mul = F->createMul("mul", relu, conv);
+  return F->createSave("output", mul);
+}
+
+int main(int argc, char **argv) {
+  llvm::cl::ParseCommandLineOptions(argc, argv, "Bundle Saver\n");
+
+  // Compute the expected output with the Interpreter and store it next to the
+  // bundle.
+  ExecutionEngine EE("Interpreter");
+  SaveNode *refSave = createNetwork(EE.getModule());
+  PlaceholderBindings bindings;
+  auto *inputT =
+      bindings.allocate(EE.getModule().getPlaceholderByNameSlow("input"));
+  auto *outputT = bindings.allocate(refSave->getPlaceholder());
+  fillTensor(*inputT, 0.1f);
+  EE.compile(CompilationMode::Infer);
+  EE.run(bindings);
+  std::ofstream expectedFile(emitBundle + "/expected.bin", std::ios::binary);
+  expectedFile.write(outputT->getUnsafePtr(), outputT->getSizeInBytes());
+  CHECK(expectedFile) << "Could not write the expected output";
+
+  // Optimize the graph for the CPU backend, so that the convolution uses the
+  // DKKC8 kernel, and save the bundle.
+  Module M;
+  Function *F = createNetwork(M)->getParent();
+  std::unique_ptr<Backend> cpuBackend(createBackend("CPU"));
+  CompilationContext cctx;
+  EXIT_ON_ERR(::glow::optimizeFunction(F, *cpuBackend, cctx));
+  cpuBackend->save(F, emitBundle, "testBundle", "testMainEntry");
+  return 0;
+}
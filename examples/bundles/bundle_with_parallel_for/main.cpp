@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <assert.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "PthreadParallelFor.h"
+#include "testBundle.h"
+
+//===----------------------------------------------------------------------===//
+//                 Wrapper code for executing a bundle
+//===----------------------------------------------------------------------===//
+/// Number of threads of the pool registered in the bundle config.
+static const unsigned numThreads = 4;
+
+/// \returns the entry of the symbol \p name in the bundle's symbol table.
+static const SymbolTableEntry &getSymbol(const char *name) {
+  for (unsigned i = 0, e = testBundle_config.numSymbols; i < e; ++i) {
+    if (!strcmp(testBundle_config.symbolTable[i].name, name)) {
+      return testBundle_config.symbolTable[i];
+    }
+  }
+  fprintf(stderr, "Expected to find variable '%s'\n", name);
+  exit(1);
+}
+
+/// Allocate an aligned block of memory of \p size bytes set to zero.
+static uint8_t *alignedAlloc(size_t size) {
+  void *ptr;
+  int res = posix_memalign(&ptr, testBundle_config.alignment, size);
+  assert(res == 0 && "posix_memalign failed");
+  memset(ptr, 0, size);
+  (void)res;
+  return static_cast<uint8_t *>(ptr);
+}
+
+/// Read the whole file \p fileName into \p data. \returns false on failure.
+static bool readFile(const std::string &fileName, std::vector<char> &data) {
+  FILE *file = fopen(fileName.c_str(), "rb");
+  if (!file) {
+    fprintf(stderr, "Could not open the file: %s\n", fileName.c_str());
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  data.resize(ftell(file));
+  fseek(file, 0, SEEK_SET);
+  bool ok = fread(data.data(), data.size(), 1, file) == 1;
+  fclose(file);
+  return ok;
+}
+
+/// Run the bundle with the constant weights \p constantWeights and \returns
+/// its output. The input is filled as in the bundle saver.
+static std::vector<float> runBundle(const std::vector<char> &constantWeights) {
+  uint8_t *constantWeightVarsAddr = alignedAlloc(constantWeights.size());
+  memcpy(constantWeightVarsAddr, constantWeights.data(),
+         constantWeights.size());
+  uint8_t *mutableWeightVarsAddr =
+      alignedAlloc(testBundle_config.mutableWeightVarsMemSize);
+  uint8_t *activationsAddr = alignedAlloc(testBundle_config.activationsMemSize);
+
+  const SymbolTableEntry &input = getSymbol("input");
+  float *inputPtr = reinterpret_cast<float *>(mutableWeightVarsAddr +
+                                              input.offset);
+  for (size_t idx = 0; idx < input.size; ++idx) {
+    inputPtr[idx] = 0.1f * (float(idx % 17) - 8.0f);
+  }
+
+  testMainEntry(constantWeightVarsAddr, mutableWeightVarsAddr,
+                activationsAddr);
+
+  const SymbolTableEntry &output = getSymbol("output");
+  float *outputPtr = reinterpret_cast<float *>(mutableWeightVarsAddr +
+                                               output.offset);
+  std::vector<float> result(outputPtr, outputPtr + output.size);
+  free(activationsAddr);
+  free(mutableWeightVarsAddr);
+  free(constantWeightVarsAddr);
+  return result;
+}
+
+/// Run the bundle saved in the directory given as the first argument on the
+/// calling thread and with a pool of threads, and check both outputs against
+/// the output of the Interpreter.
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s <bundle directory>\n", argv[0]);
+    return 1;
+  }
+  std::string dir = argv[1];
+  std::vector<char> constantWeights, expectedBytes;
+  if (!readFile(dir + "/testBundle.weights.bin", constantWeights) ||
+      !readFile(dir + "/expected.bin", expectedBytes)) {
+    return 1;
+  }
+  assert(constantWeights.size() ==
+             testBundle_config.constantWeightVarsMemSize &&
+         "Wrong weights file size");
+  const float *expected = reinterpret_cast<const float *>(expectedBytes.data());
+
+  // Without a callback all kernels run on the calling thread.
+  std::vector<float> serial = runBundle(constantWeights);
+
+  GlowPthreadPool *pool = glowCreatePthreadPool(numThreads);
+  testBundle_config.parallelFor = glowPthreadParallelFor;
+  testBundle_config.threadPool = pool;
+  std::vector<float> parallel = runBundle(constantWeights);
+  glowDestroyPthreadPool(pool);
+
+  if (serial.size() * sizeof(float) != expectedBytes.size()) {
+    fprintf(stderr, "Wrong output size\n");
+    return 1;
+  }
+  for (size_t idx = 0; idx < serial.size(); ++idx) {
+    // The ranges of a split kernel compute the same elements as the whole
+    // kernel, hence the results must be identical.
+    if (parallel[idx] != serial[idx] ||
+        fabs(serial[idx] - expected[idx]) > 1e-4 * (1 + fabs(expected[idx]))) {
+      fprintf(stderr, "Mismatch at %zu: serial %f, parallel %f, expected %f\n",
+              idx, serial[idx], parallel[idx], expected[idx]);
+      return 1;
+    }
+  }
+  printf("Outputs of the %zu elements match with %u threads\n", serial.size(),
+         numThreads);
+  return 0;
+}
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "PthreadParallelFor.h"
+
+#include <assert.h>
+#include <pthread.h>
+
+#include <vector>
+
+/// State of the pool. All fields describing the current loop are protected by
+/// the mutex.
+struct GlowPthreadPool {
+  /// Worker threads.
+  std::vector<pthread_t> workers;
+  pthread_mutex_t mutex;
+  /// Signaled when a new loop is started or the pool is stopped.
+  pthread_cond_t workCond;
+  /// Signaled when the last range of the current loop is finished.
+  pthread_cond_t doneCond;
+  /// Task and context of the current loop.
+  void (*task)(void *, uint64_t, uint64_t){nullptr};
+  void *taskCtx{nullptr};
+  /// Number of iterations of the current loop.
+  uint64_t numIters{0};
+  /// Number of ranges the current loop is split into.
+  uint64_t numRanges{0};
+  /// Next range to be picked up by a thread.
+  uint64_t nextRange{0};
+  /// Number of ranges which are not finished yet.
+  uint64_t pendingRanges{0};
+  /// Set when the pool is destroyed.
+  bool stop{false};
+};
+
+/// Pick up the next range of the current loop of \p pool and run it. The
+/// mutex of the pool must be held by the caller and is held again on return.
+static void runNextRange(GlowPthreadPool *pool) {
+  uint64_t range = pool->nextRange++;
+  uint64_t begin = pool->numIters * range / pool->numRanges;
+  uint64_t end = pool->numIters * (range + 1) / pool->numRanges;
+  auto task = pool->task;
+  void *taskCtx = pool->taskCtx;
+  pthread_mutex_unlock(&pool->mutex);
+  task(taskCtx, begin, end);
+  pthread_mutex_lock(&pool->mutex);
+  if (--pool->pendingRanges == 0) {
+    pthread_cond_signal(&pool->doneCond);
+  }
+}
+
+/// Main loop of a worker thread.
+static void *workerMain(void *arg) {
+  auto *pool = static_cast<GlowPthreadPool *>(arg);
+  pthread_mutex_lock(&pool->mutex);
+  while (true) {
+    while (!pool->stop && pool->nextRange >= pool->numRanges) {
+      pthread_cond_wait(&pool->workCond, &pool->mutex);
+    }
+    if (pool->stop) {
+      break;
+    }
+    runNextRange(pool);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return nullptr;
+}
+
+GlowPthreadPool *glowCreatePthreadPool(unsigned numThreads) {
+  auto *pool = new GlowPthreadPool();
+  pthread_mutex_init(&pool->mutex, nullptr);
+  pthread_cond_init(&pool->workCond, nullptr);
+  pthread_cond_init(&pool->doneCond, nullptr);
+  for (unsigned i = 1; i < numThreads; i++) {
+    pthread_t thread;
+    int res = pthread_create(&thread, nullptr, workerMain, pool);
+    assert(res == 0 && "Could not create a worker thread");
+    (void)res;
+    pool->workers.push_back(thread);
+  }
+  return pool;
+}
+
+void glowDestroyPthreadPool(GlowPthreadPool *pool) {
+  pthread_mutex_lock(&pool->mutex);
+  pool->stop = true;
+  pthread_cond_broadcast(&pool->workCond);
+  pthread_mutex_unlock(&pool->mutex);
+  for (auto thread : pool->workers) {
+    pthread_join(thread, nullptr);
+  }
+  pthread_cond_destroy(&pool->doneCond);
+  pthread_cond_destroy(&pool->workCond);
+  pthread_mutex_destroy(&pool->mutex);
+  delete pool;
+}
+
+void glowPthreadParallelFor(void *threadPool, uint64_t numIters,
+                            void (*task)(void *taskCtx, uint64_t begin,
+                                         uint64_t end),
+                            void *taskCtx) {
+  auto *pool = static_cast<GlowPthreadPool *>(threadPool);
+  uint64_t numThreads = pool->workers.size() + 1;
+  uint64_t numRanges = numIters < numThreads ? numIters : numThreads;
+  if (numRanges <= 1) {
+    task(taskCtx, 0, numIters);
+    return;
+  }
+  pthread_mutex_lock(&pool->mutex);
+  pool->task = task;
+  pool->taskCtx = taskCtx;
+  pool->numIters = numIters;
+  pool->numRanges = numRanges;
+  pool->nextRange = 0;
+  pool->pendingRanges = numRanges;
+  pthread_cond_broadcast(&pool->workCond);
+  // The calling thread processes ranges as well.
+  while (pool->nextRange < pool->numRanges) {
+    runNextRange(pool);
+  }
+  while (pool->pendingRanges != 0) {
+    pthread_cond_wait(&pool->doneCond, &pool->mutex);
+  }
+  pool->numRanges = 0;
+  pool->nextRange = 0;
+  pthread_mutex_unlock(&pool->mutex);
+}
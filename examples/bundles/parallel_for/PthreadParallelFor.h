@@ -0,0 +1,48 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_EXAMPLES_BUNDLES_PARALLEL_FOR_PTHREADPARALLELFOR_H
+#define GLOW_EXAMPLES_BUNDLES_PARALLEL_FOR_PTHREADPARALLELFOR_H
+
+#include <stdint.h>
+
+/// Reference implementation of the parallel-for callback used by bundles
+/// compiled with -bundle-parallel-for. A client registers it in the bundle
+/// config before invoking the bundle:
+///
+///   GlowPthreadPool *pool = glowCreatePthreadPool(4);
+///   mybundle_config.parallelFor = glowPthreadParallelFor;
+///   mybundle_config.threadPool = pool;
+///
+/// The calling thread participates in the computation, so a pool created for
+/// N threads spawns N - 1 worker threads.
+struct GlowPthreadPool;
+
+/// \returns a new pool executing parallel-for loops with \p numThreads threads
+/// (including the calling one).
+GlowPthreadPool *glowCreatePthreadPool(unsigned numThreads);
+
+/// Stop all worker threads of the \p pool and free it.
+void glowDestroyPthreadPool(GlowPthreadPool *pool);
+
+/// Parallel-for callback. Splits the iterations [0, \p numIters) into one
+/// contiguous range per thread of the pool \p threadPool and runs \p task with
+/// \p taskCtx on each of them. Returns once all ranges have been processed.
+void glowPthreadParallelFor(void *threadPool, uint64_t numIters,
+                            void (*task)(void *taskCtx, uint64_t begin,
+                                         uint64_t end),
+                            void *taskCtx);
+
+#endif // GLOW_EXAMPLES_BUNDLES_PARALLEL_FOR_PTHREADPARALLELFOR_H
@@ -20,9 +20,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
 #include <string>
 #include <vector>
 
+#include "PthreadParallelFor.h"
 #include "resnet50.h"
 
 /// This is an example demonstrating how to use auto-generated bundles and
@@ -38,6 +45,10 @@
 //===----------------------------------------------------------------------===//
 std::vector<std::string> inputImageFilenames;
 
+/// Number of threads used to run the bundle. It takes effect only if the
+/// bundle was compiled with -bundle-parallel-for.
+unsigned numThreads = 1;
+
 /// \returns the index of the element at x,y,z,w.
 size_t getXYZW(const size_t *dims, size_t x, size_t y, size_t z, size_t w) {
   return (x * dims[1] * dims[2] * dims[3]) + (y * dims[2] * dims[3]) +
@@ -205,10 +216,16 @@ static void loadImagesAndPreprocess(const std::vector<std::string> &filenames,
   printf("Loaded images size in bytes is: %lu\n", resultSizeInBytes);
 }
 
-/// Parse images file names into a vector.
+/// Parse the number of threads (-threads=N) and images file names into a
+/// vector.
 void parseCommandLineOptions(int argc, char **argv) {
   int arg = 1;
   while (arg < argc) {
+    if (!strncmp(argv[arg], "-threads=", strlen("-threads="))) {
+      numThreads = atoi(argv[arg++] + strlen("-threads="));
+      numThreads = numThreads ? numThreads : 1;
+      continue;
+    }
     inputImageFilenames.push_back(argv[arg++]);
   }
 }
@@ -254,35 +271,34 @@ void *alignedAlloc(const BundleConfig &config, size_t size) {
   return ptr;
 }
 
-/// Initialize the constant weights memory block by loading the weights from the
-/// weights file.
+/// Initialize the constant weights memory block by memory-mapping the weights
+/// file read-only. The weights file has the layout of the constant weights
+/// memory block, so it can be used in place: pages are loaded lazily when the
+/// bundle touches them and are shared with other processes mapping the file.
 static uint8_t *initConstantWeights(const char *weightsFileName,
                                     const BundleConfig &config) {
-  // Load weights.
-  FILE *weightsFile = fopen(weightsFileName, "rb");
-  if (!weightsFile) {
+  int fd = open(weightsFileName, O_RDONLY);
+  if (fd < 0) {
     fprintf(stderr, "Could not open the weights file: %s\n", weightsFileName);
     exit(1);
   }
-  fseek(weightsFile, 0, SEEK_END);
-  size_t fileSize = ftell(weightsFile);
-  fseek(weightsFile, 0, SEEK_SET);
-  uint8_t *baseConstantWeightVarsAddr =
-      static_cast<uint8_t *>(alignedAlloc(config, fileSize));
-  printf("Allocated weights of size: %lu\n", fileSize);
+  struct stat fileStat;
+  fstat(fd, &fileStat);
+  size_t fileSize = fileStat.st_size;
   printf("Expected weights of size: %" PRIu64 "\n",
          config.constantWeightVarsMemSize);
   assert(fileSize == config.constantWeightVarsMemSize &&
          "Wrong weights file size");
-  int result = fread(baseConstantWeightVarsAddr, fileSize, 1, weightsFile);
-  if (result != 1) {
-    perror("Could not read the weights file");
-  } else {
-    printf("Loaded weights of size: %lu from the file %s\n", fileSize,
-           weightsFileName);
+  // A mapping starts at a page boundary, which satisfies config.alignment.
+  void *weights = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (weights == MAP_FAILED) {
+    perror("Could not map the weights file");
+    exit(1);
   }
-  fclose(weightsFile);
-  return baseConstantWeightVarsAddr;
+  printf("Mapped weights of size: %lu from the file %s\n", fileSize,
+         weightsFileName);
+  return static_cast<uint8_t *>(weights);
 }
 
 /// The assumed layout of the area for mutable WeightVars is:
@@ -347,18 +363,34 @@ int main(int argc, char **argv) {
   uint8_t *mutableWeightVarsAddr = initMutableWeightVars(resnet50_config);
   uint8_t *activationsAddr = initActivations(resnet50_config);
 
+  // Register the parallel-for callback to split heavy kernels across threads.
+  GlowPthreadPool *threadPool = nullptr;
+  if (numThreads > 1) {
+    threadPool = glowCreatePthreadPool(numThreads);
+    resnet50_config.parallelFor = glowPthreadParallelFor;
+    resnet50_config.threadPool = threadPool;
+  }
+
   // Perform the computation.
+  auto startTime = std::chrono::steady_clock::now();
   int errCode =
       resnet50(constantWeightVarsAddr, mutableWeightVarsAddr, activationsAddr);
+  auto endTime = std::chrono::steady_clock::now();
   if (errCode != GLOW_SUCCESS) {
     printf("Error running bundle: error code %d\n", errCode);
   }
+  printf("Inference latency with %u thread(s): %.2f ms\n", numThreads,
+         std::chrono::duration<double, std::milli>(endTime - startTime)
+             .count());
 
   // Report the results.
   dumpInferenceResults(resnet50_config, mutableWeightVarsAddr);
 
   // Free all resources.
+  if (threadPool) {
+    glowDestroyPthreadPool(threadPool);
+  }
   free(activationsAddr);
-  free(constantWeightVarsAddr);
+  munmap(constantWeightVarsAddr, resnet50_config.constantWeightVarsMemSize);
   free(mutableWeightVarsAddr);
 }
@@ -184,6 +184,11 @@ public:
   /// for multiple requests.
   virtual bool supportsStaticPlaceholders() const { return false; }
 
+  /// \returns true if the DeviceManagers of the Backend run functions out of
+  /// the constants memory block of their RuntimeBundle, so that functions with
+  /// bit-identical constants can share a single block.
+  virtual bool supportsSharedConstants() const { return false; }
+
   /// \returns whether the backend supports fusing \p activation into \p parent.
   virtual bool supportsFusedActivation(Node *parent, Node *activation) const {
     return false;
@@ -18,8 +18,21 @@
 
 #include "glow/CodeGen/MemoryAllocator.h"
 #include "glow/IR/IR.h"
+#include "glow/Support/Error.h"
+
+#include "llvm/ADT/StringRef.h"
 
 #include <map>
+#include <memory>
+#include <unordered_map>
+
+namespace llvm {
+namespace sys {
+namespace fs {
+class mapped_file_region;
+} // namespace fs
+} // namespace sys
+} // namespace llvm
 
 namespace glow {
 namespace runtime {
@@ -58,6 +71,13 @@ class RuntimeBundle {
   SymbolTableTy symbolTable_;
   /// Pointer to memory containing the weights for execution.
   uint8_t *constants_{nullptr};
+  /// Read-only mapping of a weights file backing constants_, if the constants
+  /// were mapped with mapConstants() instead of being collected into a freshly
+  /// allocated block. Copies of the bundle share the mapping.
+  std::shared_ptr<llvm::sys::fs::mapped_file_region> constantsMapping_;
+  /// Shared ownership of constants_, if the block is shared with the bundles
+  /// of other functions holding bit-identical constants.
+  std::shared_ptr<uint8_t> sharedConstants_;
   /// Amount of memory needed for weights.
   size_t constantWeightVarsMemSize_{0};
   /// Amount of memory needed for mutable vars.
@@ -91,7 +111,36 @@ public:
   /// by offsets contained in symbolTable_.
   void collectConstants(const IRFunction *F);
   void collectConstants(const Module *M);
-  /// Free constants.
+  /// Write the constants of \p M into the weights file \p fileName, using the
+  /// same layout collectConstants() produces in memory, i.e. the format of the
+  /// bundle weights file, followed by a footer holding a digest of the
+  /// constants. The payloads are written directly from the Module without an
+  /// intermediate copy. \returns an Error if the file cannot be written.
+  Error saveConstants(const Module *M, llvm::StringRef fileName) const;
+  /// \returns true if the weights file \p fileName was written by
+  /// saveConstants() for the constants of \p M. The check compares the names,
+  /// types and layout of the constants and samples of their payloads, so a
+  /// file of a model whose weights were changed in place may still be deemed
+  /// valid.
+  bool isConstantsFileValid(const Module *M, llvm::StringRef fileName) const;
+  /// Map the weights file \p fileName written by saveConstants() read-only
+  /// and use it as the constants memory block. The mapping starts at a page
+  /// boundary, which satisfies the alignment of every constant. Pages are
+  /// loaded lazily by the OS and are shared between all processes mapping the
+  /// same file. \returns an Error if the file cannot be mapped, in which case
+  /// the constants are left unallocated.
+  Error mapConstants(llvm::StringRef fileName);
+  /// \returns true if the constants are backed by a mapped weights file.
+  bool isConstantsMapped() const { return constantsMapping_ != nullptr; }
+  /// \returns shared ownership of the constants memory block collected by
+  /// collectConstants(), which can then be handed to the bundles of other
+  /// functions with bit-identical constants via shareConstants().
+  std::shared_ptr<uint8_t> getSharedConstants();
+  /// Free the constants and use the block \p constants, which holds
+  /// bit-identical constants, instead. The block is freed once the last bundle
+  /// sharing it goes away.
+  void shareConstants(std::shared_ptr<uint8_t> constants);
+  /// Free constants, or unmap them if they were mapped from a weights file.
   void freeConstants();
 
   /// Sets the input and output flags for each symbol in the symbolBundle.
@@ -240,5 +289,14 @@ bool requiresPadding(const Placeholder *V, const Function *F);
 /// \returns true if \p V is used in \p F; false otherwise.
 bool usedInFunction(const Placeholder *V, const Function *F);
 
+class AllocActivationInst;
+
+/// Plan the placement of all activations allocated by \p instrs at once using
+/// \p allocator, based on the lifetimes given by their alloc and dealloc
+/// instructions. \returns the address assigned to each activation.
+std::unordered_map<const AllocActivationInst *, uint64_t>
+planActivationsMemory(const IRFunction::InstListTy &instrs,
+                      MemoryAllocator &allocator);
+
 } // end namespace glow
 #endif // GLOW_BACKENDS_BACKENDUTILS_H
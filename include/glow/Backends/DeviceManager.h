@@ -29,6 +29,8 @@
 #include <map>
 #include <mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace glow {
 namespace runtime {
@@ -85,6 +87,48 @@ protected:
     statsExporterRegistry_->setCounter(usedMemoryKey_, 0);
   }
 
+  /// Number of functions using each constants memory block on the device.
+  /// Functions with bit-identical constants may share a block, whose memory
+  /// is only accounted for once.
+  std::unordered_map<const uint8_t *, unsigned> constantsUsers_;
+
+  /// \returns the size in bytes of the constants of \p bundle, or zero if its
+  /// constants memory block is already used by a function on the device or
+  /// is in \p newConstants, the blocks of the functions being added, to which
+  /// it is then added.
+  uint64_t
+  getNewConstantsSize(const RuntimeBundle &bundle,
+                      std::unordered_set<const uint8_t *> &newConstants) const {
+    const uint8_t *constants = bundle.getConstants();
+    if (constants && (constantsUsers_.count(constants) ||
+                      !newConstants.insert(constants).second)) {
+      return 0;
+    }
+    return bundle.getConstantWeightSize();
+  }
+
+  /// Record the use of the constants of \p bundle by a function added to the
+  /// device.
+  void acquireConstants(const RuntimeBundle &bundle) {
+    if (const uint8_t *constants = bundle.getConstants()) {
+      constantsUsers_[constants]++;
+    }
+  }
+
+  /// Release the use of the constants of \p bundle by an evicted function.
+  /// \returns the size in bytes of the memory freed, which is zero if other
+  /// functions on the device still use the constants memory block.
+  uint64_t releaseConstants(const RuntimeBundle &bundle) {
+    auto it = constantsUsers_.find(bundle.getConstants());
+    if (it != constantsUsers_.end()) {
+      if (--it->second > 0) {
+        return 0;
+      }
+      constantsUsers_.erase(it);
+    }
+    return bundle.getConstantWeightSize();
+  }
+
 public:
   DeviceManager(const DeviceConfig &config)
       : config_(config),
@@ -58,6 +58,8 @@ public:
 
   bool shouldLower(const Node *N) const override;
 
+  bool supportsSharedConstants() const override { return true; }
+
   Expected<bool> transformPostLowering(
       Function *F, CompilationContext &cctx,
       const glow::runtime::DeviceInfo *devInfo = nullptr) const override;
@@ -75,7 +77,9 @@ public:
     return createInterpreterDeviceManager(deviceConfig);
   }
 
-  void parseBackendSpecificOptions(const BackendOptions &opts) const;
+  /// Parse the Interpreter options of \p opts. \returns an Error if the
+  /// "interpreter-memory" option is not a positive number of kilobytes.
+  Error parseBackendSpecificOptions(const BackendOptions &opts) const;
 };
 
 } // namespace glow
@@ -18,6 +18,7 @@
 
 #include "glow/Backends/QueueBackedDeviceManager.h"
 #include "glow/Runtime/StatsExporter.h"
+#include "glow/Support/ThreadPool.h"
 
 namespace glow {
 namespace runtime {
@@ -37,12 +38,23 @@ class InterpreterDeviceManager : public QueueBackedDeviceManager {
   static constexpr const char *kDevicesUsedInterpreter =
       "glow.devices_used.interpreter";
 
+  /// Threads executing independent instructions of a function in parallel,
+  /// as well as chunks of large data parallel kernels. The number of threads
+  /// is given by the "numThreads" parameter of the DeviceConfig. Functions are
+  /// executed sequentially if there is no pool.
+  std::unique_ptr<ThreadPool> threadPool_;
+
+  /// The minimum number of elements a kernel has to process to be split over
+  /// threadPool_, given by the "minParallelWork" parameter of the DeviceConfig.
+  dim_t minParallelWork_;
+
 public:
-  explicit InterpreterDeviceManager(const DeviceConfig &config)
-      : QueueBackedDeviceManager(config) {
-    statsExporterRegistry_->incrementCounter(kDevicesUsedInterpreter);
-    exportMemoryCounters();
-  }
+  explicit InterpreterDeviceManager(const DeviceConfig &config);
+
+  /// Parse the "numThreads" and "minParallelWork" parameters of the
+  /// DeviceConfig, which must be positive integers, and create the thread
+  /// pool. \returns an Error if a parameter is invalid.
+  Error init() override;
 
   ~InterpreterDeviceManager() override {
     statsExporterRegistry_->incrementCounter(kDevicesUsedInterpreter, -1);
@@ -24,16 +24,23 @@
 #include "glow/Quantization/Base/Base.h"
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
 
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace glow {
 
 class IRFunction;
+class Instruction;
 class Value;
 class Tensor;
 class Constant;
+class Placeholder;
+class ThreadPool;
 
 // Forward declare all of the classes.
 #define DEF_VALUE(CLASS, NAME) class CLASS;
@@ -44,12 +51,119 @@ class Constant;
 /// Function "compiled" for execution by the interpreter.
 class InterpreterFunction final : public CompiledFunction,
                                   public IRInstructionProcessingHandler {
+  friend class BoundInterpreterFunction;
+
+  /// Storage for a value operated on by the instructions, i.e. a weight, an
+  /// activation or a tensor view. Every invocation binds a tensor to each slot.
+  struct Slot {
+    /// The value backed by the slot.
+    const Value *value;
+    /// The offset of an activation inside the activations arena.
+    uint64_t offset{0};
+    /// The constant tensor backing a weight, if any.
+    Tensor *constant{nullptr};
+  };
+
+  /// An operand of a decoded instruction.
+  struct DecodedOperand {
+    /// The operand value.
+    const Value *value;
+    /// The slot backing the value.
+    unsigned slot;
+  };
+
+  /// A decoded instruction, with the slots of its operands pre-resolved.
+  struct DecodedInstr {
+    /// The instruction to execute.
+    const Instruction *I;
+    /// The slot of the value defined by the instruction itself, e.g. by a
+    /// tensor view, or npos.
+    unsigned slot;
+    /// The range of the operands of the instruction in operands_.
+    unsigned operandsBegin;
+    unsigned operandsEnd;
+    /// The number of instructions which have to be executed before this one,
+    /// as they access the same memory.
+    unsigned numPredecessors{0};
+    /// The range of the instructions depending on this one in successors_.
+    unsigned successorsBegin{0};
+    unsigned successorsEnd{0};
+  };
+
+  /// Marks instructions which do not define a value backed by a slot.
+  static constexpr unsigned npos = ~0u;
+
+  /// The memory and tensors used by one invocation of the function. Run slots
+  /// are reused by subsequent invocations, so that activations are allocated
+  /// once per concurrent invocation rather than once per run.
+  struct RunSlot {
+    /// Memory backing all activations, laid out by the activations plan of
+    /// the runtime bundle.
+    uint8_t *activations{nullptr};
+    /// Tensors bound to the slots of the function.
+    std::vector<Tensor *> slots;
+    /// Tensors owned by the run slot, i.e. the activations and tensor views
+    /// carved out of other tensors, indexed by slot.
+    std::vector<Tensor> localTensors;
+
+    ~RunSlot();
+  };
+
   /// The IR to be executed.
   std::unique_ptr<IRFunction> F_;
 
   /// Maps Value.name to tensors for constants.
   std::unordered_map<std::string, Tensor *> constants_;
 
+  /// The instruction stream decoded from F_.
+  std::vector<DecodedInstr> program_;
+
+  /// Operands of all decoded instructions.
+  std::vector<DecodedOperand> operands_;
+
+  /// Dependencies between the decoded instructions, see DecodedInstr.
+  std::vector<unsigned> successors_;
+
+  /// All slots of the function.
+  std::vector<Slot> slots_;
+
+  /// Maps values to their slots. Only used while decoding and binding, the
+  /// decoded instructions refer to slots directly.
+  std::unordered_map<const Value *, unsigned> slotIndex_;
+
+  /// Maps names of weights to their slots.
+  llvm::StringMap<unsigned> weightSlots_;
+
+  /// Placeholders used by the function along with the slots of their weights.
+  std::vector<std::pair<const Placeholder *, unsigned>> placeholderSlots_;
+
+  /// Run slots not used by any invocation.
+  mutable std::vector<std::unique_ptr<RunSlot>> freeRunSlots_;
+
+  /// Number of run slots created so far.
+  mutable size_t numRunSlots_{0};
+
+  /// Protects freeRunSlots_ and numRunSlots_.
+  mutable std::mutex runSlotsMutex_;
+
+  /// \returns a run slot for a new invocation, creating one if there is no
+  /// free run slot.
+  std::unique_ptr<RunSlot> acquireRunSlot() const;
+
+  /// Make \p runSlot available to subsequent invocations.
+  void releaseRunSlot(std::unique_ptr<RunSlot> runSlot) const;
+
+  /// Decode the instructions of F_ into program_.
+  void decode();
+
+  /// Compute the dependencies between the decoded instructions from the
+  /// memory read and written by each of them.
+  void computeDependencies();
+
+  /// Make \p T the tensor backing the weight named \p name, if the function
+  /// has such a weight.
+  void setConstantSlot(llvm::StringRef name, Tensor *T);
+
 public:
   InterpreterFunction(std::unique_ptr<IRFunction> F,
                       runtime::RuntimeBundle &&bundle);
@@ -60,6 +174,13 @@ public:
 
   Error execute(ExecutionContext *context) override;
 
+  /// Execute the function with \p context. If \p threadPool is provided,
+  /// independent instructions are executed in parallel on its threads, and
+  /// data parallel kernels processing at least \p minParallelWork elements
+  /// are split into chunks over its threads.
+  Error execute(ExecutionContext *context, ThreadPool *threadPool,
+                dim_t minParallelWork);
+
   /// Collects constants for runtime.
   void collectConstants(const Module *module) override;
 
@@ -70,6 +191,14 @@ public:
   /// Get reference to IR function.
   IRFunction *getIR() { return F_.get(); }
 
+  /// \returns the number of activation arenas allocated so far. Invocations
+  /// reuse the arenas of completed invocations, so this is the largest number
+  /// of concurrent invocations rather than the number of runs.
+  size_t getNumRunSlots() const;
+
+  /// \returns the peak amount of memory used by activations so far, in bytes.
+  uint64_t getPeakActivationsMemory() const;
+
   /// Read trace events out of this func and write them into /p context
   void translateTraceEvents(ExecutionContext *context) const override;
 
@@ -82,42 +211,78 @@ public:
 
 /// An InterpreterFunction bound to a specific invocation.
 class BoundInterpreterFunction : public IRInstructionProcessingHandler {
-  /// Maps values to Tensors, that are owned by this class.
-  std::unordered_map<const Value *, Tensor *> tensors_;
+  /// The function being executed.
+  const InterpreterFunction &function_;
+
+  /// The run slot used by this invocation.
+  std::unique_ptr<InterpreterFunction::RunSlot> runSlot_;
+
+  /// Tensors bound to the slots of the function, from runSlot_.
+  std::vector<Tensor *> &slots_;
+
+  /// Tensors owned by runSlot_, indexed by slot.
+  std::vector<Tensor> &localTensors_;
+
+  /// The instruction being executed by the current thread.
+  static thread_local const InterpreterFunction::DecodedInstr *curInstr_;
 
-  /// Maps values to Tensors, that are *not* owned by this class.
-  std::unordered_map<const Value *, Tensor *> externalTensors_;
+  /// State shared by the threads executing a function in parallel.
+  struct ParallelState;
 
-  /// A reference to the constant map from the owning InterpreterFunction.
-  const std::unordered_map<std::string, Tensor *> &constants_;
+  /// The thread pool used to execute this invocation, if any.
+  ThreadPool *threadPool_{nullptr};
+
+  /// The minimum number of elements a kernel has to process to be split
+  /// into chunks over threadPool_.
+  dim_t minParallelWork_{0};
 
 public:
-  explicit BoundInterpreterFunction(
-      const std::unordered_map<std::string, Tensor *> &constants)
-      : constants_(constants) {}
+  explicit BoundInterpreterFunction(const InterpreterFunction &function)
+      : function_(function), runSlot_(function.acquireRunSlot()),
+        slots_(runSlot_->slots), localTensors_(runSlot_->localTensors) {}
 
   ~BoundInterpreterFunction();
 
-  Error execute(IRFunction *F, ExecutionContext *context);
+  /// Execute the function with \p context, in parallel on \p threadPool if
+  /// it is provided. Kernels processing at least \p minParallelWork elements
+  /// are split into chunks over \p threadPool.
+  Error execute(ExecutionContext *context, ThreadPool *threadPool = nullptr,
+                dim_t minParallelWork = 0);
 
 private:
+  /// Execute the decoded instruction \p DI.
+  void executeInstr(const InterpreterFunction::DecodedInstr &DI);
+
+  /// Execute the instructions in parallel on \p threadPool, respecting their
+  /// dependencies.
+  void executeParallel(ThreadPool *threadPool);
+
+  /// Execute the instruction \p idx and then all instructions which become
+  /// ready, continuing on the current thread with one of them and submitting
+  /// the others to the thread pool of \p state.
+  void runReady(std::shared_ptr<ParallelState> state, unsigned idx);
+
+  /// Call \p fn on chunks [begin, end) covering the range [0, \p numItems),
+  /// in parallel on threadPool_ if the items amount to at least
+  /// minParallelWork_ elements, \p workPerItem elements each. The chunks must
+  /// be independent. \p fn must not call getTensor, which only resolves the
+  /// operands of the instruction executed by the current thread.
+  void parallelFor(dim_t numItems, dim_t workPerItem,
+                   const std::function<void(dim_t, dim_t)> &fn);
+
+  /// Bind tensors to all slots of the function, except for tensor views,
+  /// using the placeholder bindings of \p context.
+  void bind(ExecutionContext *context);
+
   /// \returns a pointer to the tensor that is saved under \p v.
   Tensor *getTensor(const Value *v) const;
 
-  /// Allocate a tensor to back the value \p v. Do not allocate anything if a
-  /// tensor is already allocated for \p v.
-  /// \returns a tensor for \p v.
-  Tensor *getOrCreateTensor(const Value *v);
-
-  /// Allocate an unowned tensor to back the value \p v. The source tensor of
-  /// the unowned tensor is provided by \p src.
+  /// Create an unowned tensor to back the tensor view \p v. The source tensor
+  /// of the unowned tensor is provided by \p src.
   /// \returns a tensor for \p v.
   Tensor *getOrCreateUnownedTensor(const Value *v, const Value *src,
                                    llvm::ArrayRef<dim_t> offsets);
 
-  /// If a tensor is allocated for \p v then delete it.
-  void deleteTensor(const Value *v);
-
   /// \returns a typed handle to the tensor that is stored at \p v.
   template <class ElemTy = float>
   Handle<ElemTy> getWeightHandle(Value *v) const {
@@ -193,12 +358,23 @@ private:
   void fwdMatMulInstQuantizedImpl(const MatMulInst *I);
   template <typename ElemTy> void fwdMatMulInstFloatImpl(const MatMulInst *I);
 
+  template <typename ElemTy>
+  void fwdBatchMatMulInstFloatImpl(const BatchMatMulInst *I);
+
+  template <typename ElemTy>
+  void fwdScaledDotProductAttentionInstFloatImpl(
+      const ScaledDotProductAttentionInst *I);
+
   template <typename ElemTy, typename AccumulatorTy,
             typename BiasElemTy = int32_t>
   void fwdFullyConnectedInstQuantizedImpl(const FullyConnectedInst *I);
   template <typename ElemTy>
   void fwdFullyConnectedInstFloatImpl(const FullyConnectedInst *I);
 
+  template <typename ElemTy>
+  void fwdBlockSparseFullyConnectedInstImpl(
+      const BlockSparseFullyConnectedInst *I);
+
   template <typename ElemTy, typename AccumulatorTy,
             typename BiasElemTy = int32_t>
   void fwdRowwiseQuantizedFullyConnectedInstImpl(Value *inV, Value *outV,
@@ -361,6 +537,10 @@ private:
   void fwdFusedRowwiseQuantizedSparseLengthsWeightedSumImpl(
       const FusedRowwiseQuantizedSparseLengthsWeightedSumInst *I);
 
+  template <typename T, typename AccumT, typename TI>
+  void fwdGroupedFusedRowwiseQuantizedSparseLengthsWeightedSumImpl(
+      const GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumInst *I);
+
   template <typename T>
   void fwdNonMaxSuppressionInstImpl(glow::NonMaxSuppressionInst const *I);
 
@@ -44,6 +44,32 @@ public:
   bool contains(uint64_t idx) const { return idx >= begin_ && idx < end_; }
 };
 
+/// A buffer with a known lifetime, placed by MemoryAllocator::allocateAll.
+struct AllocationRequest {
+  /// The client-side handle of the buffer.
+  const void *handle;
+  /// The size of the buffer in bytes.
+  uint64_t size;
+  /// The first point in time, e.g. an instruction index, at which the buffer
+  /// is live.
+  uint64_t begin;
+  /// The last point in time at which the buffer is live. Buffers with
+  /// overlapping lifetimes [begin, end] never share memory.
+  uint64_t end;
+};
+
+/// Strategies for planning the placement of buffers with known lifetimes.
+enum class MemoryPlanningStrategy {
+  /// Place the buffers in the order of their lifetimes with the first-fit
+  /// approach. This is what a sequence of allocate/deallocate calls produces.
+  FirstFit,
+  /// Place the biggest buffers first, each at the smallest gap between the
+  /// already placed buffers with overlapping lifetimes it fits into.
+  GreedyBySize,
+  /// Use the strategy producing the smallest peak memory usage.
+  Best,
+};
+
 /// Allocates segments of memory.
 /// Each allocation is associated with a user-defined handle, typically
 /// representing a client-specific object, e.g. a handle can be a `Value *` and
@@ -97,6 +123,23 @@ public:
                     const std::set<Handle> &mustNotEvict,
                     std::vector<Handle> &evicted);
 
+  /// Plans the placement of all \p requests at once, which allows for a much
+  /// better reuse of memory than allocating them one by one, since all buffer
+  /// lifetimes are known up front. The planned buffers are placed above all
+  /// currently live allocations and are not associated with their handles,
+  /// as they are known to be dead at the end of their lifetimes. The address
+  /// of each request is stored at the same position in \p addresses.
+  /// \returns false if the planned buffers do not fit into the pool.
+  bool allocateAll(const std::vector<AllocationRequest> &requests,
+                   std::vector<uint64_t> &addresses,
+                   MemoryPlanningStrategy strategy =
+                       MemoryPlanningStrategy::Best);
+
+  /// \returns the maximum total aligned size of the buffers from \p requests
+  /// that are live at the same time. This is a lower bound of the memory
+  /// needed by any placement of \p requests.
+  uint64_t getMaxLiveSize(const std::vector<AllocationRequest> &requests) const;
+
   /// \returns the handle currently associated with the allocation at \p
   /// address.
   Handle getHandle(uint64_t ptr) const;
@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_EXECUTIONCONTEXT_KERNELPROFILE_H
+#define GLOW_EXECUTIONCONTEXT_KERNELPROFILE_H
+
+#include "glow/ExecutionContext/TraceEvents.h"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+
+#include <list>
+#include <string>
+#include <vector>
+
+namespace glow {
+
+/// Aggregated runtime statistics of a single kernel, i.e. of the code emitted
+/// for a single IR instruction.
+struct KernelProfileEntry {
+  /// Name of the IR instruction the kernel was emitted for.
+  std::string name;
+  /// Kind of the IR instruction, e.g. "convolution".
+  std::string kind;
+  /// Number of recorded executions of the kernel.
+  uint64_t count{0};
+  /// Total time spent in the kernel over all executions, in microseconds.
+  uint64_t time{0};
+};
+
+/// A profile of kernel execution times gathered by an instrumented run (see
+/// BackendOptions::autoInstrument). It is consumed by backends to make
+/// profile-guided code generation decisions, e.g. which kernels are worth
+/// specializing, unrolling or inlining.
+class KernelProfile {
+  /// Profile entries in insertion order.
+  std::vector<KernelProfileEntry> entries_;
+  /// Maps kernel names to their position in entries_.
+  llvm::StringMap<size_t> index_;
+
+public:
+  /// Add \p count executions taking \p time microseconds in total to the
+  /// kernel \p name of kind \p kind.
+  void add(llvm::StringRef name, llvm::StringRef kind, uint64_t count,
+           uint64_t time);
+
+  /// Aggregate all operator-level complete events from \p events, as produced
+  /// by CompiledFunction::translateTraceEvents for auto-instrumented
+  /// functions. Manually inserted TraceEvents are ignored.
+  void addTraceEvents(const std::list<TraceEvent> &events);
+
+  /// \returns the entry for the kernel \p name or nullptr if there is none.
+  const KernelProfileEntry *getEntry(llvm::StringRef name) const;
+
+  /// \returns all entries of the profile.
+  llvm::ArrayRef<KernelProfileEntry> getEntries() const { return entries_; }
+
+  /// \returns true if the profile has no entries.
+  bool empty() const { return entries_.empty(); }
+
+  /// \returns the time spent in all kernels, in microseconds.
+  uint64_t getTotalTime() const;
+
+  /// \returns the names of the hottest kernels that together account for at
+  /// least \p fraction of the total time. If the profile did not record any
+  /// time at all, every kernel is considered hot.
+  llvm::StringSet<> getHotKernels(float fraction) const;
+
+  /// Serialize the profile into the YAML file \p fileName.
+  void serialize(llvm::StringRef fileName) const;
+
+  /// \returns a profile deserialized from the YAML file \p fileName.
+  static KernelProfile deserialize(llvm::StringRef fileName);
+};
+
+} // namespace glow
+
+#endif // GLOW_EXECUTIONCONTEXT_KERNELPROFILE_H
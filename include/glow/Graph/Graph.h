@@ -28,6 +28,9 @@
 #include "llvm/ADT/ilist_node.h"
 
 #include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace glow {
@@ -65,6 +68,18 @@ class Module final {
   /// A uniqued list of types. Types in this list can be equated by comparing
   /// their addresses.
   TypesList types_{};
+  /// Hashes the Type a TypeRef points to, consistently with Type::isEqual.
+  struct TypeRefHash {
+    size_t operator()(TypeRef T) const;
+  };
+  /// Compares the Types TypeRefs point to with Type::isEqual.
+  struct TypeRefEquals {
+    bool operator()(TypeRef LHS, TypeRef RHS) const {
+      return LHS->isEqual(*RHS);
+    }
+  };
+  /// Index of \ref types_, used to unique types in constant time.
+  std::unordered_set<TypeRef, TypeRefHash, TypeRefEquals> typesIndex_{};
   /// Stores a list of unique Storage names that were used by the module at
   /// some point.
   llvm::StringSet<> usedStorageNames_{};
@@ -165,6 +180,9 @@ public:
   /// \returns the list of types that the Module owns.
   const TypesList &getTypes() const { return types_; }
 
+  /// \returns whether a type equal to \p T was uniqued by the Module.
+  bool hasType(const Type &T) const { return typesIndex_.count(&T); }
+
   /// Erase the constant \p N from the Module.
   void eraseConstant(Constant *N);
 
@@ -317,6 +335,15 @@ class Function final : public IRContainer {
   /// The state of this function.
   FunctionState state_;
 
+  /// Hashes of the inputs, members and types of the nodes which were valid the
+  /// last time the Function was verified. A node whose hash did not change is
+  /// not verified again.
+  mutable std::unordered_map<const Node *, llvm::hash_code> verifiedNodes_;
+
+  /// Guards \ref verifiedNodes_, which const verify() calls may update
+  /// concurrently.
+  mutable std::mutex verifiedNodesMutex_;
+
 public:
   Function(Module *parent, llvm::StringRef Name = {})
       : IRContainer(Name), parent_(parent), state_(FunctionState::FuncCreated) {
@@ -641,6 +668,17 @@ public:
       llvm::StringRef name, NodeValue input, Constant *W, NodeValue B,
       TypeRef outTy, quantization::Schema schema, bool transposeWeight = false);
 
+  /// Create a fully connected node multiplying \p input by weights of shape
+  /// [K, N] stored in block-CSR format, with blocks of \p blockRows x
+  /// \p blockCols, and adding the bias \p B. \p values holds the non-zero
+  /// blocks, \p colIndices the block column of each of them and \p rowOffsets
+  /// the index of the first block of each block row, followed by the number of
+  /// blocks. The output has the element type of \p input.
+  BlockSparseFullyConnectedNode *createBlockSparseFullyConnected(
+      llvm::StringRef name, NodeValue input, NodeValue values,
+      NodeValue colIndices, NodeValue rowOffsets, NodeValue B,
+      unsigned_t blockRows, unsigned_t blockCols);
+
   /// Implement an operation that computes the row-wise dot product of its
   /// inputs. Consequently, \p X and \p Y must be either 1D or 2D tensors. This
   /// lowered to a Mul node, and is followed by a BatchedReduceAdd if \p X and
@@ -1036,6 +1074,23 @@ public:
   BatchMatMulNode *createBatchMatMul(llvm::StringRef name, NodeValue lhs,
                                      NodeValue rhs);
 
+  /// Create a ScaledDotProductAttention node with the name \p name, computing
+  /// SoftMax(\p queries x \p keys^T * \p scale + \p mask) x \p values.
+  /// \p queries is {B, Lq, D}, \p keys is {B, Lk, D}, \p values is
+  /// {B, Lk, Dv} and \p mask, which is added to the scores, is {B, Lq, Lk} or
+  /// {B, 1, Lk}.
+  ScaledDotProductAttentionNode *
+  createScaledDotProductAttention(llvm::StringRef name, NodeValue queries,
+                                  NodeValue keys, NodeValue values,
+                                  NodeValue mask, float scale);
+
+  /// Create a ScaledDotProductAttention node with the name \p name and no
+  /// mask, i.e. with a zero mask of shape {B, 1, Lk}.
+  ScaledDotProductAttentionNode *
+  createScaledDotProductAttention(llvm::StringRef name, NodeValue queries,
+                                  NodeValue keys, NodeValue values,
+                                  float scale);
+
   /// Create a node, performing BatchedReduceAdd operation. Output type is
   /// based on the input \p batch type with dimensions specified with \p axes
   /// removed.
@@ -1245,6 +1300,19 @@ public:
       bool useFP16Accumulation = false,
       LengthsMode lengthsMode = LengthsMode::Variable, float avgLength = NAN);
 
+  /// Creates a GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumNode
+  /// performing a FusedRowwiseQuantizedSparseLengthsWeightedSum for each of
+  /// the tables whose rows are packed in \p data, starting at the rows given
+  /// by \p tableOffsets. \p weights, \p indices and \p lengths are the
+  /// concatenated inputs of the tables, which all have the same number of
+  /// segments, and the result holds the results of the tables one after the
+  /// other.
+  GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumNode *
+  createGroupedFusedRowwiseQuantizedSparseLengthsWeightedSum(
+      llvm::StringRef name, NodeValue data, NodeValue weights,
+      NodeValue indices, NodeValue lengths, NodeValue tableOffsets,
+      bool useFP16Accumulation = false);
+
   /// Given a vector of segment lengths, calculates offsets of each segment and
   /// packs them next to the lengths. For the input vector of length N the
   /// output is a Nx2 matrix with (offset, lengths) packaged for each segment.
@@ -1951,9 +2019,11 @@ public:
 
   /// Verify the correctness of the Function. If \p backend is provided, checks
   /// backend-specific layout requirements. Else checks the requirements based
-  /// on Glow's "canonical" layout. \returns true when the function is valid.
-  /// False otherwise.
-  bool verify(const Backend *backend = nullptr) const;
+  /// on Glow's "canonical" layout. The verification is incremental: nodes
+  /// whose inputs, members and types did not change since the last successful
+  /// verification of the node are not verified again, unless \p full is true.
+  /// \returns true when the function is valid. False otherwise.
+  bool verify(const Backend *backend = nullptr, bool full = false) const;
 
   /// Dump a textual representation of the Function into provided output stream.
   void dump() const;
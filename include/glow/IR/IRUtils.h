@@ -29,6 +29,18 @@ bool isTensorView(Value *v);
 /// \returns the offset for \p TVI into the underlying alloc activation.
 size_t calculateTensorViewOffset(const TensorViewInst *TVI);
 
+/// \returns true if \p TVI is a broadcast view, i.e. a view with the same
+/// rank as its source that repeats the source along all dimensions in which
+/// the source has size 1. Unlike other tensor views, a broadcast view is
+/// larger than its source and its elements alias each other.
+bool isBroadcastView(const TensorViewInst *TVI);
+
+/// \returns the number of consecutive elements of a broadcast view of shape
+/// \p dims that are also consecutive in its source of shape \p srcDims, i.e.
+/// the size of the innermost dimensions that are not broadcast.
+dim_t getBroadcastRowLength(llvm::ArrayRef<dim_t> srcDims,
+                            llvm::ArrayRef<dim_t> dims);
+
 /// A helper class to iterate over all uses of a given Value.
 /// It also recursively iterates over uses of any tensorview
 /// instructions aliasing this value.
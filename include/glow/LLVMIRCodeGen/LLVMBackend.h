@@ -151,6 +151,9 @@ public:
   virtual void saveFunctions(llvm::ArrayRef<BundleEntry> entries,
                              llvm::StringRef outputDir,
                              llvm::StringRef bundleName) const override;
+
+  virtual std::unique_ptr<IRFunctionPassPipeline>
+  getIROptimizationPipeline() const override;
   /// @}
 
   /// \returns the size of metrics collected for a single TraceEvent.
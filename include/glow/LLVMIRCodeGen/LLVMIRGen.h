@@ -161,6 +161,23 @@ protected:
   /// specializer not to specialize.
   llvm::DenseSet<llvm::Value *> dontSpecializeArgsSet_;
 
+  /// The IR instruction whose LLVM IR is currently being emitted, if any.
+  const glow::Instruction *currentInstr_{nullptr};
+  /// Maps calls created by createCall to the IR instructions they were emitted
+  /// for. Used e.g. to look up profile information for a call site.
+  llvm::DenseMap<const llvm::CallInst *, const glow::Instruction *>
+      callsToInstrs_;
+  /// Addresses of the buffers of a data-parallel kernel that is emitted row
+  /// by row, rebased to the start of the current row. They take precedence
+  /// over the kernel arguments in emitBufferAddress.
+  llvm::DenseMap<Value *, llvm::Value *> rowBufferAddress_;
+  /// Global variable holding the parallel-for callback registered by the
+  /// client and its thread pool, as two consecutive pointer fields starting at
+  /// parallelForFieldIdx_. nullptr if all kernels are executed serially.
+  llvm::GlobalVariable *parallelForConfig_{nullptr};
+  /// Index of the callback field inside parallelForConfig_.
+  unsigned parallelForFieldIdx_{0};
+
   /// Bitcode of the libjit. Containts the starting address and the length of
   /// the bitcode.
   llvm::StringRef libjitBC_;
@@ -239,6 +256,21 @@ protected:
       llvm::IRBuilder<> &builder, const glow::Instruction *I,
       llvm::Function *kernel, llvm::DenseMap<Value *, int> &bufferToArgNum,
       llvm::Value *loopCount);
+  /// \returns true if the data-parallel kernel for \p bundle can be emitted
+  /// as an explicitly vectorized loop, i.e. if every instruction of the bundle
+  /// is an int8 quantized elementwise operation or copy supported by
+  /// generateVectorLLVMIRForQuantizedInstr. Derived classes overriding the
+  /// scalar code generation of such instructions may want to override this.
+  virtual bool
+  canVectorizeQuantizedBundle(llvm::ArrayRef<const Instruction *> bundle) const;
+  /// Emit explicit vector IR for the quantized data-parallel instruction \p I,
+  /// which processes \p width consecutive elements starting at \p loopCount
+  /// inside the stacked \p kernel. The results are bit-identical to the ones
+  /// of the scalar libjit kernels.
+  virtual void generateVectorLLVMIRForQuantizedInstr(
+      llvm::IRBuilder<> &builder, const glow::Instruction *I,
+      llvm::Function *kernel, llvm::DenseMap<Value *, int> &bufferToArgNum,
+      llvm::Value *loopCount, unsigned width);
   /// \returns the llvm type of the glow vale \p val.
   llvm::Type *getElementType(llvm::IRBuilder<> &builder, const Value *val);
   /// Create a debug information for a given LLVM type \p ty.
@@ -276,6 +308,22 @@ protected:
   createLoop(llvm::IRBuilder<> &builder, llvm::LLVMContext &ctx,
              llvm::Value *numElements) const;
 
+  /// Create LLVM IR for the for loop iterating over [\p begin, \p end) with
+  /// the increment \p step. The range must not be empty and its length must be
+  /// a multiple of \p step. \returns a pair of basic blocks. The first BB is
+  /// the BB of the loop body, the second BB is the loop exit BB.
+  std::pair<llvm::BasicBlock *, llvm::BasicBlock *>
+  createLoop(llvm::IRBuilder<> &builder, llvm::LLVMContext &ctx,
+             llvm::Value *begin, llvm::Value *end, unsigned step = 1) const;
+
+  /// Emit a call of the kernel \p F over the iterations [0, \p numIters). The
+  /// last two parameters of \p F are the begin and the end of the range of
+  /// iterations to be processed and the preceding ones are bound to \p args.
+  /// If a parallel-for callback is configured, the range is split across it,
+  /// otherwise it is processed by a single call.
+  void emitParallelCall(llvm::IRBuilder<> &builder, llvm::Function *F,
+                        llvm::ArrayRef<llvm::Value *> args, dim_t numIters);
+
   /// \returns the backing tensor associated to the IR constant value \p value.
   Tensor getTensorForConstantValue(Value *value);
 
@@ -400,6 +448,16 @@ public:
   unsigned getLibjitIntWidth() const;
   /// \returns true if a call is eligible for specialization.
   virtual bool isEligibleForSpecialization(const llvm::CallInst *call);
+  /// \returns the IR instruction the call \p call was emitted for or nullptr
+  /// if it is unknown.
+  const glow::Instruction *getInstrForCall(const llvm::CallInst *call) const;
+  /// Split the heavy kernels across the parallel-for callback stored in the
+  /// field \p fieldIdx of the global variable \p config. The field \p fieldIdx
+  /// + 1 holds the thread pool passed to the callback.
+  void setParallelForConfig(llvm::GlobalVariable *config, unsigned fieldIdx);
+  /// \returns true if the heavy kernels are split across a parallel-for
+  /// callback.
+  bool isParallelForEnabled() const { return parallelForConfig_ != nullptr; }
   /// \returns true if a global symbol \p GV needs to be preserved in the module
   /// and not interalized during optimizations.
   virtual bool preserveSymbol(const llvm::GlobalValue &GV);
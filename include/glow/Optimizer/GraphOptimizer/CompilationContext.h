@@ -142,6 +142,57 @@ struct OptimizationOptions {
 
   /// If true, optimizations are allowed to change quantization scale/offset.
   bool enableQuantParamChanges{false};
+
+  /// If true, FullyConnected nodes sharing their input are merged into a
+  /// single wide FullyConnected, whose result is sliced for each of them.
+  bool enableHorizontalFCFusion{true};
+
+  /// If true, backends supporting it merge the
+  /// FusedRowwiseQuantizedSparseLengthsWeightedSum nodes over different tables
+  /// into grouped nodes computing all of them with a single kernel.
+  bool enableSLSGrouping{true};
+
+  /// Maximum size in bytes of the tables of a grouped node when
+  /// enableSLSGrouping is set. The tables of a group are copied into a single
+  /// Constant, so larger tables are left ungrouped, which also lets them be
+  /// shared across networks.
+  uint64_t slsGroupingMaxBytes{64 << 20};
+
+  /// If true, backends supporting it fuse the element-wise activations and
+  /// requantizations following quantized Convolutions and FullyConnecteds
+  /// into the epilogue of their kernels.
+  bool enableQuantizedEpilogueFusion{true};
+
+  /// If true, scaled dot-product attentions are folded into
+  /// ScaledDotProductAttention nodes, which backends may compute without
+  /// materializing the scores.
+  bool enableAttentionFusion{true};
+
+  /// If true, the CPU backend converts the float FullyConnecteds and MatMuls
+  /// whose constant weights have at least blockSparseFCMinSparsity of their
+  /// blocks equal to zero into BlockSparseFullyConnected nodes. The
+  /// Interpreter only does so with -interpreter-block-sparse-fc.
+  bool enableBlockSparseFC{true};
+
+  /// Minimum fraction of all-zero blocks of the weights of a FullyConnected
+  /// for it to be converted when enableBlockSparseFC is set.
+  float blockSparseFCMinSparsity{0.8};
+
+  /// If true, functions with bit-identical constants share a single constants
+  /// memory block on backends supporting it, across all networks.
+  bool enableConstantSharing{true};
+
+  /// If true, the Provisioner deduplicates the bit-identical Constants of the
+  /// Module before compiling its partitions. The duplicates are erased from
+  /// the Module, so this is only enabled by callers which do not hold on to
+  /// its Constants.
+  bool enableConstantDeduplication{false};
+
+  /// If non-zero, the peak activation memory in bytes a Function should fit
+  /// into, e.g. DeviceInfo::availableMemory minus the memory of its weights.
+  /// Cheap activations with long lifetimes are then recomputed next to their
+  /// users until the estimated peak fits.
+  uint64_t rematerializationMemoryBudget{0};
 };
 
 /// Context for compilation.
@@ -48,6 +48,11 @@ void optimize(Function *F, CompilationContext &cctx, const Backend &B);
 /// Delete unused Constants from \p mod.
 void deleteUnusedConstants(Module &mod);
 
+/// Deduplicate the bit-identical Constants of \p mod, of any size, so that all
+/// the Functions of \p mod use a single Constant for each distinct payload.
+/// The duplicates are erased. \returns whether any Constant was deduplicated.
+bool deduplicateConstants(Module &mod);
+
 /// Fold nodes that were expressed lowered in the input model.
 void fold(Function *F, CompilationContext &cctx, const Backend *B = nullptr);
 
@@ -111,6 +116,10 @@ std::vector<Constant *> constantFold(Node *N);
 ConstantFoldingRecordMap constantFoldAndRecord(Function *F,
                                                const CompilationContext &cctx);
 
+/// \returns the number of Functions compiled by constant folding to evaluate
+/// constant operations since the start of the process.
+uint64_t getNumConstantFoldingCompilations();
+
 /// Given \p record, remove the constant folding Functions and their associated
 /// output Placeholder from \p mod and \p bindings.
 void cleanupConstantFolding(Module &mod, const ConstantFoldingRecordMap &record,
@@ -136,6 +145,32 @@ Error executeConstantFunction(Backend &backend, Function &F,
 bool executeVerticalFCWeightsSplit(Function *F, unsigned numOfChunks,
                                    unsigned minKToSplit);
 
+/// Merge the FusedRowwiseQuantizedSparseLengthsWeightedSum nodes of \p F over
+/// different Constant tables into
+/// GroupedFusedRowwiseQuantizedSparseLengthsWeightedSum nodes, which compute
+/// them with a single kernel. Nodes are grouped if they have the same types,
+/// apart from the number of rows of their tables and of their indices, and do
+/// not depend on each other. This is meant to be called by backends after
+/// lowering, once SparseLengthsSums have been lowered to the weighted
+/// version. \returns true if any node was grouped.
+/// \param[in,out] F             function to optimize.
+/// \param[in]     maxGroupBytes maximum size of the tables of a group, which
+///                              are copied into a single Constant.
+/// \param[in]     minNumTables  minimum number of nodes to group together.
+bool groupFusedRowwiseQuantizedSLWS(Function *F, uint64_t maxGroupBytes,
+                                    unsigned minNumTables = 2);
+
+/// Convert the float FullyConnected nodes of \p F, and the MatMul nodes
+/// followed or not by a BatchedAdd of a bias, whose weights are Constants with
+/// at least \p minBlockSparsity of their blocks equal to zero into
+/// BlockSparseFullyConnected nodes, storing only the non-zero blocks. Blocks of
+/// 4x8, 1x8 and 1x1 are tried in this order, the last ones amounting to a
+/// plain CSR storage. This is meant to be called by backends after lowering.
+/// \returns true if any node was converted.
+/// \param[in,out] F                function to optimize.
+/// \param[in]     minBlockSparsity minimum fraction of all-zero blocks.
+bool sparsifyFullyConnected(Function *F, float minBlockSparsity);
+
 /// Represents what kind of parallelization transformation should be performed
 /// by \ref parallelizeOps().
 enum class ParallelTransformKind { None, Data, Model };
@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_OPTIMIZER_GRAPHOPTIMIZER_GRAPHREWRITER_H
+#define GLOW_OPTIMIZER_GRAPHOPTIMIZER_GRAPHREWRITER_H
+
+#include "glow/Graph/Graph.h"
+#include "glow/Graph/Node.h"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace glow {
+
+/// A node-local rewrite of a Function. A pattern only inspects a node and its
+/// direct neighborhood, so that after a rewrite only the nodes around the
+/// change can newly match a pattern. Patterns create new nodes and replace
+/// uses, but must not erase nodes; the GraphRewriter erases the nodes left
+/// dead by a rewrite.
+struct RewritePattern {
+  /// Tries to rewrite the node \p N of the Function \p F. \returns true if
+  /// the Function was modified.
+  using RewriteFn = std::function<bool(Node *N, Function *F)>;
+
+  /// Name of the pattern, used for statistics.
+  std::string name;
+  /// Kinds of the nodes the pattern applies to, or empty if the pattern
+  /// applies to nodes of any kind.
+  std::vector<Kinded::Kind> kinds;
+  /// The rewrite itself.
+  RewriteFn rewrite;
+};
+
+/// A worklist driven rewrite engine, which applies a set of RewritePatterns
+/// to a Function until none of them applies anymore. Every node is visited
+/// once, inputs before users. Whenever a pattern modifies the Function only
+/// the nodes whose neighborhood changed are visited again: the rewritten node
+/// and its inputs and users before the rewrite, as well as the nodes created
+/// by the rewrite along with their inputs and users. Nodes left dead by a
+/// rewrite are erased right away, so that they are not counted as users by
+/// the following rewrites.
+class GraphRewriter {
+  /// The Function to rewrite.
+  Function *F_;
+  /// All patterns, in the order they were added.
+  std::vector<RewritePattern> patterns_;
+  /// Indices of the patterns applying to each kind of node, in the order the
+  /// patterns were added. Computed lazily.
+  std::unordered_map<unsigned, std::vector<size_t>> patternsByKind_;
+  /// Number of times each pattern applied during the last run.
+  std::vector<size_t> numApplied_;
+  /// Stack of nodes to visit. May contain nodes which are not queued anymore,
+  /// which are skipped.
+  std::vector<Node *> worklist_;
+  /// Nodes waiting in the worklist.
+  std::unordered_set<Node *> queued_;
+  /// Number of nodes visited during the last run.
+  size_t numVisited_{0};
+
+  /// \returns the indices of the patterns applying to nodes of kind \p kind.
+  const std::vector<size_t> &getPatterns(Kinded::Kind kind);
+
+  /// Queue \p N for a visit, unless it is already queued or does not belong
+  /// to the Function.
+  void enqueue(Node *N);
+
+  /// Erase \p N if it is dead, along with the inputs it leaves dead. The
+  /// erased nodes are added to \p erased and the surviving inputs of erased
+  /// nodes are queued for a visit.
+  void eraseIfDead(Node *N, std::unordered_set<Node *> &erased);
+
+public:
+  explicit GraphRewriter(Function *F) : F_(F) {}
+
+  /// Add \p pattern to the patterns of the rewriter. The patterns applying to
+  /// a node are tried in the order they were added.
+  void addPattern(RewritePattern pattern);
+
+  /// Add the pattern \p name rewriting nodes of the kinds \p kinds, or of any
+  /// kind if \p kinds is empty, with \p rewrite.
+  void addPattern(llvm::StringRef name, llvm::ArrayRef<Kinded::Kind> kinds,
+                  RewritePattern::RewriteFn rewrite);
+
+  /// Apply the patterns until a fixed point is reached. \returns true if the
+  /// Function was modified.
+  bool run();
+
+  /// \returns the number of node visits of the last run, including the nodes
+  /// visited again after a rewrite.
+  size_t getNumVisited() const { return numVisited_; }
+
+  /// \returns the number of times the pattern \p name applied during the last
+  /// run.
+  size_t getNumApplied(llvm::StringRef name) const;
+};
+
+} // namespace glow
+
+#endif // GLOW_OPTIMIZER_GRAPHOPTIMIZER_GRAPHREWRITER_H
@@ -24,9 +24,14 @@
 #include "llvm/ADT/ArrayRef.h"
 
 #include <functional>
+#include <memory>
 
 namespace glow {
 
+namespace runtime {
+struct DeviceInfo;
+}
+
 ///===---------------------------------------------------------------------===//
 ///                               SplitNodeOption
 ///===---------------------------------------------------------------------===//
@@ -283,6 +288,37 @@ Expected<SplitNodeMap> splitNodes(Function *F,
 Expected<SplitNodeMap> splitNodes(Function *F,
                                   const SplitNodeConstraint &splitConstraint);
 
+///===---------------------------------------------------------------------===//
+///                               splitNodesAuto
+///===---------------------------------------------------------------------===//
+/// Hardware parameters used by the automatic node splitting procedure to
+/// choose the split options. A node is split such that the operands of each
+/// split node fit in \ref cacheCapacity.
+struct SplitNodeCostModel {
+  /// Capacity in bytes of the memory in which the operands of each split node
+  /// should fit, e.g. the L2 cache of a CPU core or the SRAM of an
+  /// accelerator.
+  uint64_t cacheCapacity{1 << 20};
+  /// Maximum number of chunks a node is split into.
+  unsigned maxNumChunks{64};
+};
+
+/// Function to choose a split option for the node \p node using the cost
+/// model \p costModel. Only Convolution, FullyConnected, MatMul, MaxPool and
+/// AvgPool nodes are considered. The node is split along a single dimension
+/// of its output, the one needing the fewest chunks for the operands of each
+/// chunk to fit in the cache. \returns the split option or nullptr if the
+/// node should not be split.
+std::unique_ptr<SplitNodeOption>
+getAutoSplitNodeOption(const Node *node, const SplitNodeCostModel &costModel);
+
+/// Function to split automatically all the nodes from the function \p F for
+/// which \ref getAutoSplitNodeOption chooses a split option using the cost
+/// model \p costModel. \returns a split node map for those nodes which were
+/// actually split.
+Expected<SplitNodeMap> splitNodesAuto(Function *F,
+                                      const SplitNodeCostModel &costModel);
+
 } // namespace glow
 
 #endif // GLOW_OPTIMIZER_GRAPHOPTIMIZER_NODESPLITTING_H
@@ -22,6 +22,7 @@
 #include "glow/Support/Error.h"
 
 #include <map>
+#include <memory>
 
 namespace glow {
 namespace runtime {
@@ -69,6 +70,27 @@ private:
   /// List of available DeviceManagers added during initialization.
   std::vector<DeviceManager *> devices_;
 
+  /// A constants memory block shared by the functions with bit-identical
+  /// constants.
+  struct SharedConstants {
+    /// Size of the block in bytes.
+    size_t size;
+    /// The block, which is freed once no function uses it anymore.
+    std::weak_ptr<uint8_t> block;
+  };
+
+  /// Constants memory blocks of the functions provisioned so far, across all
+  /// networks, by hash of their content.
+  std::unordered_map<size_t, std::vector<SharedConstants>> sharedConstants_;
+
+  /// Mutex for sharedConstants_.
+  std::mutex sharedConstantsLock_;
+
+  /// Collect the constants of \p compiled from \p module, and use the
+  /// constants memory block of a previously provisioned function instead if
+  /// it holds bit-identical constants.
+  void shareConstants(CompiledFunction &compiled, const Module &module);
+
   /// Helper function to cleanup a provision call. On \p failure free the
   /// compiledFunctions that were created, \p names , and remove networks
   /// already added to devices, \p currentNetworkResidency .
@@ -172,6 +172,9 @@ public:
 
   const std::set<size_t> &getThreadIds() { return threadIds_; }
 
+  /// Returns the number of worker threads in the pool.
+  size_t getNumWorkers() const { return workers_.size(); }
+
 private:
   /// The default number of workers in the thread pool (overridable).
   constexpr static unsigned kNumWorkers = 10;
@@ -19,6 +19,11 @@
 #include "glow/Support/Debug.h"
 
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include <glog/logging.h>
 
@@ -37,20 +42,34 @@ static llvm::cl::opt<bool> reuseActivationsMemory(
     llvm::cl::desc("Should activation memory allocations be reused"),
     llvm::cl::init(true), llvm::cl::cat(BackendUtilsCat));
 
+static llvm::cl::opt<MemoryPlanningStrategy> activationsMemoryPlanner(
+    "activations-memory-planner",
+    llvm::cl::desc("Strategy used to place the activations in memory"),
+    llvm::cl::values(clEnumValN(MemoryPlanningStrategy::FirstFit, "first-fit",
+                                "Place activations in the order of their "
+                                "lifetimes with the first-fit approach"),
+                     clEnumValN(MemoryPlanningStrategy::GreedyBySize,
+                                "greedy-by-size",
+                                "Place the biggest activations first"),
+                     clEnumValN(MemoryPlanningStrategy::Best, "best",
+                                "Use the strategy with the smallest peak")),
+    llvm::cl::init(MemoryPlanningStrategy::Best),
+    llvm::cl::cat(BackendUtilsCat));
+
 namespace {
 /// Allocate space for the activations of \p instrs using \p allocator and store
 /// the resultant symbols in \p symbolTable.
 void allocateActivations(const glow::IRFunction::InstListTy &instrs,
                          MemoryAllocator &allocator,
                          glow::runtime::SymbolTableTy &symbolTable) {
+  auto activationAddr = planActivationsMemory(instrs, allocator);
   for (const auto &I : instrs) {
     if (auto *A = dyn_cast<AllocActivationInst>(&I)) {
       auto numBytes = I.getSizeInBytes();
-      size_t addr = allocator.allocate(numBytes, A);
       assert(!symbolTable.count(std::string(A->getName())) &&
              "Allocation already made!");
       runtime::RuntimeSymbolInfo symbol;
-      symbol.offset = addr;
+      symbol.offset = activationAddr[A];
       symbol.size = numBytes;
       symbol.type = *A->getType();
       symbol.input = false;
@@ -95,16 +114,6 @@ void allocateActivations(const glow::IRFunction::InstListTy &instrs,
                      TV->getName().data(), symbol.offset, symbol.size));
       continue;
     }
-
-    if (auto *D = dyn_cast<DeallocActivationInst>(&I)) {
-      auto *A = D->getAlloc();
-      assert(symbolTable.count(std::string(A->getName())) &&
-             "Invalid deallocation!");
-      if (reuseActivationsMemory) {
-        allocator.deallocate(A);
-      }
-      continue;
-    }
   }
 }
 
@@ -162,6 +171,8 @@ operator=(glow::runtime::RuntimeBundle &&rhs) {
 
   std::swap(symbolTable_, rhs.symbolTable_);
   std::swap(constants_, rhs.constants_);
+  std::swap(constantsMapping_, rhs.constantsMapping_);
+  std::swap(sharedConstants_, rhs.sharedConstants_);
   std::swap(constantWeightVarsMemSize_, rhs.constantWeightVarsMemSize_);
   std::swap(mutableWeightVarsMemSize_, rhs.mutableWeightVarsMemSize_);
   std::swap(activationsMemSize_, rhs.activationsMemSize_);
@@ -179,11 +190,185 @@ void glow::runtime::RuntimeBundle::collectConstants(const IRFunction *F) {
 void glow::runtime::RuntimeBundle::freeConstants() {
   DCHECK(isValid_);
 
+  if (constantsMapping_) {
+    // The pages are unmapped once the last bundle sharing them goes away.
+    constantsMapping_.reset();
+    constants_ = nullptr;
+    return;
+  }
+  if (sharedConstants_) {
+    // The block is freed once the last bundle sharing it goes away.
+    sharedConstants_.reset();
+    constants_ = nullptr;
+    return;
+  }
   if (constants_) {
     glow::alignedFree(constants_);
     constants_ = nullptr;
   }
 }
+
+std::shared_ptr<uint8_t> glow::runtime::RuntimeBundle::getSharedConstants() {
+  DCHECK(isValid_);
+  assert(!constantsMapping_ && "Mapped constants cannot be shared");
+  if (!sharedConstants_ && constants_) {
+    sharedConstants_.reset(constants_, glow::alignedFree);
+  }
+  return sharedConstants_;
+}
+
+void glow::runtime::RuntimeBundle::shareConstants(
+    std::shared_ptr<uint8_t> constants) {
+  DCHECK(isValid_);
+  freeConstants();
+  sharedConstants_ = std::move(constants);
+  constants_ = sharedConstants_.get();
+}
+
+/// Magic string starting the footer of the weights files written by
+/// RuntimeBundle::saveConstants().
+static constexpr const char *kWeightsFileMagic = "GLOWWTS1";
+
+/// Number of payload bytes of a constant sampled into the digest of a weights
+/// file, and the size of the chunks they are sampled in.
+static constexpr size_t kWeightsDigestMaxBytes = 4096;
+static constexpr size_t kWeightsDigestChunkBytes = 64;
+
+/// Compute into \p digest the hex MD5 digest of the constants of \p M in the
+/// layout of \p bundle. The digest covers the names, types, offsets and sizes
+/// of the constants, but only samples their payloads, which keeps it cheap for
+/// large models: small payloads are hashed completely, larger ones in evenly
+/// spaced chunks of kWeightsDigestChunkBytes.
+static void getConstantsDigest(const glow::runtime::RuntimeBundle &bundle,
+                               const Module *M,
+                               llvm::SmallString<32> &digest) {
+  llvm::MD5 MD5;
+  auto update = [&MD5](const void *data, size_t size) {
+    MD5.update(llvm::makeArrayRef(reinterpret_cast<const uint8_t *>(data),
+                                  size));
+  };
+  for (const auto &symbol : bundle.getSymbolTable()) {
+    Constant *c = M->getConstantByName(symbol.first);
+    if (!c) {
+      continue;
+    }
+    const runtime::RuntimeSymbolInfo &info = symbol.second;
+    MD5.update(symbol.first);
+    MD5.update(c->getType()->toString());
+    update(&info.offset, sizeof(info.offset));
+    update(&info.size, sizeof(info.size));
+    const char *data = c->getPayload().getUnsafePtr();
+    if (info.size <= kWeightsDigestMaxBytes) {
+      update(data, info.size);
+      continue;
+    }
+    size_t numChunks = kWeightsDigestMaxBytes / kWeightsDigestChunkBytes;
+    size_t stride = (info.size - kWeightsDigestChunkBytes) / (numChunks - 1);
+    for (size_t i = 0; i < numChunks; i++) {
+      update(data + i * stride, kWeightsDigestChunkBytes);
+    }
+  }
+  llvm::MD5::MD5Result res;
+  MD5.final(res);
+  llvm::MD5::stringifyResult(res, digest);
+}
+
+Error glow::runtime::RuntimeBundle::saveConstants(
+    const Module *M, llvm::StringRef fileName) const {
+  DCHECK(isValid_);
+  std::error_code EC;
+  llvm::raw_fd_ostream weightsFile(fileName, EC, llvm::sys::fs::F_None);
+  RETURN_ERR_IF_NOT(!EC, "Could not open the output file for saving the "
+                         "weights with file name: " +
+                             fileName.str());
+  if (constantWeightVarsMemSize_ == 0) {
+    return Error::success();
+  }
+
+  for (const auto &symbol : symbolTable_) {
+    llvm::StringRef name = symbol.first;
+    const RuntimeSymbolInfo &info = symbol.second;
+
+    Constant *c = M->getConstantByName(name);
+    if (!c) {
+      continue;
+    }
+    assert(info.size == c->getPayload().getSizeInBytes() &&
+           "Mismatched constant size");
+    weightsFile.seek(info.offset);
+    weightsFile.write(c->getPayload().getUnsafePtr(), info.size);
+  }
+
+  // The footer follows the constantWeightVarsMemSize_ bytes of constants, the
+  // trailing alignment padding reads back as zeros.
+  llvm::SmallString<32> digest;
+  getConstantsDigest(*this, M, digest);
+  weightsFile.seek(constantWeightVarsMemSize_);
+  weightsFile << kWeightsFileMagic << digest;
+  weightsFile.close();
+  if (weightsFile.has_error()) {
+    // A stream destroyed with a pending error aborts the process.
+    weightsFile.clear_error();
+    return MAKE_ERR("Could not write the weights file " + fileName.str());
+  }
+  return Error::success();
+}
+
+bool glow::runtime::RuntimeBundle::isConstantsFileValid(
+    const Module *M, llvm::StringRef fileName) const {
+  DCHECK(isValid_);
+  if (constantWeightVarsMemSize_ == 0) {
+    return true;
+  }
+  llvm::SmallString<32> digest;
+  getConstantsDigest(*this, M, digest);
+  llvm::StringRef magic(kWeightsFileMagic);
+  uint64_t fileSize = 0;
+  if (llvm::sys::fs::file_size(fileName, fileSize) ||
+      fileSize != constantWeightVarsMemSize_ + magic.size() + digest.size()) {
+    return false;
+  }
+  auto footerOrErr = llvm::MemoryBuffer::getFileSlice(
+      fileName, magic.size() + digest.size(), constantWeightVarsMemSize_);
+  if (!footerOrErr) {
+    return false;
+  }
+  return (*footerOrErr)->getBuffer() == (magic + digest).str();
+}
+
+Error glow::runtime::RuntimeBundle::mapConstants(llvm::StringRef fileName) {
+  DCHECK(isValid_);
+  assert(constants_ == nullptr && "constants already allocated");
+  if (constantWeightVarsMemSize_ == 0) {
+    return Error::success();
+  }
+
+  uint64_t fileSize = 0;
+  RETURN_ERR_IF_NOT(!llvm::sys::fs::file_size(fileName, fileSize),
+                    "Could not get the size of the weights file " +
+                        fileName.str());
+  RETURN_ERR_IF_NOT(fileSize >= constantWeightVarsMemSize_,
+                    "Weights file " + fileName.str() + " is too small");
+
+  int fd;
+  RETURN_ERR_IF_NOT(!llvm::sys::fs::openFileForRead(fileName, fd),
+                    "Could not open the weights file " + fileName.str());
+  std::error_code EC;
+  auto mapping = std::make_shared<llvm::sys::fs::mapped_file_region>(
+      fd, llvm::sys::fs::mapped_file_region::readonly,
+      constantWeightVarsMemSize_, 0, EC);
+  // The mapping stays valid after the descriptor is closed.
+  llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+  RETURN_ERR_IF_NOT(!EC, "Could not map the weights file " + fileName.str() +
+                             ": " + EC.message());
+  // The generated code only ever reads the constants, so a read-only mapping
+  // can be handed out as the constants memory block.
+  constantsMapping_ = std::move(mapping);
+  constants_ = reinterpret_cast<uint8_t *>(
+      const_cast<char *>(constantsMapping_->const_data()));
+  return Error::success();
+}
+
 void glow::runtime::RuntimeBundle::collectConstants(const Module *M) {
   DCHECK(isValid_);
 
@@ -198,6 +383,9 @@ void glow::runtime::RuntimeBundle::collectConstants(const Module *M) {
   assert(constants_ == nullptr && "constants already allocated");
   constants_ =
       (uint8_t *)alignedAlloc(constantWeightVarsMemSize_, TensorAlignment);
+  // Zero the alignment padding between constants, so that blocks of
+  // bit-identical constants compare and hash equal as a whole.
+  memset(constants_, 0, constantWeightVarsMemSize_);
 
   for (const auto &symbol : symbolTable_) {
     llvm::StringRef name = symbol.first;
@@ -475,6 +663,46 @@ bool usedInFunction(const Placeholder *V, const Function *F) {
   return false;
 }
 
+std::unordered_map<const AllocActivationInst *, uint64_t>
+planActivationsMemory(const IRFunction::InstListTy &instrs,
+                      MemoryAllocator &allocator) {
+  // Collect the lifetimes of all activations, in terms of instruction indices.
+  std::vector<AllocationRequest> requests;
+  std::unordered_map<const AllocActivationInst *, size_t> requestIdx;
+  uint64_t lastIdx = instrs.empty() ? 0 : instrs.size() - 1;
+  uint64_t idx = 0;
+  for (const auto &I : instrs) {
+    if (auto *A = dyn_cast<AllocActivationInst>(&I)) {
+      assert(!requestIdx.count(A) && "Allocation already made!");
+      requestIdx[A] = requests.size();
+      requests.push_back({A, A->getSizeInBytes(), idx, lastIdx});
+    } else if (auto *D = dyn_cast<DeallocActivationInst>(&I)) {
+      auto it = requestIdx.find(D->getAlloc());
+      assert(it != requestIdx.end() && "Invalid deallocation!");
+      // Without reuse every activation stays live till the end.
+      if (reuseActivationsMemory) {
+        requests[it->second].end = idx;
+      }
+    }
+    idx++;
+  }
+
+  std::vector<uint64_t> addresses;
+  bool planned =
+      allocator.allocateAll(requests, addresses, activationsMemoryPlanner);
+  CHECK(planned) << "Not enough memory to allocate the activations";
+  DEBUG_GLOW(LOG(INFO) << strFormat(
+                 "Planned %zu activations: %zu bytes, lower bound %zu bytes\n",
+                 requests.size(), size_t(allocator.getMaxMemoryUsage()),
+                 size_t(allocator.getMaxLiveSize(requests))));
+
+  std::unordered_map<const AllocActivationInst *, uint64_t> activationAddr;
+  for (const auto &entry : requestIdx) {
+    activationAddr[entry.first] = addresses[entry.second];
+  }
+  return activationAddr;
+}
+
 } // namespace glow
 
 runtime::RuntimeBundle
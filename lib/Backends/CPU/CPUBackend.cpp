@@ -250,6 +250,22 @@ bool CPUBackend::isOpSupported(const NodeInfo &NI) const {
            (NI.getInElemTy(ConvolutionNode::BiasIdx) == ElemKind::Int8QTy ||
             NI.getInElemTy(ConvolutionNode::BiasIdx) == ElemKind::Int32QTy);
 
+  case Kinded::Kind::CPUFusedQuantizedConvNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind(
+               {ElemKind::Int8QTy}, {CPUFusedQuantizedConvNode::BiasIdx}) &&
+           (NI.getInElemTy(CPUFusedQuantizedConvNode::BiasIdx) ==
+                ElemKind::Int8QTy ||
+            NI.getInElemTy(CPUFusedQuantizedConvNode::BiasIdx) ==
+                ElemKind::Int32QTy);
+
+  case Kinded::Kind::CPUFusedQuantizedFCNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind(
+               {ElemKind::Int8QTy}, {CPUFusedQuantizedFCNode::BiasIdx}) &&
+           (NI.getInElemTy(CPUFusedQuantizedFCNode::BiasIdx) ==
+                ElemKind::Int8QTy ||
+            NI.getInElemTy(CPUFusedQuantizedFCNode::BiasIdx) ==
+                ElemKind::Int32QTy);
+
   case Kinded::Kind::ChannelwiseQuantizedConvolutionNodeKind:
     return (NI.getInElemTy(ChannelwiseQuantizedConvolutionNode::InputIdx) ==
             ElemKind::Int8QTy) &&
@@ -379,6 +395,9 @@ bool CPUBackend::isOpSupported(const NodeInfo &NI) const {
            (NI.getInElemTy(SoftMaxNode::SelectedIdx) == ElemKind::Int64ITy ||
             NI.getInElemTy(SoftMaxNode::SelectedIdx) == ElemKind::Int32ITy);
 
+  case Kinded::Kind::ScaledDotProductAttentionNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind({ElemKind::FloatTy});
+
   case Kinded::Kind::CrossEntropyLossNodeKind:
     return NI.allInputsAndOutputsHaveSameElemKind(
                {ElemKind::FloatTy}, {CrossEntropyLossNode::LabelsIdx}) &&
@@ -404,6 +423,21 @@ bool CPUBackend::isOpSupported(const NodeInfo &NI) const {
            (NI.getOutElemTy(EmbeddingBagByteRowwiseOffsetsNode::ResultIdx) ==
             ElemKind::FloatTy);
 
+  case Kinded::Kind::BlockSparseFullyConnectedNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind(
+        {ElemKind::FloatTy}, {BlockSparseFullyConnectedNode::ColIndicesIdx,
+                              BlockSparseFullyConnectedNode::RowOffsetsIdx});
+
+  case Kinded::Kind::
+      GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumNodeKind:
+    if (NI.getInElemTy(
+            GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumNode::
+                TableOffsetsIdx) != ElemKind::Int64ITy) {
+      return false;
+    }
+    // The other inputs are the ones of a
+    // FusedRowwiseQuantizedSparseLengthsWeightedSum, at the same indices.
+    LLVM_FALLTHROUGH;
   case Kinded::Kind::FusedRowwiseQuantizedSparseLengthsWeightedSumNodeKind:
     return (NI.getInElemTy(
                 FusedRowwiseQuantizedSparseLengthsWeightedSumNode::DataIdx) ==
@@ -517,6 +551,12 @@ bool CPUBackend::shouldLower(const Node *N) const {
   case Kinded::Kind::ConvolutionNodeKind:
   case Kinded::Kind::SparseLengthsSumNodeKind:
     return false;
+  case Kinded::Kind::ScaledDotProductAttentionNodeKind:
+    // Float attentions are computed by a kernel which does not materialize
+    // the scores.
+    return llvm::cast<ScaledDotProductAttentionNode>(N)
+               ->getResult()
+               .getElementType() != ElemKind::FloatTy;
   default:
     return true;
   }
@@ -558,6 +598,9 @@ bool CPUBackend::canDoIndexTypeDemotion(
       Kinded::Kind::FusedRowwiseQuantizedSparseLengthsSumNodeKind);
   precConfig.precisionModeKindSet.insert(
       Kinded::Kind::FusedRowwiseQuantizedSparseLengthsWeightedSumNodeKind);
+  precConfig.precisionModeKindSet.insert(
+      Kinded::Kind::
+          GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumNodeKind);
   precConfig.precisionModeKindSet.insert(
       Kinded::Kind::SparseToDenseMaskNodeKind);
   return fromTy == ElemKind::Int64ITy && toTy == ElemKind::Int32ITy;
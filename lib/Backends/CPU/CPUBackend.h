@@ -48,10 +48,19 @@ public:
       Function *F, CompilationContext &cctx,
       const glow::runtime::DeviceInfo *devInfo = nullptr) const override;
 
+  std::unique_ptr<FunctionPassPipeline>
+  getOptimizationPipeline() const override;
+
   bool isOpSupported(const NodeInfo &NI) const override;
 
   bool shouldLower(const Node *N) const override;
 
+  /// Constants memory-mapped from -cpu-weights-dir are not collected by the
+  /// Provisioner, and so are not shared.
+  bool supportsSharedConstants() const override {
+    return !runtime::isCPUWeightsDirSet();
+  }
+
   runtime::DeviceManager *
   createDeviceManager(const runtime::DeviceConfig &deviceConfig) override {
     return createCPUDeviceManager(deviceConfig);
@@ -17,9 +17,14 @@
 #include "CPUFunction.h"
 
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <unordered_set>
+
 namespace glow {
 namespace runtime {
 
@@ -30,6 +35,76 @@ static llvm::cl::opt<unsigned, /* ExternalStorage */ true> GlowCPUMemoryOpt(
     llvm::cl::desc("CPU DeviceManager maximum memory in kilobytes."),
     llvm::cl::location(GlowCPUMemory));
 
+static llvm::cl::opt<std::string> cpuWeightsDir(
+    "cpu-weights-dir",
+    llvm::cl::desc(
+        "Directory of page-aligned weights files for the CPU DeviceManager. "
+        "The constants of a network are written to <dir>/<function>.weights "
+        "the first time it is added and are memory-mapped read-only instead "
+        "of being copied into a freshly allocated block. The files are keyed "
+        "by function name and validated by the layout and sampled contents "
+        "of the constants; if a file does not match the constants of its "
+        "function, they are copied instead and the file must be removed. "
+        "Remove the files whenever the weights of a model change."),
+    llvm::cl::init(""));
+
+/// Memory-map the constants of \p bundle for the function \p name of
+/// \p module from the weights file in cpuWeightsDir, creating the file if it
+/// does not exist yet. The constants are collected as usual if the file holds
+/// different constants, e.g. those of a previous version of the model, or if
+/// it cannot be written or mapped.
+static void mapConstantsFromWeightsDir(runtime::RuntimeBundle &bundle,
+                                       const Module *module,
+                                       llvm::StringRef name) {
+  llvm::SmallString<128> pathBuf(cpuWeightsDir);
+  llvm::sys::path::append(pathBuf, name + ".weights");
+  std::string path = pathBuf.str().str();
+  if (!llvm::sys::fs::exists(path)) {
+    // Write into a unique temporary file first and rename it into place, so
+    // that concurrent processes never map a partially written file.
+    llvm::SmallString<128> tmpPath;
+    int fd;
+    auto EC =
+        llvm::sys::fs::createUniqueFile(path + "-%%%%%%.tmp", fd, tmpPath);
+    if (EC) {
+      LOG(WARNING) << "Could not create a weights file for " << path << ": "
+                   << EC.message() << ", copying the constants instead";
+      bundle.collectConstants(module);
+      return;
+    }
+    llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+    if (auto err = bundle.saveConstants(module, tmpPath)) {
+      LOG(WARNING) << ERR_TO_STRING(std::move(err))
+                   << ", copying the constants instead";
+      llvm::sys::fs::remove(tmpPath);
+      bundle.collectConstants(module);
+      return;
+    }
+    EC = llvm::sys::fs::rename(tmpPath, path);
+    if (EC) {
+      LOG(WARNING) << "Could not rename the weights file "
+                   << tmpPath.str().str() << " to " << path << ": "
+                   << EC.message() << ", copying the constants instead";
+      llvm::sys::fs::remove(tmpPath);
+      bundle.collectConstants(module);
+      return;
+    }
+  }
+  if (!bundle.isConstantsFileValid(module, path)) {
+    LOG(WARNING) << "Weights file " << path << " does not match the constants "
+                 << "of " << name.str() << ", copying them instead";
+    bundle.collectConstants(module);
+    return;
+  }
+  if (auto err = bundle.mapConstants(path)) {
+    LOG(WARNING) << ERR_TO_STRING(std::move(err))
+                 << ", copying the constants instead";
+    bundle.collectConstants(module);
+  }
+}
+
+bool isCPUWeightsDirSet() { return !cpuWeightsDir.empty(); }
+
 DeviceManager *createCPUDeviceManager(const DeviceConfig &config) {
   if (GlowCPUMemory) {
     // Convert command line GlowCPUMemory to bytes from kilobytes.
@@ -68,6 +143,7 @@ void CPUDeviceManager::addNetworkImpl(const Module *module,
   DCHECK(readyCB != nullptr);
 
   uint64_t allFunctionsMemoryBytes{0};
+  std::unordered_set<const uint8_t *> newConstants;
 
   // First check for uniqueness of the function name.
   for (const auto &func : functions) {
@@ -93,8 +169,10 @@ void CPUDeviceManager::addNetworkImpl(const Module *module,
       return;
     }
 
+    // Constants already shared with a function on the device take no extra
+    // memory.
     allFunctionsMemoryBytes +=
-        func.second->getRuntimeBundle().getConstantWeightSize();
+        getNewConstantsSize(func.second->getRuntimeBundle(), newConstants);
   }
 
   if (usedMemoryBytes_ + allFunctionsMemoryBytes > maxMemoryBytes_) {
@@ -106,9 +184,15 @@ void CPUDeviceManager::addNetworkImpl(const Module *module,
 
   // Add to the function name lookup map.
   for (const auto &func : functions) {
-    if (func.second->getRuntimeBundle().getConstants() == nullptr) {
-      func.second->getRuntimeBundle().collectConstants(module);
+    auto &bundle = func.second->getRuntimeBundle();
+    if (bundle.getConstants() == nullptr) {
+      if (!cpuWeightsDir.empty()) {
+        mapConstantsFromWeightsDir(bundle, module, func.first);
+      } else {
+        bundle.collectConstants(module);
+      }
     }
+    acquireConstants(bundle);
     functions_.emplace(func.first, func.second);
   }
 
@@ -128,7 +212,7 @@ void CPUDeviceManager::evictNetworkImpl(std::string functionName,
 
   auto it = functions_.find(functionName);
   if (it != functions_.end()) {
-    usedMemoryBytes_ -= it->second->getRuntimeBundle().getConstantWeightSize();
+    usedMemoryBytes_ -= releaseConstants(it->second->getRuntimeBundle());
     functions_.erase(it);
   } else {
     evictCB(functionName,
@@ -74,6 +74,10 @@ protected:
 
 DeviceManager *createCPUDeviceManager(const DeviceConfig &config);
 
+/// \returns true if the CPU DeviceManagers memory-map the constants of the
+/// functions from the weights files of -cpu-weights-dir.
+bool isCPUWeightsDirSet();
+
 } // namespace runtime
 } // namespace glow
 
@@ -101,6 +101,23 @@ void CPULLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     auto *sizeGroupYVal = emitConstI32(builder, sizeGroupY);
     auto *depthStripsVal = emitConstI32(builder, depthStrips);
 
+    if (isParallelForEnabled()) {
+      // Split the output channels across the parallel-for callback in chunks
+      // of [float8 * numDepthRegs * depthStrips] channels of a single group.
+      auto outCperG = outChannels / CI->getGroup();
+      auto chunkSize = 8 * numDepthRegs * depthStrips;
+      dim_t numChunks =
+          CI->getGroup() * ((outCperG + chunkSize - 1) / chunkSize);
+      auto *F = getFunction("convDKKC8_range", dest->getElementType());
+      emitParallelCall(builder, F,
+                       {destPtr, srcPtr, filterPtr, biasPtr, destDims, srcDims,
+                        filterDims, biasDims, kernels, strides, pads, group,
+                        pixelScanFirstVal, numDepthRegsVal, sizeGroupYVal,
+                        depthStripsVal},
+                       numChunks);
+      break;
+    }
+
     const char *kernelName = "convDKKC8";
     auto *F = getFunction(kernelName, dest->getElementType());
 
@@ -111,6 +128,120 @@ void CPULLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
                 depthStripsVal});
     break;
   }
+  case Kinded::Kind::CPUFusedQuantizedConvInstKind: {
+    auto *CI = cast<CPUFusedQuantizedConvInst>(I);
+    auto *dest = CI->getDest();
+    auto *src = CI->getSrc();
+    auto *filter = CI->getFilter();
+    auto *bias = CI->getBias();
+    auto *mapping = CI->getMapping();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *srcPtr = emitValueAddress(builder, src);
+    auto *filterPtr = emitValueAddress(builder, filter);
+    auto *biasPtr = emitValueAddress(builder, bias);
+    auto *mappingPtr = emitValueAddress(builder, mapping);
+
+    auto *destDims = emitValueDims(builder, dest);
+    auto *srcDims = emitValueDims(builder, src);
+    auto *filterDims = emitValueDims(builder, filter);
+    auto *biasDims = emitValueDims(builder, bias);
+
+    auto *kernels = emitConstDimTArray(builder, CI->getKernels());
+    auto *strides = emitConstDimTArray(builder, CI->getStrides());
+    auto *pads = emitConstDimTArray(builder, CI->getPads());
+    auto *group = emitConstDimT(builder, CI->getGroup());
+    auto *dilation = emitConstDimT(builder, CI->getDilation());
+
+    // Process 8 output channels together when the groups allow it, as for the
+    // regular convolution.
+    unsigned unrollDFactor =
+        ((dest->dims()[3] / CI->getGroup()) % 8) == 0 ? 8 : 1;
+    auto *unrollD = emitConstI32(builder, unrollDFactor);
+
+    // The accumulator is requantized to the type of the mapping, which is
+    // indexed by the requantized values.
+    auto *preTy = mapping->getType();
+    auto *srcTy = src->getType();
+    auto *filterTy = filter->getType();
+    auto *biasTy = bias->getType();
+
+    auto *preOffset = emitConstI32(builder, preTy->getOffset());
+    auto *srcOffset = emitConstI32(builder, srcTy->getOffset());
+    auto *filterOffset = emitConstI32(builder, filterTy->getOffset());
+    auto *biasOffset = emitConstI32(builder, biasTy->getOffset());
+
+    float matMulScale = srcTy->getScale() * filterTy->getScale();
+    auto biasScaleParam = quantization::quantizeScaleOffset32To8(
+        biasTy->getScale() / matMulScale, biasTy->getOffset());
+    auto outScaleParam = quantization::quantizeScaleOffset32To8(
+        matMulScale / preTy->getScale(), 0);
+
+    auto *biasPre = emitConstI32(builder, biasScaleParam.pre);
+    auto *biasPost = emitConstI32(builder, biasScaleParam.post);
+    auto *biasScale = emitConstI32(builder, biasScaleParam.scale);
+    auto *outPre = emitConstI32(builder, outScaleParam.pre);
+    auto *outPost = emitConstI32(builder, outScaleParam.post);
+    auto *outScale = emitConstI32(builder, outScaleParam.scale);
+
+    auto *F = getFunction("conv2d_act",
+                          {dest->getElementType(), bias->getElementType()});
+    createCall(builder, F,
+               {destPtr, srcPtr, filterPtr, biasPtr, mappingPtr, destDims,
+                srcDims, filterDims, biasDims, kernels, strides, pads, group,
+                preOffset, srcOffset, filterOffset, biasOffset, biasPre,
+                biasPost, biasScale, outPre, outPost, outScale, unrollD,
+                dilation});
+    break;
+  }
+  case Kinded::Kind::CPUFusedQuantizedFCInstKind: {
+    auto *FI = cast<CPUFusedQuantizedFCInst>(I);
+    auto *dest = FI->getDest();
+    auto *src = FI->getSrc();
+    auto *weights = FI->getWeights();
+    auto *bias = FI->getBias();
+    auto *mapping = FI->getMapping();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *srcPtr = emitValueAddress(builder, src);
+    auto *weightsPtr = emitValueAddress(builder, weights);
+    auto *biasPtr = emitValueAddress(builder, bias);
+    auto *mappingPtr = emitValueAddress(builder, mapping);
+
+    auto *destDims = emitValueDims(builder, dest);
+    auto *srcDims = emitValueDims(builder, src);
+
+    // The accumulator is requantized to the type of the mapping, which is
+    // indexed by the requantized values.
+    auto *preTy = mapping->getType();
+    auto *srcTy = src->getType();
+    auto *weightsTy = weights->getType();
+    auto *biasTy = bias->getType();
+
+    auto *preOffset = emitConstI32(builder, preTy->getOffset());
+    auto *srcOffset = emitConstI32(builder, srcTy->getOffset());
+    auto *weightsOffset = emitConstI32(builder, weightsTy->getOffset());
+    auto *biasOffset = emitConstI32(builder, biasTy->getOffset());
+
+    float matMulScale = srcTy->getScale() * weightsTy->getScale();
+    auto biasScaleParam = quantization::quantizeScaleOffset32To8(
+        biasTy->getScale() / matMulScale, biasTy->getOffset());
+    auto outScaleParam = quantization::quantizeScaleOffset32To8(
+        matMulScale / preTy->getScale(), 0);
+
+    auto *biasPre = emitConstI32(builder, biasScaleParam.pre);
+    auto *biasPost = emitConstI32(builder, biasScaleParam.post);
+    auto *biasScale = emitConstI32(builder, biasScaleParam.scale);
+    auto *outPre = emitConstI32(builder, outScaleParam.pre);
+    auto *outPost = emitConstI32(builder, outScaleParam.post);
+    auto *outScale = emitConstI32(builder, outScaleParam.scale);
+
+    auto *F = getFunction("fc_act",
+                          {dest->getElementType(), bias->getElementType()});
+    createCall(builder, F,
+               {destPtr, srcPtr, weightsPtr, biasPtr, mappingPtr, destDims,
+                srcDims, preOffset, srcOffset, weightsOffset, biasOffset,
+                biasPre, biasPost, biasScale, outPre, outPost, outScale});
+    break;
+  }
   default:
     LLVMIRGen::generateLLVMIRForInstr(builder, I);
   }
@@ -33,4 +33,30 @@ void CPUConvDKKC8Inst::verify() const {
          "Invalid Element Type");
 }
 
+void CPUFusedQuantizedConvInst::verify() const {
+  assert(getSrc()->dims()[3] % getGroup() == 0 &&
+         "Input channels must be divisible by group.");
+  assert(getDest()->dims()[3] % getGroup() == 0 &&
+         "Output channels must be divisible by group.");
+  assert(getDest()->getElementType() == ElemKind::Int8QTy &&
+         getSrc()->getElementType() == ElemKind::Int8QTy &&
+         getFilter()->getElementType() == ElemKind::Int8QTy &&
+         "Invalid Element Type");
+  assert(getMapping()->getElementType() == ElemKind::Int8QTy &&
+         getMapping()->size() == 256 && "Invalid mapping");
+}
+
+void CPUFusedQuantizedFCInst::verify() const {
+  assert(getSrc()->dims()[1] == getWeights()->dims()[0] &&
+         "Mismatch on reduced dimension");
+  assert(getDest()->dims()[1] == getWeights()->dims()[1] &&
+         getDest()->dims()[1] == getBias()->dims()[0] && "Invalid shape");
+  assert(getDest()->getElementType() == ElemKind::Int8QTy &&
+         getSrc()->getElementType() == ElemKind::Int8QTy &&
+         getWeights()->getElementType() == ElemKind::Int8QTy &&
+         "Invalid Element Type");
+  assert(getMapping()->getElementType() == ElemKind::Int8QTy &&
+         getMapping()->size() == 256 && "Invalid mapping");
+}
+
 #endif // GLOW_WITH_CPU
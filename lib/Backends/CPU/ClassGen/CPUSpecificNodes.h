@@ -33,6 +33,34 @@ BB.newBackendSpecificNode("CPUConvDKKC8")
     .setDocstring("This is a cpu-specific convolution implementation where the "
                   "filter is transposed to the shape [D/8, K, K, C, 8]");
 
+BB.newBackendSpecificNode("CPUFusedQuantizedConv")
+    .addInput("Input")
+    .addInput("Filter")
+    .addInput("Bias")
+    .addInput("Mapping")
+    .addMember(MemberType::VectorUnsigned, "Kernels")
+    .addMember(MemberType::VectorUnsigned, "Strides")
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .addMember(MemberType::Unsigned, "Group")
+    .addMember(MemberType::Unsigned, "Dilation")
+    .addResultFromCtorArg()
+    .setDocstring("An int8 NHWC Convolution followed by element-wise "
+                  "activations and requantizations; CPU specific. The "
+                  "accumulator is requantized to the type of Mapping, which "
+                  "is then looked up in the 256 entries of Mapping.");
+
+BB.newBackendSpecificNode("CPUFusedQuantizedFC")
+    .addInput("Input")
+    .addInput("Weights")
+    .addInput("Bias")
+    .addInput("Mapping")
+    .addResultFromCtorArg()
+    .setDocstring("An int8 FullyConnected, with Weights of shape [K, N], "
+                  "followed by element-wise activations and "
+                  "requantizations; CPU specific. The accumulator is "
+                  "requantized to the type of Mapping, which is then looked "
+                  "up in the 256 entries of Mapping.");
+
 BB.includeBackendSpecificVerification("glow/CPUSpecificNodesVerification.h");
 
 #endif // GLOW_WITH_CPU
@@ -30,4 +30,62 @@ bool CPUConvDKKC8Node::verify() const {
   return expectCompareTrue("Invalid output dimensions", exp, odim, this);
 }
 
+/// Verify the Mapping of the fused quantized node \p N.
+static bool verifyFusedQuantizedMapping(NodeValue mapping, const Node *N) {
+  bool isValid = checkType(mapping, ElemKind::Int8QTy, N);
+  isValid &= expectCompareTrue("Mapping should have 256 entries",
+                               mapping.dims(), llvm::ArrayRef<dim_t>({256}),
+                               N);
+  return isValid;
+}
+
+bool CPUFusedQuantizedConvNode::verify() const {
+  ShapeNHWC idim(getInput().getType()->dims());
+  ShapeNHWC odim(getResult().getType()->dims());
+  auto outSz = calculateConvPoolOutputDims(idim.h, idim.w, getKernels(),
+                                           getStrides(), getPads(),
+                                           getDilation());
+  ShapeNHWC exp(idim.n, outSz.first, outSz.second, getBias().dims()[0]);
+  bool isValid =
+      expectCompareTrue("Invalid output dimensions", exp, odim, this);
+  isValid &= checkType(getInput(), ElemKind::Int8QTy, this);
+  isValid &= checkType(getFilter(), ElemKind::Int8QTy, this);
+  isValid &= checkType(getResult(), ElemKind::Int8QTy, this);
+  isValid &= checkType(getBias(),
+                       llvm::ArrayRef<ElemKind>({ElemKind::Int8QTy,
+                                                 ElemKind::Int32QTy}),
+                       this);
+  isValid &= verifyFusedQuantizedMapping(getMapping(), this);
+  return isValid;
+}
+
+bool CPUFusedQuantizedFCNode::verify() const {
+  auto idims = getInput().dims();
+  auto wdims = getWeights().dims();
+  auto odims = getResult().dims();
+  bool isValid = expectCompareTrue("Input should be 2D", idims.size(),
+                                   size_t(2), this);
+  isValid &= expectCompareTrue("Weights should be 2D", wdims.size(),
+                               size_t(2), this);
+  if (!isValid) {
+    return false;
+  }
+  isValid &= expectCompareTrue("Mismatch on reduced dimension", idims[1],
+                               wdims[0], this);
+  isValid &= expectCompareTrue("Invalid output dimensions", odims,
+                               llvm::ArrayRef<dim_t>({idims[0], wdims[1]}),
+                               this);
+  isValid &= expectCompareTrue("Invalid bias dimensions", getBias().dims(),
+                               llvm::ArrayRef<dim_t>({wdims[1]}), this);
+  isValid &= checkType(getInput(), ElemKind::Int8QTy, this);
+  isValid &= checkType(getWeights(), ElemKind::Int8QTy, this);
+  isValid &= checkType(getResult(), ElemKind::Int8QTy, this);
+  isValid &= checkType(getBias(),
+                       llvm::ArrayRef<ElemKind>({ElemKind::Int8QTy,
+                                                 ElemKind::Int32QTy}),
+                       this);
+  isValid &= verifyFusedQuantizedMapping(getMapping(), this);
+  return isValid;
+}
+
 #endif // GLOW_WITH_CPU
@@ -34,3 +34,22 @@ Error ONNXModelWriter::writeCPUConvDKKC8(const CPUConvDKKC8Node *node,
 
   return writeAllWithNode("CPUConvDKKC8", node, graph, proto);
 }
+
+Error ONNXModelWriter::writeCPUFusedQuantizedConv(
+    const CPUFusedQuantizedConvNode *node, GraphType &graph) {
+  auto *proto = graph.add_node();
+  // Add dictionary entries.
+  addValueAttribute(proto, "kernel_shape", node->getKernels());
+  addValueAttribute(proto, "strides", node->getStrides());
+  addValueAttribute(proto, "pads", node->getPads());
+  addValueAttribute(proto, "group", node->getGroup());
+  addValueAttribute(proto, "dilation", node->getDilation());
+
+  return writeAllWithNode("CPUFusedQuantizedConv", node, graph, proto);
+}
+
+Error ONNXModelWriter::writeCPUFusedQuantizedFC(
+    const CPUFusedQuantizedFCNode *node, GraphType &graph) {
+  auto *proto = graph.add_node();
+  return writeAllWithNode("CPUFusedQuantizedFC", node, graph, proto);
+}
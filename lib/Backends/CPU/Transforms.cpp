@@ -18,11 +18,35 @@
 
 #include "glow/Graph/Graph.h"
 #include "glow/Graph/Nodes.h"
+#include "glow/Optimizer/GraphOptimizer/FunctionPassPipeline.h"
+#include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
+#include "glow/Optimizer/GraphOptimizer/NodeSplitting.h"
+#include "glow/Quantization/Base/Base.h"
+#include "glow/Runtime/RuntimeTypes.h"
+
+#include "llvm/Support/CommandLine.h"
+
+#include <array>
 
 using namespace glow;
+using llvm::cast;
 using llvm::dyn_cast;
 using llvm::isa;
 
+static llvm::cl::opt<bool> cpuAutoSplitNodes(
+    "cpu-auto-split-nodes",
+    llvm::cl::desc("Split the Convolution, MatMul and Pool nodes after "
+                   "lowering such that the operands of each chunk fit in the "
+                   "cache of a core"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<unsigned> cpuAutoSplitCacheSize(
+    "cpu-auto-split-cache-size",
+    llvm::cl::desc("Size in kilobytes of the per-core cache in which the "
+                   "operands of the chunks are fitted by "
+                   "-cpu-auto-split-nodes"),
+    llvm::cl::init(1024));
+
 /// Try to optimize the regular Convolution into a target-specific convolution
 /// with a different filter memory layout. This optimization adds a new kind of
 /// cpu-specific convolution that operates on filter weight data in a
@@ -119,12 +143,261 @@ static Node *optimizeCPUMaxSplat(MaxNode *MN, Function *F) {
       new CPUMaxSplatNode(MN->getName(), input, splat->getValue()));
 }
 
+/// Lookup table over the 256 int8 values.
+using Int8LookupTable = std::array<int8_t, 256>;
+
+/// \returns the int8 value \p q of type \p from requantized to type \p to.
+static int8_t rescaleInt8(int8_t q, TypeRef from, TypeRef to) {
+  TensorQuantizationParams fromTQP{from->getScale(), from->getOffset()};
+  TensorQuantizationParams toTQP{to->getScale(), to->getOffset()};
+  return quantization::quantize(quantization::dequantize(q, fromTQP), toTQP);
+}
+
+/// \returns the value of the splat \p splat quantized to type \p T, rounded
+/// through the type of \p splat as it is when it is computed.
+static int8_t quantizeSplatValue(SplatNode *splat, TypeRef T) {
+  TypeRef splatTy = splat->getResult().getType();
+  TensorQuantizationParams TQP{T->getScale(), T->getOffset()};
+  if (!splatTy->isQuantizedType()) {
+    return quantization::quantize(splat->getValue(), TQP);
+  }
+  TensorQuantizationParams splatTQP{splatTy->getScale(), splatTy->getOffset()};
+  return rescaleInt8(quantization::quantize(splat->getValue(), splatTQP),
+                     splatTy, T);
+}
+
+/// If \p N is an int8 element-wise activation or requantization of \p input,
+/// apply it to the entries of \p lut, which are of type \p lutTy, and set
+/// \p lutTy to the result type of \p N. \returns false, leaving \p lut
+/// untouched, if \p N cannot be folded into a lookup table.
+static bool foldIntoLookupTable(Node *N, NodeValue input,
+                                Int8LookupTable &lut, TypeRef &lutTy) {
+  if (N->getNumResults() != 1 || N->hasPredicate()) {
+    return false;
+  }
+  TypeRef outTy = N->getNthResult(0).getType();
+  if (outTy->getElementType() != ElemKind::Int8QTy) {
+    return false;
+  }
+
+  // Bounds of the values of type outTy, applied after the requantization.
+  int lo = std::numeric_limits<int8_t>::min();
+  int hi = std::numeric_limits<int8_t>::max();
+  TensorQuantizationParams outTQP{outTy->getScale(), outTy->getOffset()};
+  switch (N->getKind()) {
+  case Kinded::Kind::MaxNodeKind:
+  case Kinded::Kind::MinNodeKind: {
+    NodeValue LHS = N->getNthInput(ArithmeticNode::LHSIdx);
+    NodeValue RHS = N->getNthInput(ArithmeticNode::RHSIdx);
+    auto *splat = dyn_cast<SplatNode>(LHS == input ? RHS : LHS);
+    if (!splat || (LHS != input && RHS != input)) {
+      return false;
+    }
+    int bound = quantizeSplatValue(splat, outTy);
+    (isa<MaxNode>(N) ? lo : hi) = bound;
+    break;
+  }
+  case Kinded::Kind::ReluNodeKind:
+    lo = quantization::quantize(0.f, outTQP);
+    break;
+  case Kinded::Kind::ClipNodeKind: {
+    auto *CN = cast<ClipNode>(N);
+    lo = quantization::quantize(CN->getMin(), outTQP);
+    hi = quantization::quantize(CN->getMax(), outTQP);
+    break;
+  }
+  case Kinded::Kind::RescaleQuantizedNodeKind:
+    break;
+  case Kinded::Kind::IntLookupTableNodeKind: {
+    auto *mapping =
+        dyn_cast<Constant>(cast<IntLookupTableNode>(N)->getMapping());
+    if (!mapping || mapping->getType()->size() != lut.size()) {
+      return false;
+    }
+    auto MH = mapping->getHandle<int8_t>();
+    for (auto &q : lut) {
+      q = MH.raw(q + 128);
+    }
+    lutTy = outTy;
+    return true;
+  }
+  default:
+    return false;
+  }
+
+  for (auto &q : lut) {
+    int v = rescaleInt8(q, lutTy, outTy);
+    q = std::max(lo, std::min(hi, v));
+  }
+  lutTy = outTy;
+  return true;
+}
+
+/// Fold the chain of int8 element-wise activations and requantizations
+/// computed from \p result into a lookup table, which is stored in a new
+/// Constant \p mapping. Note that \p mapping has the type of \p result, the
+/// pre-activation type to which the fused kernels requantize their
+/// accumulators before the lookup, while its entries are values of the type
+/// of the last folded node. \returns the last folded node, or nullptr if
+/// there is none.
+static Node *foldActivationChain(Function *F, NodeValue result,
+                                 Constant *&mapping) {
+  Int8LookupTable lut;
+  for (size_t i = 0; i < lut.size(); i++) {
+    lut[i] = int(i) - 128;
+  }
+  TypeRef lutTy = result.getType();
+  NodeValue cur = result;
+  Node *last = nullptr;
+  while (cur.hasOneUse()) {
+    Node *user = cur.getNode()->getUsers().front().getUser();
+    if (!foldIntoLookupTable(user, cur, lut, lutTy)) {
+      break;
+    }
+    last = user;
+    cur = user->getNthResult(0);
+  }
+  if (!last) {
+    return nullptr;
+  }
+
+  // The entries are in the type of last, but the kernels read the scale and
+  // offset of the pre-activation type from mapping.
+  TypeRef preTy = result.getType();
+  mapping = F->getParent()->createConstant(
+      ElemKind::Int8QTy, {(dim_t)lut.size()}, preTy->getScale(),
+      preTy->getOffset(), result.getNode()->getName().str() + ".mapping");
+  mapping->getHandle<int8_t>() = llvm::ArrayRef<int8_t>(lut);
+  return last;
+}
+
+/// \returns whether \p N is an int8 or int32 quantized bias.
+static bool isQuantizedBias(NodeValue N) {
+  return N.getElementType() == ElemKind::Int8QTy ||
+         N.getElementType() == ElemKind::Int32QTy;
+}
+
+/// Fuse the int8 Convolution \p CN and the activations and requantizations
+/// that follow it into a CPUFusedQuantizedConv node, which computes them in
+/// the epilogue of the convolution kernel instead of in separate passes over
+/// the result. \returns the node whose result was replaced, or nullptr.
+static Node *fuseQuantizedConvEpilogue(ConvolutionNode *CN, Function *F) {
+  if (CN->getLayout() != NHWC ||
+      CN->getFusedActivation() != FusedActivation::NONE ||
+      CN->hasPredicate() ||
+      CN->getInput().getElementType() != ElemKind::Int8QTy ||
+      CN->getFilter().getElementType() != ElemKind::Int8QTy ||
+      CN->getResult().getElementType() != ElemKind::Int8QTy ||
+      !isQuantizedBias(CN->getBias())) {
+    return nullptr;
+  }
+
+  Constant *mapping;
+  Node *last = foldActivationChain(F, CN->getResult(), mapping);
+  if (!last) {
+    return nullptr;
+  }
+  auto *FCN = F->addNode(new CPUFusedQuantizedConvNode(
+      CN->getName(), last->getNthResult(0).getType(), CN->getInput(),
+      CN->getFilter(), CN->getBias(), mapping, CN->getKernels(),
+      CN->getStrides(), CN->getPads(), CN->getGroup(), CN->getDilation()));
+  last->getNthResult(0).replaceAllUsesOfWith(FCN->getResult());
+  return last;
+}
+
+/// Fuse the int8 FullyConnected lowered into the MatMul and BatchedAdd
+/// \p BA, and the activations and requantizations that follow it, into a
+/// CPUFusedQuantizedFC node. Besides the activations this removes the
+/// intermediate rounding of the MatMul result. \returns the node whose
+/// result was replaced, or nullptr.
+static Node *fuseQuantizedFCEpilogue(BatchedAddNode *BA, Function *F) {
+  auto *MM = dyn_cast<MatMulNode>(BA->getBatch());
+  if (!MM || !MM->getResult().hasOneUse() || MM->hasPredicate() ||
+      BA->hasPredicate() ||
+      MM->getLHS().getElementType() != ElemKind::Int8QTy ||
+      MM->getRHS().getElementType() != ElemKind::Int8QTy ||
+      BA->getResult().getElementType() != ElemKind::Int8QTy ||
+      BA->getSlice().dims().size() != 1 || !isQuantizedBias(BA->getSlice())) {
+    return nullptr;
+  }
+
+  Constant *mapping;
+  Node *last = foldActivationChain(F, BA->getResult(), mapping);
+  if (!last) {
+    return nullptr;
+  }
+  auto *FFC = F->addNode(new CPUFusedQuantizedFCNode(
+      BA->getName(), last->getNthResult(0).getType(), MM->getLHS(),
+      MM->getRHS(), BA->getSlice(), mapping));
+  last->getNthResult(0).replaceAllUsesOfWith(FFC->getResult());
+  return last;
+}
+
+/// Fuse the activations and requantizations following the int8 Convolutions
+/// and FullyConnecteds of \p F into the epilogue of their kernels. \returns
+/// true if any node was fused.
+static bool fuseQuantizedEpilogues(Function *F, CompilationContext &cctx) {
+  bool changed = false;
+  for (auto &node : F->getNodes()) {
+    if (auto *CN = dyn_cast<ConvolutionNode>(&node)) {
+      changed |= fuseQuantizedConvEpilogue(CN, F) != nullptr;
+    } else if (auto *BA = dyn_cast<BatchedAddNode>(&node)) {
+      changed |= fuseQuantizedFCEpilogue(BA, F) != nullptr;
+    }
+  }
+  // Remove the fused nodes, so that they are not optimized further.
+  if (changed) {
+    runDCEPass(F, cctx);
+  }
+  return changed;
+}
+
+/// Split the heavy nodes of \p F such that the operands of each chunk fit in
+/// the cache of a core. \returns true if any node was split.
+static Expected<bool> autoSplitCPUNodes(Function *F) {
+  SplitNodeCostModel costModel;
+  // The SRAM capacity in the device info of the CPU is its memory, not the
+  // cache of a core.
+  costModel.cacheCapacity = uint64_t(cpuAutoSplitCacheSize) * 1024;
+
+  SplitNodeMap splitMap;
+  ASSIGN_VALUE_OR_RETURN_ERR(splitMap, splitNodesAuto(F, costModel));
+  for (const auto &split : splitMap) {
+    if (!split.second.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::unique_ptr<FunctionPassPipeline>
+CPUBackend::getOptimizationPipeline() const {
+  auto pipeline = LLVMBackend::getOptimizationPipeline();
+  // Disable MergeMatMul when splitting the nodes, as it would merge the chunks
+  // of the split MatMuls back together after lowering.
+  if (cpuAutoSplitNodes) {
+    pipeline->removeAllInstancesOfPass(FunctionPassID::MergeMatMul);
+  }
+  return pipeline;
+}
+
 Expected<bool>
-CPUBackend::transformPostLowering(Function *F, CompilationContext &,
-                                  const glow::runtime::DeviceInfo *) const {
+CPUBackend::transformPostLowering(
+    Function *F, CompilationContext &cctx,
+    const glow::runtime::DeviceInfo *devInfo) const {
   LOG_SCOPE(F->getLogContext(), "CPUBackend::transformPostLowering")
 
   bool changed = false;
+  // Split the nodes before they are replaced by CPU specific nodes, which the
+  // node splitting does not know about.
+  if (cpuAutoSplitNodes) {
+    ASSIGN_VALUE_OR_RETURN_ERR(changed, autoSplitCPUNodes(F));
+  }
+  // Fuse the activations following quantized Convolutions and
+  // FullyConnecteds before the Max nodes are replaced by CPUMaxSplat below.
+  if (cctx.optimizationOpts.enableQuantizedEpilogueFusion) {
+    changed |= fuseQuantizedEpilogues(F, cctx);
+  }
   for (auto &node : F->getNodes()) {
     // Try to replace generic convolution with cpu-optimized version.
     if (auto *CN = dyn_cast<ConvolutionNode>(&node)) {
@@ -145,5 +418,17 @@ CPUBackend::transformPostLowering(Function *F, CompilationContext &,
     }
   }
 
+  // Compute the SLWS nodes of sibling tables with a single kernel.
+  if (cctx.optimizationOpts.enableSLSGrouping) {
+    changed |= groupFusedRowwiseQuantizedSLWS(
+        F, cctx.optimizationOpts.slsGroupingMaxBytes);
+  }
+
+  // Store the weights of sparse FullyConnecteds in block-CSR format.
+  if (cctx.optimizationOpts.enableBlockSparseFC) {
+    changed |= sparsifyFullyConnected(
+        F, cctx.optimizationOpts.blockSparseFCMinSparsity);
+  }
+
   return changed;
 }
@@ -1137,6 +1137,47 @@ static void libjit_fused_rowwise_quantized_sparse_lengths_weighted_sum_generic(
   }
 }
 
+/// Computes the FusedRowwiseQuantizedSparseLengthsWeightedSum of the tables
+/// [\p tableBegin, \p tableEnd) of a grouped SLWS. The rows of table t start
+/// at row \p tableOffsets[t] of \p data and its \p segmentsPerTable segments
+/// follow the segments of the previous tables in \p lengths and \p dest.
+template <typename T, typename T2>
+static void
+libjit_grouped_fused_rowwise_quantized_sparse_lengths_weighted_sum_generic(
+    T *dest, int8_t *data, T *weights, T2 *indices, int32_t *lengths,
+    int64_t *tableOffsets, dim_t segmentsPerTable, dim_t inLineSize,
+    dim_t outLineSize, dim_t tableBegin, dim_t tableEnd) {
+  dim_t segBegin = tableBegin * segmentsPerTable;
+  dim_t curIndex = 0;
+  for (dim_t i = 0; i < segBegin; i++) {
+    curIndex += lengths[i];
+  }
+  for (dim_t t = tableBegin; t < tableEnd; t++) {
+    int8_t *tableData = data + tableOffsets[t] * inLineSize;
+    dim_t segEnd = segBegin + segmentsPerTable;
+    memset(dest + segBegin * outLineSize, 0,
+           segmentsPerTable * outLineSize * sizeof(float));
+    for (dim_t i = segBegin; i < segEnd; i++) {
+      for (int32_t j = 0, e = lengths[i]; j < e; j++) {
+        const float weight = weights[curIndex];
+        const dim_t line = indices[curIndex];
+        const int8_t *currRowScaleOffsetPtr =
+            tableData + ((line + 1) * inLineSize) - 2 * sizeof(float);
+        float scale, offset;
+        memcpy(&scale, currRowScaleOffsetPtr, sizeof(float));
+        memcpy(&offset, currRowScaleOffsetPtr + sizeof(float), sizeof(float));
+        for (dim_t k = 0; k < outLineSize; k++) {
+          const float fData =
+              (scale * (uint8_t)(tableData[line * inLineSize + k])) + offset;
+          dest[i * outLineSize + k] += weight * fData;
+        }
+        curIndex++;
+      }
+    }
+    segBegin = segEnd;
+  }
+}
+
 template <typename T, typename T2>
 static void libjit_sparse_to_dense_generic(T *dest, const T2 *indices,
                                            const T *values, dim_t numIndices,
@@ -2145,6 +2186,24 @@ void libjit_fused_rowwise_quantized_sparse_lengths_weighted_sum_f(
   }
 }
 
+void libjit_grouped_fused_rowwise_quantized_sparse_lengths_weighted_sum_f_u(
+    float *dest, int8_t *data, float *weights, size_t *indices,
+    int32_t *lengths, int64_t *tableOffsets, dim_t segmentsPerTable,
+    dim_t inLineSize, dim_t outLineSize, dim_t tableBegin, dim_t tableEnd) {
+  libjit_grouped_fused_rowwise_quantized_sparse_lengths_weighted_sum_generic(
+      dest, data, weights, indices, lengths, tableOffsets, segmentsPerTable,
+      inLineSize, outLineSize, tableBegin, tableEnd);
+}
+
+void libjit_grouped_fused_rowwise_quantized_sparse_lengths_weighted_sum_f_i32(
+    float *dest, int8_t *data, float *weights, int32_t *indices,
+    int32_t *lengths, int64_t *tableOffsets, dim_t segmentsPerTable,
+    dim_t inLineSize, dim_t outLineSize, dim_t tableBegin, dim_t tableEnd) {
+  libjit_grouped_fused_rowwise_quantized_sparse_lengths_weighted_sum_generic(
+      dest, data, weights, indices, lengths, tableOffsets, segmentsPerTable,
+      inLineSize, outLineSize, tableBegin, tableEnd);
+}
+
 void libjit_embedding_bag_byte_rowwise_offsets_f(
     float *dest, int8_t *data, float *weights, size_t *indices, size_t *offsets,
     dim_t segments, dim_t numIndices, dim_t inLineSize, dim_t outLineSize,
@@ -2657,6 +2716,90 @@ void libjit_softmax_grad_f_u(float *inG, float *outW, const size_t *selectedW,
   libjit_softmax_grad_generic(inG, outW, selectedW, idim, selectdim);
 }
 
+/// Computes the rows [\p begin, \p end) of the scaled dot-product attention
+/// \p dest = SoftMax(\p queries x \p keys^T * \p scale + \p mask) x
+/// \p values, where the rows of all batches are numbered consecutively. The
+/// mask has \p maskQueryLen rows per batch, i.e. 1 if it is broadcast over the
+/// queries. The keys are processed in blocks, which are reused by a tile of
+/// query rows while they are in the cache. The SoftMax is computed online:
+/// the rows of \p dest accumulate the values weighted by exp(score - max)
+/// with the largest score seen so far, and are rescaled whenever it grows, so
+/// that the matrix of the scores is never materialized. The rows whose keys
+/// are all masked out by -infinity are NaN.
+void libjit_scaled_dot_product_attention_f(
+    float *dest, const float *queries, const float *keys, const float *values,
+    const float *mask, dim_t queryLen, dim_t keyLen, dim_t headDim,
+    dim_t valueDim, dim_t maskQueryLen, float scale, dim_t begin, dim_t end) {
+  constexpr dim_t queryTile = 8;
+  constexpr dim_t keyTile = 64;
+  float scores[keyTile];
+  float maxScore[queryTile];
+  float sumExp[queryTile];
+  for (dim_t row = begin; row < end;) {
+    // The tile of query rows stays within a batch.
+    const dim_t b = row / queryLen;
+    const dim_t q = row % queryLen;
+    const dim_t numRows = MIN(queryTile, MIN(end - row, queryLen - q));
+    const float *Q = queries + row * headDim;
+    const float *K = keys + b * keyLen * headDim;
+    const float *V = values + b * keyLen * valueDim;
+    float *D = dest + row * valueDim;
+    for (dim_t i = 0; i < numRows; i++) {
+      maxScore[i] = -INFINITY;
+      sumExp[i] = 0;
+    }
+    memset(D, 0, numRows * valueDim * sizeof(float));
+
+    for (dim_t k = 0; k < keyLen; k += keyTile) {
+      const dim_t numKeys = MIN(keyTile, keyLen - k);
+      for (dim_t i = 0; i < numRows; i++) {
+        const dim_t maskRow = maskQueryLen == 1 ? b : b * queryLen + q + i;
+        const float *M = mask + maskRow * keyLen + k;
+        float blockMax = -INFINITY;
+        for (dim_t j = 0; j < numKeys; j++) {
+          float sum = 0;
+          for (dim_t d = 0; d < headDim; d++) {
+            sum += Q[i * headDim + d] * K[(k + j) * headDim + d];
+          }
+          scores[j] = sum * scale + M[j];
+          blockMax = MAX(blockMax, scores[j]);
+        }
+        // All the keys so far are masked out.
+        const float newMax = MAX(maxScore[i], blockMax);
+        if (newMax == -INFINITY) {
+          continue;
+        }
+        // Rescale what was accumulated with the previous maximum.
+        const float correction = expf(maxScore[i] - newMax);
+        float *Drow = D + i * valueDim;
+        sumExp[i] *= correction;
+        for (dim_t v = 0; v < valueDim; v++) {
+          Drow[v] *= correction;
+        }
+        for (dim_t j = 0; j < numKeys; j++) {
+          const float p = expf(scores[j] - newMax);
+          const float *Vrow = V + (k + j) * valueDim;
+          sumExp[i] += p;
+          for (dim_t v = 0; v < valueDim; v++) {
+            Drow[v] += p * Vrow[v];
+          }
+        }
+        maxScore[i] = newMax;
+      }
+    }
+
+    // Normalize the rows. Like the SoftMax of the scores, the rows whose keys
+    // are all masked out are NaN.
+    for (dim_t i = 0; i < numRows; i++) {
+      const float inv = sumExp[i] > 0 ? 1 / sumExp[i] : NAN;
+      for (dim_t v = 0; v < valueDim; v++) {
+        D[i * valueDim + v] *= inv;
+      }
+    }
+    row += numRows;
+  }
+}
+
 void libjit_softmax_grad_f_i32(float *inG, float *outW,
                                const int32_t *selectedW, const dim_t *idim,
                                const dim_t *selectdim) {
@@ -3339,4 +3482,28 @@ void libjit_mfcc_f(void *scratch, float *coefficients, const float *spectrogram,
     spectrogram += winSize;
   }
 }
+
+/// Task invoked by a parallel-for callback for the iterations [begin, end).
+typedef void (*libjit_parallel_task)(void *taskCtx, uint64_t begin,
+                                     uint64_t end);
+
+/// Parallel-for callback registered by the client of a bundle. It must invoke
+/// the task for non-overlapping ranges covering [0, numIters) and return once
+/// all of them have completed.
+typedef void (*libjit_parallel_for_fn)(void *threadPool, uint64_t numIters,
+                                       libjit_parallel_task task,
+                                       void *taskCtx);
+
+/// Run the \p task with the context \p taskCtx over \p numIters iterations
+/// using the client callback \p parallelFor and its \p threadPool. If no
+/// callback is registered the whole range is processed by the calling thread.
+void libjit_parallel_for(void *parallelFor, void *threadPool,
+                         uint64_t numIters, void *task, void *taskCtx) {
+  auto taskFn = (libjit_parallel_task)task;
+  if (!parallelFor || numIters < 2) {
+    taskFn(taskCtx, 0, numIters);
+    return;
+  }
+  ((libjit_parallel_for_fn)parallelFor)(threadPool, numIters, taskFn, taskCtx);
+}
 } // extern "C"
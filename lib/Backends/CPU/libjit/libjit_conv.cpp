@@ -25,16 +25,18 @@
 #include "libjit_defs.h"
 
 namespace {
-// Initialize the convolution output frame for slice \p N with the bias \p
-// biasW.
-void libjit_conv_init_output_with_bias(dim_t N, float *outW, const float *biasW,
-                                       const dim_t *outWdims,
-                                       const dim_t *biasWdims) {
+// Initialize the output channels [\p startD, \p endD) of the convolution
+// output frame for slice \p N with the bias \p biasW.
+void libjit_conv_init_output_with_bias_range(dim_t N, float *outW,
+                                             const float *biasW,
+                                             const dim_t *outWdims,
+                                             const dim_t *biasWdims,
+                                             dim_t startD, dim_t endD) {
   // For each (x,y) step in the output tensor:
   for (dim_t ax = 0; ax < outWdims[1]; ax++) {
     for (dim_t ay = 0; ay < outWdims[2]; ay++) {
-      // For each output channel:
-      for (dim_t d = 0; d < outWdims[3]; d++) {
+      // For each output channel in the range:
+      for (dim_t d = startD; d < endD; d++) {
         // Store the results to the output buffer.
         float bias = biasW[d];
         auto outIdx = libjit_getXYZW(outWdims, N, ax, ay, d);
@@ -44,6 +46,15 @@ void libjit_conv_init_output_with_bias(dim_t N, float *outW, const float *biasW,
   }     // For each X in the output.
 }
 
+// Initialize the convolution output frame for slice \p N with the bias \p
+// biasW.
+void libjit_conv_init_output_with_bias(dim_t N, float *outW, const float *biasW,
+                                       const dim_t *outWdims,
+                                       const dim_t *biasWdims) {
+  libjit_conv_init_output_with_bias_range(N, outW, biasW, outWdims, biasWdims,
+                                          0, outWdims[3]);
+}
+
 /// Perform the heart of the convolution. Load \p ywidth scalars in a specific
 /// channel, broadcast them, and multiply them with
 /// [ywidth * float8 * numDepthRegs] depth values and accumulate them to create
@@ -251,7 +262,9 @@ void libjit_convDKKC8_foreach_xy_pixels_filter(
 }
 
 /// Generic template for quantized conv2d. The template allows choosing
-/// element type and bias type.
+/// element type and bias type. If \p mapping is not null, the requantized
+/// results are looked up in the 256 entries of \p mapping, which computes the
+/// activations fused into the convolution.
 template <typename ElemTy, typename BiasElemTy>
 void libjit_quantized_conv2d_generic(
     ElemTy *outW, const ElemTy *inW, const ElemTy *filterW,
@@ -260,7 +273,8 @@ void libjit_quantized_conv2d_generic(
     const dim_t *strides, const dim_t *pads, dim_t group, int32_t outOffset,
     int32_t inOffset, int32_t filterOffset, int32_t biasOffset, int32_t biasPre,
     int32_t biasPost, int32_t biasScale, int32_t outPre, int32_t outPost,
-    int32_t outScale, unsigned depthUnroll, dim_t dilation) {
+    int32_t outScale, unsigned depthUnroll, dim_t dilation,
+    const int8_t *mapping) {
   dim_t inChannels = inWdims[3];
   dim_t outChannels = outWdims[3];
   dim_t inCperG = inChannels / group;
@@ -339,8 +353,11 @@ void libjit_quantized_conv2d_generic(
               // Scale the result back to the expected destination scale.
               int32_t scaledSum = libjit_scale_i32i8(sum[i], outPre, outPost,
                                                      outScale, outOffset);
-              outW[libjit_getXYZW(outWdims, n, ax, ay, d + i)] =
-                  libjit_clip(scaledSum);
+              int8_t result = libjit_clip(scaledSum);
+              if (mapping) {
+                result = mapping[(int32_t)result + 128];
+              }
+              outW[libjit_getXYZW(outWdims, n, ax, ay, d + i)] = result;
             }
           } // W
         }   // H
@@ -547,17 +564,25 @@ void libjit_channelwise_quantized_conv3d_generic(
 } // namespace
 
 extern "C" {
-void libjit_convDKKC8_f(float *outW, const float *inW, const float *filterW,
-                        const float *biasW, const dim_t *outWdims,
-                        const dim_t *inWdims, const dim_t *filterWdims,
-                        const dim_t *biasWdims, const dim_t *kernelSizes,
-                        const dim_t *strides, const dim_t *pads, dim_t group,
-                        unsigned pixelScanFirst, unsigned numDepthRegs,
-                        unsigned sizeGroupY, unsigned depthStrips) {
+/// Perform the DKKC8 convolution only for the chunks [\p startChunk, \p
+/// endChunk) of output channels. A chunk consists of [numDepthRegs x float8 x
+/// depthStrips] output channels of a single group, so that disjoint chunk
+/// ranges can be processed by different threads.
+void libjit_convDKKC8_range_f(
+    float *outW, const float *inW, const float *filterW, const float *biasW,
+    const dim_t *outWdims, const dim_t *inWdims, const dim_t *filterWdims,
+    const dim_t *biasWdims, const dim_t *kernelSizes, const dim_t *strides,
+    const dim_t *pads, dim_t group, unsigned pixelScanFirst,
+    unsigned numDepthRegs, unsigned sizeGroupY, unsigned depthStrips,
+    dim_t startChunk, dim_t endChunk) {
   dim_t inChannels = inWdims[3];
   dim_t outChannels = outWdims[3];
   dim_t inCperG = inChannels / group;
   dim_t outCperG = outChannels / group;
+  // Each chunk covers [numDepthRegs x float8 x depthStrips] output channels of
+  // a single group.
+  dim_t chunkSize = 8 * numDepthRegs * depthStrips;
+  dim_t chunksPerG = (outCperG + chunkSize - 1) / chunkSize;
 
   // Select the order in which we iterate over the pixels in the picture.
   auto eachPixelConv =
@@ -567,28 +592,41 @@ void libjit_convDKKC8_f(float *outW, const float *inW, const float *filterW,
   // For each input in the batch:
   for (dim_t n = 0; n < inWdims[0]; n++) {
 
-    // Initialize the output frame for the N'th slice with the bias.
-    // Later we will accumulate values into this slice.
-    libjit_conv_init_output_with_bias(n, outW, biasW, outWdims, biasWdims);
+    // For each chunk of output channels in the range:
+    for (dim_t chunk = startChunk; chunk < endChunk; chunk++) {
+      dim_t g = chunk / chunksPerG;
+      dim_t endChannelIndex = (g + 1) * outCperG;
+      dim_t d = g * outCperG + (chunk % chunksPerG) * chunkSize;
 
-    // For each group of input channels:
-    for (dim_t g = 0; g < group; g++) {
+      // Initialize the output channels of the chunk with the bias. Later we
+      // will accumulate values into them.
+      libjit_conv_init_output_with_bias_range(
+          n, outW, biasW, outWdims, biasWdims, d,
+          MIN(d + chunkSize, endChannelIndex));
 
-      // For each output channel, process [numDepthRegs x float8] elements.
-      dim_t startChannelIndex = g * outCperG;
-      dim_t endChannelIndex = (g + 1) * outCperG;
-      for (dim_t d = startChannelIndex; d < endChannelIndex;
-           d += 8 * numDepthRegs * depthStrips) {
-
-        // Perform the convolution for each pixel.
-        eachPixelConv(n, d, numDepthRegs, depthStrips, sizeGroupY, inCperG,
-                      outW, inW, filterW, biasW, outWdims, inWdims, filterWdims,
-                      biasWdims, kernelSizes, strides, pads, g,
-                      endChannelIndex);
-
-      } // For each D (the depth, or the output channel).
-    }   // for each G, the group
-  }     // For each N, the sample in the batch.
+      // Perform the convolution for each pixel.
+      eachPixelConv(n, d, numDepthRegs, depthStrips, sizeGroupY, inCperG,
+                    outW, inW, filterW, biasW, outWdims, inWdims, filterWdims,
+                    biasWdims, kernelSizes, strides, pads, g, endChannelIndex);
+
+    } // For each chunk of D (the depth, or the output channel).
+  }   // For each N, the sample in the batch.
+}
+
+void libjit_convDKKC8_f(float *outW, const float *inW, const float *filterW,
+                        const float *biasW, const dim_t *outWdims,
+                        const dim_t *inWdims, const dim_t *filterWdims,
+                        const dim_t *biasWdims, const dim_t *kernelSizes,
+                        const dim_t *strides, const dim_t *pads, dim_t group,
+                        unsigned pixelScanFirst, unsigned numDepthRegs,
+                        unsigned sizeGroupY, unsigned depthStrips) {
+  dim_t outCperG = outWdims[3] / group;
+  dim_t chunkSize = 8 * numDepthRegs * depthStrips;
+  dim_t numChunks = group * ((outCperG + chunkSize - 1) / chunkSize);
+  libjit_convDKKC8_range_f(outW, inW, filterW, biasW, outWdims, inWdims,
+                           filterWdims, biasWdims, kernelSizes, strides, pads,
+                           group, pixelScanFirst, numDepthRegs, sizeGroupY,
+                           depthStrips, 0, numChunks);
 }
 
 void libjit_conv2d_f(float *outW, const float *inW, const float *filterW,
@@ -721,7 +759,7 @@ void libjit_conv2d_i8_i32(
       outW, inW, filterW, biasW, outWdims, inWdims, filterWdims, biasWdims,
       kernelSizes, strides, pads, group, outOffset, inOffset, filterOffset,
       biasOffset, biasPre, biasPost, biasScale, outPre, outPost, outScale,
-      depthUnroll, dilation);
+      depthUnroll, dilation, nullptr);
 }
 
 void libjit_conv2d_i8_i8(int8_t *outW, const int8_t *inW, const int8_t *filterW,
@@ -738,7 +776,42 @@ void libjit_conv2d_i8_i8(int8_t *outW, const int8_t *inW, const int8_t *filterW,
       outW, inW, filterW, biasW, outWdims, inWdims, filterWdims, biasWdims,
       kernelSizes, strides, pads, group, outOffset, inOffset, filterOffset,
       biasOffset, biasPre, biasPost, biasScale, outPre, outPost, outScale,
-      depthUnroll, dilation);
+      depthUnroll, dilation, nullptr);
+}
+
+/// Quantized conv2d whose activations are fused into the lookup table
+/// \p mapping, which is indexed by the results requantized with \p outOffset
+/// and \p outPre, \p outPost and \p outScale.
+void libjit_conv2d_act_i8_i32(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW,
+    const int32_t *biasW, const int8_t *mapping, const dim_t *outWdims,
+    const dim_t *inWdims, const dim_t *filterWdims, const dim_t *biasWdims,
+    const dim_t *kernelSizes, const dim_t *strides, const dim_t *pads,
+    dim_t group, int32_t outOffset, int32_t inOffset, int32_t filterOffset,
+    int32_t biasOffset, int32_t biasPre, int32_t biasPost, int32_t biasScale,
+    int32_t outPre, int32_t outPost, int32_t outScale, unsigned depthUnroll,
+    dim_t dilation) {
+  libjit_quantized_conv2d_generic<int8_t, int32_t>(
+      outW, inW, filterW, biasW, outWdims, inWdims, filterWdims, biasWdims,
+      kernelSizes, strides, pads, group, outOffset, inOffset, filterOffset,
+      biasOffset, biasPre, biasPost, biasScale, outPre, outPost, outScale,
+      depthUnroll, dilation, mapping);
+}
+
+void libjit_conv2d_act_i8_i8(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW,
+    const int8_t *biasW, const int8_t *mapping, const dim_t *outWdims,
+    const dim_t *inWdims, const dim_t *filterWdims, const dim_t *biasWdims,
+    const dim_t *kernelSizes, const dim_t *strides, const dim_t *pads,
+    dim_t group, int32_t outOffset, int32_t inOffset, int32_t filterOffset,
+    int32_t biasOffset, int32_t biasPre, int32_t biasPost, int32_t biasScale,
+    int32_t outPre, int32_t outPost, int32_t outScale, unsigned depthUnroll,
+    dim_t dilation) {
+  libjit_quantized_conv2d_generic<int8_t, int8_t>(
+      outW, inW, filterW, biasW, outWdims, inWdims, filterWdims, biasWdims,
+      kernelSizes, strides, pads, group, outOffset, inOffset, filterOffset,
+      biasOffset, biasPre, biasPost, biasScale, outPre, outPost, outScale,
+      depthUnroll, dilation, mapping);
 }
 
 void libjit_channelwise_quantized_conv2d_i8_i32(
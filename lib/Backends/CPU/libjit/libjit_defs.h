@@ -109,15 +109,25 @@ inline int8_t libjit_clip(int32_t val) {
   return (int8_t)MIN(MAX(val, -128), 127);
 }
 
-/// Scales a 32-bit integer using the integer shift-mult-shift method.
-/// See QuantizationTransform32To8 for more details.
-inline int32_t libjit_scale_i32i8(int32_t input, int32_t pre, int32_t post,
-                                  int32_t scale, int32_t offset) {
-  // The operation x >> post is rounded down to negative infinity. To get to
-  // round-nearest we add (1 << (post - 1)) to the value prior to shifting.
-  // Rounding is performed only when shifting right (pos > 0).
-  int rtn = (post > 0) ? (1 << (post - 1)) : 0;
+/// \returns the rounding term added by the shift-mult-shift rescale before
+/// shifting right by \p post. The operation x >> post is rounded down to
+/// negative infinity. To get to round-nearest we add (1 << (post - 1)) to the
+/// value prior to shifting. Rounding is performed only when shifting right
+/// (post > 0).
+inline int32_t libjit_scale_rtn(int32_t post) {
+  return (post > 0) ? (1 << (post - 1)) : 0;
+}
 
+/// Scales a 32-bit integer using the integer shift-mult-shift method with the
+/// rounding term \p rtn computed by libjit_scale_rtn. Unlike
+/// libjit_scale_i32i8, this is branch-free: it consists of two arithmetic
+/// shifts, a 32-bit multiplication and additions only, which map one-to-one
+/// onto SIMD instructions. The vectorized quantized kernels emitted by
+/// LLVMIRGen follow exactly this sequence, so that their results are
+/// bit-identical to the scalar kernels.
+inline int32_t libjit_scale_i32i8_r(int32_t input, int32_t pre, int32_t post,
+                                    int32_t scale, int32_t rtn,
+                                    int32_t offset) {
   // NOTICE: If your tests are failing because of signed integer overflow then
   // this is a bug in the test and not in the program. You should make sure that
   // the inputs to the operations do not overflow. The semantics of the
@@ -127,6 +137,14 @@ inline int32_t libjit_scale_i32i8(int32_t input, int32_t pre, int32_t post,
   return ((((input >> pre) * scale) + rtn) >> post) + offset;
 }
 
+/// Scales a 32-bit integer using the integer shift-mult-shift method.
+/// See QuantizationTransform32To8 for more details.
+inline int32_t libjit_scale_i32i8(int32_t input, int32_t pre, int32_t post,
+                                  int32_t scale, int32_t offset) {
+  return libjit_scale_i32i8_r(input, pre, post, scale, libjit_scale_rtn(post),
+                              offset);
+}
+
 #ifdef _WIN32
 #define libjit_aligned_malloc(p, a, s)                                         \
   (((*(p)) = _aligned_malloc((s), (a))), *(p) ? 0 : errno)
@@ -284,6 +284,60 @@ void libjit_rowwise_quantized_fc_generic(
     }
   }
 }
+
+/// Number of output columns computed together by the fused quantized
+/// FullyConnected, whose int32 accumulators stay in registers.
+constexpr dim_t fusedFCBlockCols = 64;
+
+/// Generic template for quantized FullyConnected with fused activations. The
+/// template allows choosing the bias type. \p weightsW is not transposed, i.e.
+/// out = in * weights + bias. The accumulators of a block of columns of a row
+/// are initialized with the scaled bias, updated with the whole reduction
+/// dimension, requantized with \p outOffset, \p outPre, \p outPost and
+/// \p outScale and looked up in \p mapping, which computes the activations.
+template <typename BiasElemTy>
+void libjit_fc_act_generic(int8_t *outW, const int8_t *inW,
+                           const int8_t *weightsW, const BiasElemTy *biasW,
+                           const int8_t *mapping, const dim_t *outWdims,
+                           const dim_t *inWdims, int32_t outOffset,
+                           int32_t inOffset, int32_t weightsOffset,
+                           int32_t biasOffset, int32_t biasPre,
+                           int32_t biasPost, int32_t biasScale, int32_t outPre,
+                           int32_t outPost, int32_t outScale) {
+  dim_t in_w = inWdims[1];
+  dim_t out_h = outWdims[0];
+  dim_t out_w = outWdims[1];
+  int32_t sum[fusedFCBlockCols];
+  for (dim_t j0 = 0; j0 < out_w; j0 += fusedFCBlockCols) {
+    dim_t numCols = MIN(fusedFCBlockCols, out_w - j0);
+    for (dim_t i = 0; i < out_h; i++) {
+      for (dim_t j = 0; j < numCols; j++) {
+        // Scale the bias to match the scale of the matrix multiplication.
+        sum[j] = libjit_scale_i32i8((int32_t)biasW[j0 + j] - biasOffset,
+                                    biasPre, biasPost, biasScale, 0);
+      }
+      const int8_t *inRow = inW + i * in_w;
+      for (dim_t k = 0; k < in_w; k++) {
+        int32_t in = (int32_t)inRow[k] - inOffset;
+        const int8_t *weightsRow = weightsW + k * out_w + j0;
+        for (dim_t j = 0; j < numCols; j++) {
+          sum[j] += ((int32_t)weightsRow[j] - weightsOffset) * in;
+        }
+      }
+      int8_t *outRow = outW + i * out_w + j0;
+      for (dim_t j = 0; j < numCols; j++) {
+        int32_t scaledSum =
+            libjit_scale_i32i8(sum[j], outPre, outPost, outScale, outOffset);
+        outRow[j] = mapping[(int32_t)libjit_clip(scaledSum) + 128];
+      }
+    }
+  }
+}
+
+/// Number of rows of the input of the block-sparse FullyConnected processed
+/// together, so that each non-zero block is read from memory once for all of
+/// them.
+constexpr dim_t blockSparseFCTileRows = 4;
 } // namespace
 
 extern "C" {
@@ -339,6 +393,87 @@ void libjit_matmul_i8(int8_t *outW, const int8_t *lhsW, const int8_t *rhsW,
   }
 }
 
+/// Float FullyConnected whose weights of shape [K, N] are stored in block-CSR
+/// format: \p values holds the non-zero blocks of \p blockRows x
+/// \p blockCols, \p colIndices the block column of each of them and
+/// \p rowOffsets the index of the first block of each block row. Only the
+/// rows [\p begin, \p end) of \p inW are processed. The columns of the
+/// blocks are accumulated in float8 registers when they are a multiple of 8.
+void libjit_block_sparse_fc_f(float *outW, const float *inW,
+                              const float *values, const int32_t *colIndices,
+                              const int32_t *rowOffsets, const float *biasW,
+                              const dim_t *outWdims, const dim_t *inWdims,
+                              dim_t blockRows, dim_t blockCols, dim_t begin,
+                              dim_t end) {
+  dim_t in_w = inWdims[1];
+  dim_t out_w = outWdims[1];
+  dim_t blockSize = blockRows * blockCols;
+  for (dim_t i0 = begin; i0 < end; i0 += blockSparseFCTileRows) {
+    dim_t numRows = MIN(blockSparseFCTileRows, end - i0);
+    for (dim_t i = 0; i < numRows; i++) {
+      memcpy(outW + (i0 + i) * out_w, biasW, out_w * sizeof(float));
+    }
+    for (dim_t br = 0; br < in_w / blockRows; br++) {
+      for (int32_t b = rowOffsets[br]; b < rowOffsets[br + 1]; b++) {
+        const float *block = values + b * blockSize;
+        dim_t col = colIndices[b] * blockCols;
+        for (dim_t i = 0; i < numRows; i++) {
+          const float *inRow = inW + (i0 + i) * in_w + br * blockRows;
+          float *outRow = outW + (i0 + i) * out_w + col;
+          dim_t j = 0;
+          for (; j + 8 <= blockCols; j += 8) {
+            float8 acc = LoaduFloat8(outRow + j);
+            for (dim_t k = 0; k < blockRows; k++) {
+              acc += BroadcastFloat8(inRow[k]) *
+                     LoaduFloat8(block + k * blockCols + j);
+            }
+            StoreuFloat8(outRow + j, acc);
+          }
+          for (; j < blockCols; j++) {
+            float acc = outRow[j];
+            for (dim_t k = 0; k < blockRows; k++) {
+              acc += inRow[k] * block[k * blockCols + j];
+            }
+            outRow[j] = acc;
+          }
+        }
+      }
+    }
+  }
+}
+
+/// Quantized FullyConnected with int32 bias whose activations are fused into
+/// the lookup table \p mapping.
+void libjit_fc_act_i8_i32(int8_t *outW, const int8_t *inW,
+                          const int8_t *weightsW, const int32_t *biasW,
+                          const int8_t *mapping, const dim_t *outWdims,
+                          const dim_t *inWdims, int32_t outOffset,
+                          int32_t inOffset, int32_t weightsOffset,
+                          int32_t biasOffset, int32_t biasPre,
+                          int32_t biasPost, int32_t biasScale, int32_t outPre,
+                          int32_t outPost, int32_t outScale) {
+  libjit_fc_act_generic<int32_t>(outW, inW, weightsW, biasW, mapping,
+                                 outWdims, inWdims, outOffset, inOffset,
+                                 weightsOffset, biasOffset, biasPre, biasPost,
+                                 biasScale, outPre, outPost, outScale);
+}
+
+/// Quantized FullyConnected with int8 bias whose activations are fused into
+/// the lookup table \p mapping.
+void libjit_fc_act_i8_i8(int8_t *outW, const int8_t *inW,
+                         const int8_t *weightsW, const int8_t *biasW,
+                         const int8_t *mapping, const dim_t *outWdims,
+                         const dim_t *inWdims, int32_t outOffset,
+                         int32_t inOffset, int32_t weightsOffset,
+                         int32_t biasOffset, int32_t biasPre, int32_t biasPost,
+                         int32_t biasScale, int32_t outPre, int32_t outPost,
+                         int32_t outScale) {
+  libjit_fc_act_generic<int8_t>(outW, inW, weightsW, biasW, mapping, outWdims,
+                                inWdims, outOffset, inOffset, weightsOffset,
+                                biasOffset, biasPre, biasPost, biasScale,
+                                outPre, outPost, outScale);
+}
+
 /// Rowwise quantized FullyConnected with int8 precision and int32 bias.
 void libjit_rowwise_quantized_fc_i8_i32(
     int8_t *outW, const int8_t *inW, const int8_t *weightsW,
@@ -292,6 +292,7 @@ std::set<std::string> glow::backendTestBlacklist = {
     "QuantizedArgMaxNoKeepDim/0",
     "QuantizedArithmeticRescaled/0",
     "QuantizedArithmeticUnrescaled/0",
+    "QuantizedElementwiseChain/0",
     "QuantizedCmpLTEAndSelect/0",
     "QuantizedMaxPoolWithArgmax/0",
     "QuantizedMaxPoolWithArgmaxTransposed/0",
@@ -397,4 +398,9 @@ std::set<std::string> glow::backendTestBlacklist = {
     "mul_int64/0",
     "add_int32/0",
     "add_int64/0",
+    "SLSOfRescaledSharedBuffer/0",
+    "IntLookupTableAfterBroadcast256/0",
+    "ScaledDotProductAttention/0",
+    "ScaledDotProductAttentionBroadcastMask/0",
+    "ScaledDotProductAttentionFullyMaskedRow/0",
 };
@@ -23,24 +23,26 @@
 #include "glow/Graph/Nodes.h"
 #include "glow/IR/IR.h"
 #include "glow/IR/Instrs.h"
+#include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
 #include "glow/Optimizer/IROptimizer/IROptimizer.h"
 
 namespace glow {
 namespace runtime {
 extern unsigned GlowInterpreterMemory;
+extern bool GlowInterpreterBlockSparseFC;
 }
 } // namespace glow
 using namespace glow;
 
 Expected<std::unique_ptr<CompiledFunction>>
 Interpreter::compile(Function *F, const BackendOptions &opts) const {
-  TraceInfo traceInfo = buildManualTraceInfo(F);
-  auto IR = generateAndOptimizeIR(F, *this, shouldShareBuffers());
-
   if (!opts.backendSpecificOpts.empty()) {
-    parseBackendSpecificOptions(opts);
+    RETURN_IF_ERR(parseBackendSpecificOptions(opts));
   }
 
+  TraceInfo traceInfo = buildManualTraceInfo(F);
+  auto IR = generateAndOptimizeIR(F, *this, shouldShareBuffers());
+
   if (opts.autoInstrument) {
     autoInstrument(traceInfo, IR.get());
   }
@@ -119,6 +121,14 @@ bool Interpreter::isOpSupported(const NodeInfo &NI) const {
         {ElemKind::FloatTy, ElemKind::Float16Ty, ElemKind::Int8QTy,
          ElemKind::Int16QTy});
 
+  case Kinded::Kind::BatchMatMulNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind(
+        {ElemKind::FloatTy, ElemKind::Float16Ty});
+
+  case Kinded::Kind::ScaledDotProductAttentionNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind(
+        {ElemKind::FloatTy, ElemKind::Float16Ty});
+
   case Kinded::Kind::FullyConnectedNodeKind:
     if (!NI.getInTy(ConvolutionNode::InputIdx)->isQuantizedType()) {
       return NI.allInputsAndOutputsHaveSameElemKind(
@@ -294,6 +304,11 @@ bool Interpreter::isOpSupported(const NodeInfo &NI) const {
             (NI.getInElemTy(BatchedAddNode::SliceIdx) == ElemKind::Int16QTy ||
              NI.getInElemTy(BatchedAddNode::SliceIdx) == ElemKind::Int32QTy));
 
+  case Kinded::Kind::BlockSparseFullyConnectedNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind(
+        {ElemKind::FloatTy}, {BlockSparseFullyConnectedNode::ColIndicesIdx,
+                              BlockSparseFullyConnectedNode::RowOffsetsIdx});
+
   case Kinded::Kind::RowwiseQuantizedFullyConnectedNodeKind:
     return (NI.getInElemTy(RowwiseQuantizedFullyConnectedNode::InputIdx) ==
             ElemKind::Int8QTy) &&
@@ -401,6 +416,16 @@ bool Interpreter::isOpSupported(const NodeInfo &NI) const {
     }
   }
 
+  case Kinded::Kind::
+      GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumNodeKind:
+    if (NI.getInElemTy(
+            GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumNode::
+                TableOffsetsIdx) != ElemKind::Int64ITy) {
+      return false;
+    }
+    // The other inputs are the ones of a
+    // FusedRowwiseQuantizedSparseLengthsWeightedSum, at the same indices.
+    LLVM_FALLTHROUGH;
   case Kinded::Kind::FusedRowwiseQuantizedSparseLengthsWeightedSumNodeKind: {
     if ((NI.getInElemTy(
              FusedRowwiseQuantizedSparseLengthsWeightedSumNode::IndicesIdx) !=
@@ -757,6 +782,14 @@ bool Interpreter::shouldLower(const Node *N) const {
   case Kinded::Kind::SparseLengthsSumNodeKind:
   case Kinded::Kind::FullyConnectedNodeKind:
     return false;
+  case Kinded::Kind::BatchMatMulNodeKind:
+    // Floating point BatchMatMul has a native implementation.
+    return !isFloatElemKind(
+        llvm::cast<BatchMatMulNode>(N)->getResult().getElementType());
+  case Kinded::Kind::ScaledDotProductAttentionNodeKind:
+    return !isFloatElemKind(llvm::cast<ScaledDotProductAttentionNode>(N)
+                                ->getResult()
+                                .getElementType());
   default:
     return true;
   }
@@ -928,17 +961,39 @@ Expected<bool> Interpreter::transformPostLowering(
       changed |= quantizeRQFCFloatBias(F, *rowwiseFC);
     }
   }
+
+  // Compute the SLWS nodes of sibling tables with a single kernel.
+  if (cctx.optimizationOpts.enableSLSGrouping) {
+    changed |= groupFusedRowwiseQuantizedSLWS(
+        F, cctx.optimizationOpts.slsGroupingMaxBytes);
+  }
+
+  // Store the weights of sparse FullyConnecteds in block-CSR format. The
+  // Interpreter is the reference backend, so its FullyConnecteds are only
+  // converted on request.
+  if (glow::runtime::GlowInterpreterBlockSparseFC &&
+      cctx.optimizationOpts.enableBlockSparseFC) {
+    changed |= sparsifyFullyConnected(
+        F, cctx.optimizationOpts.blockSparseFCMinSparsity);
+  }
   return changed;
 }
 
-void Interpreter::parseBackendSpecificOptions(
+Error Interpreter::parseBackendSpecificOptions(
     const BackendOptions &opts) const {
   auto interpreterMaxMemOpt =
       opts.backendSpecificOpts.find("interpreter-memory");
   if (interpreterMaxMemOpt != opts.backendSpecificOpts.end()) {
-    glow::runtime::GlowInterpreterMemory =
-        std::stoi(interpreterMaxMemOpt->second);
+    int memory;
+    ASSIGN_VALUE_OR_RETURN_ERR(memory,
+                               getIntFromStr(interpreterMaxMemOpt->second));
+    RETURN_ERR_IF_NOT(memory > 0,
+                      "interpreter-memory must be a positive number of "
+                      "kilobytes, got " +
+                          interpreterMaxMemOpt->second);
+    glow::runtime::GlowInterpreterMemory = memory;
     llvm::outs() << "Interpreter memory set to "
                  << glow::runtime::GlowInterpreterMemory << "\n";
   }
+  return Error::success();
 }
@@ -20,6 +20,8 @@
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <unordered_set>
+
 namespace glow {
 namespace runtime {
 
@@ -32,6 +34,71 @@ static llvm::cl::opt<unsigned, /* ExternalStorage */ true> interpreterMaxMemOpt(
     llvm::cl::location(GlowInterpreterMemory),
     llvm::cl::cat(InterpreterBackendCat));
 
+unsigned GlowInterpreterThreads = 1;
+static llvm::cl::opt<unsigned, /* ExternalStorage */ true> interpreterThreads(
+    "interpreter-threads",
+    llvm::cl::desc("Number of threads used by each Interpreter DeviceManager "
+                   "to execute independent instructions in parallel"),
+    llvm::cl::location(GlowInterpreterThreads),
+    llvm::cl::cat(InterpreterBackendCat));
+
+unsigned GlowInterpreterMinParallelWork = 1 << 16;
+static llvm::cl::opt<unsigned, /* ExternalStorage */ true>
+    interpreterMinParallelWork(
+        "interpreter-min-parallel-work",
+        llvm::cl::desc("Minimum number of elements an Interpreter kernel has "
+                       "to process to be split over the threads"),
+        llvm::cl::location(GlowInterpreterMinParallelWork),
+        llvm::cl::cat(InterpreterBackendCat));
+
+bool GlowInterpreterBlockSparseFC = false;
+static llvm::cl::opt<bool, /* ExternalStorage */ true> interpreterBlockSparseFC(
+    "interpreter-block-sparse-fc",
+    llvm::cl::desc("Convert the sparse FullyConnecteds to "
+                   "BlockSparseFullyConnected nodes on the Interpreter, if "
+                   "OptimizationOptions::enableBlockSparseFC is set"),
+    llvm::cl::location(GlowInterpreterBlockSparseFC),
+    llvm::cl::cat(InterpreterBackendCat));
+
+InterpreterDeviceManager::InterpreterDeviceManager(const DeviceConfig &config)
+    : QueueBackedDeviceManager(config),
+      minParallelWork_(GlowInterpreterMinParallelWork) {
+  statsExporterRegistry_->incrementCounter(kDevicesUsedInterpreter);
+  exportMemoryCounters();
+}
+
+/// \returns the positive integer value of the parameter \p name of \p config,
+/// or \p defaultValue if it is not set.
+static Expected<unsigned> getPositiveParameter(const DeviceConfig &config,
+                                               llvm::StringRef name,
+                                               unsigned defaultValue) {
+  auto it = config.parameters.find(name);
+  if (it == config.parameters.end()) {
+    return defaultValue;
+  }
+  int value;
+  ASSIGN_VALUE_OR_RETURN_ERR(value, getIntFromStr(it->second));
+  RETURN_ERR_IF_NOT(value > 0, llvm::formatv("Interpreter parameter {0} must "
+                                             "be positive, got {1}",
+                                             name, it->second)
+                                   .str());
+  return value;
+}
+
+Error InterpreterDeviceManager::init() {
+  unsigned numThreads;
+  ASSIGN_VALUE_OR_RETURN_ERR(
+      numThreads,
+      getPositiveParameter(config_, "numThreads", GlowInterpreterThreads));
+  ASSIGN_VALUE_OR_RETURN_ERR(
+      minParallelWork_, getPositiveParameter(config_, "minParallelWork",
+                                             GlowInterpreterMinParallelWork));
+  if (numThreads > 1) {
+    threadPool_ = glow::make_unique<ThreadPool>(numThreads, "Interpreter");
+  }
+  return QueueBackedDeviceManager::init();
+}
+
 DeviceManager *createInterpreterDeviceManager(const DeviceConfig &config) {
   if (GlowInterpreterMemory) {
     // Convert command line GlowInterpreterMemory to bytes from kilobytes.
@@ -71,6 +138,7 @@ void InterpreterDeviceManager::addNetworkImpl(const Module *module,
   DCHECK(readyCB != nullptr);
 
   uint64_t allFunctionsMemoryBytes{0};
+  std::unordered_set<const uint8_t *> newConstants;
 
   // First check for uniqueness of the function name.
   for (const auto &func : functions) {
@@ -93,8 +161,10 @@ void InterpreterDeviceManager::addNetworkImpl(const Module *module,
       return;
     }
 
+    // Constants already shared with a function on the device take no extra
+    // memory.
     allFunctionsMemoryBytes +=
-        func.second->getRuntimeBundle().getConstantWeightSize();
+        getNewConstantsSize(func.second->getRuntimeBundle(), newConstants);
 
     // Add function name to map for static placeholders.
     InterpreterFunction *function =
@@ -115,9 +185,10 @@ void InterpreterDeviceManager::addNetworkImpl(const Module *module,
 
   // Add to the function name lookup map.
   for (const auto &func : functions) {
-    if (func.second->getRuntimeBundle().getConstants() == nullptr) {
-      func.second->collectConstants(module);
-    }
+    // Constants collected at compile time or shared by the Provisioner still
+    // need to be bound to the function.
+    func.second->collectConstants(module);
+    acquireConstants(func.second->getRuntimeBundle());
     functions_.emplace(func.first, func.second);
   }
 
@@ -154,7 +225,7 @@ void InterpreterDeviceManager::evictNetworkImpl(std::string functionName,
   auto it = functions_.find(functionName);
 
   if (it != functions_.end()) {
-    usedMemoryBytes_ -= it->second->getRuntimeBundle().getConstantWeightSize();
+    usedMemoryBytes_ -= releaseConstants(it->second->getRuntimeBundle());
     functions_.erase(it);
   } else {
     evictCB(functionName,
@@ -188,10 +259,12 @@ void InterpreterDeviceManager::runFunctionImpl(
     return;
   }
 
-  CompiledFunction *func = funcIt->second;
+  InterpreterFunction *func =
+      static_cast<InterpreterFunction *>(funcIt->second);
 
   // Run that function.
-  auto executeErr = func->execute(context.get());
+  auto executeErr = func->execute(context.get(), threadPool_.get(),
+                                  minParallelWork_);
 
   // End the TraceEvent early to avoid time in the CB.
   TRACE_EVENT_SCOPE_END_NAMED(dmRun);
@@ -19,15 +19,182 @@
 #include "glow/IR/IR.h"
 #include "glow/IR/IRUtils.h"
 #include "glow/IR/Instrs.h"
+#include "glow/Support/Memory.h"
 #include "glow/Support/ThreadPool.h"
 
 #include "llvm/Support/Casting.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 using namespace glow;
 
 InterpreterFunction::InterpreterFunction(std::unique_ptr<IRFunction> F,
                                          runtime::RuntimeBundle &&bundle)
-    : CompiledFunction(std::move(bundle)), F_(std::move(F)) {}
+    : CompiledFunction(std::move(bundle)), F_(std::move(F)) {
+  decode();
+}
+
+void InterpreterFunction::decode() {
+  auto getOrCreateSlot = [&](const Value *v) -> unsigned {
+    auto it = slotIndex_.find(v);
+    if (it != slotIndex_.end()) {
+      return it->second;
+    }
+    unsigned slot = slots_.size();
+    slots_.push_back({v});
+    slotIndex_[v] = slot;
+    return slot;
+  };
+
+  for (const auto *W : F_->getWeights()) {
+    weightSlots_[W->getName()] = getOrCreateSlot(W);
+  }
+  for (const auto *PH : F_->findPlaceholders()) {
+    auto *W = F_->getWeightForNode(PH);
+    if (W) {
+      placeholderSlots_.emplace_back(PH, getOrCreateSlot(W));
+    }
+  }
+
+  const auto &instrs = F_->getInstrs();
+  program_.reserve(instrs.size());
+  for (const auto &I : instrs) {
+    unsigned slot = npos;
+    if (llvm::isa<AllocActivationInst>(&I) || llvm::isa<TensorViewInst>(&I)) {
+      slot = getOrCreateSlot(&I);
+    }
+    // Activations live at the offsets planned by the runtime bundle.
+    if (llvm::isa<AllocActivationInst>(&I)) {
+      slots_[slot].offset = runtimeBundle_.getSymbolInfo(&I).offset;
+    }
+    unsigned operandsBegin = operands_.size();
+    for (const auto &op : I.getOperands()) {
+      operands_.push_back({op.first, getOrCreateSlot(op.first)});
+    }
+    program_.push_back({&I, slot, operandsBegin, unsigned(operands_.size())});
+  }
+  computeDependencies();
+}
+
+void InterpreterFunction::computeDependencies() {
+  /// Accesses to the memory of a single weight or activation.
+  struct MemoryState {
+    /// The last instruction which wrote the memory, or npos.
+    unsigned lastWriter{npos};
+    /// Instructions which read the memory since it was last written.
+    std::vector<unsigned> readers;
+    /// Accesses to dead activations which occupied the same memory before
+    /// the memory was first written.
+    std::vector<unsigned> inherited;
+  };
+  std::unordered_map<const Value *, MemoryState> memory;
+  /// Ranges of the activations arena occupied by the activations seen so far.
+  struct ArenaRange {
+    uint64_t begin;
+    uint64_t end;
+    const Value *alloc;
+  };
+  std::vector<ArenaRange> arena;
+  /// Instructions defining tensor views.
+  std::unordered_map<const Value *, unsigned> viewDefs;
+
+  std::vector<std::vector<unsigned>> predecessors(program_.size());
+  for (unsigned idx = 0, e = program_.size(); idx < e; idx++) {
+    const Instruction *I = program_[idx].I;
+    auto &preds = predecessors[idx];
+
+    // Activations reuse the memory of the dead activations they overlap with,
+    // so order them after all accesses to those.
+    if (auto *A = llvm::dyn_cast<AllocActivationInst>(I)) {
+      ArenaRange range{slots_[program_[idx].slot].offset, 0, A};
+      range.end = range.begin + A->getSizeInBytes();
+      auto &state = memory[A];
+      for (const auto &other : arena) {
+        if (other.begin >= range.end || range.begin >= other.end) {
+          continue;
+        }
+        const auto &otherState = memory[other.alloc];
+        if (otherState.lastWriter != npos) {
+          state.inherited.push_back(otherState.lastWriter);
+        }
+        state.inherited.insert(state.inherited.end(),
+                               otherState.readers.begin(),
+                               otherState.readers.end());
+        state.inherited.insert(state.inherited.end(),
+                               otherState.inherited.begin(),
+                               otherState.inherited.end());
+      }
+      arena.push_back(range);
+      continue;
+    }
+    if (llvm::isa<DeallocActivationInst>(I)) {
+      continue;
+    }
+
+    for (unsigned i = program_[idx].operandsBegin,
+                  opEnd = program_[idx].operandsEnd;
+         i < opEnd; i++) {
+      const Value *v = operands_[i].value;
+      // Tensor views have to be created before they are used.
+      auto viewIt = viewDefs.find(v);
+      if (viewIt != viewDefs.end()) {
+        preds.push_back(viewIt->second);
+      }
+      // Creating a tensor view does not access any memory.
+      if (llvm::isa<TensorViewInst>(I)) {
+        continue;
+      }
+      auto &state = memory[getOrigin(v)];
+      auto kind = I->getOperands()[i - program_[idx].operandsBegin].second;
+      if (state.lastWriter != npos) {
+        preds.push_back(state.lastWriter);
+      }
+      preds.insert(preds.end(), state.inherited.begin(), state.inherited.end());
+      if (kind == OperandKind::In) {
+        state.readers.push_back(idx);
+        continue;
+      }
+      preds.insert(preds.end(), state.readers.begin(), state.readers.end());
+      state.lastWriter = idx;
+      state.readers.clear();
+      state.inherited.clear();
+    }
+    if (llvm::isa<TensorViewInst>(I)) {
+      viewDefs[I] = idx;
+    }
+  }
+
+  // Store the dependencies as successor lists.
+  std::vector<std::vector<unsigned>> successors(program_.size());
+  for (unsigned idx = 0, e = program_.size(); idx < e; idx++) {
+    auto &preds = predecessors[idx];
+    std::sort(preds.begin(), preds.end());
+    preds.erase(std::unique(preds.begin(), preds.end()), preds.end());
+    // An instruction reading and writing the same memory does not depend on
+    // itself.
+    preds.erase(std::remove(preds.begin(), preds.end(), idx), preds.end());
+    program_[idx].numPredecessors = preds.size();
+    for (unsigned pred : preds) {
+      successors[pred].push_back(idx);
+    }
+  }
+  for (unsigned idx = 0, e = program_.size(); idx < e; idx++) {
+    program_[idx].successorsBegin = successors_.size();
+    successors_.insert(successors_.end(), successors[idx].begin(),
+                       successors[idx].end());
+    program_[idx].successorsEnd = successors_.size();
+  }
+}
+
+void InterpreterFunction::setConstantSlot(llvm::StringRef name, Tensor *T) {
+  auto it = weightSlots_.find(name);
+  if (it != weightSlots_.end()) {
+    slots_[it->second].constant = T;
+  }
+}
 
 InterpreterFunction::~InterpreterFunction() {
   for (const auto &p : constants_) {
@@ -37,7 +204,9 @@ InterpreterFunction::~InterpreterFunction() {
 }
 
 void InterpreterFunction::collectConstants(const Module *module) {
-  runtimeBundle_.collectConstants(module);
+  if (runtimeBundle_.getConstants() == nullptr) {
+    runtimeBundle_.collectConstants(module);
+  }
   if (constants_.empty()) {
     if (runtimeBundle_.getConstantWeightSize()) {
       for (const auto &v : F_->findConstants()) {
@@ -45,6 +214,7 @@ void InterpreterFunction::collectConstants(const Module *module) {
         auto addr = runtimeBundle_.getConstants() + symbolInfo.offset;
         auto tensor = new Tensor(addr, &symbolInfo.type);
         constants_.emplace(std::string(v->getName()), tensor);
+        setConstantSlot(v->getName(), tensor);
       }
     }
   }
@@ -54,13 +224,20 @@ void InterpreterFunction::addConstant(std::string name, Tensor *T) {
   Tensor *newTensor = new Tensor;
   newTensor->assign(T);
   constants_[name] = newTensor;
+  setConstantSlot(name, newTensor);
 }
 
 Error InterpreterFunction::execute(ExecutionContext *context) {
-  BoundInterpreterFunction boundFunc(constants_);
+  return execute(context, nullptr, 0);
+}
+
+Error InterpreterFunction::execute(ExecutionContext *context,
+                                   ThreadPool *threadPool,
+                                   dim_t minParallelWork) {
+  BoundInterpreterFunction boundFunc(*this);
   boundFunc.setIRInstructionProcessingHandler(
       getIRInstructionProcessingHandler());
-  auto res = boundFunc.execute(F_.get(), context);
+  auto res = boundFunc.execute(context, threadPool, minParallelWork);
   {
     TRACE_EVENT_SCOPE(context, TraceLevel::RUNTIME, "processInstrumentation");
     translateTraceEvents(context);
@@ -124,123 +301,161 @@ void InterpreterFunction::translateTraceEvents(
   }
 }
 
-BoundInterpreterFunction::~BoundInterpreterFunction() {
-  // Delete the tensors that are owned by this backend.
-  for (const auto &p : tensors_) {
-    delete p.second;
-  }
-  tensors_.clear();
-  externalTensors_.clear();
+InterpreterFunction::RunSlot::~RunSlot() {
+  // Drop the tensors before the memory backing them.
+  localTensors.clear();
+  alignedFree(activations);
 }
 
-Tensor *BoundInterpreterFunction::getTensor(const Value *v) const {
-  auto it = tensors_.find(v);
-  if (it != tensors_.end()) {
-    return it->second;
+std::unique_ptr<InterpreterFunction::RunSlot>
+InterpreterFunction::acquireRunSlot() const {
+  {
+    std::lock_guard<std::mutex> lock(runSlotsMutex_);
+    if (!freeRunSlots_.empty()) {
+      auto runSlot = std::move(freeRunSlots_.back());
+      freeRunSlots_.pop_back();
+      return runSlot;
+    }
+    numRunSlots_++;
   }
-  auto ic = constants_.find(std::string(v->getName()));
-  if (ic != constants_.end()) {
-    return ic->second;
+
+  // All activations are carved out of a single arena, following the
+  // activations plan of the runtime bundle. The tensors backing them are
+  // created once and kept for subsequent invocations.
+  auto runSlot = glow::make_unique<RunSlot>();
+  runSlot->slots.resize(slots_.size());
+  runSlot->localTensors.resize(slots_.size());
+  size_t activationsSize = runtimeBundle_.getActivationsSize();
+  if (activationsSize) {
+    runSlot->activations = static_cast<uint8_t *>(
+        alignedAlloc(activationsSize, TensorAlignment));
   }
+  for (unsigned i = 0, e = slots_.size(); i < e; i++) {
+    if (llvm::isa<AllocActivationInst>(slots_[i].value)) {
+      runSlot->localTensors[i] = Tensor(runSlot->activations + slots_[i].offset,
+                                        slots_[i].value->getType());
+    }
+  }
+  return runSlot;
+}
 
-  auto ie = externalTensors_.find(v);
-  assert(ie != externalTensors_.end() && "Unknown key Value.");
-  return ie->second;
+void InterpreterFunction::releaseRunSlot(
+    std::unique_ptr<RunSlot> runSlot) const {
+  std::lock_guard<std::mutex> lock(runSlotsMutex_);
+  freeRunSlots_.push_back(std::move(runSlot));
 }
 
-Tensor *BoundInterpreterFunction::getOrCreateTensor(const Value *v) {
-  auto ie = externalTensors_.find(v);
-  if (ie != externalTensors_.end()) {
-    return ie->second;
-  }
-  auto ic = constants_.find(std::string(v->getName()));
-  if (ic != constants_.end()) {
-    return ic->second;
-  }
+size_t InterpreterFunction::getNumRunSlots() const {
+  std::lock_guard<std::mutex> lock(runSlotsMutex_);
+  return numRunSlots_;
+}
+
+uint64_t InterpreterFunction::getPeakActivationsMemory() const {
+  return getNumRunSlots() * runtimeBundle_.getActivationsSize();
+}
+
+BoundInterpreterFunction::~BoundInterpreterFunction() {
+  function_.releaseRunSlot(std::move(runSlot_));
+}
 
-  // Pick the tensor.
-  auto it = tensors_.find(v);
-  if (it == tensors_.end()) {
-    auto *T = new Tensor(v->getType());
-    tensors_[v] = T;
-    return T;
+Tensor *BoundInterpreterFunction::getTensor(const Value *v) const {
+  // The operands of the instruction being executed are pre-resolved, look
+  // through them before falling back to the slot map.
+  if (curInstr_) {
+    if (curInstr_->I == v) {
+      return slots_[curInstr_->slot];
+    }
+    const auto *ops = function_.operands_.data();
+    for (unsigned i = curInstr_->operandsBegin; i < curInstr_->operandsEnd;
+         i++) {
+      if (ops[i].value == v) {
+        assert(slots_[ops[i].slot] && "Unbound value");
+        return slots_[ops[i].slot];
+      }
+    }
   }
-  return it->second;
+  auto it = function_.slotIndex_.find(v);
+  assert(it != function_.slotIndex_.end() && "Unknown key Value.");
+  assert(slots_[it->second] && "Unbound value");
+  return slots_[it->second];
 }
 
 Tensor *BoundInterpreterFunction::getOrCreateUnownedTensor(
     const Value *v, const Value *src, llvm::ArrayRef<dim_t> offsets) {
   assert(llvm::isa<TensorViewInst>(v) && "Expected a tensor view");
-
-  // Pick the tensor.
-  auto it = tensors_.find(v);
-
-  // Release unowned tensors before re-creating them.
-  if (it != tensors_.end()) {
-    deleteTensor(v);
+  unsigned slot = curInstr_ && curInstr_->I == v
+                      ? curInstr_->slot
+                      : function_.slotIndex_.find(v)->second;
+  localTensors_[slot] = getTensor(src)->getUnowned(v->dims(), offsets);
+  // Views created by buffer sharing may have other quantization parameters
+  // than the buffer they alias, and kernels read them from the tensor type.
+  if (v->getType()->isQuantizedType()) {
+    localTensors_[slot].setType(v->getType());
   }
-
-  auto *T = new Tensor();
-  *T = getTensor(src)->getUnowned(v->dims(), offsets);
-  tensors_[v] = T;
-  return T;
+  slots_[slot] = &localTensors_[slot];
+  return slots_[slot];
 }
 
-void BoundInterpreterFunction::deleteTensor(const Value *v) {
-  auto it = tensors_.find(v);
-  if (it == tensors_.end()) {
-    return;
-  }
-
-  delete it->second;
-  tensors_.erase(it);
-}
+void BoundInterpreterFunction::bind(ExecutionContext *context) {
+  auto *bindings = context->getPlaceholderBindings();
+  // Make sure all referenced tensors are on the host.
+  bindings->ensureOnHost();
 
-Error BoundInterpreterFunction::execute(IRFunction *F,
-                                        ExecutionContext *context) {
-  {
-    TRACE_EVENT_SCOPE(context, TraceLevel::RUNTIME, "registerTensors");
-    // Make sure all referenced tensors are on the host.
-    context->getPlaceholderBindings()->ensureOnHost();
-
-    // Find all virtually padded tensors so they can be replaced.
-    std::vector<Placeholder *> virtualPadded;
-    for (auto &ph : context->getPlaceholderBindings()->pairs()) {
-      if (ph.second.getUnpaddedSizeInBytes() < ph.second.getSizeInBytes()) {
-        virtualPadded.push_back(ph.first);
-      }
+  // Find all virtually padded tensors so they can be replaced.
+  std::vector<Placeholder *> virtualPadded;
+  for (auto &ph : bindings->pairs()) {
+    if (ph.second.getUnpaddedSizeInBytes() < ph.second.getSizeInBytes()) {
+      virtualPadded.push_back(ph.first);
     }
-    // Replace all virtually padded tensors with real padding tensors.
-    for (auto &ph : virtualPadded) {
-      auto oldTensor = context->getPlaceholderBindings()->get(ph);
-      Tensor paddedTensor(oldTensor->getType());
-      memcpy(paddedTensor.getUnsafePtr(), oldTensor->getUnsafePtr(),
-             oldTensor->getUnpaddedSizeInBytes());
-      context->getPlaceholderBindings()->erase(ph);
-      context->getPlaceholderBindings()->insert(ph, std::move(paddedTensor));
+  }
+  // Replace all virtually padded tensors with real padding tensors.
+  for (auto &ph : virtualPadded) {
+    auto oldTensor = bindings->get(ph);
+    Tensor paddedTensor(oldTensor->getType());
+    memcpy(paddedTensor.getUnsafePtr(), oldTensor->getUnsafePtr(),
+           oldTensor->getUnpaddedSizeInBytes());
+    bindings->erase(ph);
+    bindings->insert(ph, std::move(paddedTensor));
+  }
+
+  // The activation tensors of the run slot are reused, everything else is
+  // bound again.
+  const auto &slots = function_.slots_;
+  for (unsigned i = 0, e = slots.size(); i < e; i++) {
+    const auto &slot = slots[i];
+    if (slot.constant) {
+      slots_[i] = slot.constant;
+    } else if (llvm::isa<AllocActivationInst>(slot.value)) {
+      slots_[i] = &localTensors_[i];
+    } else {
+      slots_[i] = nullptr;
     }
-    // Register the concrete tensors that back the placeholder tensors.
-    for (auto &ph : context->getPlaceholderBindings()->pairs()) {
-      auto *w = F->getWeightForNode(ph.first);
-      // If the Placeholder has been aliased to the same Weight, just skip it.
-      if (externalTensors_.count(w)) {
-        continue;
-      }
+  }
 
-      externalTensors_[w] = &ph.second;
+  // Register the concrete tensors that back the placeholder tensors. If the
+  // Placeholder has been aliased to the same Weight, the first one wins.
+  for (const auto &PS : function_.placeholderSlots_) {
+    if (slots_[PS.second]) {
+      continue;
     }
+    slots_[PS.second] = bindings->get(const_cast<Placeholder *>(PS.first));
   }
+}
 
-  // Do the forward pass.
+thread_local const InterpreterFunction::DecodedInstr
+    *BoundInterpreterFunction::curInstr_ = nullptr;
+
+void BoundInterpreterFunction::executeInstr(
+    const InterpreterFunction::DecodedInstr &DI) {
   auto &irInstructionProcessingHandler = getIRInstructionProcessingHandler();
-  // Dispatch the interpreter on each instruction in the program.
-  for (const auto &I : F->getInstrs()) {
-    // Perform custom processing if needed and proceed with standard processing
-    // if required.
-    if (!irInstructionProcessingHandler ||
-        !irInstructionProcessingHandler(
-            &I, IRInstructionProcessingStage::PROCESSING, this)) {
-      switch (I.getKind()) {
+  curInstr_ = &DI;
+  const Instruction &I = *DI.I;
+  // Perform custom processing if needed and proceed with standard processing
+  // if required.
+  if (!irInstructionProcessingHandler ||
+      !irInstructionProcessingHandler(
+          &I, IRInstructionProcessingStage::PROCESSING, this)) {
+    switch (I.getKind()) {
 #define DEF_VALUE(CLASS, NAME)
 #define DEF_INSTR(CLASS, NAME)                                                 \
   case Kinded::Kind::CLASS##Kind: {                                            \
@@ -250,28 +465,172 @@ Error BoundInterpreterFunction::execute(IRFunction *F,
 #define DEF_BACKEND_SPECIFIC_INSTR(CLASS, NAME)
 #include "glow/AutoGenInstr.def"
 
-      default:
-        glow::errs() << "Invalid instruction: " << &I << "\n";
-        llvm_unreachable("Invalid instruction.");
+    default:
+      glow::errs() << "Invalid instruction: " << &I << "\n";
+      llvm_unreachable("Invalid instruction.");
+    }
+  }
+
+  // Perform post-processing of the instruction.
+  if (irInstructionProcessingHandler) {
+    irInstructionProcessingHandler(
+        &I, IRInstructionProcessingStage::POSTPROCESSING, this);
+  }
+  curInstr_ = nullptr;
+}
+
+struct BoundInterpreterFunction::ParallelState {
+  /// The thread pool executing the instructions.
+  ThreadPool *threadPool;
+  /// Number of predecessors of each instruction which are not executed yet.
+  std::unique_ptr<std::atomic<unsigned>[]> pending;
+  /// Number of executed instructions.
+  size_t numDone{0};
+  /// Protects numDone.
+  std::mutex mutex;
+  /// Signaled when all instructions are executed.
+  std::condition_variable allDone;
+};
+
+void BoundInterpreterFunction::runReady(std::shared_ptr<ParallelState> state,
+                                        unsigned idx) {
+  const auto &program = function_.program_;
+  const auto &successors = function_.successors_;
+  while (true) {
+    executeInstr(program[idx]);
+
+    unsigned next = InterpreterFunction::npos;
+    for (unsigned i = program[idx].successorsBegin,
+                  e = program[idx].successorsEnd;
+         i < e; i++) {
+      unsigned succ = successors[i];
+      if (--state->pending[succ] != 0) {
+        continue;
+      }
+      if (next == InterpreterFunction::npos) {
+        next = succ;
+      } else {
+        state->threadPool->submit(
+            [this, state, succ]() { runReady(state, succ); });
       }
     }
 
-    // Perform post-processing of the instruction.
-    if (irInstructionProcessingHandler) {
-      irInstructionProcessingHandler(
-          &I, IRInstructionProcessingStage::POSTPROCESSING, this);
+    // Nothing may touch this function once the last instruction is done.
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (++state->numDone == program.size()) {
+        state->allDone.notify_all();
+      }
     }
+    if (next == InterpreterFunction::npos) {
+      return;
+    }
+    idx = next;
   }
+}
 
-  {
+void BoundInterpreterFunction::executeParallel(ThreadPool *threadPool) {
+  const auto &program = function_.program_;
+  if (program.empty()) {
+    return;
+  }
+  auto state = std::make_shared<ParallelState>();
+  state->threadPool = threadPool;
+  state->pending.reset(new std::atomic<unsigned>[program.size()]);
+  for (unsigned idx = 0, e = program.size(); idx < e; idx++) {
+    state->pending[idx] = program[idx].numPredecessors;
+  }
+  for (unsigned idx = 0, e = program.size(); idx < e; idx++) {
+    if (program[idx].numPredecessors == 0) {
+      threadPool->submit([this, state, idx]() { runReady(state, idx); });
+    }
+  }
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->allDone.wait(lock, [&]() { return state->numDone == program.size(); });
+}
 
-    TRACE_EVENT_SCOPE(context, TraceLevel::RUNTIME, "eraseTensors");
-    // Remove the concrete tensors that back the placeholder tensors.
-    for (auto &ph : context->getPlaceholderBindings()->pairs()) {
-      auto *w = F->getWeightForNode(ph.first);
-      externalTensors_.erase(w);
+namespace {
+/// State shared by the threads executing the chunks of a parallelFor.
+struct ParallelForState {
+  /// Number of items and of chunks the items are split into.
+  dim_t numItems;
+  dim_t numChunks;
+  /// The next chunk to be claimed by a thread.
+  std::atomic<dim_t> nextChunk{0};
+  /// Number of completed chunks.
+  dim_t numDone{0};
+  /// Protects numDone.
+  std::mutex mutex;
+  /// Signaled when all chunks are completed.
+  std::condition_variable allDone;
+};
+
+/// Claim and run chunks of \p state with \p fn until none is left.
+void runChunks(ParallelForState &state,
+               const std::function<void(dim_t, dim_t)> *fn) {
+  dim_t chunk;
+  while ((chunk = state.nextChunk++) < state.numChunks) {
+    (*fn)(chunk * state.numItems / state.numChunks,
+          (chunk + 1) * state.numItems / state.numChunks);
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (++state.numDone == state.numChunks) {
+      state.allDone.notify_all();
     }
   }
+}
+} // namespace
+
+void BoundInterpreterFunction::parallelFor(
+    dim_t numItems, dim_t workPerItem,
+    const std::function<void(dim_t, dim_t)> &fn) {
+  if (!threadPool_ || numItems < 2 ||
+      numItems * std::max<dim_t>(workPerItem, 1) < minParallelWork_) {
+    fn(0, numItems);
+    return;
+  }
+
+  // Use a few chunks per thread to balance the load, the calling thread
+  // processes chunks too.
+  dim_t numThreads = threadPool_->getNumWorkers() + 1;
+  auto state = std::make_shared<ParallelForState>();
+  state->numItems = numItems;
+  state->numChunks = std::min<dim_t>(numItems, 4 * numThreads);
+
+  // Helpers may start after all chunks are done and this call returned, so
+  // they may only touch fn once they claimed a chunk.
+  const auto *fnPtr = &fn;
+  for (dim_t i = 1; i < numThreads; i++) {
+    threadPool_->submit([state, fnPtr]() { runChunks(*state, fnPtr); });
+  }
+  // The calling thread may be a thread of the pool itself, so it only waits
+  // once all chunks are claimed to avoid waiting on queued helpers.
+  runChunks(*state, &fn);
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->allDone.wait(lock,
+                      [&]() { return state->numDone == state->numChunks; });
+}
+
+Error BoundInterpreterFunction::execute(ExecutionContext *context,
+                                        ThreadPool *threadPool,
+                                        dim_t minParallelWork) {
+  threadPool_ = threadPool;
+  minParallelWork_ = minParallelWork;
+  {
+    TRACE_EVENT_SCOPE(context, TraceLevel::RUNTIME, "registerTensors");
+    bind(context);
+  }
+
+  // Custom instruction processing is not required to be thread-safe.
+  if (threadPool && !getIRInstructionProcessingHandler()) {
+    executeParallel(threadPool);
+    return Error::success();
+  }
+
+  // Do the forward pass, dispatching the interpreter on each instruction in
+  // the program.
+  for (const auto &DI : function_.program_) {
+    executeInstr(DI);
+  }
 
   return Error::success();
 }
@@ -27,6 +27,7 @@
 
 #include <chrono>
 #include <cmath>
+#include <limits>
 #include <math.h>
 
 #ifdef WIN32
@@ -186,6 +187,65 @@ using namespace glow;
                        typename std::remove_cv<ElemTy>::type>::value,          \
       "This implementation is for arithmetic values only")
 
+//===----------------------------------------------------------------------===//
+//                       Blocked floating point kernels
+//===----------------------------------------------------------------------===//
+
+/// Number of rows of the left-hand side processed together by the blocked
+/// matrix multiplication, sharing each loaded row of the right-hand side.
+static constexpr dim_t kMatMulRowBlock = 4;
+/// Number of output columns accumulated together by the blocked kernels.
+static constexpr dim_t kMatMulColBlock = 128;
+
+/// Multiplies the row-major MxK matrix \p lhs with the KxN matrix \p rhs
+/// into the MxN matrix \p dest, adding the optional vector \p bias of N
+/// elements to each row. \p lhsRowStride, \p rhsRowStride and
+/// \p destRowStride are the distances between rows in elements. Every
+/// element of dest accumulates its products in float and in order of k, so
+/// the results are identical to the naive triple loop. If \p ProductInElemTy
+/// is set the products are computed in ElemTy before being accumulated.
+template <typename ElemTy, bool ProductInElemTy>
+static void blockedMatMul(const ElemTy *lhs, const ElemTy *rhs, ElemTy *dest,
+                          const ElemTy *bias, dim_t M, dim_t K, dim_t N,
+                          dim_t lhsRowStride, dim_t rhsRowStride,
+                          dim_t destRowStride) {
+  float acc[kMatMulRowBlock][kMatMulColBlock];
+  for (dim_t x0 = 0; x0 < M; x0 += kMatMulRowBlock) {
+    dim_t rows = std::min(kMatMulRowBlock, M - x0);
+    for (dim_t y0 = 0; y0 < N; y0 += kMatMulColBlock) {
+      dim_t cols = std::min(kMatMulColBlock, N - y0);
+      for (dim_t r = 0; r < rows; r++) {
+        std::fill(&acc[r][0], &acc[r][0] + cols, 0.f);
+      }
+      for (dim_t k = 0; k < K; k++) {
+        const ElemTy *rhsRow = rhs + k * rhsRowStride + y0;
+        for (dim_t r = 0; r < rows; r++) {
+          const ElemTy a = lhs[(x0 + r) * lhsRowStride + k];
+          float *accRow = acc[r];
+          for (dim_t y = 0; y < cols; y++) {
+            accRow[y] += ProductInElemTy ? float(a * rhsRow[y])
+                                         : float(a) * float(rhsRow[y]);
+          }
+        }
+      }
+      for (dim_t r = 0; r < rows; r++) {
+        ElemTy *destRow = dest + (x0 + r) * destRowStride + y0;
+        for (dim_t y = 0; y < cols; y++) {
+          destRow[y] = bias ? ElemTy(acc[r][y] + float(bias[y0 + y]))
+                            : ElemTy(acc[r][y]);
+        }
+      }
+    }
+  }
+}
+
+/// \returns a pointer to the payload of \p T viewed as elements of ElemTy.
+template <typename ElemTy> static ElemTy *getTypedPtr(Tensor *T) {
+  assert((T->dims().empty() || T->getType().strides().back() == 1) &&
+         "The innermost dimension must be dense");
+  return reinterpret_cast<ElemTy *>(T->getUnsafePtr());
+}
+
 //===----------------------------------------------------------------------===//
 //                       Convolution
 //===----------------------------------------------------------------------===//
@@ -215,23 +275,42 @@ void BoundInterpreterFunction::fwdConvolutionInstFloatImpl(
 
   PaddingTLBR pdim(pads);
 
+  Tensor *inT = getTensor(inV);
+  Tensor *outT = getTensor(outV);
+  Tensor *filterT = getTensor(filterV);
+  const ElemTy *inP = getTypedPtr<ElemTy>(inT);
+  ElemTy *outP = getTypedPtr<ElemTy>(outT);
+  const ElemTy *filterP = getTypedPtr<ElemTy>(filterT);
+  auto inS = inT->getType().strides();
+  auto outS = outT->getType().strides();
+  auto filterS = filterT->getType().strides();
+
+  // Accumulators of a block of output channels of a single output pixel. Each
+  // accumulates its products in the same order as a naive loop nest over
+  // (fx, fy, fd) would, while the input window is reused across the block.
+  float acc[kMatMulColBlock];
+
   // For each input in the batch:
   for (dim_t n = 0; n < idim.n; n++) {
 
     // For each group of input channels:
     for (dim_t g = 0; g < group; g++) {
+      const ElemTy *inG = inP + n * inS[0] + g * inCperG;
 
-      // For each output channel in the group:
-      for (dim_t d = g * outCperG; d < (g + 1) * outCperG; d++) {
+      // For each convolution 'jump' in the input tensor:
+      ssize_t x = -ssize_t(pdim.top);
+      for (dim_t ax = 0; ax < odim.h; x += sdim.height, ax++) {
+        ssize_t y = -ssize_t(pdim.left);
+        for (dim_t ay = 0; ay < odim.w; y += sdim.width, ay++) {
+          ElemTy *outPixel = outP + n * outS[0] + ax * outS[1] + ay * outS[2];
 
-        // For each convolution 'jump' in the input tensor:
-        ssize_t x = -ssize_t(pdim.top);
-        for (dim_t ax = 0; ax < odim.h; x += sdim.height, ax++) {
-          ssize_t y = -ssize_t(pdim.left);
-          for (dim_t ay = 0; ay < odim.w; y += sdim.width, ay++) {
+          // For each block of output channels in the group:
+          for (dim_t d0 = g * outCperG; d0 < (g + 1) * outCperG;
+               d0 += kMatMulColBlock) {
+            dim_t numD = std::min(kMatMulColBlock, (g + 1) * outCperG - d0);
+            std::fill(acc, acc + numD, 0.f);
 
             // For each element in the convolution-filter:
-            float sum = 0;
             for (dim_t fx = 0; fx < kdim.height; fx++) {
               for (dim_t fy = 0; fy < kdim.width; fy++) {
                 sdim_t ox = x + fx * dilation;
@@ -242,19 +321,26 @@ void BoundInterpreterFunction::fwdConvolutionInstFloatImpl(
                     oy >= ssize_t(idim.w)) {
                   continue;
                 }
-                for (dim_t fd = 0; fd < inCperG; fd++) {
-                  sum += float(
-                      filterW.at({d, fx, fy, fd}) *
-                      inW.at({n, (dim_t)ox, (dim_t)oy, g * inCperG + fd}));
+                const ElemTy *inPixel = inG + ox * inS[1] + oy * inS[2];
+                const ElemTy *filterPixel =
+                    filterP + fx * filterS[1] + fy * filterS[2];
+                for (dim_t i = 0; i < numD; i++) {
+                  const ElemTy *filterRow = filterPixel + (d0 + i) * filterS[0];
+                  float sum = acc[i];
+                  for (dim_t fd = 0; fd < inCperG; fd++) {
+                    sum += float(filterRow[fd] * inPixel[fd]);
+                  }
+                  acc[i] = sum;
                 }
               }
             }
 
-            sum += float(biasW.at({d}));
-            outW.at({n, ax, ay, d}) = ElemTy(sum);
-          } // W
-        }   // H
-      }     // C
+            for (dim_t i = 0; i < numD; i++) {
+              outPixel[d0 + i] = ElemTy(acc[i] + float(biasW.at({d0 + i})));
+            }
+          } // C
+        }   // W
+      }     // H
     }       // G
   }         // N
 }
@@ -2488,19 +2574,21 @@ void BoundInterpreterFunction::fwdElementAddInstI8Impl(
   auto outW = getWeightHandle<int8_t>(I->getDest());
   auto lhsW = getWeightHandle<int8_t>(I->getLHS());
   auto rhsW = getWeightHandle<int8_t>(I->getRHS());
-  for (dim_t i = 0, e = outW.size(); i < e; i++) {
-    int32_t L = lhsW.raw(i);
-    int32_t R = rhsW.raw(i);
+  parallelFor(outW.size(), 1, [&](dim_t begin, dim_t end) {
+    for (dim_t i = begin; i < end; i++) {
+      int32_t L = lhsW.raw(i);
+      int32_t R = rhsW.raw(i);
 
-    // We increase the size of the integer up to 16 bits to prevent overflow.
-    const float largeScale = float(1) / (1 << 15);
-    // Scale both sides from 8-bit to 16-bits.
-    int32_t L32 = std::round(float(L - lhsOffset) * (lhsScale / largeScale));
-    int32_t R32 = std::round(float(R - rhsOffset) * (rhsScale / largeScale));
-    int32_t sum32 = L32 + R32;
-    sum32 = std::round(float(sum32) * (largeScale / destScale) + destOffset);
-    outW.raw(i) = quantization::clip<int32_t, int8_t>(sum32);
-  }
+      // We increase the size of the integer up to 16 bits to prevent overflow.
+      const float largeScale = float(1) / (1 << 15);
+      // Scale both sides from 8-bit to 16-bits.
+      int32_t L32 = std::round(float(L - lhsOffset) * (lhsScale / largeScale));
+      int32_t R32 = std::round(float(R - rhsOffset) * (rhsScale / largeScale));
+      int32_t sum32 = L32 + R32;
+      sum32 = std::round(float(sum32) * (largeScale / destScale) + destOffset);
+      outW.raw(i) = quantization::clip<int32_t, int8_t>(sum32);
+    }
+  });
 }
 
 template <typename ElemTy>
@@ -2511,9 +2599,11 @@ void BoundInterpreterFunction::fwdElementAddInstArithmeticImpl(
   auto outW = getWeightHandle<ElemTy>(I->getDest());
   auto lhsW = getWeightHandle<ElemTy>(I->getLHS());
   auto rhsW = getWeightHandle<ElemTy>(I->getRHS());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = lhsW.raw(i) + rhsW.raw(i);
-  }
+  parallelFor(outW.size(), 1, [&](dim_t begin, dim_t end) {
+    for (dim_t i = begin; i < end; i++) {
+      outW.raw(i) = lhsW.raw(i) + rhsW.raw(i);
+    }
+  });
 }
 
 void BoundInterpreterFunction::fwdElementAddInst(const ElementAddInst *I) {
@@ -2534,9 +2624,11 @@ void BoundInterpreterFunction::fwdElementSubInstArithmeticImpl(
   auto outW = getWeightHandle<ElemTy>(I->getDest());
   auto lhsW = getWeightHandle<ElemTy>(I->getLHS());
   auto rhsW = getWeightHandle<ElemTy>(I->getRHS());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = lhsW.raw(i) - rhsW.raw(i);
-  }
+  parallelFor(outW.size(), 1, [&](dim_t begin, dim_t end) {
+    for (dim_t i = begin; i < end; i++) {
+      outW.raw(i) = lhsW.raw(i) - rhsW.raw(i);
+    }
+  });
 }
 
 void BoundInterpreterFunction::fwdElementSubInst(const ElementSubInst *I) {
@@ -2556,14 +2648,16 @@ void BoundInterpreterFunction::fwdElementSubInst(const ElementSubInst *I) {
     auto outW = getWeightHandle<int8_t>(I->getDest());
     auto lhsW = getWeightHandle<int8_t>(I->getLHS());
     auto rhsW = getWeightHandle<int8_t>(I->getRHS());
-    for (size_t i = 0, e = outW.size(); i < e; i++) {
-      //    s_d * (i_d - o_d) = s_l * (i_l - o_l) - s_r * (i_r - o_r)
-      // => i_d = (s_l / s_d) * (i_l - o_l) - (s_r / s_d) * (i_r - o_r) + o_d
-      float l = (lhsScale / destScale) * float(lhsW.raw(i) - lhsOffset);
-      float r = (rhsScale / destScale) * float(rhsW.raw(i) - rhsOffset);
-      int32_t q = std::round(l - r + destOffset);
-      outW.raw(i) = quantization::clip<int32_t, int8_t>(q);
-    }
+    parallelFor(outW.size(), 1, [&](dim_t begin, dim_t end) {
+      for (dim_t i = begin; i < end; i++) {
+        //    s_d * (i_d - o_d) = s_l * (i_l - o_l) - s_r * (i_r - o_r)
+        // => i_d = (s_l / s_d) * (i_l - o_l) - (s_r / s_d) * (i_r - o_r) + o_d
+        float l = (lhsScale / destScale) * float(lhsW.raw(i) - lhsOffset);
+        float r = (rhsScale / destScale) * float(rhsW.raw(i) - rhsOffset);
+        int32_t q = std::round(l - r + destOffset);
+        outW.raw(i) = quantization::clip<int32_t, int8_t>(q);
+      }
+    });
     return;
   }
 
@@ -2579,9 +2673,11 @@ void BoundInterpreterFunction::fwdElementMulInstArithmeticImpl(
   auto outW = getWeightHandle<ElemTy>(I->getDest());
   auto lhsW = getWeightHandle<ElemTy>(I->getLHS());
   auto rhsW = getWeightHandle<ElemTy>(I->getRHS());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = lhsW.raw(i) * rhsW.raw(i);
-  }
+  parallelFor(outW.size(), 1, [&](dim_t begin, dim_t end) {
+    for (dim_t i = begin; i < end; i++) {
+      outW.raw(i) = lhsW.raw(i) * rhsW.raw(i);
+    }
+  });
 }
 
 void BoundInterpreterFunction::fwdElementMulInst(const ElementMulInst *I) {
@@ -2598,11 +2694,13 @@ void BoundInterpreterFunction::fwdElementMulInst(const ElementMulInst *I) {
     auto lhsW = getWeightHandle<int8_t>(I->getLHS());
     auto rhsW = getWeightHandle<int8_t>(I->getRHS());
     float scale = lhsQ.scale * rhsQ.scale / destQ.scale;
-    for (size_t i = 0, e = outW.size(); i < e; i++) {
-      int32_t mul = (lhsW.raw(i) - lhsQ.offset) * (rhsW.raw(i) - rhsQ.offset);
-      outW.raw(i) = quantization::clip<int32_t, int8_t>(
-          std::round(mul * scale) + destQ.offset);
-    }
+    parallelFor(outW.size(), 1, [&](dim_t begin, dim_t end) {
+      for (dim_t i = begin; i < end; i++) {
+        int32_t mul = (lhsW.raw(i) - lhsQ.offset) * (rhsW.raw(i) - rhsQ.offset);
+        outW.raw(i) = quantization::clip<int32_t, int8_t>(
+            std::round(mul * scale) + destQ.offset);
+      }
+    });
     return;
   }
 
@@ -2627,14 +2725,16 @@ void BoundInterpreterFunction::fwdElementDivInst(const ElementDivInst *I) {
     auto outW = getWeightHandle<int8_t>(I->getDest());
     auto lhsW = getWeightHandle<int8_t>(I->getLHS());
     auto rhsW = getWeightHandle<int8_t>(I->getRHS());
-    for (size_t i = 0, e = outW.size(); i < e; i++) {
-      //    s_d * (i_d - o_d) = (s_l * (i_l - o_l)) / (s_r * (i_r - o_r))
-      // => i_d = (s_l * (i_l - o_l)) / (s_d * s_r * (i_r - o_r)) + o_d
-      float l = lhsScale * float(lhsW.raw(i) - lhsOffset);
-      float r = rhsScale * destScale * float(rhsW.raw(i) - rhsOffset);
-      int32_t q = std::round(l / r + destOffset);
-      outW.raw(i) = quantization::clip<int32_t, int8_t>(q);
-    }
+    parallelFor(outW.size(), 1, [&](dim_t begin, dim_t end) {
+      for (dim_t i = begin; i < end; i++) {
+        //    s_d * (i_d - o_d) = (s_l * (i_l - o_l)) / (s_r * (i_r - o_r))
+        // => i_d = (s_l * (i_l - o_l)) / (s_d * s_r * (i_r - o_r)) + o_d
+        float l = lhsScale * float(lhsW.raw(i) - lhsOffset);
+        float r = rhsScale * destScale * float(rhsW.raw(i) - rhsOffset);
+        int32_t q = std::round(l / r + destOffset);
+        outW.raw(i) = quantization::clip<int32_t, int8_t>(q);
+      }
+    });
     return;
   }
 
@@ -2642,9 +2742,11 @@ void BoundInterpreterFunction::fwdElementDivInst(const ElementDivInst *I) {
   auto outW = getWeightHandle<TYPE_>(I->getDest());                            \
   auto lhsW = getWeightHandle<TYPE_>(I->getLHS());                             \
   auto rhsW = getWeightHandle<TYPE_>(I->getRHS());                             \
-  for (size_t i = 0, e = outW.size(); i < e; i++) {                            \
-    outW.raw(i) = lhsW.raw(i) / rhsW.raw(i);                                   \
-  }
+  parallelFor(outW.size(), 1, [&](dim_t begin, dim_t end) {                    \
+    for (dim_t i = begin; i < end; i++) {                                      \
+      outW.raw(i) = lhsW.raw(i) / rhsW.raw(i);                                 \
+    }                                                                          \
+  });
 
   auto *T = getTensor(I->getDest());
   switch (T->getElementType()) {
@@ -2680,15 +2782,17 @@ void BoundInterpreterFunction::fwdElementMaxInstI8Impl(
   auto outW = getWeightHandle<int8_t>(I->getDest());
   auto lhsW = getWeightHandle<int8_t>(I->getLHS());
   auto rhsW = getWeightHandle<int8_t>(I->getRHS());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    // Convert both sides to the destination scale and perform a regular
-    // comparison.
-    int8_t L = quantization::quantize(
-        quantization::dequantize(lhsW.raw(i), lhsQ), destQ);
-    int8_t R = quantization::quantize(
-        quantization::dequantize(rhsW.raw(i), rhsQ), destQ);
-    outW.raw(i) = std::max(L, R);
-  }
+  parallelFor(outW.size(), 1, [&](dim_t begin, dim_t end) {
+    for (dim_t i = begin; i < end; i++) {
+      // Convert both sides to the destination scale and perform a regular
+      // comparison.
+      int8_t L = quantization::quantize(
+          quantization::dequantize(lhsW.raw(i), lhsQ), destQ);
+      int8_t R = quantization::quantize(
+          quantization::dequantize(rhsW.raw(i), rhsQ), destQ);
+      outW.raw(i) = std::max(L, R);
+    }
+  });
 }
 
 template <typename ElemTy>
@@ -2699,9 +2803,11 @@ void BoundInterpreterFunction::fwdElementMaxInstArithmeticImpl(
   auto outW = getWeightHandle<ElemTy>(I->getDest());
   auto lhsW = getWeightHandle<ElemTy>(I->getLHS());
   auto rhsW = getWeightHandle<ElemTy>(I->getRHS());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = std::max(lhsW.raw(i), rhsW.raw(i));
-  }
+  parallelFor(outW.size(), 1, [&](dim_t begin, dim_t end) {
+    for (dim_t i = begin; i < end; i++) {
+      outW.raw(i) = std::max(lhsW.raw(i), rhsW.raw(i));
+    }
+  });
 }
 
 void BoundInterpreterFunction::fwdElementMaxInst(const ElementMaxInst *I) {
@@ -2722,9 +2828,11 @@ void BoundInterpreterFunction::fwdElementMinInstArithmeticImpl(
   auto outW = getWeightHandle<ElemTy>(I->getDest());
   auto lhsW = getWeightHandle<ElemTy>(I->getLHS());
   auto rhsW = getWeightHandle<ElemTy>(I->getRHS());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = std::min(lhsW.raw(i), rhsW.raw(i));
-  }
+  parallelFor(outW.size(), 1, [&](dim_t begin, dim_t end) {
+    for (dim_t i = begin; i < end; i++) {
+      outW.raw(i) = std::min(lhsW.raw(i), rhsW.raw(i));
+    }
+  });
 }
 
 void BoundInterpreterFunction::fwdElementMinInst(const ElementMinInst *I) {
@@ -2740,15 +2848,17 @@ void BoundInterpreterFunction::fwdElementMinInst(const ElementMinInst *I) {
     auto outW = getWeightHandle<int8_t>(I->getDest());
     auto lhsW = getWeightHandle<int8_t>(I->getLHS());
     auto rhsW = getWeightHandle<int8_t>(I->getRHS());
-    for (size_t i = 0, e = outW.size(); i < e; i++) {
-      // Convert both sides to the destination scale and perform a regular
-      // comparison.
-      int8_t L = quantization::quantize(
-          quantization::dequantize(lhsW.raw(i), lhsQ), destQ);
-      int8_t R = quantization::quantize(
-          quantization::dequantize(rhsW.raw(i), rhsQ), destQ);
-      outW.raw(i) = std::min(L, R);
-    }
+    parallelFor(outW.size(), 1, [&](dim_t begin, dim_t end) {
+      for (dim_t i = begin; i < end; i++) {
+        // Convert both sides to the destination scale and perform a regular
+        // comparison.
+        int8_t L = quantization::quantize(
+            quantization::dequantize(lhsW.raw(i), lhsQ), destQ);
+        int8_t R = quantization::quantize(
+            quantization::dequantize(rhsW.raw(i), rhsQ), destQ);
+        outW.raw(i) = std::min(L, R);
+      }
+    });
     return;
   }
 
@@ -3254,27 +3364,18 @@ template <typename ElemTy>
 void BoundInterpreterFunction::fwdMatMulInstFloatImpl(const MatMulInst *I) {
   staticAssertFloatingPointType(ElemTy);
 
-  auto lhs = getWeightHandle<ElemTy>(I->getLHS());
-  auto rhs = getWeightHandle<ElemTy>(I->getRHS());
-  auto dest = getWeightHandle<ElemTy>(I->getDest());
-
-  auto destDim = dest.dims();
-  auto lhsDim = lhs.dims();
-
-  dest.clear(0);
+  Tensor *lhs = getTensor(I->getLHS());
+  Tensor *rhs = getTensor(I->getRHS());
+  Tensor *dest = getTensor(I->getDest());
 
-  // For each (x,y) in the destination matrix:
-  for (dim_t x = 0; x < destDim[0]; x++) {
-    for (dim_t y = 0; y < destDim[1]; y++) {
+  auto destDim = dest->dims();
+  auto lhsDim = lhs->dims();
 
-      // Perform DOT on the row an column.
-      float sum = 0;
-      for (dim_t i = 0; i < lhsDim[1]; i++) {
-        sum += float(lhs.at({x, i}) * rhs.at({i, y}));
-      }
-      dest.at({x, y}) = ElemTy(sum);
-    }
-  }
+  blockedMatMul<ElemTy, /* ProductInElemTy */ true>(
+      getTypedPtr<ElemTy>(lhs), getTypedPtr<ElemTy>(rhs),
+      getTypedPtr<ElemTy>(dest), nullptr, destDim[0], lhsDim[1], destDim[1],
+      lhs->getType().strides()[0], rhs->getType().strides()[0],
+      dest->getType().strides()[0]);
 }
 
 void BoundInterpreterFunction::fwdMatMulInst(const glow::MatMulInst *I) {
@@ -3288,9 +3389,97 @@ void BoundInterpreterFunction::fwdMatMulInst(const glow::MatMulInst *I) {
                             I->getLHS()->getElementType(), I);
 }
 
+template <typename ElemTy>
+void BoundInterpreterFunction::fwdBatchMatMulInstFloatImpl(
+    const BatchMatMulInst *I) {
+  staticAssertFloatingPointType(ElemTy);
+
+  Tensor *lhs = getTensor(I->getLHS());
+  Tensor *rhs = getTensor(I->getRHS());
+  Tensor *dest = getTensor(I->getDest());
+
+  auto destDim = dest->dims();
+  auto lhsDim = lhs->dims();
+  auto lhsS = lhs->getType().strides();
+  auto rhsS = rhs->getType().strides();
+  auto destS = dest->getType().strides();
+
+  // Same as a MatMul of each of the batches, which is what BatchMatMul used to
+  // be lowered to.
+  for (dim_t b = 0; b < destDim[0]; b++) {
+    blockedMatMul<ElemTy, /* ProductInElemTy */ true>(
+        getTypedPtr<ElemTy>(lhs) + b * lhsS[0],
+        getTypedPtr<ElemTy>(rhs) + b * rhsS[0],
+        getTypedPtr<ElemTy>(dest) + b * destS[0], nullptr, destDim[1],
+        lhsDim[2], destDim[2], lhsS[1], rhsS[1], destS[1]);
+  }
+}
+
 void BoundInterpreterFunction::fwdBatchMatMulInst(
     const glow::BatchMatMulInst *I) {
-  DCHECK(!"Found BatchMatMulInst but BatchMatMul is lowered on Interpreter");
+  dispatchFloatingPointImpl(fwdBatchMatMulInstFloatImpl,
+                            I->getLHS()->getElementType(), I);
+}
+
+template <typename ElemTy>
+void BoundInterpreterFunction::fwdScaledDotProductAttentionInstFloatImpl(
+    const ScaledDotProductAttentionInst *I) {
+  staticAssertFloatingPointType(ElemTy);
+
+  auto QH = getWeightHandle<ElemTy>(I->getQueries());
+  auto KH = getWeightHandle<ElemTy>(I->getKeys());
+  auto VH = getWeightHandle<ElemTy>(I->getValues());
+  auto MH = getWeightHandle<ElemTy>(I->getMask());
+  auto destH = getWeightHandle<ElemTy>(I->getDest());
+  const float scale = I->getScale();
+
+  const dim_t numBatches = QH.dims()[0];
+  const dim_t queryLen = QH.dims()[1];
+  const dim_t headDim = QH.dims()[2];
+  const dim_t keyLen = KH.dims()[1];
+  const dim_t valueDim = VH.dims()[2];
+  const bool broadcastMask = MH.dims()[1] == 1;
+
+  std::vector<float> probs(keyLen);
+  for (dim_t b = 0; b < numBatches; b++) {
+    for (dim_t q = 0; q < queryLen; q++) {
+      // Compute the scores of the row and their max.
+      const dim_t maskRow = broadcastMask ? 0 : q;
+      float max = std::numeric_limits<float>::lowest();
+      for (dim_t k = 0; k < keyLen; k++) {
+        float score = 0;
+        for (dim_t d = 0; d < headDim; d++) {
+          score += float(QH.at({b, q, d})) * float(KH.at({b, k, d}));
+        }
+        probs[k] = score * scale + float(MH.at({b, maskRow, k}));
+        max = std::max(max, probs[k]);
+      }
+
+      // SoftMax of the scores.
+      float sum = 0;
+      for (dim_t k = 0; k < keyLen; k++) {
+        probs[k] = std::exp(probs[k] - max);
+        sum += probs[k];
+      }
+
+      // The rows whose keys are all masked out are NaN, like the SoftMax.
+      for (dim_t v = 0; v < valueDim; v++) {
+        float acc = 0;
+        for (dim_t k = 0; k < keyLen; k++) {
+          acc += probs[k] * float(VH.at({b, k, v}));
+        }
+        destH.at({b, q, v}) =
+            sum > 0 ? ElemTy(acc / sum)
+                    : ElemTy(std::numeric_limits<float>::quiet_NaN());
+      }
+    }
+  }
+}
+
+void BoundInterpreterFunction::fwdScaledDotProductAttentionInst(
+    const glow::ScaledDotProductAttentionInst *I) {
+  dispatchFloatingPointImpl(fwdScaledDotProductAttentionInstFloatImpl,
+                            I->getQueries()->getElementType(), I);
 }
 
 void BoundInterpreterFunction::fwdReluGradInst(const glow::ReluGradInst *I) {
@@ -3362,26 +3551,19 @@ void BoundInterpreterFunction::fwdFullyConnectedInstFloatImpl(
     const FullyConnectedInst *I) {
   staticAssertFloatingPointType(ElemTy);
 
-  auto inW = getWeightHandle<ElemTy>(I->getSrc());
-  auto weightsW = getWeightHandle<ElemTy>(I->getWeights());
-  auto biasW = getWeightHandle<ElemTy>(I->getBias());
-  auto outW = getWeightHandle<ElemTy>(I->getDest());
-
-  ShapeHW idim(inW.dims());
-  ShapeHW odim(outW.dims());
-
-  outW.clear(0);
+  Tensor *in = getTensor(I->getSrc());
+  Tensor *weights = getTensor(I->getWeights());
+  Tensor *bias = getTensor(I->getBias());
+  Tensor *out = getTensor(I->getDest());
 
-  for (dim_t i = 0; i < idim.height; i++) {
-    for (dim_t j = 0; j < odim.width; j++) {
-      float sum = 0;
-      for (dim_t k = 0; k < idim.width; k++) {
-        sum += float(inW.at({i, k})) * float(weightsW.at({k, j}));
-      }
+  ShapeHW idim(in->dims());
+  ShapeHW odim(out->dims());
 
-      outW.at({i, j}) = sum + float(biasW.at({j}));
-    }
-  }
+  blockedMatMul<ElemTy, /* ProductInElemTy */ false>(
+      getTypedPtr<ElemTy>(in), getTypedPtr<ElemTy>(weights),
+      getTypedPtr<ElemTy>(out), getTypedPtr<ElemTy>(bias), idim.height,
+      idim.width, odim.width, in->getType().strides()[0],
+      weights->getType().strides()[0], out->getType().strides()[0]);
 }
 
 void BoundInterpreterFunction::fwdFullyConnectedInst(
@@ -3398,6 +3580,51 @@ void BoundInterpreterFunction::fwdFullyConnectedInst(
   }
 }
 
+template <typename ElemTy>
+void BoundInterpreterFunction::fwdBlockSparseFullyConnectedInstImpl(
+    const BlockSparseFullyConnectedInst *I) {
+  staticAssertFloatingPointType(ElemTy);
+
+  auto inW = getWeightHandle<ElemTy>(I->getSrc());
+  auto outW = getWeightHandle<ElemTy>(I->getDest());
+  auto valuesW = getWeightHandle<ElemTy>(I->getValues());
+  auto colIndicesW = getWeightHandle<int32_t>(I->getColIndices());
+  auto rowOffsetsW = getWeightHandle<int32_t>(I->getRowOffsets());
+  auto biasW = getWeightHandle<ElemTy>(I->getBias());
+  ShapeHW idim(inW.dims());
+  ShapeHW odim(outW.dims());
+  const dim_t blockRows = I->getBlockRows();
+  const dim_t blockCols = I->getBlockCols();
+
+  std::vector<float> acc(odim.width);
+  for (dim_t i = 0; i < idim.height; i++) {
+    for (dim_t j = 0; j < odim.width; j++) {
+      acc[j] = float(biasW.raw(j));
+    }
+    // Only the non-zero blocks of the weights contribute to the result.
+    for (dim_t br = 0; br < idim.width / blockRows; br++) {
+      for (int32_t b = rowOffsetsW.raw(br); b < rowOffsetsW.raw(br + 1); b++) {
+        dim_t col = colIndicesW.raw(b) * blockCols;
+        for (dim_t k = 0; k < blockRows; k++) {
+          float in = float(inW.at({i, br * blockRows + k}));
+          for (dim_t j = 0; j < blockCols; j++) {
+            acc[col + j] += in * float(valuesW.at({dim_t(b), k, j}));
+          }
+        }
+      }
+    }
+    for (dim_t j = 0; j < odim.width; j++) {
+      outW.at({i, j}) = ElemTy(acc[j]);
+    }
+  }
+}
+
+void BoundInterpreterFunction::fwdBlockSparseFullyConnectedInst(
+    const BlockSparseFullyConnectedInst *I) {
+  dispatchFloatingPointImpl(fwdBlockSparseFullyConnectedInstImpl,
+                            I->getSrc()->getElementType(), I);
+}
+
 //===----------------------------------------------------------------------===//
 //                       Row-wise quantized FC
 //===----------------------------------------------------------------------===//
@@ -3890,6 +4117,18 @@ void BoundInterpreterFunction::fwdSparseLengthsSumInst(
                                     I->getIndices()->getElementType(), I);
 }
 
+/// \returns the offsets of the first index of each of the \p segments
+/// segments whose lengths are given by \p LH, followed by the total length.
+/// This allows reducing the segments independently of each other.
+static std::vector<dim_t> getSegmentOffsets(const Handle<int32_t> &LH,
+                                            dim_t segments) {
+  std::vector<dim_t> offsets(segments + 1, 0);
+  for (dim_t i = 0; i < segments; i++) {
+    offsets[i + 1] = offsets[i] + LH.raw(i);
+  }
+  return offsets;
+}
+
 template <typename ElemTy, typename TI>
 void BoundInterpreterFunction::fwdSparseLengthsWeightedSumInstFloatImpl(
     const SparseLengthsWeightedSumInst *I) {
@@ -3906,11 +4145,9 @@ void BoundInterpreterFunction::fwdSparseLengthsWeightedSumInstFloatImpl(
   auto IH = indices->getHandle<TI>();
   auto LH = lengths->getHandle<int32_t>();
 
-  size_t segments = lengths->dims()[0];
-  size_t totalLength = 0;
-  for (dim_t i = 0; i < segments; i++) {
-    totalLength += LH.raw(i);
-  }
+  dim_t segments = lengths->dims()[0];
+  std::vector<dim_t> segmentBegin = getSegmentOffsets(LH, segments);
+  dim_t totalLength = segmentBegin[segments];
   assert(totalLength <= indices->dims()[0] &&
          "sum(Lengths) must be equal to len(Indices)");
 
@@ -3920,16 +4157,20 @@ void BoundInterpreterFunction::fwdSparseLengthsWeightedSumInstFloatImpl(
   auto WH = weights->getHandle<ElemTy>();
   auto OH = out->getHandle<ElemTy>();
 
-  dim_t curIdx = 0;
-  for (dim_t i = 0; i < segments; i++) {
-    for (dim_t j = 0, e = LH.raw(i); j < e; j++) {
-      ElemTy weight = WH.raw(curIdx);
-      size_t offsetIn = IH.raw(curIdx++) * lineSize;
-      size_t offsetOut = i * lineSize;
-      for (dim_t k = 0; k < lineSize; k++)
-        OH.raw(offsetOut++) += DH.raw(offsetIn++) * weight;
+  // Segments are reduced independently of each other.
+  dim_t workPerSegment = segments ? totalLength * lineSize / segments : 0;
+  parallelFor(segments, workPerSegment, [&](dim_t begin, dim_t end) {
+    for (dim_t i = begin; i < end; i++) {
+      for (dim_t curIdx = segmentBegin[i]; curIdx < segmentBegin[i + 1];
+           curIdx++) {
+        ElemTy weight = WH.raw(curIdx);
+        size_t offsetIn = IH.raw(curIdx) * lineSize;
+        size_t offsetOut = i * lineSize;
+        for (dim_t k = 0; k < lineSize; k++)
+          OH.raw(offsetOut++) += DH.raw(offsetIn++) * weight;
+      }
     }
-  }
+  });
 }
 
 template <typename TI>
@@ -3948,10 +4189,8 @@ void BoundInterpreterFunction::fwdSparseLengthsWeightedSumInstI8Impl(
   auto LH = lengths->getHandle<int32_t>();
 
   dim_t segments = lengths->dims()[0];
-  dim_t totalLength = 0;
-  for (dim_t i = 0; i < segments; i++) {
-    totalLength += LH.raw(i);
-  }
+  std::vector<dim_t> segmentBegin = getSegmentOffsets(LH, segments);
+  dim_t totalLength = segmentBegin[segments];
   assert(totalLength <= indices->dims()[0] &&
          "sum(Lengths) must be equal to len(Indices)");
 
@@ -3967,22 +4206,26 @@ void BoundInterpreterFunction::fwdSparseLengthsWeightedSumInstI8Impl(
   };
   using namespace quantization;
 
-  dim_t curIdx = 0;
-  for (dim_t i = 0; i < segments; i++) {
-    std::vector<float> accum(lineSize, 0.0f);
-    for (int32_t j = 0; j < LH.raw(i); j++) {
-      float weight = dequantize(WH.raw(curIdx), TQP(weights));
-      size_t offsetIn = IH.raw(curIdx) * lineSize;
+  // Segments are reduced independently of each other.
+  dim_t workPerSegment = segments ? totalLength * lineSize / segments : 0;
+  parallelFor(segments, workPerSegment, [&](dim_t begin, dim_t end) {
+    std::vector<float> accum(lineSize);
+    for (dim_t i = begin; i < end; i++) {
+      std::fill(accum.begin(), accum.end(), 0.0f);
+      for (dim_t curIdx = segmentBegin[i]; curIdx < segmentBegin[i + 1];
+           curIdx++) {
+        float weight = dequantize(WH.raw(curIdx), TQP(weights));
+        size_t offsetIn = IH.raw(curIdx) * lineSize;
+        for (dim_t k = 0; k < lineSize; k++) {
+          accum[k] += weight * dequantize(DH.raw(offsetIn++), TQP(data));
+        }
+      }
+      dim_t offsetOut = i * lineSize;
       for (dim_t k = 0; k < lineSize; k++) {
-        accum[k] += weight * dequantize(DH.raw(offsetIn++), TQP(data));
+        OH.raw(offsetOut++) = quantize(accum[k], TQP(out));
       }
-      curIdx++;
-    }
-    dim_t offsetOut = i * lineSize;
-    for (dim_t k = 0; k < lineSize; k++) {
-      OH.raw(offsetOut++) = quantize(accum[k], TQP(out));
     }
-  }
+  });
 }
 
 void BoundInterpreterFunction::fwdSparseLengthsSumGradInst(
@@ -4223,6 +4466,51 @@ void BoundInterpreterFunction::fwdRowwiseQuantizedSparseLengthsWeightedSumInst(
   }
 }
 
+/// Accumulates into \p accum the rows of the fused rowwise-quantized \p DH
+/// indexed by the indices \p IH in [\p begin, \p end), each scaled by its
+/// weight in \p WH. Indices are relative to the row \p rowBase.
+template <typename T, typename AccumT, typename TI>
+static void accumulateFusedRowwiseQuantizedSegment(
+    Handle<uint8_t> &DH, Handle<T> &WH, Handle<TI> &IH,
+    ElemKind scaleOffsetKind, bool using4BitQuantization, dim_t rowBase,
+    dim_t begin, dim_t end, std::vector<AccumT> &accum) {
+  const dim_t outLineSize = accum.size();
+  for (dim_t curIdx = begin; curIdx < end; curIdx++) {
+    const float weight = static_cast<float>(WH.raw(curIdx));
+    const dim_t rowIdx = rowBase + IH.raw(curIdx);
+    // Data type for the Scale and Offset for fused types need not follow
+    // the type for the output Tensor passed in T.
+    float scale, offset;
+    switch (scaleOffsetKind) {
+    case ElemKind::FloatTy:
+      std::tie(scale, offset) = DH.getFusedScaleOffsetFromRow<float>(rowIdx);
+      break;
+    case ElemKind::Float16Ty:
+      std::tie(scale, offset) =
+          DH.getFusedScaleOffsetFromRow<float16_t>(rowIdx);
+      break;
+    default:
+      llvm_unreachable("Type is not supported");
+      break;
+    }
+
+    for (dim_t k = 0; k < outLineSize; k++) {
+      float d = 0.0f;
+      if (!using4BitQuantization) {
+        d = quantization::dequantizeWithFloatOffset(
+            DH.at({rowIdx, k}), static_cast<float>(scale),
+            static_cast<float>(offset));
+      } else {
+        const bool isMSB = (k % 2 == 1);
+        d = quantization::dequantize4BitWithFloatOffset(
+            DH.at({rowIdx, k / 2}), static_cast<float>(scale),
+            static_cast<float>(offset), isMSB);
+      }
+      accum[k] += d * weight;
+    }
+  }
+}
+
 template <typename T, typename AccumT, typename TI>
 void BoundInterpreterFunction::
     fwdFusedRowwiseQuantizedSparseLengthsWeightedSumImpl(
@@ -4238,11 +4526,9 @@ void BoundInterpreterFunction::
   auto IH = indices->getHandle<TI>();
   auto LH = lengths->getHandle<int32_t>();
 
-  size_t segments = lengths->dims()[0];
-  size_t totalLength = 0;
-  for (size_t i = 0; i < segments; i++) {
-    totalLength += LH.raw(i);
-  }
+  dim_t segments = lengths->dims()[0];
+  std::vector<dim_t> segmentBegin = getSegmentOffsets(LH, segments);
+  dim_t totalLength = segmentBegin[segments];
   assert(totalLength <= indices->dims()[0] &&
          "sum(Lengths) must be equal to len(Indices)");
 
@@ -4255,50 +4541,25 @@ void BoundInterpreterFunction::
   auto WH = weights->getHandle<T>();
   auto OH = out->getHandle<T>();
 
-  dim_t curIdx = 0;
-  for (dim_t i = 0; i < segments; i++) {
-    std::vector<AccumT> accum(outLineSize, 0.0f);
-    for (dim_t j = 0, e = LH.raw(i); j < e; j++) {
-      const float weight = static_cast<float>(WH.raw(curIdx));
-      const dim_t rowIdx = IH.raw(curIdx++);
-      // Data type for the Scale and Offset for fused types need not follow
-      // the type for the output Tensor passed in T.
-      float scale, offset;
-      switch (
-          getScaleOffsetElemKindFromFused(data->getType().getElementType())) {
-      case ElemKind::FloatTy:
-        std::tie(scale, offset) = DH.getFusedScaleOffsetFromRow<float>(rowIdx);
-        break;
-      case ElemKind::Float16Ty:
-        std::tie(scale, offset) =
-            DH.getFusedScaleOffsetFromRow<float16_t>(rowIdx);
-        break;
-      default:
-        llvm_unreachable("Type is not supported");
-        break;
-      }
-
+  const ElemKind scaleOffsetKind =
+      getScaleOffsetElemKindFromFused(data->getType().getElementType());
+
+  // Segments are reduced independently of each other.
+  dim_t workPerSegment = segments ? totalLength * outLineSize / segments : 0;
+  parallelFor(segments, workPerSegment, [&](dim_t begin, dim_t end) {
+    std::vector<AccumT> accum(outLineSize);
+    for (dim_t i = begin; i < end; i++) {
+      std::fill(accum.begin(), accum.end(), AccumT(0.0f));
+      accumulateFusedRowwiseQuantizedSegment<T, AccumT, TI>(
+          DH, WH, IH, scaleOffsetKind, using4BitQuantization, /* rowBase */ 0,
+          segmentBegin[i], segmentBegin[i + 1], accum);
+      // Accumulation in FP32 complete, now copy back to output as T.
+      dim_t offsetOut = i * outLineSize;
       for (dim_t k = 0; k < outLineSize; k++) {
-        float d = 0.0f;
-        if (!using4BitQuantization) {
-          d = quantization::dequantizeWithFloatOffset(
-              DH.at({rowIdx, k}), static_cast<float>(scale),
-              static_cast<float>(offset));
-        } else {
-          const bool isMSB = (k % 2 == 1);
-          d = quantization::dequantize4BitWithFloatOffset(
-              DH.at({rowIdx, k / 2}), static_cast<float>(scale),
-              static_cast<float>(offset), isMSB);
-        }
-        accum[k] += d * weight;
+        OH.raw(offsetOut++) = static_cast<T>(accum[k]);
       }
     }
-    // Accumulation in FP32 complete, now copy back to output with cast to T.
-    dim_t offsetOut = i * outLineSize;
-    for (dim_t k = 0; k < outLineSize; k++) {
-      OH.raw(offsetOut++) = static_cast<T>(accum[k]);
-    }
-  }
+  });
 }
 
 void BoundInterpreterFunction::
@@ -4345,6 +4606,109 @@ void BoundInterpreterFunction::
   }
 }
 
+template <typename T, typename AccumT, typename TI>
+void BoundInterpreterFunction::
+    fwdGroupedFusedRowwiseQuantizedSparseLengthsWeightedSumImpl(
+        const GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumInst *I) {
+  auto *out = getTensor(I->getDest());
+  auto *data = getTensor(I->getData());
+  auto *weights = getTensor(I->getWeights());
+  auto *indices = getTensor(I->getIndices());
+  auto *lengths = getTensor(I->getLengths());
+  auto *tableOffsets = getTensor(I->getTableOffsets());
+
+  out->zero();
+
+  auto IH = indices->getHandle<TI>();
+  auto LH = lengths->getHandle<int32_t>();
+  auto TH = tableOffsets->getHandle<int64_t>();
+
+  const dim_t segments = lengths->dims()[0];
+  const dim_t numTables = tableOffsets->dims()[0];
+  const dim_t segmentsPerTable = segments / numTables;
+  std::vector<dim_t> segmentBegin = getSegmentOffsets(LH, segments);
+  dim_t totalLength = segmentBegin[segments];
+  assert(totalLength <= indices->dims()[0] &&
+         "sum(Lengths) must be equal to len(Indices)");
+
+  const bool using4BitQuantization =
+      data->getType().getElementType() == ElemKind::UInt4FusedFP16QTy;
+
+  const size_t outLineSize = out->size() / out->dims()[0];
+
+  auto DH = data->getHandle<uint8_t>();
+  auto WH = weights->getHandle<T>();
+  auto OH = out->getHandle<T>();
+
+  const ElemKind scaleOffsetKind =
+      getScaleOffsetElemKindFromFused(data->getType().getElementType());
+
+  // Tables are reduced independently of each other, each with its own base
+  // row in the packed data.
+  dim_t workPerTable = totalLength * outLineSize / numTables;
+  parallelFor(numTables, workPerTable, [&](dim_t begin, dim_t end) {
+    std::vector<AccumT> accum(outLineSize);
+    for (dim_t t = begin; t < end; t++) {
+      const dim_t rowBase = TH.raw(t);
+      for (dim_t i = t * segmentsPerTable, e = i + segmentsPerTable; i < e;
+           i++) {
+        std::fill(accum.begin(), accum.end(), AccumT(0.0f));
+        accumulateFusedRowwiseQuantizedSegment<T, AccumT, TI>(
+            DH, WH, IH, scaleOffsetKind, using4BitQuantization, rowBase,
+            segmentBegin[i], segmentBegin[i + 1], accum);
+        dim_t offsetOut = i * outLineSize;
+        for (dim_t k = 0; k < outLineSize; k++) {
+          OH.raw(offsetOut++) = static_cast<T>(accum[k]);
+        }
+      }
+    }
+  });
+}
+
+void BoundInterpreterFunction::
+    fwdGroupedFusedRowwiseQuantizedSparseLengthsWeightedSumInst(
+        const GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumInst *I) {
+  const auto ity = I->getIndices()->getElementType();
+  switch (I->getDest()->getElementType()) {
+  case ElemKind::FloatTy:
+    if (ity == ElemKind::Int32ITy) {
+      fwdGroupedFusedRowwiseQuantizedSparseLengthsWeightedSumImpl<
+          float, float, int32_t>(I);
+    } else if (ity == ElemKind::Int64ITy) {
+      fwdGroupedFusedRowwiseQuantizedSparseLengthsWeightedSumImpl<
+          float, float, int64_t>(I);
+    } else {
+      llvm_unreachable("Index type is not supported");
+    }
+    break;
+  case ElemKind::Float16Ty:
+    if (I->getUseFP16Accumulation()) {
+      if (ity == ElemKind::Int32ITy) {
+        fwdGroupedFusedRowwiseQuantizedSparseLengthsWeightedSumImpl<
+            float16_t, float16_t, int32_t>(I);
+      } else if (ity == ElemKind::Int64ITy) {
+        fwdGroupedFusedRowwiseQuantizedSparseLengthsWeightedSumImpl<
+            float16_t, float16_t, int64_t>(I);
+      } else {
+        llvm_unreachable("Index type is not supported");
+      }
+    } else {
+      if (ity == ElemKind::Int32ITy) {
+        fwdGroupedFusedRowwiseQuantizedSparseLengthsWeightedSumImpl<
+            float16_t, float, int32_t>(I);
+      } else if (ity == ElemKind::Int64ITy) {
+        fwdGroupedFusedRowwiseQuantizedSparseLengthsWeightedSumImpl<
+            float16_t, float, int64_t>(I);
+      } else {
+        llvm_unreachable("Index type is not supported");
+      }
+    }
+    break;
+  default:
+    llvm_unreachable("Type is not supported");
+  }
+}
+
 template <typename T, typename AccumT>
 void BoundInterpreterFunction::fwdEmbeddingBagByteRowwiseOffsetsImpl(
     const EmbeddingBagByteRowwiseOffsetsInst *I) {
@@ -4772,15 +5136,13 @@ void BoundInterpreterFunction::fwdArgMinInst(const ArgMinInst *I) {
 //                  Tensor allocation operations
 //===----------------------------------------------------------------------===//
 
+// Activations are carved out of the activations arena when the function is
+// bound, so there is nothing to do at run time.
 void BoundInterpreterFunction::fwdAllocActivationInst(
-    const AllocActivationInst *I) {
-  getOrCreateTensor(I);
-}
+    const AllocActivationInst *I) {}
 
 void BoundInterpreterFunction::fwdDeallocActivationInst(
-    const DeallocActivationInst *I) {
-  deleteTensor(I->getSrc());
-}
+    const DeallocActivationInst *I) {}
 
 //===----------------------------------------------------------------------===//
 //                       Debug instructions
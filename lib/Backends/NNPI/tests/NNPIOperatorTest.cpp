@@ -359,6 +359,15 @@ struct BlacklistInitializer {
             {"Sqrt_FloatTy/0", TestBlacklist::AnyDeviceAnyEngine},
             {"Sqrt_Int8QTy/0", TestBlacklist::AnyDeviceAnyEngine},
             {"Xor/0", TestBlacklist::AnyDeviceAnyEngine},
+            {"SLSOfRescaledSharedBuffer/0", TestBlacklist::AnyDeviceAnyEngine},
+            {"IntLookupTableAfterBroadcast256/0",
+             TestBlacklist::AnyDeviceAnyEngine},
+            {"ScaledDotProductAttention/0",
+             TestBlacklist::AnyDeviceAnyEngine},
+            {"ScaledDotProductAttentionBroadcastMask/0",
+             TestBlacklist::AnyDeviceAnyEngine},
+            {"ScaledDotProductAttentionFullyMaskedRow/0",
+             TestBlacklist::AnyDeviceAnyEngine},
         };
     TestBlacklist::prepareBlacklist(testBlacklistedSetups,
                                     backendTestBlacklist);
@@ -445,4 +445,11 @@ std::set<std::string> glow::backendTestBlacklist = {
     "CmpGTE_Int64ITy/0",
     "rowwiseQuantizedFCTestAsymmetric_Int8_BiasFloat32/0",
     "rowwiseQuantizedFCTestSymmetric_Int8_BiasFloat32/0",
+    "SLSOfRescaledSharedBuffer/0",
+    "IntLookupTableAfterBroadcast256/0",
+    "GroupedFusedRowwiseQuantizedSparseLengthsWeightedSum/0",
+    "GroupedFusedRowwiseQuantizedSparseLengthsWeightedSum_Int32/0",
+    "ScaledDotProductAttention/0",
+    "ScaledDotProductAttentionBroadcastMask/0",
+    "ScaledDotProductAttentionFullyMaskedRow/0",
 };
@@ -22,6 +22,9 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <numeric>
+
 #define DEBUG_TYPE "memory-allocator"
 
 using namespace glow;
@@ -69,6 +72,171 @@ uint64_t MemoryAllocator::allocate(uint64_t size, Handle handle) {
   return prev;
 }
 
+namespace {
+/// \returns true if the lifetimes of \p a and \p b overlap.
+bool lifetimesOverlap(const AllocationRequest &a, const AllocationRequest &b) {
+  return a.begin <= b.end && b.begin <= a.end;
+}
+
+/// Place the \p requests of \p sizes bytes in the order of their lifetimes
+/// using the first-fit approach, storing their offsets into \p offsets.
+/// \returns the peak memory usage.
+uint64_t planFirstFit(const std::vector<AllocationRequest> &requests,
+                      const std::vector<uint64_t> &sizes,
+                      std::vector<uint64_t> &offsets) {
+  std::vector<size_t> order(requests.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return requests[a].begin < requests[b].begin;
+  });
+  // Live buffers sorted by their offsets.
+  std::vector<size_t> live;
+  uint64_t peak = 0;
+  for (size_t idx : order) {
+    // Release the buffers which are dead by now.
+    live.erase(std::remove_if(live.begin(), live.end(),
+                              [&](size_t other) {
+                                return requests[other].end <
+                                       requests[idx].begin;
+                              }),
+               live.end());
+    uint64_t prev = 0;
+    auto pos = live.begin();
+    for (; pos != live.end(); ++pos) {
+      if (offsets[*pos] - prev >= sizes[idx]) {
+        break;
+      }
+      prev = offsets[*pos] + sizes[*pos];
+    }
+    offsets[idx] = prev;
+    live.insert(pos, idx);
+    peak = std::max(peak, prev + sizes[idx]);
+  }
+  return peak;
+}
+
+/// Place the \p requests of \p sizes bytes starting with the biggest ones,
+/// each into the smallest gap between the already placed buffers with
+/// overlapping lifetimes, storing their offsets into \p offsets.
+/// \returns the peak memory usage.
+uint64_t planGreedyBySize(const std::vector<AllocationRequest> &requests,
+                          const std::vector<uint64_t> &sizes,
+                          std::vector<uint64_t> &offsets) {
+  std::vector<size_t> order(requests.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    if (sizes[a] != sizes[b]) {
+      return sizes[a] > sizes[b];
+    }
+    return requests[a].begin < requests[b].begin;
+  });
+  // Placed buffers sorted by their offsets.
+  std::vector<size_t> placed;
+  uint64_t peak = 0;
+  for (size_t idx : order) {
+    uint64_t prev = 0;
+    uint64_t bestOffset = MemoryAllocator::npos;
+    uint64_t bestGap = MemoryAllocator::npos;
+    for (size_t other : placed) {
+      if (!lifetimesOverlap(requests[idx], requests[other])) {
+        continue;
+      }
+      if (offsets[other] > prev) {
+        uint64_t gap = offsets[other] - prev;
+        if (gap >= sizes[idx] && gap < bestGap) {
+          bestGap = gap;
+          bestOffset = prev;
+        }
+      }
+      // Buffers with overlapping lifetimes may overlap in memory, too.
+      prev = std::max(prev, offsets[other] + sizes[other]);
+    }
+    if (bestOffset == MemoryAllocator::npos) {
+      bestOffset = prev;
+    }
+    offsets[idx] = bestOffset;
+    placed.insert(std::upper_bound(placed.begin(), placed.end(), bestOffset,
+                                   [&](uint64_t offset, size_t other) {
+                                     return offset < offsets[other];
+                                   }),
+                  idx);
+    peak = std::max(peak, bestOffset + sizes[idx]);
+  }
+  return peak;
+}
+} // namespace
+
+bool MemoryAllocator::allocateAll(
+    const std::vector<AllocationRequest> &requests,
+    std::vector<uint64_t> &addresses, MemoryPlanningStrategy strategy) {
+  // Always allocate buffers properly aligned to hold values of any type.
+  std::vector<uint64_t> sizes;
+  sizes.reserve(requests.size());
+  for (const auto &request : requests) {
+    assert(request.begin <= request.end && "Invalid lifetime");
+    sizes.push_back(alignedSize(request.size, alignment_));
+  }
+
+  std::vector<uint64_t> offsets(requests.size());
+  uint64_t peak = 0;
+  switch (strategy) {
+  case MemoryPlanningStrategy::FirstFit:
+    peak = planFirstFit(requests, sizes, offsets);
+    break;
+  case MemoryPlanningStrategy::GreedyBySize:
+    peak = planGreedyBySize(requests, sizes, offsets);
+    break;
+  case MemoryPlanningStrategy::Best: {
+    // Prefer the first-fit placement if it is as good, it keeps the layout
+    // produced by allocating the buffers one by one.
+    peak = planFirstFit(requests, sizes, offsets);
+    std::vector<uint64_t> greedyOffsets(requests.size());
+    uint64_t greedyPeak = planGreedyBySize(requests, sizes, greedyOffsets);
+    if (greedyPeak < peak) {
+      peak = greedyPeak;
+      offsets = std::move(greedyOffsets);
+    }
+    break;
+  }
+  }
+
+  // Place the planned buffers above all live allocations.
+  uint64_t base = allocations_.empty() ? 0 : allocations_.back().end_;
+  if (poolSize_ && base + peak > poolSize_) {
+    return false;
+  }
+  DEBUG_GLOW(llvm::dbgs() << "Planned " << requests.size() << " buffers in '"
+                          << name_ << "': peak: " << peak << " lower bound: "
+                          << getMaxLiveSize(requests) << "\n");
+  addresses.resize(requests.size());
+  for (size_t idx = 0, e = requests.size(); idx < e; idx++) {
+    addresses[idx] = base + offsets[idx];
+  }
+  maxMemoryAllocated_ = std::max(maxMemoryAllocated_, base + peak);
+  return true;
+}
+
+uint64_t MemoryAllocator::getMaxLiveSize(
+    const std::vector<AllocationRequest> &requests) const {
+  // Sweep over the lifetime boundaries. A buffer is released right after the
+  // end of its lifetime, releases are processed before allocations.
+  std::vector<std::pair<uint64_t, int64_t>> events;
+  events.reserve(requests.size() * 2);
+  for (const auto &request : requests) {
+    int64_t size = alignedSize(request.size, alignment_);
+    events.emplace_back(request.begin, size);
+    events.emplace_back(request.end + 1, -size);
+  }
+  std::sort(events.begin(), events.end());
+  uint64_t live = 0;
+  uint64_t maxLive = 0;
+  for (const auto &event : events) {
+    live += event.second;
+    maxLive = std::max(maxLive, live);
+  }
+  return maxLive;
+}
+
 void MemoryAllocator::evictFirstFit(uint64_t size,
                                     const std::set<Handle> &mustNotEvict,
                                     std::vector<Handle> &evicted) {
@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/ExecutionContext/KernelProfile.h"
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+namespace llvm {
+namespace yaml {
+
+/// Mapping for KernelProfileEntry yaml serializer.
+template <> struct MappingTraits<glow::KernelProfileEntry> {
+  static void mapping(IO &io, glow::KernelProfileEntry &entry) {
+    io.mapRequired("name", entry.name);
+    io.mapOptional("kind", entry.kind);
+    io.mapRequired("count", entry.count);
+    io.mapRequired("time", entry.time);
+  }
+};
+
+} // end namespace yaml
+} // end namespace llvm
+
+/// Yaml serializer for vector of KernelProfileEntry.
+LLVM_YAML_IS_SEQUENCE_VECTOR(glow::KernelProfileEntry);
+
+namespace glow {
+
+void KernelProfile::add(llvm::StringRef name, llvm::StringRef kind,
+                        uint64_t count, uint64_t time) {
+  auto it = index_.find(name);
+  if (it == index_.end()) {
+    index_[name] = entries_.size();
+    entries_.push_back({name.str(), kind.str(), count, time});
+    return;
+  }
+  auto &entry = entries_[it->second];
+  entry.count += count;
+  entry.time += time;
+}
+
+void KernelProfile::addTraceEvents(const std::list<TraceEvent> &events) {
+  for (const auto &event : events) {
+    if (event.type != TraceEvent::CompleteType ||
+        event.level != TraceLevel::OPERATOR) {
+      continue;
+    }
+    // Auto-instrumentation always attaches the kind of the instruction, manual
+    // TraceEvents do not have one.
+    auto kindIt = event.args.find("kind");
+    if (kindIt == event.args.end() || kindIt->second.empty()) {
+      continue;
+    }
+    add(event.name, kindIt->second, 1, event.duration);
+  }
+}
+
+const KernelProfileEntry *KernelProfile::getEntry(llvm::StringRef name) const {
+  auto it = index_.find(name);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+  return &entries_[it->second];
+}
+
+uint64_t KernelProfile::getTotalTime() const {
+  uint64_t total = 0;
+  for (const auto &entry : entries_) {
+    total += entry.time;
+  }
+  return total;
+}
+
+llvm::StringSet<> KernelProfile::getHotKernels(float fraction) const {
+  llvm::StringSet<> hot;
+  uint64_t total = getTotalTime();
+  if (total == 0) {
+    for (const auto &entry : entries_) {
+      hot.insert(entry.name);
+    }
+    return hot;
+  }
+  std::vector<const KernelProfileEntry *> sorted;
+  for (const auto &entry : entries_) {
+    sorted.push_back(&entry);
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const KernelProfileEntry *lhs,
+                      const KernelProfileEntry *rhs) {
+                     return lhs->time > rhs->time;
+                   });
+  uint64_t covered = 0;
+  for (const auto *entry : sorted) {
+    if (covered >= fraction * total) {
+      break;
+    }
+    hot.insert(entry->name);
+    covered += entry->time;
+  }
+  return hot;
+}
+
+void KernelProfile::serialize(llvm::StringRef fileName) const {
+  std::error_code EC;
+  llvm::raw_fd_ostream outputStream(fileName, EC, llvm::sys::fs::F_None);
+  CHECK(!EC) << "Unable to create output stream";
+
+  llvm::yaml::Output yout(outputStream);
+  // The yaml serializer requires a non-const vector.
+  std::vector<KernelProfileEntry> entries = entries_;
+  yout << entries;
+}
+
+KernelProfile KernelProfile::deserialize(llvm::StringRef fileName) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> text =
+      llvm::MemoryBuffer::getFileAsStream(fileName);
+  CHECK(!text.getError()) << "Unable to open file with name: "
+                          << fileName.str();
+
+  std::unique_ptr<llvm::MemoryBuffer> buffer = std::move(*text);
+  llvm::yaml::Input yin(buffer->getBuffer());
+  std::vector<KernelProfileEntry> entries;
+  yin >> entries;
+
+  CHECK(!yin.error()) << "Error reading yaml file";
+
+  KernelProfile profile;
+  for (const auto &entry : entries) {
+    profile.add(entry.name, entry.kind, entry.count, entry.time);
+  }
+  return profile;
+}
+
+} // namespace glow
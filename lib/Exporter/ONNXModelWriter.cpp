@@ -2179,6 +2179,72 @@ Error ONNXModelWriter::writeCumSum(const CumSumNode *node, GraphType &graph) {
   return writeAllWithNode("CumSum", node, graph, proto);
 }
 
+Error ONNXModelWriter::writeScaledDotProductAttention(
+    const ScaledDotProductAttentionNode *node, GraphType &graph) {
+  // There is no ONNX operator for the attention, so write the subgraph it was
+  // folded from: MatMul(Softmax(MatMul(Q, K^T) * Scale + Mask), V).
+  const std::string name = node->getName().str();
+  const dim_t queryLen = node->getQueries().dims()[1];
+
+  auto *keysT = graph.add_node();
+  keysT->set_name(name + "_keysT");
+  keysT->set_op_type("Transpose");
+  std::vector<unsigned_t> perm = {0, 2, 1};
+  addValueAttribute(keysT, "perm", llvm::makeArrayRef(perm));
+  keysT->add_input(node->getKeys().getNode()->getName());
+  keysT->add_output(name + "_keysT");
+
+  auto *QK = graph.add_node();
+  QK->set_name(name + "_scores");
+  QK->set_op_type("MatMul");
+  QK->add_input(node->getQueries().getNode()->getName());
+  QK->add_input(name + "_keysT");
+  QK->add_output(name + "_scores");
+
+  Tensor scale(ElemKind::FloatTy, {1});
+  scale.getHandle<float>().raw(0) = node->getScale();
+  auto *scaleProto = addInitializer(graph);
+  scaleProto->set_name(name + "_scale");
+  writeTensor(scale, scaleProto, useGlowCustomOps_);
+
+  auto *scaled = graph.add_node();
+  scaled->set_name(name + "_scaled");
+  scaled->set_op_type("Mul");
+  scaled->add_input(name + "_scores");
+  scaled->add_input(name + "_scale");
+  scaled->add_output(name + "_scaled");
+  addValueAttribute(scaled, "axis", -1);
+  addValueAttribute(scaled, "broadcast", 1UL);
+
+  NodeValue mask = node->getMask();
+  auto *masked = graph.add_node();
+  masked->set_name(name + "_masked");
+  masked->set_op_type("Add");
+  masked->add_input(name + "_scaled");
+  masked->add_input(mask.getNode()->getName());
+  masked->add_output(name + "_masked");
+  if (mask.dims()[1] != queryLen) {
+    addValueAttribute(masked, "axis", 0);
+    addValueAttribute(masked, "broadcast", 1UL);
+  }
+
+  // Normalize the scores of each query along the keys.
+  auto *probs = graph.add_node();
+  probs->set_name(name + "_probs");
+  probs->set_op_type("Softmax");
+  addValueAttribute(probs, "axis", 2);
+  probs->add_input(name + "_masked");
+  probs->add_output(name + "_probs");
+
+  auto *proto = graph.add_node();
+  proto->set_name(name);
+  proto->set_op_type("MatMul");
+  proto->add_input(name + "_probs");
+  proto->add_input(node->getValues().getNode()->getName());
+  outputsToProto(node, graph, proto);
+  return Error::success();
+}
+
 // Unsupported for export Glow nodes.
 #define DEF_UNSUPPORTED_STORAGE(NAME)                                          \
   Error ONNXModelWriter::write##NAME(const NAME *node, GraphType &) {          \
@@ -2202,6 +2268,9 @@ DEF_UNSUPPORTED_NODE(SGD)
 DEF_UNSUPPORTED_NODE(Save)
 // TODO: Turn to ScatterNd when it is supported in ONNX.
 DEF_UNSUPPORTED_NODE(ScatterData)
+// Backend-specific nodes created after lowering.
+DEF_UNSUPPORTED_NODE(GroupedFusedRowwiseQuantizedSparseLengthsWeightedSum)
+DEF_UNSUPPORTED_NODE(BlockSparseFullyConnected)
 // Gradient nodes.
 DEF_UNSUPPORTED_NODE(AddGrad)
 DEF_UNSUPPORTED_NODE(DivGrad)
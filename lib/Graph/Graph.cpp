@@ -211,18 +211,15 @@ bool Module::verify() const {
   }
   // Check that all types used by constants or placeholders belong to the
   // module.
-  auto &types = getTypes();
   for (const auto *PH : getPlaceholders()) {
-    bool foundType =
-        std::find(types.begin(), types.end(), *PH->getType()) != types.end();
+    bool foundType = hasType(*PH->getType());
     isValid &=
         expectCompareTrue("Every type used by placeholders should be part of "
                           "the graph",
                           foundType, true, PH);
   }
   for (const auto *C : getConstants()) {
-    bool foundType =
-        std::find(types.begin(), types.end(), *C->getType()) != types.end();
+    bool foundType = hasType(*C->getType());
     isValid &=
         expectCompareTrue("Every type used by constants should be part of "
                           "the graph",
@@ -513,14 +510,19 @@ TypeRef Module::uniqueTypeWithNewShape(TypeRef T, TypeRef shapeType) {
   return uniqueType(Type::newShape(*T, shapeType));
 }
 
+size_t Module::TypeRefHash::operator()(TypeRef T) const {
+  return T->equals_hash();
+}
+
 TypeRef Module::uniqueType(const Type &T) {
-  for (auto &tp : types_) {
-    if (T.isEqual(tp)) {
-      return &tp;
-    }
+  auto it = typesIndex_.find(&T);
+  if (it != typesIndex_.end()) {
+    return *it;
   }
 
-  return &*types_.insert(types_.begin(), T);
+  TypeRef uniqued = &*types_.insert(types_.begin(), T);
+  typesIndex_.insert(uniqued);
+  return uniqued;
 }
 
 TypeRef Module::getVoidTy() { return uniqueType(Type()); }
@@ -1097,6 +1099,17 @@ Function::createRowwiseQuantizedFullyConnected(llvm::StringRef name,
       name, outTy, input, qWeights, scales, offsets, B));
 }
 
+BlockSparseFullyConnectedNode *Function::createBlockSparseFullyConnected(
+    llvm::StringRef name, NodeValue input, NodeValue values,
+    NodeValue colIndices, NodeValue rowOffsets, NodeValue B,
+    unsigned_t blockRows, unsigned_t blockCols) {
+  auto OT = getParent()->uniqueTypeWithNewShape(
+      input.getType(), {input.dims()[0], B.dims()[0]});
+  return addNode(new BlockSparseFullyConnectedNode(
+      name, OT, input, values, colIndices, rowOffsets, B, blockRows,
+      blockCols));
+}
+
 ReluNode *Function::createRELU(llvm::StringRef name, NodeValue input,
                                TypeRef outTy) {
   return addNode(new ReluNode(name, outTy, input));
@@ -1843,6 +1856,27 @@ BatchMatMulNode *Function::createBatchMatMul(llvm::StringRef name,
   return addNode(new BatchMatMulNode(name, OT, LHS, RHS));
 }
 
+ScaledDotProductAttentionNode *Function::createScaledDotProductAttention(
+    llvm::StringRef name, NodeValue queries, NodeValue keys, NodeValue values,
+    NodeValue mask, float scale) {
+  // Result = {numBatches, queryLen, valueDim}
+  auto OT = getParent()->uniqueTypeWithNewShape(
+      queries.getType(),
+      {queries.dims()[0], queries.dims()[1], values.dims()[2]});
+  return addNode(new ScaledDotProductAttentionNode(name, OT, queries, keys,
+                                                   values, mask, scale));
+}
+
+ScaledDotProductAttentionNode *Function::createScaledDotProductAttention(
+    llvm::StringRef name, NodeValue queries, NodeValue keys, NodeValue values,
+    float scale) {
+  auto maskTy = getParent()->uniqueTypeWithNewShape(
+      queries.getType(), {queries.dims()[0], 1, keys.dims()[1]});
+  auto *mask = createSplat(name.str() + ".mask", maskTy, 0);
+  return createScaledDotProductAttention(name, queries, keys, values, mask,
+                                         scale);
+}
+
 BatchedReduceAddNode *
 Function::createBatchedReduceAdd(llvm::StringRef name, TypeRef outTy,
                                  NodeValue batch,
@@ -2083,6 +2117,17 @@ Function::createFusedRowwiseQuantizedSparseLengthsWeightedSum(
       lengthsMode, avgLength));
 }
 
+GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumNode *
+Function::createGroupedFusedRowwiseQuantizedSparseLengthsWeightedSum(
+    llvm::StringRef name, NodeValue data, NodeValue weights, NodeValue indices,
+    NodeValue lengths, NodeValue tableOffsets, bool useFP16Accumulation) {
+  auto outTy =
+      getOutputTypeOfFusedRowwiseQuantizedSLS(this, data, lengths.dims());
+  return addNode(new GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumNode(
+      name, outTy, data, weights, indices, lengths, tableOffsets,
+      useFP16Accumulation));
+}
+
 FusedRowwiseQuantizedSparseLengthsSumNode *
 Function::createFusedRowwiseQuantizedSparseLengthsSum(
     llvm::StringRef name, Storage *data, NodeValue indices, NodeValue lengths,
@@ -5124,20 +5169,22 @@ Module *Module::clone(Module *M) const {
 
 /// \returns True if \p n is a storage node (constant or placeholder) of the
 /// function \p F.
-static bool isGraphStorageNode(Node *n, const Function *F) {
-  auto &vars = F->getParent()->getConstants();
-  auto &placeholders = F->getParent()->getPlaceholders();
-
-  if (Constant *V = dyn_cast<Constant>(n)) {
-    return std::find(vars.begin(), vars.end(), V) != vars.end();
+/// \returns a hash of the inputs, members and types of \p N, which changes
+/// whenever \p N is modified in a way that may make it invalid.
+static llvm::hash_code getVerificationHash(const Node &N) {
+  llvm::hash_code hash = llvm::hash_combine(N.getKind(), N.getHash());
+  for (size_t idx = 0, e = N.getNumResults(); idx < e; ++idx) {
+    hash = llvm::hash_combine(hash, N.getType(idx));
   }
-
-  if (Placeholder *P = dyn_cast<Placeholder>(n)) {
-    return std::find(placeholders.begin(), placeholders.end(), P) !=
-           placeholders.end();
+  for (size_t idx = 0, e = N.getNumInputs(); idx < e; ++idx) {
+    hash = llvm::hash_combine(hash, N.getNthInput(idx).getType());
   }
-
-  return false;
+  if (N.hasPredicate()) {
+    NodeValue pred = N.getPredicate();
+    hash = llvm::hash_combine(hash, pred.getNode(), pred.getResNo(),
+                              pred.getType());
+  }
+  return hash;
 }
 
 /// Insert \p node in \p nameToNode and report an error if the insertion fails.
@@ -5165,7 +5212,7 @@ insertAndReport(std::unordered_map<std::string, const Node *> &nameToNode,
   return true;
 }
 
-bool Function::verify(const Backend *backend) const {
+bool Function::verify(const Backend *backend, bool full) const {
   bool isValid = true;
   if (backend) {
     if (backend->getTensorLayoutRequirements().isEnabled()) {
@@ -5193,19 +5240,41 @@ bool Function::verify(const Backend *backend) const {
     isValid &= insertAndReport(nameToNode, N, *this);
   }
 
+  // Nodes which were valid and did not change since the last verification are
+  // not verified again. The hashes of the nodes which are valid now replace
+  // the ones of the last verification, which may refer to erased nodes.
+  std::unordered_map<const Node *, llvm::hash_code> verifiedNodes;
+  std::unordered_set<const Node *> changedNodes;
+  {
+    std::lock_guard<std::mutex> lock(verifiedNodesMutex_);
+    for (const auto &N : nodes_) {
+      auto hash = getVerificationHash(N);
+      auto it = verifiedNodes_.find(&N);
+      if (full || it == verifiedNodes_.end() || it->second != hash) {
+        changedNodes.insert(&N);
+      }
+      verifiedNodes[&N] = hash;
+    }
+  }
+
   // Any node referenced by one of the graph nodes should be part of the
   // Graph.
+  std::unordered_set<const Node *> graphNodes;
+  for (const auto &N : nodes_) {
+    graphNodes.insert(&N);
+  }
+  for (const auto *C : getParent()->getConstants()) {
+    graphNodes.insert(C);
+  }
+  for (const auto *PH : getParent()->getPlaceholders()) {
+    graphNodes.insert(PH);
+  }
   for (const auto &N : nodes_) {
     for (size_t idx = 0, e = N.getNumInputs(); idx < e; ++idx) {
-      auto &input = N.getNthInput(idx);
-      // Verify each input of N.
-      isValid &= verifyNodeInput(N, idx);
-      bool foundNode =
-          std::find(nodes_.begin(), nodes_.end(), *input) != nodes_.end();
       isValid &= expectCompareTrue(
           "Every node referenced by one of the graph nodes should be part of "
           "the graph",
-          foundNode || isGraphStorageNode(input, this), true, &N);
+          graphNodes.count(N.getNthInput(idx).getNode()) != 0, true, &N);
     }
   }
 
@@ -5220,12 +5289,9 @@ bool Function::verify(const Backend *backend) const {
   }
 
   // Check that all types used by nodes belong to the parent module.
-  auto &types = getParent()->getTypes();
   for (const auto &N : nodes_) {
     for (size_t idx = 0, e = N.getNumResults(); idx < e; ++idx) {
-      auto ty = N.getType(idx);
-      bool foundType =
-          std::find(types.begin(), types.end(), *ty) != types.end();
+      bool foundType = getParent()->hasType(*N.getType(idx));
       isValid &= expectCompareTrue(
           "Every type used by one of the graph nodes should be part of "
           "the graph",
@@ -5238,7 +5304,17 @@ bool Function::verify(const Backend *backend) const {
     isValid &=
         expectCompareTrue("Node is not linked to the function it belongs",
                           N.getParent(), this, &N);
-    isValid &= N.verify();
+    if (changedNodes.count(&N)) {
+      // Verify the node and each of its inputs.
+      bool isNodeValid = N.verify();
+      for (size_t idx = 0, e = N.getNumInputs(); idx < e; ++idx) {
+        isNodeValid &= verifyNodeInput(N, idx);
+      }
+      if (!isNodeValid) {
+        verifiedNodes.erase(&N);
+      }
+      isValid &= isNodeValid;
+    }
     // Make sure all the placeholders are at most written once, and that
     // constants are never written to.
     for (size_t idx = 0, e = N.getNumInputs(); idx < e; ++idx) {
@@ -5305,6 +5381,8 @@ bool Function::verify(const Backend *backend) const {
           user, varToWrite.second, user);
     }
   }
+  std::lock_guard<std::mutex> lock(verifiedNodesMutex_);
+  verifiedNodes_ = std::move(verifiedNodes);
   return isValid;
 }
 
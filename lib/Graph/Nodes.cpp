@@ -957,6 +957,56 @@ bool BatchMatMulNode::verify() const {
   return isValid;
 }
 
+bool ScaledDotProductAttentionNode::verify() const {
+  auto Q = getQueries();
+  auto K = getKeys();
+  auto V = getValues();
+  auto mask = getMask();
+  auto dest = getResult();
+
+  bool isValid = expectCompareTrue("Queries must be 3 dimensional.",
+                                   Q.dims().size(), size_t(3), this);
+  isValid &= expectCompareTrue("Keys must be 3 dimensional.", K.dims().size(),
+                               size_t(3), this);
+  isValid &= expectCompareTrue("Values must be 3 dimensional.",
+                               V.dims().size(), size_t(3), this);
+  isValid &= expectCompareTrue("Mask must be 3 dimensional.",
+                               mask.dims().size(), size_t(3), this);
+  isValid &= expectCompareTrue("Result must be 3 dimensional.",
+                               dest.dims().size(), size_t(3), this);
+  if (!isValid) {
+    return false;
+  }
+
+  const dim_t numBatches = Q.dims()[0];
+  const dim_t queryLen = Q.dims()[1];
+  const dim_t keyLen = K.dims()[1];
+  isValid &= expectCompareTrue("Keys have invalid dimensions.", K.dims(),
+                               {numBatches, keyLen, Q.dims()[2]}, this);
+  isValid &= expectCompareTrue("Values have invalid dimensions.",
+                               V.dims().slice(0, 2), {numBatches, keyLen},
+                               this);
+  isValid &= expectCompareTrue("Mask has invalid dimensions.",
+                               mask.dims()[2], keyLen, this);
+  isValid &= expectCompareTrue("Mask must have same batch size as Queries.",
+                               mask.dims()[0], numBatches, this);
+  if (mask.dims()[1] != 1) {
+    isValid &= expectCompareTrue("Mask must have 1 or Lq rows.",
+                                 mask.dims()[1], queryLen, this);
+  }
+  isValid &= expectCompareTrue("Result has invalid dimensions given inputs.",
+                               dest.dims(), {numBatches, queryLen, V.dims()[2]},
+                               this);
+
+  auto elemType = dest.getType()->getElementType();
+  isValid &= checkType(Q, elemType, this);
+  isValid &= checkType(K, elemType, this);
+  isValid &= checkType(V, elemType, this);
+  isValid &= checkType(mask, elemType, this);
+
+  return isValid;
+}
+
 bool SigmoidNode::verify() const {
   return verifyActivation(getInput(), getResult());
 }
@@ -1605,6 +1655,33 @@ bool FusedRowwiseQuantizedSparseLengthsWeightedSumNode::verify() const {
       getUseFP16Accumulation());
 }
 
+bool GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumNode::verify() const {
+  bool isValid = verifyFusedRowwiseQuantizedSparseLengthsSum(
+      getResult(), getData(), getIndices(), getLengths(), getWeights(),
+      getUseFP16Accumulation());
+  isValid &= checkType(getTableOffsets(), ElemKind::Int64ITy, this);
+  isValid &= expectCompareTrue("TableOffsets must be a 1D vector",
+                               getTableOffsets().dims().size(), size_t(1),
+                               this);
+  if (!isValid) {
+    return false;
+  }
+  const dim_t numTables = getTableOffsets().dims()[0];
+  isValid &= expectCompareTrue("There must be at least one table", numTables,
+                               dim_t(0), this,
+                               CompareOperatorGreaterThan<dim_t>());
+  if (!isValid) {
+    return false;
+  }
+  isValid &= expectCompareTrue("Lengths must be a multiple of the tables",
+                               getLengths().dims()[0] % numTables, dim_t(0),
+                               this);
+  isValid &= expectCompareTrue("Result and Lengths must have the same size",
+                               getResult().dims()[0], getLengths().dims()[0],
+                               this);
+  return isValid;
+}
+
 bool FusedRowwiseQuantizedSparseLengthsSumNode::verify() const {
   return verifyFusedRowwiseQuantizedSparseLengthsSum(
       getResult(), getData(), getIndices(), getLengths(), nullptr,
@@ -1814,6 +1891,61 @@ bool RowwiseQuantizedFullyConnectedNode::verify() const {
   return isValid;
 }
 
+bool BlockSparseFullyConnectedNode::verify() const {
+  auto src = getInput();
+  auto values = getValues();
+  auto colIndices = getColIndices();
+  auto rowOffsets = getRowOffsets();
+  auto bias = getBias();
+  auto dest = getResult();
+  const dim_t blockRows = getBlockRows();
+  const dim_t blockCols = getBlockCols();
+
+  bool isValid = expectCompareTrue("Inputs should be 2D tensor",
+                                   src.dims().size(), size_t(2), this);
+  isValid &= expectCompareTrue("Values should be 3D tensor",
+                               values.dims().size(), size_t(3), this);
+  isValid &= expectCompareTrue("Result should be 2D tensor", dest.dims().size(),
+                               size_t(2), this);
+  isValid &= expectCompareTrue("ColIndices should be 1D tensor",
+                               colIndices.dims().size(), size_t(1), this);
+  isValid &= expectCompareTrue("RowOffsets should be 1D tensor",
+                               rowOffsets.dims().size(), size_t(1), this);
+  isValid &= expectCompareTrue("Bias should be 1D tensor", bias.dims().size(),
+                               size_t(1), this);
+  isValid &= expectCompareTrue("Blocks should not be empty",
+                               blockRows * blockCols, dim_t(0), this,
+                               CompareOperatorGreaterThan<dim_t>());
+  if (!isValid) {
+    return false;
+  }
+
+  isValid &= checkType(dest, src.getElementType(), this);
+  isValid &= checkType(values, src.getElementType(), this);
+  isValid &= checkType(bias, src.getElementType(), this);
+  isValid &= checkType(colIndices, ElemKind::Int32ITy, this);
+  isValid &= checkType(rowOffsets, ElemKind::Int32ITy, this);
+
+  isValid &= expectCompareTrue("Mismatch on expected source dimension 0",
+                               src.dims()[0], dest.dims()[0], this);
+  isValid &= expectCompareTrue("Inconsistent bias/dest sizes", bias.dims()[0],
+                               dest.dims()[1], this);
+  isValid &= expectCompareTrue("Inconsistent values/block sizes",
+                               values.dims().slice(1),
+                               llvm::ArrayRef<dim_t>({blockRows, blockCols}),
+                               this);
+  isValid &= expectCompareTrue("Inconsistent values/colIndices sizes",
+                               values.dims()[0], colIndices.dims()[0], this);
+  isValid &= expectCompareTrue("Source should have whole block rows",
+                               src.dims()[1] % blockRows, dim_t(0), this);
+  isValid &= expectCompareTrue("Dest should have whole block columns",
+                               dest.dims()[1] % blockCols, dim_t(0), this);
+  isValid &= expectCompareTrue("Inconsistent source/rowOffsets sizes",
+                               src.dims()[1] / blockRows + 1,
+                               rowOffsets.dims()[0], this);
+  return isValid;
+}
+
 bool GatherNode::verify() const {
   bool isValid = checkType(getResult(), getData().getElementType(), this);
   isValid &= checkType(
@@ -17,6 +17,8 @@
 
 #include "llvm/Support/CommandLine.h"
 
+#include <algorithm>
+
 using namespace glow;
 
 namespace {
@@ -29,7 +31,11 @@ llvm::cl::opt<SchedulerKind> graphScheduler(
                                 "Use ChildMemSizeBased"),
                      clEnumValN(SchedulerKind::TopologicalSortBased,
                                 "topological-sort-based",
-                                "Use TopologicalSortBased")),
+                                "Use TopologicalSortBased"),
+                     clEnumValN(SchedulerKind::LivenessBased,
+                                "liveness-based", "Use LivenessBased"),
+                     clEnumValN(SchedulerKind::ParallelismBased,
+                                "parallelism-based", "Use ParallelismBased")),
     llvm::cl::init(SchedulerKind::ChildMemSizeBased),
     llvm::cl::cat(graphSchedulerCat));
 } // namespace
@@ -42,10 +48,126 @@ Scheduler *createScheduler(SchedulerKind schedulerKind, Function &G,
     return new ChildMemSizeBasedScheduler(G, scheduled);
   case SchedulerKind::TopologicalSortBased:
     return new TopologicalSortBasedScheduler(G, scheduled);
+  case SchedulerKind::LivenessBased:
+    return new LivenessBasedScheduler(G, scheduled);
+  case SchedulerKind::ParallelismBased:
+    return new ParallelismBasedScheduler(G, scheduled);
   }
   llvm_unreachable("unreachable");
 }
 
+NodeDependencies::NodeDependencies(Function &G) {
+  for (auto &N : G.getNodes()) {
+    index[&N] = nodes.size();
+    nodes.push_back(&N);
+  }
+  size_t numNodes = nodes.size();
+  operands.resize(numNodes);
+  preds.resize(numNodes);
+  succs.resize(numNodes);
+  numUsers.assign(numNodes, 0);
+  resultSize.assign(numNodes, 0);
+
+  auto getIndex = [&](const Node *N) -> unsigned {
+    auto it = index.find(N);
+    return it == index.end() ? ~0u : it->second;
+  };
+
+  for (unsigned idx = 0; idx < numNodes; idx++) {
+    Node *N = nodes[idx];
+    for (unsigned res = 0, e = N->getNumResults(); res < e; res++) {
+      resultSize[idx] += N->getType(res)->getSizeInBytes();
+    }
+
+    // Data dependencies. Storage nodes are not part of the function.
+    auto &ops = operands[idx];
+    for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+      unsigned op = getIndex(N->getNthInput(i).getNode());
+      if (op != ~0u) {
+        ops.push_back(op);
+      }
+    }
+    if (N->hasPredicate()) {
+      unsigned op = getIndex(N->getPredicate().getNode());
+      if (op != ~0u) {
+        ops.push_back(op);
+      }
+    }
+    std::sort(ops.begin(), ops.end());
+    ops.erase(std::unique(ops.begin(), ops.end()), ops.end());
+    preds[idx] = ops;
+
+    // A node overwriting one of its inputs, e.g. a SaveNode, has to happen
+    // after all other uses of the input. Nodes overwriting the same input are
+    // kept in the order of the function.
+    for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+      if (!N->isOverwrittenNthInput(i)) {
+        continue;
+      }
+      Node *dest = N->getNthInput(i).getNode();
+      for (NodeUse &use : dest->getUsers()) {
+        unsigned user = getIndex(use.getUser());
+        if (user == ~0u || user == idx) {
+          continue;
+        }
+        bool overwrites = false;
+        for (unsigned j = 0, f = nodes[user]->getNumInputs(); j < f; j++) {
+          overwrites |= nodes[user]->isOverwrittenNthInput(j) &&
+                        nodes[user]->getNthInput(j).getNode() == dest;
+        }
+        if (!overwrites || user < idx) {
+          preds[idx].push_back(user);
+        }
+      }
+    }
+    auto &P = preds[idx];
+    std::sort(P.begin(), P.end());
+    P.erase(std::unique(P.begin(), P.end()), P.end());
+  }
+
+  for (unsigned idx = 0; idx < numNodes; idx++) {
+    for (unsigned pred : preds[idx]) {
+      succs[pred].push_back(idx);
+    }
+    for (unsigned op : operands[idx]) {
+      numUsers[op]++;
+    }
+  }
+}
+
+uint64_t
+NodeDependencies::getPeakLiveMemory(llvm::ArrayRef<unsigned> order) const {
+  std::vector<unsigned> usersLeft = numUsers;
+  uint64_t live = 0;
+  uint64_t peak = 0;
+  for (unsigned idx : order) {
+    // The result is allocated while the operands are still live.
+    live += resultSize[idx];
+    peak = std::max(peak, live);
+    for (unsigned op : operands[idx]) {
+      if (--usersLeft[op] == 0) {
+        live -= resultSize[op];
+      }
+    }
+    if (numUsers[idx] == 0) {
+      live -= resultSize[idx];
+    }
+  }
+  return peak;
+}
+
+uint64_t getPeakLiveMemory(Function &G, const NodesPtrList &schedule) {
+  NodeDependencies deps(G);
+  std::vector<unsigned> order;
+  for (const Node *N : schedule) {
+    auto it = deps.index.find(N);
+    if (it != deps.index.end()) {
+      order.push_back(it->second);
+    }
+  }
+  return deps.getPeakLiveMemory(order);
+}
+
 void IRFunction::scheduleGraph(NodesPtrList &Schedule) {
   Schedule.clear();
   auto constants = G_->findConstants();
@@ -18,7 +18,10 @@
 
 #include "glow/IR/IR.h"
 
+#include "llvm/ADT/ArrayRef.h"
+
 #include <unordered_map>
+#include <vector>
 
 namespace glow {
 
@@ -28,8 +31,46 @@ enum class SchedulerKind {
   ChildMemSizeBased,
   /// Performs a standard topological search
   TopologicalSortBased,
+  /// Minimizes the peak of live activation bytes by searching over candidate
+  /// schedules.
+  LivenessBased,
+  /// Interleaves independent branches so that a parallel executor can run
+  /// them concurrently.
+  ParallelismBased,
+};
+
+/// Dependencies between the nodes of a function which are not storage,
+/// identified by their position in the node list of the function. Besides
+/// data dependencies, a node overwriting one of its inputs depends on all
+/// other users of that input.
+struct NodeDependencies {
+  /// The nodes of the function.
+  std::vector<Node *> nodes;
+  /// Maps nodes to their position in nodes.
+  std::unordered_map<const Node *, unsigned> index;
+  /// Distinct nodes whose results are used by each node.
+  std::vector<std::vector<unsigned>> operands;
+  /// Nodes which have to be scheduled before and after each node.
+  std::vector<std::vector<unsigned>> preds;
+  std::vector<std::vector<unsigned>> succs;
+  /// Number of distinct nodes using the results of each node.
+  std::vector<unsigned> numUsers;
+  /// Number of bytes required to hold the results of each node.
+  std::vector<uint64_t> resultSize;
+
+  explicit NodeDependencies(Function &G);
+
+  /// \returns the peak number of bytes held by results of nodes when
+  /// executing the nodes in \p order, see getPeakLiveMemory.
+  uint64_t getPeakLiveMemory(llvm::ArrayRef<unsigned> order) const;
 };
 
+/// \returns the peak number of bytes held by the results of the nodes of
+/// \p G, i.e. the activations, when executing them in the order given by
+/// \p schedule. A result is live from the execution of its node until the
+/// execution of its last user. Storage nodes in \p schedule are ignored.
+uint64_t getPeakLiveMemory(Function &G, const NodesPtrList &schedule);
+
 class Scheduler {
 protected:
   /// Graph being processed.
@@ -104,6 +145,40 @@ public:
   void schedule() override;
 };
 
+/// A scheduler minimizing the peak of live activation bytes, as computed by
+/// getPeakLiveMemory. It searches over candidate schedules: the schedules of
+/// the other memory oriented schedulers, a depth-first schedule visiting the
+/// operands needing the most memory first, as in the Sethi-Ullman algorithm,
+/// and depth-first schedules visiting the operands in pseudo-random orders.
+/// The candidate with the lowest peak wins, so the result is never worse
+/// than the ChildMemSizeBased and TopologicalSortBased schedules.
+class LivenessBasedScheduler : public Scheduler {
+public:
+  LivenessBasedScheduler(Function &G, NodesPtrList &Schedule)
+      : Scheduler(G, Schedule) {}
+
+  ~LivenessBasedScheduler() override = default;
+
+  void schedule() override;
+};
+
+/// A scheduler exposing parallelism to the executor. Nodes are scheduled
+/// level by level, the level of a node being the length of the longest path
+/// from the inputs of the function to it, so that the nodes of independent
+/// branches are interleaved. This keeps the activations of independent
+/// branches live at the same time, which prevents the memory planner from
+/// introducing false dependencies between them by reusing their buffers.
+/// Within a level, nodes on the longest path to the outputs come first.
+class ParallelismBasedScheduler : public Scheduler {
+public:
+  ParallelismBasedScheduler(Function &G, NodesPtrList &Schedule)
+      : Scheduler(G, Schedule) {}
+
+  ~ParallelismBasedScheduler() override = default;
+
+  void schedule() override;
+};
+
 Scheduler *createScheduler(SchedulerKind schedulerKind, Function &G,
                            NodesPtrList &scheduled);
 
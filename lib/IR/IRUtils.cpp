@@ -42,6 +42,31 @@ size_t glow::calculateTensorViewOffset(const TensorViewInst *TVI) {
   return totalOffsetLength;
 }
 
+bool glow::isBroadcastView(const TensorViewInst *TVI) {
+  auto srcDims = TVI->getSrc()->dims();
+  auto dims = TVI->getType()->dims();
+  if (srcDims.size() != dims.size() || TVI->getSrc()->size() >= TVI->size()) {
+    return false;
+  }
+  for (size_t i = 0, e = dims.size(); i < e; i++) {
+    if (TVI->getOffsets()[i] != 0 ||
+        (srcDims[i] != dims[i] && srcDims[i] != 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+dim_t glow::getBroadcastRowLength(llvm::ArrayRef<dim_t> srcDims,
+                                  llvm::ArrayRef<dim_t> dims) {
+  assert(srcDims.size() == dims.size() && "Broadcast must preserve the rank");
+  dim_t length = 1;
+  for (size_t i = dims.size(); i > 0 && srcDims[i - 1] == dims[i - 1]; i--) {
+    length *= dims[i - 1];
+  }
+  return length;
+}
+
 Value *glow::getAllocationOrigin(Value *V) {
   while (true) {
     if (auto *AI = dyn_cast<AllocActivationInst>(V))
@@ -16,6 +16,7 @@
 
 #include "glow/IR/Instrs.h"
 #include "glow/IR/IR.h"
+#include "glow/IR/IRUtils.h"
 #include "glow/Support/Support.h"
 
 #include "llvm/Support/Casting.h"
@@ -57,8 +58,10 @@ void CopyInst::verify() const {
 }
 
 void TensorViewInst::verify() const {
-  assert(getSrc()->getType()->size() >= getType()->size() &&
-         "TensorView view size should be no larger than Src size");
+  assert((getSrc()->getType()->size() >= getType()->size() ||
+          isBroadcastView(this)) &&
+         "TensorView view size should be no larger than Src size, unless it "
+         "is a broadcast view");
   assert(getSrc()->getElementType() == getType()->getElementType() &&
          "TensorView view element type should be the same as Src type");
   assert(getSrc()->getType()->dims().size() == getOffsets().size() &&
@@ -0,0 +1,167 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GraphScheduler.h"
+
+#include "glow/Support/Debug.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+
+#define DEBUG_TYPE "graph-scheduler"
+
+namespace {
+llvm::cl::OptionCategory livenessSchedulerCat("Liveness Scheduler Options");
+
+llvm::cl::opt<unsigned> livenessSchedulerRestarts(
+    "liveness-scheduler-restarts",
+    llvm::cl::desc("Number of depth-first schedules with pseudo-random operand "
+                   "orders evaluated by the liveness based graph scheduler"),
+    llvm::cl::init(16), llvm::cl::cat(livenessSchedulerCat));
+
+using glow::NodeDependencies;
+
+/// \returns a depth-first post order of the nodes of \p deps, in which all
+/// predecessors of a node come before it. The roots, i.e. the nodes without
+/// successors, are visited in the order given by \p roots and the
+/// predecessors of each node in the order given by \p preds.
+std::vector<unsigned>
+getPostOrder(const NodeDependencies &deps, llvm::ArrayRef<unsigned> roots,
+             const std::vector<std::vector<unsigned>> &preds) {
+  std::vector<unsigned> order;
+  order.reserve(deps.nodes.size());
+  std::vector<bool> visited(deps.nodes.size(), false);
+  // Explicit stack of (node, next predecessor to visit).
+  std::vector<std::pair<unsigned, unsigned>> stack;
+  for (unsigned root : roots) {
+    if (visited[root]) {
+      continue;
+    }
+    visited[root] = true;
+    stack.push_back({root, 0});
+    while (!stack.empty()) {
+      auto &top = stack.back();
+      const auto &P = preds[top.first];
+      if (top.second < P.size()) {
+        unsigned pred = P[top.second++];
+        if (!visited[pred]) {
+          visited[pred] = true;
+          stack.push_back({pred, 0});
+        }
+        continue;
+      }
+      order.push_back(top.first);
+      stack.pop_back();
+    }
+  }
+  return order;
+}
+
+/// Shuffle \p values with \p gen. Unlike std::shuffle, the result does not
+/// depend on the standard library, so that schedules are reproducible.
+void shuffle(std::vector<unsigned> &values, std::mt19937 &gen) {
+  for (size_t i = values.size(); i > 1; i--) {
+    std::swap(values[i - 1], values[gen() % i]);
+  }
+}
+} // namespace
+
+namespace glow {
+void LivenessBasedScheduler::schedule() {
+  NodeDependencies deps(G_);
+  const unsigned numNodes = deps.nodes.size();
+
+  std::vector<unsigned> roots;
+  for (unsigned idx = 0; idx < numNodes; idx++) {
+    if (deps.succs[idx].empty()) {
+      roots.push_back(idx);
+    }
+  }
+
+  std::vector<unsigned> best;
+  uint64_t bestPeak = 0;
+  auto consider = [&](std::vector<unsigned> &&order, const char *name) {
+    // Schedulers ignoring memory dependencies may miss some nodes.
+    if (order.size() != numNodes) {
+      return;
+    }
+    uint64_t peak = deps.getPeakLiveMemory(order);
+    DEBUG_GLOW(llvm::dbgs() << "Peak of the " << name << " schedule: " << peak
+                            << "\n");
+    if (best.empty() || peak < bestPeak) {
+      best = std::move(order);
+      bestPeak = peak;
+    }
+  };
+
+  // The schedules of the other schedulers.
+  for (auto kind : {SchedulerKind::ChildMemSizeBased,
+                    SchedulerKind::TopologicalSortBased}) {
+    NodesPtrList schedule;
+    std::unique_ptr<Scheduler> scheduler(createScheduler(kind, G_, schedule));
+    scheduler->schedule();
+    std::vector<unsigned> order;
+    for (const Node *N : schedule) {
+      auto it = deps.index.find(N);
+      if (it != deps.index.end()) {
+        order.push_back(it->second);
+      }
+    }
+    consider(std::move(order), "reference");
+  }
+
+  // A depth-first schedule visiting first the predecessors needing the most
+  // memory beyond their results, which is optimal for trees. The memory
+  // needed by each node is computed as if the graph were a tree.
+  std::vector<unsigned> topoOrder = getPostOrder(deps, roots, deps.preds);
+  std::vector<uint64_t> need(numNodes, 0);
+  std::vector<std::vector<unsigned>> preds = deps.preds;
+  for (unsigned idx : topoOrder) {
+    auto &P = preds[idx];
+    std::stable_sort(P.begin(), P.end(), [&](unsigned lhs, unsigned rhs) {
+      return need[lhs] - deps.resultSize[lhs] >
+             need[rhs] - deps.resultSize[rhs];
+    });
+    uint64_t live = 0;
+    for (unsigned pred : P) {
+      need[idx] = std::max(need[idx], live + need[pred]);
+      live += deps.resultSize[pred];
+    }
+    need[idx] = std::max(need[idx], live + deps.resultSize[idx]);
+  }
+  consider(getPostOrder(deps, roots, preds), "Sethi-Ullman");
+
+  // Depth-first schedules visiting the predecessors in pseudo-random orders.
+  std::mt19937 gen(0);
+  for (unsigned i = 0; i < livenessSchedulerRestarts; i++) {
+    std::vector<unsigned> shuffledRoots = roots;
+    shuffle(shuffledRoots, gen);
+    for (auto &P : preds) {
+      shuffle(P, gen);
+    }
+    consider(getPostOrder(deps, shuffledRoots, preds), "shuffled");
+  }
+
+  for (unsigned idx : best) {
+    scheduled_.push_back(deps.nodes[idx]);
+  }
+}
+} // namespace glow
@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GraphScheduler.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace glow {
+void ParallelismBasedScheduler::schedule() {
+  NodeDependencies deps(G_);
+  const unsigned numNodes = deps.nodes.size();
+
+  // Compute a topological order of the nodes along with the level of each
+  // node, i.e. the length of the longest path reaching it.
+  std::vector<unsigned> predsLeft(numNodes);
+  std::vector<unsigned> topoOrder;
+  topoOrder.reserve(numNodes);
+  for (unsigned idx = 0; idx < numNodes; idx++) {
+    predsLeft[idx] = deps.preds[idx].size();
+    if (predsLeft[idx] == 0) {
+      topoOrder.push_back(idx);
+    }
+  }
+  std::vector<unsigned> level(numNodes, 0);
+  for (unsigned i = 0; i < topoOrder.size(); i++) {
+    unsigned idx = topoOrder[i];
+    for (unsigned succ : deps.succs[idx]) {
+      level[succ] = std::max(level[succ], level[idx] + 1);
+      if (--predsLeft[succ] == 0) {
+        topoOrder.push_back(succ);
+      }
+    }
+  }
+  assert(topoOrder.size() == numNodes && "Cyclic dependencies between nodes");
+
+  // The length of the longest path from each node to the outputs.
+  std::vector<unsigned> height(numNodes, 0);
+  for (auto it = topoOrder.rbegin(), e = topoOrder.rend(); it != e; ++it) {
+    for (unsigned succ : deps.succs[*it]) {
+      height[*it] = std::max(height[*it], height[succ] + 1);
+    }
+  }
+
+  // All predecessors of a node are on lower levels, so scheduling the nodes
+  // level by level honors the dependencies.
+  std::vector<unsigned> order(topoOrder);
+  std::sort(order.begin(), order.end(), [&](unsigned lhs, unsigned rhs) {
+    return std::make_tuple(level[lhs], height[rhs], lhs) <
+           std::make_tuple(level[rhs], height[lhs], rhs);
+  });
+  for (unsigned idx : order) {
+    scheduled_.push_back(deps.nodes[idx]);
+  }
+}
+} // namespace glow
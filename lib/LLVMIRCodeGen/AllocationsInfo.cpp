@@ -97,26 +97,11 @@ void AllocationsInfo::allocateWeightVars(const IRFunction *F) {
 }
 
 void AllocationsInfo::allocateActivations(const IRFunction *F) {
-  // Maps activations and views to some offset within the heap.
-  llvm::DenseMap<const Value *, uint64_t> activationAddr;
-
-  // Assign device-space addresses to the activations.
-  for (const auto &I : F->getInstrs()) {
-    if (auto *A = dyn_cast<AllocActivationInst>(&I)) {
-      auto numBytes = I.getSizeInBytes();
-      size_t addr = activationsAllocator.allocate(numBytes, A);
-      assert(!activationAddr.count(A) && "Allocation already made!");
-      activationAddr[A] = addr;
-      continue;
-    }
-
-    if (auto *D = dyn_cast<DeallocActivationInst>(&I)) {
-      auto *A = D->getAlloc();
-      assert(activationAddr.count(A) && "Invalid deallocation!");
-      activationsAllocator.deallocate(A);
-      continue;
-    }
-  }
+  // Assign device-space addresses to the activations. All their lifetimes are
+  // known, so plan them at once to minimize the peak memory usage. This has
+  // to match the plan of runtime::RuntimeBundle::create.
+  auto activationAddr =
+      planActivationsMemory(F->getInstrs(), activationsAllocator);
 
   activationsMemSize_ = activationsAllocator.getMaxMemoryUsage();
 
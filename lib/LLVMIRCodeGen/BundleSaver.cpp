@@ -97,7 +97,10 @@ static void printHeader(llvm::StringRef headerFileName,
   headerFile.close();
 }
 
-/// Header file common definitions for dynamic API.
+/// Header file common definitions for dynamic API. The definitions of the
+/// parallel-for callback are inserted only for bundles compiled with
+/// -bundle-parallel-for, so that the layout of the BundleConfig of the other
+/// bundles is not changed.
 static const char *dynamicApiCommonDefines = R"RAW(
 // Type describing a symbol table entry of a generated bundle.
 struct SymbolTableEntry {
@@ -110,7 +113,7 @@ struct SymbolTableEntry {
   // Variable kind: 1 if it is a mutable variable, 0 otherwise.
   char kind;
 };
-
+%s
 // Type describing the config of a generated bundle.
 struct BundleConfig {
   // Size of the constant weight variables memory area.
@@ -125,9 +128,29 @@ struct BundleConfig {
   uint64_t numSymbols;
   // Symbol table.
   const SymbolTableEntry *symbolTable;
-};
+%s};
+)RAW";
+
+/// Header file definitions of the parallel-for callback for dynamic API.
+static const char *dynamicApiParallelForDefines = R"RAW(
+// Task processing the iterations [begin, end) of a kernel split by a bundle.
+typedef void (*GlowParallelTask)(void *taskCtx, uint64_t begin, uint64_t end);
+
+// Parallel-for callback provided by the client. It must invoke the task for
+// non-overlapping ranges covering [0, numIters) and return once all of them
+// have completed.
+typedef void (*GlowParallelFor)(void *threadPool, uint64_t numIters,
+                                GlowParallelTask task, void *taskCtx);
 )RAW";
 
+/// Fields of the BundleConfig holding the parallel-for callback.
+static const char *bundleConfigParallelForFields =
+    "  // Parallel-for callback used to split heavy kernels across threads.\n"
+    "  // If it is not set, all kernels are executed by the calling thread.\n"
+    "  GlowParallelFor parallelFor;\n"
+    "  // Thread pool passed to the parallel-for callback.\n"
+    "  void *threadPool;\n";
+
 /// Header file common definitions for static API.
 static const char *staticApiCommonDefines = R"RAW(
 // Memory alignment definition with given alignment size
@@ -140,6 +163,10 @@ static const char *staticApiCommonDefines = R"RAW(
 #define GLOW_GET_ADDR(mutableBaseAddr, placeholderOff)  (((uint8_t*)(mutableBaseAddr)) + placeholderOff)
 )RAW";
 
+/// Index of the parallel-for callback field in the BundleConfig. It is followed
+/// by the thread pool field.
+static constexpr unsigned kBundleConfigParallelForIdx = 6;
+
 /// Utility function to serialize a binary file to text file as a C array.
 static void serializeBinaryToText(llvm::StringRef binFileName,
                                   llvm::StringRef txtFileName) {
@@ -176,6 +203,15 @@ BundleSaver::BundleSaver(const LLVMBackend &llvmBackend,
   opts.setCodeModel(opts.getBundleCodeModel());
   irgen_->initTargetMachine(opts);
   irgen_->initCodeGen();
+  // The generated code reads the parallel-for callback from the bundle config,
+  // therefore the config needs to exist before the code generation.
+  if (bundleParallelFor) {
+    CHECK(bundleAPI_ == BundleApiType::Dynamic)
+        << "Splitting kernels across a parallel-for callback requires the "
+           "dynamic bundle API";
+    irgen_->setParallelForConfig(getOrCreateParallelForBundleConfig(),
+                                 kBundleConfigParallelForIdx);
+  }
 }
 
 void BundleSaver::setIRFunction(llvm::StringRef mainEntryName,
@@ -276,9 +312,13 @@ void BundleSaver::saveHeader(llvm::StringRef headerFileName) {
   auto totMemSize = constMemSize + mutableMemSize + activationsMemSize;
 
   // Format common bundle definitions.
-  auto commonDefines = (bundleAPI_ == BundleApiType::Dynamic)
-                           ? dynamicApiCommonDefines
-                           : staticApiCommonDefines;
+  std::string commonDefines = staticApiCommonDefines;
+  if (bundleAPI_ == BundleApiType::Dynamic) {
+    commonDefines = strFormat(
+        dynamicApiCommonDefines,
+        bundleParallelFor ? dynamicApiParallelForDefines : "",
+        bundleParallelFor ? bundleConfigParallelForFields : "");
+  }
 
   // Format model description.
   std::string modelInfo = strFormat("// Model name: \"%s\"\n"
@@ -578,6 +618,26 @@ void BundleSaver::emitBundleEntryFunction(
   irgen_->generateFunctionDebugInfo(func);
 }
 
+llvm::GlobalVariable *BundleSaver::getOrCreateParallelForBundleConfig() {
+  auto configName = irgen_->getBundleName().str() + "_config";
+  if (auto *config = irgen_->getModule().getGlobalVariable(configName)) {
+    return config;
+  }
+  auto &ctx = irgen_->getLLVMContext();
+  // Get the integer type having the same size in bits as uint64_t.
+  auto *uint64TType = llvm::Type::getIntNTy(ctx, sizeof(uint64_t) * 8);
+  auto *int8PtrTy = llvm::Type::getInt8PtrTy(ctx);
+  // The symbol table does not exist yet, hence the i8* for its address.
+  auto *bundleConfigTy = llvm::StructType::get(
+      ctx, {uint64TType, uint64TType, uint64TType, uint64TType, uint64TType,
+            int8PtrTy, int8PtrTy, int8PtrTy});
+  // Unlike the config of the other bundles, this one is not constant, because
+  // the clients register the parallel-for callback in it.
+  return new llvm::GlobalVariable(
+      irgen_->getModule(), bundleConfigTy, /* isConst */ false,
+      llvm::GlobalValue::LinkageTypes::ExternalLinkage, nullptr, configName);
+}
+
 // Create a config for this network. It will be exposed to the clients,
 // so that they know how much memory they need to allocate, etc.
 // Config consists of the following fields:
@@ -588,6 +648,9 @@ void BundleSaver::emitBundleEntryFunction(
 //   uint64_t alignment;
 //   uint64_t numSymbols;
 //   SymbolTableEntry *symbolTable;
+//   // Only with -bundle-parallel-for.
+//   GlowParallelFor parallelFor;
+//   void *threadPool;
 // };
 void BundleSaver::emitBundleConfig() {
   auto symbolTableName = irgen_->getBundleName().str() + "SymbolTable";
@@ -598,17 +661,7 @@ void BundleSaver::emitBundleConfig() {
       << symbolTableName;
   // Get the integer type having the same size in bits as uint64_t.
   auto *uint64TType = irgen_->getBuilder().getIntNTy(sizeof(uint64_t) * 8);
-  auto symbolTableEntryTy = symbolTable->getType()->getPointerElementType();
-  auto *bundleConfigTy =
-      llvm::StructType::get(irgen_->getLLVMContext(),
-                            {uint64TType, uint64TType, uint64TType, uint64TType,
-                             uint64TType, symbolTableEntryTy->getPointerTo()});
-  auto config = new llvm::GlobalVariable(
-      irgen_->getModule(), bundleConfigTy, /* isConst */ true,
-      llvm::GlobalValue::LinkageTypes::ExternalLinkage, nullptr,
-      irgen_->getBundleName().str() + "_config");
-  config->setInitializer(llvm::ConstantStruct::get(
-      bundleConfigTy,
+  std::vector<llvm::Constant *> fields = {
       llvm::ConstantInt::get(
           uint64TType, irgen_->getAllocationsInfo().constantWeightVarsMemSize_),
       llvm::ConstantInt::get(
@@ -617,9 +670,31 @@ void BundleSaver::emitBundleConfig() {
                              irgen_->getAllocationsInfo().activationsMemSize_),
 
       llvm::ConstantInt::get(uint64TType, TensorAlignment),
-      llvm::ConstantInt::get(uint64TType, findPlaceholders().size()),
-
-      symbolTable));
+      llvm::ConstantInt::get(uint64TType, findPlaceholders().size())};
+
+  llvm::GlobalVariable *config;
+  if (bundleParallelFor) {
+    auto *int8PtrTy = irgen_->getBuilder().getInt8PtrTy();
+    auto *nullPtr = llvm::ConstantPointerNull::get(int8PtrTy);
+    fields.push_back(llvm::ConstantExpr::getBitCast(symbolTable, int8PtrTy));
+    // The parallel-for callback and the thread pool are set by the client.
+    fields.push_back(nullPtr);
+    fields.push_back(nullPtr);
+    config = getOrCreateParallelForBundleConfig();
+  } else {
+    fields.push_back(symbolTable);
+    auto symbolTableEntryTy = symbolTable->getType()->getPointerElementType();
+    auto *bundleConfigTy = llvm::StructType::get(
+        irgen_->getLLVMContext(),
+        {uint64TType, uint64TType, uint64TType, uint64TType, uint64TType,
+         symbolTableEntryTy->getPointerTo()});
+    config = new llvm::GlobalVariable(
+        irgen_->getModule(), bundleConfigTy, /* isConst */ true,
+        llvm::GlobalValue::LinkageTypes::ExternalLinkage, nullptr,
+        irgen_->getBundleName().str() + "_config");
+  }
+  config->setInitializer(llvm::ConstantStruct::get(
+      llvm::cast<llvm::StructType>(config->getValueType()), fields));
 }
 
 void BundleSaver::performBundleMemoryAllocation() {
@@ -65,6 +65,10 @@ private:
   void saveHeader(llvm::StringRef headerFileName);
   /// Emit config for a bundle.
   void emitBundleConfig();
+  /// \returns the global variable of the config of a bundle compiled with
+  /// -bundle-parallel-for. It is created without an initializer if it does not
+  /// exist yet.
+  llvm::GlobalVariable *getOrCreateParallelForBundleConfig();
   /// Emit the symbol table for a bundle.
   void emitSymbolTable();
   /// Emit the entry function for the saved function \p savedF.
@@ -108,3 +108,10 @@ llvm::cl::opt<bool> bundleAPIVerbose(
     "bundle-api-verbose",
     llvm::cl::desc("Print more details in the bundle API header file"),
     llvm::cl::init(false), llvm::cl::cat(bundleSaverCat));
+
+llvm::cl::opt<bool> bundleParallelFor(
+    "bundle-parallel-for",
+    llvm::cl::desc("Split heavy kernels of the bundle across the parallel-for "
+                   "callback registered by the client in the bundle config. "
+                   "Requires the dynamic bundle API"),
+    llvm::cl::init(false), llvm::cl::cat(bundleSaverCat));
@@ -73,4 +73,8 @@ extern llvm::cl::opt<glow::BundleApiType> bundleAPI;
 /// Option to print more details in the bundle API.
 extern llvm::cl::opt<bool> bundleAPIVerbose;
 
+/// Option to split heavy kernels of a bundle across a parallel-for callback
+/// provided by the client.
+extern llvm::cl::opt<bool> bundleParallelFor;
+
 #endif // GLOW_LLVMIRCODEGEN_COMMANDLINE_H
@@ -18,10 +18,13 @@
 #include "glow/LLVMIRCodeGen/LLVMBackend.h"
 #include "glow/LLVMIRCodeGen/LLVMIRGen.h"
 
+#include "glow/ExecutionContext/KernelProfile.h"
 #include "glow/IR/Instrs.h"
 #include "glow/Support/Debug.h"
 
 #include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/ValueMapper.h"
@@ -44,8 +47,31 @@ static llvm::cl::opt<bool>
                                      "operations with constant dimensions"),
                       llvm::cl::init(true), llvm::cl::cat(getLLVMBackendCat()));
 
+/// Profile produced by an instrumented run (see KernelProfile), which is used
+/// to guide the specialization decisions.
+static llvm::cl::opt<std::string> jitKernelProfile(
+    "llvm-kernel-profile",
+    llvm::cl::desc("Kernel profile (YAML) of an instrumented run used to guide "
+                   "the specialization, inlining and unrolling of kernels"),
+    llvm::cl::value_desc("profile.yaml"), llvm::cl::init(""),
+    llvm::cl::cat(getLLVMBackendCat()));
+
+static llvm::cl::opt<float> jitKernelProfileHotFraction(
+    "llvm-kernel-profile-hot-fraction",
+    llvm::cl::desc("Fraction of the total profiled time covered by the kernels "
+                   "considered to be hot"),
+    llvm::cl::init(0.9), llvm::cl::cat(getLLVMBackendCat()));
+
+static llvm::cl::opt<unsigned> jitKernelProfileUnrollCount(
+    "llvm-kernel-profile-unroll-count",
+    llvm::cl::desc("Unroll count requested for the innermost loops of hot "
+                   "kernels. 0 leaves unrolling to the LLVM heuristics"),
+    llvm::cl::init(4), llvm::cl::cat(getLLVMBackendCat()));
+
 STATISTIC(NumSpecializations, "Number of created specializations");
 STATISTIC(NumSharedSpecializations, "Number of shared specializations");
+STATISTIC(NumHotSpecializations, "Number of specializations of hot kernels");
+STATISTIC(NumColdCalls, "Number of calls skipped as cold by the profile");
 
 /// Check if the value \p Value is a constant for the purposes of the function
 /// specialization, i.e. it is an LLVM constant or it is a global constant
@@ -86,9 +112,48 @@ static bool isArgToBeSpecialized(uint64_t argsToBeSpecialized,
   return argsToBeSpecialized & (((uint64_t)1) << argIdx);
 }
 
+/// Request unrolling by \p count of all innermost loops of \p F by means of
+/// the llvm.loop.unroll.count metadata. Existing loop metadata, e.g.
+/// llvm.loop.vectorize.enable, is preserved.
+static void addUnrollHints(llvm::Function *F, unsigned count) {
+  auto &ctx = F->getContext();
+  llvm::DominatorTree DT(*F);
+  llvm::LoopInfo LI(DT);
+  for (auto *L : LI.getLoopsInPreorder()) {
+    if (!L->getSubLoops().empty()) {
+      continue;
+    }
+    llvm::SmallVector<llvm::Metadata *, 4> args;
+    // Reserve operand 0 for loop id self reference.
+    llvm::TempMDTuple tmpMD = llvm::MDNode::getTemporary(ctx, llvm::None);
+    args.push_back(tmpMD.get());
+    if (auto *loopID = L->getLoopID()) {
+      for (unsigned i = 1, e = loopID->getNumOperands(); i < e; ++i) {
+        args.push_back(loopID->getOperand(i));
+      }
+    }
+    llvm::Metadata *vals[] = {
+        llvm::MDString::get(ctx, "llvm.loop.unroll.count"),
+        llvm::ConstantAsMetadata::get(
+            llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), count))};
+    args.push_back(llvm::MDNode::get(ctx, vals));
+    auto *loopMD = llvm::MDNode::get(ctx, args);
+    // Set the first operand to itself.
+    loopMD->replaceOperandWith(0, loopMD);
+    L->setLoopID(loopMD);
+  }
+}
+
 /// Specialize functions for constant arguments. Such specialized functions are
 /// marked as noinline and simply invoke the original function with constant
 /// arguments. This call later gets inlined and optimized.
+///
+/// If a kernel profile is provided (see -llvm-kernel-profile), only the calls
+/// emitted for hot instructions are specialized. The specializations of hot
+/// kernels are inlined into their callers and get their innermost loops
+/// unrolled, while calls of cold kernels are left untouched to save code size
+/// and compile time. Calls of instructions unknown to the profile are handled
+/// by the default heuristic.
 class FunctionSpecializer {
   /// Create a unique name for each specialization.
   std::string createUniqueName(llvm::StringRef name) {
@@ -215,12 +280,21 @@ class FunctionSpecializer {
 
     // Create a specialized function by cloning the body of the original
     // function and substituting the values of constant arguments. The
-    // specialized function should be marked as noinline, to avoid code bloat.
+    // specialized function should be marked as noinline, to avoid code bloat,
+    // unless the profile tells that it is hot.
     specializedF = llvm::CloneFunction(F, VMap);
     specializedF->setLinkage(llvm::GlobalValue::LinkageTypes::InternalLinkage);
     assert(specializedF && "Could not create a specialized function");
-    // Specializations should not be inlined.
-    specializedF->addFnAttr(llvm::Attribute::AttrKind::NoInline);
+    if (isHotCall(call)) {
+      // Hot specializations are inlined into their callers and unrolled.
+      if (jitKernelProfileUnrollCount > 1) {
+        addUnrollHints(specializedF, jitKernelProfileUnrollCount);
+      }
+      NumHotSpecializations++;
+    } else {
+      // Specializations should not be inlined.
+      specializedF->addFnAttr(llvm::Attribute::AttrKind::NoInline);
+    }
     specializedF->setName(specializedName);
     // No need to explicitly emit a debug info for the specialized function. If
     // the original function had it, the cloner would have automatically copied
@@ -259,17 +333,53 @@ class FunctionSpecializer {
     if (!irgen_.isEligibleForSpecialization(call)) {
       return false;
     }
+    // Do not specialize calls which are cold according to the profile.
+    if (isColdCall(call)) {
+      NumColdCalls++;
+      return false;
+    }
     // Do not specialize noinline functions, because it does not improve
     // anything.
     return callee != nullptr &&
            !callee->hasFnAttribute(llvm::Attribute::AttrKind::NoInline);
   }
 
+  /// \returns the name of the IR instruction the call \p call was emitted for
+  /// if it is covered by the kernel profile, or an empty string otherwise.
+  llvm::StringRef getProfiledInstrName(const llvm::CallInst *call) const {
+    if (!profile_) {
+      return "";
+    }
+    const auto *I = irgen_.getInstrForCall(call);
+    if (!I || !profile_->getEntry(I->getName())) {
+      return "";
+    }
+    return I->getName();
+  }
+
+  /// \returns true if the call \p call belongs to a hot kernel.
+  bool isHotCall(const llvm::CallInst *call) const {
+    auto name = getProfiledInstrName(call);
+    return !name.empty() && hotKernels_.count(name);
+  }
+
+  /// \returns true if the call \p call belongs to a kernel which is covered by
+  /// the profile, but is not hot.
+  bool isColdCall(const llvm::CallInst *call) const {
+    auto name = getProfiledInstrName(call);
+    return !name.empty() && !hotKernels_.count(name);
+  }
+
 public:
   FunctionSpecializer(llvm::SmallVectorImpl<llvm::Function *> &entryFunctions,
-                      llvm::DenseSet<llvm::Value *> &dontSpec, LLVMIRGen &irgen)
+                      llvm::DenseSet<llvm::Value *> &dontSpec, LLVMIRGen &irgen,
+                      const KernelProfile *profile)
       : entryFunctions_(entryFunctions), dontSpecializeArgsSet_(dontSpec),
-        irgen_(irgen) {}
+        irgen_(irgen), profile_(profile) {
+    if (profile_) {
+      hotKernels_ = profile_->getHotKernels(jitKernelProfileHotFraction);
+    }
+  }
 
   /// Specialize a single call.
   /// \returns the specialized Call instruction if it was possible to specialize
@@ -439,12 +549,22 @@ private:
   llvm::DenseSet<llvm::Value *> &dontSpecializeArgsSet_;
   /// LLVMIRGen to be used.
   LLVMIRGen &irgen_;
+  /// Kernel profile guiding the specialization or nullptr if there is none.
+  const KernelProfile *profile_;
+  /// Names of the instructions whose kernels are hot according to profile_.
+  llvm::StringSet<> hotKernels_;
 };
 
 } // namespace
 
 void LLVMIRGen::performSpecialization() {
+  std::unique_ptr<KernelProfile> profile;
+  if (!jitKernelProfile.empty()) {
+    profile = glow::make_unique<KernelProfile>(
+        KernelProfile::deserialize(jitKernelProfile));
+  }
   FunctionSpecializer FuncSpecializer(emittedLLVMFunctions_,
-                                      dontSpecializeArgsSet_, *this);
+                                      dontSpecializeArgsSet_, *this,
+                                      profile.get());
   FuncSpecializer.run();
 }
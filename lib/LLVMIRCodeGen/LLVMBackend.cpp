@@ -65,6 +65,17 @@ LLVMBackendOptions::LLVMBackendOptions() {
 
 LLVMBackend::LLVMBackend() {}
 
+std::unique_ptr<IRFunctionPassPipeline>
+LLVMBackend::getIROptimizationPipeline() const {
+  auto pipeline = createDefaultIRFunctionOptimizationPipeline();
+  // Data-parallel kernels generated by LLVMIRGen support broadcast views as
+  // operands, so tiles read by them do not need to be materialized.
+  if (pipeline->size()) {
+    pipeline->pushFront({IRFunctionPassID::FoldTilesIntoBroadcastViews});
+  }
+  return pipeline;
+}
+
 /// Emit the entry point for JIT called "jitmain".
 /// Function has the following API:
 /// int jitmain(uint8_t *baseConstantWeightVars,
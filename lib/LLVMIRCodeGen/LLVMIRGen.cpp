@@ -26,11 +26,13 @@
 #include "glow/IR/Instrs.h"
 #include "glow/Quantization/Base/Base.h"
 
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetSelect.h"
@@ -55,9 +57,21 @@ llvm::cl::opt<bool>
     emitDebugInfo("g", llvm::cl::desc("Emit debug information for debuggers"),
                   llvm::cl::init(false), llvm::cl::cat(getLLVMBackendCat()));
 
+static llvm::cl::opt<unsigned> quantizedVectorWidth(
+    "llvm-quantized-vector-width",
+    llvm::cl::desc("Number of elements processed per iteration by the "
+                   "explicitly vectorized loops of int8 quantized "
+                   "data-parallel kernels. 0 or 1 disables them"),
+    llvm::cl::init(16), llvm::cl::cat(getLLVMBackendCat()));
+
 /// Limitation of number of arguments for `emitDataParallelKernel`.
 constexpr static size_t kArgLimit = 64;
 
+/// Minimal number of elements processed by a data-parallel kernel for it to be
+/// split across the parallel-for callback. Smaller kernels are not worth the
+/// synchronization overhead.
+constexpr static dim_t kParallelForMinElements = 16384;
+
 /// Generate the LLVM machine attribute list for the host.
 static llvm::SmallVector<std::string, 0> getHostMachineAttributes() {
   llvm::SmallVector<std::string, 0> result;
@@ -634,12 +648,15 @@ llvm::CallInst *LLVMIRGen::createCall(llvm::IRBuilder<> &builder,
            "Calling a function with a bad signature: argument type mismatch.");
   }
 #endif
+  auto *result = builder.CreateCall(callee, args);
+  if (currentInstr_) {
+    callsToInstrs_[result] = currentInstr_;
+  }
   if (!checked || !callee->getReturnType()->isIntegerTy()) {
-    return builder.CreateCall(callee, args);
+    return result;
   }
   // Check if callee returned an error, i.e. non-zero result.
   // Emit a return with this error code in this case.
-  auto *result = builder.CreateCall(callee, args);
   auto *zero = builder.getIntN(result->getType()->getIntegerBitWidth(), 0);
   auto *cond = builder.CreateICmpNE(result, zero);
   auto insertionPoint = builder.GetInsertPoint();
@@ -677,7 +694,15 @@ std::pair<llvm::BasicBlock *, llvm::BasicBlock *>
 LLVMIRGen::createLoop(llvm::IRBuilder<> &builder, llvm::LLVMContext &ctx,
                       llvm::Value *numElements) const {
   auto dimTTy = builder.getIntNTy(DIM_T_BITWIDTH);
-  auto *initVal = llvm::ConstantInt::get(dimTTy, 0);
+  return createLoop(builder, ctx, llvm::ConstantInt::get(dimTTy, 0),
+                    numElements);
+}
+
+std::pair<llvm::BasicBlock *, llvm::BasicBlock *>
+LLVMIRGen::createLoop(llvm::IRBuilder<> &builder, llvm::LLVMContext &ctx,
+                      llvm::Value *begin, llvm::Value *end,
+                      unsigned step) const {
+  auto dimTTy = builder.getIntNTy(DIM_T_BITWIDTH);
 
   // Make the new basic block for the loop header. Insert it after current
   // block.
@@ -693,20 +718,28 @@ LLVMIRGen::createLoop(llvm::IRBuilder<> &builder, llvm::LLVMContext &ctx,
 
   // Create the PHI node with an entry for initial value.
   llvm::PHINode *var = builder.CreatePHI(dimTTy, 2);
-  var->addIncoming(initVal, preheaderBB);
+  var->addIncoming(begin, preheaderBB);
 
   // Emit the step value.
-  auto *stepVal = llvm::ConstantInt::get(dimTTy, 1);
+  auto *stepVal = llvm::ConstantInt::get(dimTTy, step);
   auto *nextVal = builder.CreateAdd(var, stepVal, "nextvar", /* HasNUW */ true,
                                     /* HasNSW */ true);
   // Compute the end condition.
-  auto *endCond = builder.CreateICmpULT(nextVal, numElements, "loopcond");
+  auto *endCond = builder.CreateICmpULT(nextVal, end, "loopcond");
 
   // Create the "after loop" block and insert it.
   auto *afterBB = llvm::BasicBlock::Create(ctx, "afterloop", func);
 
   // Insert the conditional branch at the end of the loopBB.
   auto *backEdge = builder.CreateCondBr(endCond, loopBB, afterBB);
+  // Add a new entry to the PHI node for the backedge.
+  var->addIncoming(nextVal, loopBB);
+  builder.SetInsertPoint(afterBB);
+  // Loops with a step bigger than one process vectors explicitly and are not
+  // subject to the loop vectorizer.
+  if (step != 1) {
+    return std::make_pair(loopBB, afterBB);
+  }
   // Add explicit loop llvm.loop.vectorize.enable metadata to the generated
   // loop to help the LLVM vectorizer. Without this metadata, LLVM loop
   // vectorizer bails on long data-parallel loops with a lot of operations. This
@@ -729,22 +762,160 @@ LLVMIRGen::createLoop(llvm::IRBuilder<> &builder, llvm::LLVMContext &ctx,
   // Set the first operand to itself.
   loopMD->replaceOperandWith(0, loopMD);
   backEdge->setMetadata(llvm::LLVMContext::MD_loop, loopMD);
-  // Add a new entry to the PHI node for the backedge.
-  var->addIncoming(nextVal, loopBB);
-  builder.SetInsertPoint(afterBB);
   return std::make_pair(loopBB, afterBB);
 }
 
+void LLVMIRGen::setParallelForConfig(llvm::GlobalVariable *config,
+                                     unsigned fieldIdx) {
+  parallelForConfig_ = config;
+  parallelForFieldIdx_ = fieldIdx;
+}
+
+/// The kernel \p F is invoked from a task function with the signature:
+/// void task(void *taskCtx, uint64_t begin, uint64_t end);
+/// Constant arguments of the kernel are embedded into the task, so that the
+/// call can still be specialized. All other arguments are stored into a
+/// context struct on the stack of the caller, which is passed as taskCtx.
+void LLVMIRGen::emitParallelCall(llvm::IRBuilder<> &builder, llvm::Function *F,
+                                 llvm::ArrayRef<llvm::Value *> args,
+                                 dim_t numIters) {
+  auto *dimTTy = builder.getIntNTy(DIM_T_BITWIDTH);
+  if (!isParallelForEnabled()) {
+    llvm::SmallVector<llvm::Value *, 32> callArgs(args.begin(), args.end());
+    callArgs.push_back(emitConstDimT(builder, 0));
+    callArgs.push_back(emitConstDimT(builder, numIters));
+    createUncheckedCall(builder, F, callArgs);
+    return;
+  }
+  auto &ctx = getLLVMContext();
+  auto *int8PtrTy = builder.getInt8PtrTy();
+  auto *int64Ty = builder.getInt64Ty();
+
+  // Collect the arguments to be passed through the context struct.
+  llvm::SmallVector<llvm::Type *, 32> ctxFieldTypes;
+  for (auto *arg : args) {
+    if (!isa<llvm::Constant>(arg)) {
+      ctxFieldTypes.push_back(arg->getType());
+    }
+  }
+  auto *ctxTy = llvm::StructType::get(ctx, ctxFieldTypes);
+
+  // Create the task function.
+  auto *taskTy = llvm::FunctionType::get(builder.getVoidTy(),
+                                         {int8PtrTy, int64Ty, int64Ty}, false);
+  auto *taskF = llvm::Function::Create(taskTy, llvm::Function::InternalLinkage,
+                                       "libjit_parallel_task", llmodule_.get());
+  auto *entryBB = llvm::BasicBlock::Create(ctx, "entry", taskF);
+  auto *callBB = llvm::BasicBlock::Create(ctx, "call", taskF);
+  auto *exitBB = llvm::BasicBlock::Create(ctx, "exit", taskF);
+  llvm::IRBuilder<> taskBuilder(exitBB);
+  taskBuilder.CreateRetVoid();
+  taskBuilder.SetInsertPoint(entryBB);
+  auto *taskCtx = taskBuilder.CreateBitCast(taskF->arg_begin(),
+                                            ctxTy->getPointerTo(), "task.ctx");
+  auto *begin =
+      taskBuilder.CreateIntCast(taskF->arg_begin() + 1, dimTTy, false);
+  auto *end = taskBuilder.CreateIntCast(taskF->arg_begin() + 2, dimTTy, false);
+  // Kernels expect a non-empty range.
+  taskBuilder.CreateCondBr(taskBuilder.CreateICmpULT(begin, end), callBB,
+                           exitBB);
+  taskBuilder.SetInsertPoint(callBB);
+  llvm::SmallVector<llvm::Value *, 32> callArgs;
+  unsigned fieldIdx = 0;
+  for (auto *arg : args) {
+    if (isa<llvm::Constant>(arg)) {
+      callArgs.push_back(arg);
+      continue;
+    }
+    auto *fieldAddr =
+        taskBuilder.CreateStructGEP(ctxTy, taskCtx, fieldIdx++, "task.arg");
+    callArgs.push_back(taskBuilder.CreateLoad(arg->getType(), fieldAddr));
+  }
+  callArgs.push_back(begin);
+  callArgs.push_back(end);
+  // The calls inside the task need to be specialized just like the calls in
+  // the entry function.
+  emittedLLVMFunctions_.emplace_back(taskF);
+  auto *ret = taskBuilder.CreateBr(exitBB);
+  taskBuilder.SetInsertPoint(ret);
+  if (currentInstr_) {
+    setCurrentDebugLocation(taskBuilder, currentInstr_);
+  }
+  createUncheckedCall(taskBuilder, F, callArgs);
+
+  // Store the arguments into the context struct allocated in the entry block
+  // of the caller.
+  auto *callerF = builder.GetInsertBlock()->getParent();
+  llvm::IRBuilder<> allocaBuilder(&callerF->getEntryBlock(),
+                                  callerF->getEntryBlock().begin());
+  auto *ctxAlloca = allocaBuilder.CreateAlloca(ctxTy, nullptr, "task.ctx");
+  fieldIdx = 0;
+  for (auto *arg : args) {
+    if (isa<llvm::Constant>(arg)) {
+      continue;
+    }
+    builder.CreateStore(
+        arg, builder.CreateStructGEP(ctxTy, ctxAlloca, fieldIdx++, "task.arg"));
+  }
+
+  // Load the callback registered by the client and invoke it.
+  auto *configTy = parallelForConfig_->getValueType();
+  auto *parallelFor = builder.CreateLoad(
+      int8PtrTy, builder.CreateStructGEP(configTy, parallelForConfig_,
+                                         parallelForFieldIdx_));
+  auto *threadPool = builder.CreateLoad(
+      int8PtrTy, builder.CreateStructGEP(configTy, parallelForConfig_,
+                                         parallelForFieldIdx_ + 1));
+  auto *parallelForF = getFunction("parallel_for");
+  createUncheckedCall(builder, parallelForF,
+                      {parallelFor, threadPool,
+                       llvm::ConstantInt::get(int64Ty, numIters),
+                       builder.CreateBitCast(taskF, int8PtrTy),
+                       builder.CreateBitCast(ctxAlloca, int8PtrTy)});
+  generateFunctionDebugInfo(taskF);
+}
+
 /// Emit the address of the buffer \p v inside a data-parallel kernel \p kernel
 /// using the mapping provided by \p bufferToArgNum.
 llvm::Value *
 LLVMIRGen::emitBufferAddress(llvm::IRBuilder<> &builder, Value *val,
                              llvm::Function *kernel,
                              llvm::DenseMap<Value *, int> &bufferToArgNum) {
+  auto it = rowBufferAddress_.find(val);
+  if (it != rowBufferAddress_.end()) {
+    return it->second;
+  }
   assert(bufferToArgNum.count(val) && "Buffer should be in the map");
   return kernel->args().begin() + bufferToArgNum[val];
 }
 
+/// Emit the offset into the source of the broadcast view \p TVI of the
+/// element \p idx of the view using \p builder.
+static llvm::Value *emitBroadcastViewOffset(llvm::IRBuilder<> &builder,
+                                            const TensorViewInst *TVI,
+                                            llvm::Value *idx) {
+  auto srcDims = TVI->getSrc()->dims();
+  auto dims = TVI->getType()->dims();
+  auto *dimTTy = builder.getIntNTy(DIM_T_BITWIDTH);
+  llvm::Value *offset = llvm::ConstantInt::get(dimTTy, 0);
+  dim_t stride = 1;
+  dim_t srcStride = 1;
+  for (size_t i = dims.size(); i > 0; i--) {
+    // Broadcast dimensions do not contribute to the offset.
+    if (srcDims[i - 1] != 1) {
+      auto *coord = builder.CreateURem(
+          builder.CreateUDiv(idx, llvm::ConstantInt::get(dimTTy, stride)),
+          llvm::ConstantInt::get(dimTTy, dims[i - 1]));
+      offset = builder.CreateAdd(
+          offset,
+          builder.CreateMul(coord, llvm::ConstantInt::get(dimTTy, srcStride)));
+    }
+    stride *= dims[i - 1];
+    srcStride *= srcDims[i - 1];
+  }
+  return offset;
+}
+
 /// Implementation of emitDataParallelKernel where we guarantee that the number
 /// of arguments will be bound by 64.
 void LLVMIRGen::emitDataParallelKernelImpl(
@@ -755,10 +926,24 @@ void LLVMIRGen::emitDataParallelKernelImpl(
   if (bundle.empty()) {
     return;
   }
+  // Number of tensor elements.
+  dim_t numElements = bundle[0]->getOperand(0).first->size();
+  // Big kernels are split across the parallel-for callback, if there is one.
+  // Such kernels get the range of elements to be processed as two additional
+  // parameters.
+  bool isParallel =
+      isParallelForEnabled() && numElements >= kParallelForMinElements;
+  llvm::SmallVector<llvm::Type *, 32> kernelArgTypes(argTypes.begin(),
+                                                     argTypes.end());
+  if (isParallel) {
+    auto *dimTTy = builder.getIntNTy(DIM_T_BITWIDTH);
+    kernelArgTypes.push_back(dimTTy);
+    kernelArgTypes.push_back(dimTTy);
+  }
   // Create stacked kernel function type.
   llvm::Type *voidTy = llvm::Type::getVoidTy(getLLVMContext());
   llvm::FunctionType *kernelFuncTy =
-      llvm::FunctionType::get(voidTy, argTypes, false);
+      llvm::FunctionType::get(voidTy, kernelArgTypes, false);
   auto *kernelFunc =
       llvm::Function::Create(kernelFuncTy, llvm::Function::InternalLinkage,
                              "libjit_stacked_kernel", llmodule_.get());
@@ -772,11 +957,140 @@ void LLVMIRGen::emitDataParallelKernelImpl(
   llvm::BasicBlock *entryBB =
       llvm::BasicBlock::Create(getLLVMContext(), "entry", kernelFunc);
   llvm::IRBuilder<> kernelBuilder(entryBB);
-  // Number of tensor elements.
-  auto *numElements =
-      emitValueSize(kernelBuilder, bundle[0]->getOperand(0).first);
+  // The range of elements processed by the kernel.
+  llvm::Value *begin;
+  llvm::Value *end;
+  if (isParallel) {
+    auto *endArg = kernelFunc->arg_end() - 1;
+    end = endArg;
+    begin = endArg - 1;
+  } else {
+    begin = llvm::ConstantInt::get(kernelBuilder.getIntNTy(DIM_T_BITWIDTH), 0);
+    end = emitValueSize(kernelBuilder, bundle[0]->getOperand(0).first);
+  }
+
+  // Buffers of the kernel in the order of its arguments.
+  llvm::SmallVector<Value *, 32> args(bufferToArgNum.size());
+  for (const auto &it : bufferToArgNum) {
+    args[it.second] = it.first;
+  }
+  // Elements of broadcast views are consecutive in their sources only within
+  // rows of rowLength elements. If there are any, the kernel iterates over
+  // such rows and rebases all buffers to the start of each row.
+  dim_t rowLength = 0;
+  for (auto *buf : args) {
+    auto *TVI = dyn_cast<TensorViewInst>(buf);
+    if (TVI && isBroadcastView(TVI)) {
+      rowLength = llvm::GreatestCommonDivisor64(
+          rowLength, getBroadcastRowLength(TVI->getSrc()->dims(),
+                                           TVI->getType()->dims()));
+    }
+  }
+
+  // Quantized kernels process blocks of quantizedVectorWidth elements with
+  // explicit vector IR first. The remaining elements are processed by the
+  // scalar loop below.
+  unsigned width = quantizedVectorWidth;
+  if (width > 1 && !rowLength && canVectorizeQuantizedBundle(bundle)) {
+    auto *dimTTy = kernelBuilder.getIntNTy(DIM_T_BITWIDTH);
+    auto *widthVal = llvm::ConstantInt::get(dimTTy, width);
+    auto *vecEnd = kernelBuilder.CreateAdd(
+        begin, kernelBuilder.CreateMul(
+                   kernelBuilder.CreateUDiv(
+                       kernelBuilder.CreateSub(end, begin), widthVal),
+                   widthVal));
+    auto *vecBB =
+        llvm::BasicBlock::Create(getLLVMContext(), "vector.ph", kernelFunc);
+    auto *tailCheckBB =
+        llvm::BasicBlock::Create(getLLVMContext(), "vector.end", kernelFunc);
+    kernelBuilder.CreateCondBr(kernelBuilder.CreateICmpULT(begin, vecEnd),
+                               vecBB, tailCheckBB);
+    kernelBuilder.SetInsertPoint(vecBB);
+    auto vecLoopBBs =
+        createLoop(kernelBuilder, getLLVMContext(), begin, vecEnd, width);
+    auto *vecLoopIdx = dyn_cast<llvm::PHINode>(vecLoopBBs.first->begin());
+    assert(vecLoopIdx && "Could not find the loop index");
+    kernelBuilder.SetInsertPoint(vecLoopBBs.first->getFirstNonPHIOrDbg());
+    for (auto &BI : bundle) {
+      generateVectorLLVMIRForQuantizedInstr(kernelBuilder, BI, kernelFunc,
+                                            bufferToArgNum, vecLoopIdx, width);
+    }
+    kernelBuilder.SetInsertPoint(vecLoopBBs.second);
+    kernelBuilder.CreateBr(tailCheckBB);
+
+    // Skip the scalar loop if there are no remaining elements.
+    kernelBuilder.SetInsertPoint(tailCheckBB);
+    auto *tailBB =
+        llvm::BasicBlock::Create(getLLVMContext(), "scalar.ph", kernelFunc);
+    auto *exitBB =
+        llvm::BasicBlock::Create(getLLVMContext(), "exit", kernelFunc);
+    kernelBuilder.CreateCondBr(kernelBuilder.CreateICmpULT(vecEnd, end), tailBB,
+                               exitBB);
+    kernelBuilder.SetInsertPoint(exitBB);
+    kernelBuilder.CreateRetVoid();
+    kernelBuilder.SetInsertPoint(tailBB);
+    begin = vecEnd;
+  }
+
+  // The loop over the rows overlapping [begin, end), if any.
+  std::pair<llvm::BasicBlock *, llvm::BasicBlock *> rowLoopBBs{nullptr,
+                                                               nullptr};
+  llvm::BasicBlock *rowLatchBB = nullptr;
+  if (rowLength) {
+    auto *dimTTy = kernelBuilder.getIntNTy(DIM_T_BITWIDTH);
+    auto *rowLengthVal = llvm::ConstantInt::get(dimTTy, rowLength);
+    auto *rowBegin = kernelBuilder.CreateUDiv(begin, rowLengthVal);
+    auto *rowEnd = kernelBuilder.CreateUDiv(
+        kernelBuilder.CreateAdd(end, llvm::ConstantInt::get(dimTTy,
+                                                            rowLength - 1)),
+        rowLengthVal);
+    rowLoopBBs = createLoop(kernelBuilder, getLLVMContext(), rowBegin, rowEnd);
+    auto *rowIdx = dyn_cast<llvm::PHINode>(rowLoopBBs.first->begin());
+    assert(rowIdx && "Could not find the row index");
+    kernelBuilder.SetInsertPoint(rowLoopBBs.first->getFirstNonPHIOrDbg());
+    auto *rowStart = kernelBuilder.CreateMul(rowIdx, rowLengthVal);
+    auto *rowStop = kernelBuilder.CreateAdd(rowStart, rowLengthVal);
+    // Process the elements of the current row within [begin, end).
+    begin = kernelBuilder.CreateSub(
+        kernelBuilder.CreateSelect(kernelBuilder.CreateICmpULT(begin, rowStart),
+                                   rowStart, begin),
+        rowStart);
+    end = kernelBuilder.CreateSub(
+        kernelBuilder.CreateSelect(kernelBuilder.CreateICmpULT(end, rowStop),
+                                   end, rowStop),
+        rowStart);
+    // Rebase the buffers processed element by element. Lookup tables are
+    // indexed by the values of the elements rather than by their positions and
+    // are left as they are, even when they happen to have numElements entries.
+    llvm::SmallPtrSet<const Value *, 4> tables;
+    for (auto *I : bundle) {
+      if (auto *ILT = dyn_cast<IntLookupTableInst>(I)) {
+        tables.insert(ILT->getMapping());
+      }
+    }
+    for (auto *buf : args) {
+      if (buf->size() != numElements || tables.count(buf)) {
+        continue;
+      }
+      llvm::Value *offset = rowStart;
+      auto *TVI = dyn_cast<TensorViewInst>(buf);
+      if (TVI && isBroadcastView(TVI)) {
+        offset = emitBroadcastViewOffset(kernelBuilder, TVI, rowStart);
+      }
+      rowBufferAddress_[buf] = kernelBuilder.CreateGEP(
+          getElementType(kernelBuilder, buf),
+          kernelFunc->args().begin() + bufferToArgNum[buf], offset);
+    }
+    // Split off the latch of the row loop, so that the loop over the elements
+    // of a row can be nested into it.
+    rowLatchBB = rowLoopBBs.first->splitBasicBlock(
+        kernelBuilder.GetInsertPoint(), "row.latch");
+    rowLoopBBs.first->getTerminator()->eraseFromParent();
+    kernelBuilder.SetInsertPoint(rowLoopBBs.first);
+  }
+
   // Create a loop inside the stacked kernel function being generated.
-  auto loopBBs = createLoop(kernelBuilder, getLLVMContext(), numElements);
+  auto loopBBs = createLoop(kernelBuilder, getLLVMContext(), begin, end);
 
   // Get the index parameter of the loop.
   // This is the PHI node of the BB.
@@ -794,12 +1108,24 @@ void LLVMIRGen::emitDataParallelKernelImpl(
                                        bufferToArgNum, kernelLoopIdx);
   }
   kernelBuilder.SetInsertPoint(loopBBs.second);
+  if (rowLatchBB) {
+    kernelBuilder.CreateBr(rowLatchBB);
+    kernelBuilder.SetInsertPoint(rowLoopBBs.second);
+    rowBufferAddress_.clear();
+  }
   // Add a return.
   kernelBuilder.CreateRetVoid();
 
   setCurrentDebugLocation(builder, *bundle.begin());
-  // Emit a call of the kernel.
-  createUncheckedCall(builder, kernelFunc, buffers);
+  // Emit a call of the kernel. Attribute it to the first instruction of the
+  // bundle for profile lookups.
+  currentInstr_ = *bundle.begin();
+  if (isParallel) {
+    emitParallelCall(builder, kernelFunc, buffers, numElements);
+  } else {
+    createUncheckedCall(builder, kernelFunc, buffers);
+  }
+  currentInstr_ = nullptr;
   // Emit debug info for the generated data-parallel kernel.
   generateFunctionDebugInfo(kernelFunc);
 }
@@ -912,7 +1238,9 @@ void LLVMIRGen::generateLLVMIRForModule(llvm::IRBuilder<> &builder) {
       }
       emitDataParallelKernel(builder, bundle);
       bundle.clear();
+      currentInstr_ = &I;
       generateLLVMIRForInstr(builder, &I);
+      currentInstr_ = nullptr;
       continue;
     }
 
@@ -933,8 +1261,10 @@ void LLVMIRGen::generateLLVMIRForModule(llvm::IRBuilder<> &builder) {
     // instruction cannot be included into the data-parallel bundle, because
     // overlapping operand buffers are not data parallel.
     for (auto op : I.getOperands()) {
-      // Skip non-mutated operands.
-      if (op.second == OperandKind::In)
+      // Skip non-mutated operands, except for broadcast views. They read
+      // elements at other positions than the ones written by the bundle.
+      auto *TVI = dyn_cast<TensorViewInst>(op.first);
+      if (op.second == OperandKind::In && !(TVI && isBroadcastView(TVI)))
         continue;
       // If the mutated operand buffer overlaps with any buffer already used by
       // the bundle, the current instruction cannot become a part of the bundle.
@@ -958,6 +1288,172 @@ void LLVMIRGen::generateLLVMIRForModule(llvm::IRBuilder<> &builder) {
   emitDataParallelKernel(builder, bundle);
 }
 
+bool LLVMIRGen::canVectorizeQuantizedBundle(
+    llvm::ArrayRef<const Instruction *> bundle) const {
+  for (const auto *I : bundle) {
+    switch (I->getKind()) {
+    case Kinded::Kind::ElementAddInstKind:
+    case Kinded::Kind::ElementSubInstKind:
+    case Kinded::Kind::ElementMaxInstKind:
+    case Kinded::Kind::ElementMinInstKind:
+    case Kinded::Kind::ElementMulInstKind:
+    case Kinded::Kind::CopyInstKind:
+      break;
+    default:
+      return false;
+    }
+    for (const auto &op : I->getOperands()) {
+      if (op.first->getElementType() != ElemKind::Int8QTy) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/// \returns the vector type with \p width elements of type \p elemTy.
+static llvm::Type *getVectorType(llvm::Type *elemTy, unsigned width) {
+#if LLVM_VERSION_MAJOR >= 11
+  return llvm::FixedVectorType::get(elemTy, width);
+#else
+  return llvm::VectorType::get(elemTy, width);
+#endif
+}
+
+/// Load a vector of \p width int8 elements starting at the element \p idx of
+/// the buffer \p ptr and sign-extend it to int32. Buffers are only guaranteed
+/// to be aligned to their element size.
+static llvm::Value *emitLoadI8Vector(llvm::IRBuilder<> &builder,
+                                     llvm::Value *ptr, llvm::Value *idx,
+                                     unsigned width) {
+  auto *vecTy = getVectorType(builder.getInt8Ty(), width);
+  auto *addr = builder.CreateBitCast(
+      builder.CreateGEP(builder.getInt8Ty(), ptr, idx), vecTy->getPointerTo());
+  auto *load = builder.CreateLoad(vecTy, addr);
+#if LLVM_VERSION_MAJOR >= 10
+  load->setAlignment(llvm::Align(1));
+#else
+  load->setAlignment(1);
+#endif
+  return builder.CreateSExt(load, getVectorType(builder.getInt32Ty(), width));
+}
+
+/// Clip the int32 vector \p val to the int8 range and store it at the element
+/// \p idx of the buffer \p ptr. This mirrors libjit_clip.
+static void emitStoreI8Vector(llvm::IRBuilder<> &builder, llvm::Value *val,
+                              llvm::Value *ptr, llvm::Value *idx,
+                              unsigned width) {
+  auto *minVal = builder.CreateVectorSplat(width, builder.getInt32(-128));
+  auto *maxVal = builder.CreateVectorSplat(width, builder.getInt32(127));
+  val = builder.CreateSelect(builder.CreateICmpSLT(val, minVal), minVal, val);
+  val = builder.CreateSelect(builder.CreateICmpSGT(val, maxVal), maxVal, val);
+  auto *vecTy = getVectorType(builder.getInt8Ty(), width);
+  auto *addr = builder.CreateBitCast(
+      builder.CreateGEP(builder.getInt8Ty(), ptr, idx), vecTy->getPointerTo());
+  auto *store = builder.CreateStore(builder.CreateTrunc(val, vecTy), addr);
+#if LLVM_VERSION_MAJOR >= 10
+  store->setAlignment(llvm::Align(1));
+#else
+  store->setAlignment(1);
+#endif
+}
+
+/// Rescale the int32 vector \p val with the shift-mult-shift parameters
+/// \p params and add \p offset. This is the vector form of
+/// libjit_scale_i32i8_r, with the rounding term folded at compile time.
+static llvm::Value *
+emitRescaleI32Vector(llvm::IRBuilder<> &builder, llvm::Value *val,
+                     const QuantizationTransform32To8 &params, int32_t offset,
+                     unsigned width) {
+  auto splat = [&](int32_t c) {
+    return builder.CreateVectorSplat(width, builder.getInt32(c));
+  };
+  int32_t rtn = (params.post > 0) ? (1 << (params.post - 1)) : 0;
+  val = builder.CreateAShr(val, splat(params.pre));
+  val = builder.CreateMul(val, splat(params.scale));
+  val = builder.CreateAdd(val, splat(rtn));
+  val = builder.CreateAShr(val, splat(params.post));
+  return builder.CreateAdd(val, splat(offset));
+}
+
+void LLVMIRGen::generateVectorLLVMIRForQuantizedInstr(
+    llvm::IRBuilder<> &builder, const glow::Instruction *I,
+    llvm::Function *kernel, llvm::DenseMap<Value *, int> &bufferToArgNum,
+    llvm::Value *loopCount, unsigned width) {
+  setCurrentDebugLocation(builder, I);
+  assert(canVectorizeQuantizedBundle(I) && "Unsupported instruction");
+  if (auto *CI = dyn_cast<CopyInst>(I)) {
+    auto *destPtr =
+        emitBufferAddress(builder, CI->getDest(), kernel, bufferToArgNum);
+    auto *srcPtr =
+        emitBufferAddress(builder, CI->getSrc(), kernel, bufferToArgNum);
+    emitStoreI8Vector(builder,
+                      emitLoadI8Vector(builder, srcPtr, loopCount, width),
+                      destPtr, loopCount, width);
+    return;
+  }
+  // All other supported instructions have the operands (dest, LHS, RHS).
+  auto *dest = I->getOperand(0).first;
+  auto *lhs = I->getOperand(1).first;
+  auto *rhs = I->getOperand(2).first;
+  auto *destPtr = emitBufferAddress(builder, dest, kernel, bufferToArgNum);
+  auto *lhsPtr = emitBufferAddress(builder, lhs, kernel, bufferToArgNum);
+  auto *rhsPtr = emitBufferAddress(builder, rhs, kernel, bufferToArgNum);
+  auto *destTy = dest->getType();
+  auto *lhsTy = lhs->getType();
+  auto *rhsTy = rhs->getType();
+
+  auto splat = [&](int32_t c) {
+    return builder.CreateVectorSplat(width, builder.getInt32(c));
+  };
+  auto *lhsVal = builder.CreateSub(
+      emitLoadI8Vector(builder, lhsPtr, loopCount, width),
+      splat(lhsTy->getOffset()));
+  auto *rhsVal = builder.CreateSub(
+      emitLoadI8Vector(builder, rhsPtr, loopCount, width),
+      splat(rhsTy->getOffset()));
+
+  llvm::Value *result;
+  if (I->getKind() == Kinded::Kind::ElementMulInstKind) {
+    // See the scalar code generation of ElementMulInst for the derivation of
+    // the scale.
+    float scale = lhsTy->getScale() * rhsTy->getScale() / destTy->getScale();
+    auto scaleParams = quantization::quantizeScaleOffset32To8(scale, 0);
+    result = emitRescaleI32Vector(builder, builder.CreateMul(lhsVal, rhsVal),
+                                  scaleParams, destTy->getOffset(), width);
+  } else {
+    // Both operands are rescaled to the scale of the destination first, see
+    // ARITHMETIC_BINARY_OP_CASE.
+    float destScale = destTy->getScale();
+    auto lhsScaleParams = quantization::quantizeScaleOffset32To8(
+        lhsTy->getScale() / destScale, lhsTy->getOffset());
+    auto rhsScaleParams = quantization::quantizeScaleOffset32To8(
+        rhsTy->getScale() / destScale, rhsTy->getOffset());
+    lhsVal = emitRescaleI32Vector(builder, lhsVal, lhsScaleParams, 0, width);
+    rhsVal = emitRescaleI32Vector(builder, rhsVal, rhsScaleParams, 0, width);
+    switch (I->getKind()) {
+    case Kinded::Kind::ElementAddInstKind:
+      result = builder.CreateAdd(lhsVal, rhsVal);
+      break;
+    case Kinded::Kind::ElementSubInstKind:
+      result = builder.CreateSub(lhsVal, rhsVal);
+      break;
+    case Kinded::Kind::ElementMaxInstKind:
+      result = builder.CreateSelect(builder.CreateICmpSGT(lhsVal, rhsVal),
+                                    lhsVal, rhsVal);
+      break;
+    case Kinded::Kind::ElementMinInstKind:
+      result = builder.CreateSelect(builder.CreateICmpSLT(lhsVal, rhsVal),
+                                    lhsVal, rhsVal);
+      break;
+    default:
+      llvm_unreachable("Unsupported instruction");
+    }
+    result = builder.CreateAdd(result, splat(destTy->getOffset()));
+  }
+  emitStoreI8Vector(builder, result, destPtr, loopCount, width);
+}
+
 void LLVMIRGen::generateLLVMIRForDataParallelInstr(
     llvm::IRBuilder<> &builder, const glow::Instruction *I,
     llvm::Function *kernel, llvm::DenseMap<Value *, int> &bufferToArgNum,
@@ -1649,6 +2145,30 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     break;
   }
 
+  case Kinded::Kind::BlockSparseFullyConnectedInstKind: {
+    auto *BSFC = cast<BlockSparseFullyConnectedInst>(I);
+    auto *dest = BSFC->getDest();
+    auto *src = BSFC->getSrc();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *srcPtr = emitValueAddress(builder, src);
+    auto *valuesPtr = emitValueAddress(builder, BSFC->getValues());
+    auto *colIndicesPtr = emitValueAddress(builder, BSFC->getColIndices());
+    auto *rowOffsetsPtr = emitValueAddress(builder, BSFC->getRowOffsets());
+    auto *biasPtr = emitValueAddress(builder, BSFC->getBias());
+    auto *destDims = emitValueDims(builder, dest);
+    auto *srcDims = emitValueDims(builder, src);
+    auto *blockRows = emitConstDimT(builder, BSFC->getBlockRows());
+    auto *blockCols = emitConstDimT(builder, BSFC->getBlockCols());
+    auto *F = getFunction("block_sparse_fc", dest->getElementType());
+    // The rows of the input are independent, so they are split across the
+    // parallel-for callback if there is one.
+    emitParallelCall(builder, F,
+                     {destPtr, srcPtr, valuesPtr, colIndicesPtr, rowOffsetsPtr,
+                      biasPtr, destDims, srcDims, blockRows, blockCols},
+                     src->dims()[0]);
+    break;
+  }
+
   case Kinded::Kind::QuantizationProfileInstKind: {
     auto *QP = cast<QuantizationProfileInst>(I);
     auto *hist = QP->getHistogram();
@@ -2494,6 +3014,35 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     break;
   }
 
+  case Kinded::Kind::ScaledDotProductAttentionInstKind: {
+    auto *SDPA = cast<ScaledDotProductAttentionInst>(I);
+    auto *dest = SDPA->getDest();
+    auto *queries = SDPA->getQueries();
+    auto *keys = SDPA->getKeys();
+    auto *values = SDPA->getValues();
+    auto *mask = SDPA->getMask();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *queriesPtr = emitValueAddress(builder, queries);
+    auto *keysPtr = emitValueAddress(builder, keys);
+    auto *valuesPtr = emitValueAddress(builder, values);
+    auto *maskPtr = emitValueAddress(builder, mask);
+    auto *queryLen = emitConstDimT(builder, queries->dims()[1]);
+    auto *keyLen = emitConstDimT(builder, keys->dims()[1]);
+    auto *headDim = emitConstDimT(builder, queries->dims()[2]);
+    auto *valueDim = emitConstDimT(builder, values->dims()[2]);
+    auto *maskQueryLen = emitConstDimT(builder, mask->dims()[1]);
+    auto *scale = emitConstF32(builder, SDPA->getScale());
+    auto *F = getFunction("scaled_dot_product_attention",
+                          dest->getElementType());
+    // The query rows are independent, so they are split across the
+    // parallel-for callback if there is one.
+    emitParallelCall(builder, F,
+                     {destPtr, queriesPtr, keysPtr, valuesPtr, maskPtr,
+                      queryLen, keyLen, headDim, valueDim, maskQueryLen, scale},
+                     queries->dims()[0] * queries->dims()[1]);
+    break;
+  }
+
   case Kinded::Kind::SoftMaxGradInstKind: {
     auto *SMG = cast<SoftMaxGradInst>(I);
     auto *srcGrad = SMG->getSrcGrad();
@@ -2931,6 +3480,39 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     break;
   }
 
+  case Kinded::Kind::
+      GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumInstKind: {
+    auto *N = cast<GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumInst>(I);
+    auto *dest = N->getDest();
+    auto *data = N->getData();
+    auto *weights = N->getWeights();
+    auto *indices = N->getIndices();
+    auto *lengths = N->getLengths();
+    auto *tableOffsets = N->getTableOffsets();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *dataPtr = emitValueAddress(builder, data);
+    auto *weightsPtr = emitValueAddress(builder, weights);
+    auto *indicesPtr = emitValueAddress(builder, indices);
+    auto *lengthsPtr = emitValueAddress(builder, lengths);
+    auto *tableOffsetsPtr = emitValueAddress(builder, tableOffsets);
+    dim_t numTables = tableOffsets->dims()[0];
+    auto *segmentsPerTable =
+        emitConstDimT(builder, lengths->dims()[0] / numTables);
+    auto *inLineSize = emitConstDimT(builder, data->size() / data->dims()[0]);
+    auto *outLineSize = emitConstDimT(builder, dest->size() / dest->dims()[0]);
+    auto *F = getFunction(
+        "grouped_fused_rowwise_quantized_sparse_lengths_weighted_sum",
+        {dest->getElementType(), indices->getElementType()});
+    // The tables are independent, so they are split across the parallel-for
+    // callback if there is one.
+    emitParallelCall(builder, F,
+                     {destPtr, dataPtr, weightsPtr, indicesPtr, lengthsPtr,
+                      tableOffsetsPtr, segmentsPerTable, inLineSize,
+                      outLineSize},
+                     numTables);
+    break;
+  }
+
   case Kinded::Kind::EmbeddingBagByteRowwiseOffsetsInstKind: {
     auto *N = cast<EmbeddingBagByteRowwiseOffsetsInst>(I);
     auto *dest = N->getDest();
@@ -3229,6 +3811,12 @@ bool LLVMIRGen::isEligibleForSpecialization(const llvm::CallInst *call) {
   return true;
 }
 
+const glow::Instruction *
+LLVMIRGen::getInstrForCall(const llvm::CallInst *call) const {
+  auto it = callsToInstrs_.find(call);
+  return it == callsToInstrs_.end() ? nullptr : it->second;
+}
+
 bool LLVMIRGen::canBePartOfDataParallelKernel(
     const glow::Instruction *I) const {
   return I->isDataParallel();
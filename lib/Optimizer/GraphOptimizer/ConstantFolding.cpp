@@ -26,8 +26,37 @@
 #include "glow/Graph/TensorLayout.h"
 #include "glow/Graph/Utils.h"
 #include "glow/Optimizer/GraphOptimizer/FunctionPasses.h"
+#include "glow/Support/Register.h"
+#include "glow/Support/ThreadPool.h"
 
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CommandLine.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+extern llvm::cl::OptionCategory graphOptCat;
+
+llvm::cl::opt<unsigned> constFoldThreadsOpt(
+    "const_fold_threads",
+    llvm::cl::desc("Number of threads evaluating independent constant "
+                   "subgraphs during constant folding, 0 for one per core"),
+    llvm::cl::Optional, llvm::cl::init(0), llvm::cl::cat(graphOptCat));
+
+llvm::cl::opt<std::string> constFoldBackendOpt(
+    "const_fold_backend",
+    llvm::cl::desc("Backend evaluating large batches of constant operations "
+                   "if it is registered and supports all of them, instead of "
+                   "the Interpreter"),
+    llvm::cl::Optional, llvm::cl::init("CPU"), llvm::cl::cat(graphOptCat));
+
+llvm::cl::opt<unsigned> constFoldMinBatchNodesOpt(
+    "const_fold_min_batch_nodes",
+    llvm::cl::desc("Min number of nodes of a batch of constant operations for "
+                   "it to be evaluated on its own thread and on "
+                   "const_fold_backend"),
+    llvm::cl::Optional, llvm::cl::init(64), llvm::cl::cat(graphOptCat));
 
 using namespace glow;
 using llvm::dyn_cast;
@@ -101,11 +130,15 @@ bool hasNonConstantOperationUser(const Node *N, const Backend &backend,
   return false;
 }
 
+/// Number of Functions compiled by constant folding so far.
+std::atomic<uint64_t> numConstantFoldingCompilations{0};
+
 /// Compile the function \p F for the provided \p backend using the compilation
 /// context \p cctx.
 /// \returns compiled function.
 Expected<std::unique_ptr<CompiledFunction>>
 compile(Backend &backend, Function &F, CompilationContext &cctx) {
+  numConstantFoldingCompilations++;
   RETURN_IF_ERR(::glow::optimizeFunction(&F, backend, cctx));
   return backend.compile(&F, cctx.backendOpts);
 }
@@ -292,8 +325,287 @@ bool constantFoldNodeImpl(Backend &backend, Node *N,
   return evaluateConstantOperation(backend, cctx, N, constResults, record);
 }
 
+/// A batch of constant operations of a Function, evaluated together by a
+/// single temporary Function. Every batch lives in its own Module, holding
+/// copies of the Constants the batch reads, so that batches can be compiled
+/// and executed concurrently.
+struct ConstantFoldingBatch {
+  /// Module owning the temporary Function and its Constants.
+  Module mod;
+  /// The temporary Function evaluating the batch.
+  Function *F{nullptr};
+  /// Number of nodes of the constant subgraphs of the batch.
+  size_t numNodes{0};
+  /// The constant operations to fold, in post-order.
+  std::vector<Node *> roots;
+  /// The SaveNodes of the results of each of the roots. Empty for the roots
+  /// which cannot be folded.
+  std::vector<llvm::SmallVector<SaveNode *, 4>> savedResults;
+  /// Bindings of the Placeholders of the SaveNodes.
+  PlaceholderBindings bindings;
+  /// Whether the evaluation of the batch succeeded.
+  bool succeeded{false};
+};
+
+/// Clone the constant operation \p N and all of its inputs into the Function
+/// of \p batch, reusing the nodes recorded in \p currToNew. The Constants
+/// created in the Module of \p batch are unowned views of the payloads of the
+/// original ones, which outlive the batch. \returns the clone of \p N.
+Node *cloneIntoBatch(ConstantFoldingBatch &batch, Node *N,
+                     NodeMap &currToNew) {
+  auto it = currToNew.find(N);
+  if (it != currToNew.end()) {
+    return it->second;
+  }
+  if (auto *C = dyn_cast<Constant>(N)) {
+    auto *newC = batch.mod.createConstant(
+        C->getName(), C->getPayload().getUnowned(), C->getLayout());
+    currToNew[C] = newC;
+    return newC;
+  }
+  for (size_t idx = 0, e = N->getNumInputs(); idx < e; ++idx) {
+    cloneIntoBatch(batch, N->getNthInput(idx).getNode(), currToNew);
+  }
+  return recursiveClone(batch.F, N, currToNew);
+}
+
+/// \returns the backend to evaluate \p batch with. The backend named by
+/// -const_fold_backend is used for batches large enough to amortize its
+/// compilation time if it supports all nodes of the batch, and \p interpreter
+/// is used otherwise.
+std::unique_ptr<Backend> getBatchBackend(const ConstantFoldingBatch &batch,
+                                         const Backend &interpreter) {
+  if (batch.numNodes >= constFoldMinBatchNodesOpt &&
+      constFoldBackendOpt != interpreter.getBackendName()) {
+    std::unique_ptr<Backend> backend(
+        FactoryRegistry<std::string, Backend>::get(constFoldBackendOpt));
+    bool supported = backend != nullptr;
+    for (auto &N : batch.F->getNodes()) {
+      if (!supported) {
+        break;
+      }
+      supported = isa<SaveNode>(&N) || isa<SplatNode>(&N) ||
+                  (N.isCanonical() && (backend->shouldLower(&N) ||
+                                       backend->isOpSupported(NodeInfo(N))));
+    }
+    if (supported) {
+      return backend;
+    }
+  }
+  return std::unique_ptr<Backend>(new Interpreter());
+}
+
+/// Split the constant operations \p roots of a Function into batches of
+/// independent constant subgraphs, one per thread out of \p numThreads, and
+/// build them for evaluation. Constant subgraphs sharing nodes always end up
+/// in the same batch so that the shared nodes are evaluated only once.
+/// \p backend is used to check the layouts of the results.
+std::vector<std::unique_ptr<ConstantFoldingBatch>>
+createBatches(llvm::ArrayRef<Node *> roots, size_t numThreads,
+              Backend &backend) {
+  // Union-find over the roots, merging the roots whose constant subgraphs
+  // share nodes. Constants and Splats are cheap to duplicate and do not merge
+  // subgraphs.
+  std::vector<size_t> leader(roots.size());
+  std::vector<size_t> numNodes(roots.size(), 0);
+  auto find = [&](size_t idx) {
+    while (leader[idx] != idx) {
+      idx = leader[idx] = leader[leader[idx]];
+    }
+    return idx;
+  };
+  std::unordered_map<Node *, size_t> owner;
+  for (size_t i = 0, e = roots.size(); i < e; i++) {
+    leader[i] = i;
+    std::vector<Node *> worklist = {roots[i]};
+    while (!worklist.empty()) {
+      Node *N = worklist.back();
+      worklist.pop_back();
+      if (isa<Storage>(N) || isa<SplatNode>(N)) {
+        continue;
+      }
+      auto it = owner.find(N);
+      if (it != owner.end()) {
+        size_t lhs = find(i), rhs = find(it->second);
+        if (lhs != rhs) {
+          leader[rhs] = lhs;
+          numNodes[lhs] += numNodes[rhs];
+        }
+        continue;
+      }
+      owner[N] = i;
+      numNodes[find(i)]++;
+      for (size_t idx = 0, numInputs = N->getNumInputs(); idx < numInputs;
+           ++idx) {
+        worklist.push_back(N->getNthInput(idx).getNode());
+      }
+    }
+  }
+
+  // Only use several batches when each of them is large enough to be worth
+  // its own compilation.
+  std::vector<size_t> components;
+  size_t totalNodes = 0;
+  for (size_t i = 0, e = roots.size(); i < e; i++) {
+    if (find(i) == i) {
+      components.push_back(i);
+      totalNodes += numNodes[i];
+    }
+  }
+  size_t minBatchNodes = std::max(1u, unsigned(constFoldMinBatchNodesOpt));
+  size_t maxBatches =
+      std::max<size_t>(1, std::min(numThreads, totalNodes / minBatchNodes));
+
+  // Assign the largest subgraphs first, each to the batch with the fewest
+  // nodes so far.
+  std::stable_sort(components.begin(), components.end(),
+                   [&](size_t lhs, size_t rhs) {
+                     return numNodes[lhs] > numNodes[rhs];
+                   });
+  std::vector<std::unique_ptr<ConstantFoldingBatch>> batches;
+  std::unordered_map<size_t, size_t> batchOf;
+  for (size_t component : components) {
+    size_t b = 0;
+    if (batches.size() < maxBatches) {
+      b = batches.size();
+      batches.emplace_back(new ConstantFoldingBatch());
+    } else {
+      for (size_t other = 1, e = batches.size(); other < e; other++) {
+        if (batches[other]->numNodes < batches[b]->numNodes) {
+          b = other;
+        }
+      }
+    }
+    batchOf[component] = b;
+    batches[b]->numNodes += numNodes[component];
+  }
+
+  // Build the temporary Functions, cloning the roots in post-order.
+  std::vector<NodeMap> currToNew(batches.size());
+  for (auto &batch : batches) {
+    batch->F = batch->mod.createFunction(
+        std::string(constEvaluationFunctionName) + std::to_string(numFolds++));
+  }
+  for (size_t i = 0, e = roots.size(); i < e; i++) {
+    size_t b = batchOf[find(i)];
+    ConstantFoldingBatch &batch = *batches[b];
+    Node *clonedC = cloneIntoBatch(batch, roots[i], currToNew[b]);
+    batch.roots.push_back(roots[i]);
+    batch.savedResults.emplace_back();
+    // Skip the roots with results in a non-canonical layout, see
+    // bailOnNonCanonicalLayout.
+    bool canonical = true;
+    for (size_t idx = 0, numResults = clonedC->getNumResults();
+         idx < numResults; ++idx) {
+      canonical &=
+          isCanonicalLayout(clonedC->getNthResult(idx), backend, clonedC, idx);
+    }
+    if (!canonical) {
+      continue;
+    }
+    for (size_t idx = 0, numResults = clonedC->getNumResults();
+         idx < numResults; ++idx) {
+      auto *SN = batch.F->createSave(clonedC->getName(),
+                                     clonedC->getNthResult(idx));
+      batch.savedResults.back().push_back(SN);
+      batch.bindings.allocate(SN->getPlaceholder());
+    }
+  }
+  return batches;
+}
+
+/// Evaluate the constant operations \p roots of the Function \p F in batches
+/// and replace their results by the computed Constants. The batches are
+/// evaluated concurrently. Batches which fail to be evaluated fall back to
+/// folding their nodes one at a time with \p interpreter. \returns true if any
+/// node was folded.
+bool constantFoldBatched(Function *F, llvm::ArrayRef<Node *> roots,
+                         Backend &interpreter) {
+  auto startTime = std::chrono::steady_clock::now();
+  size_t numThreads = constFoldThreadsOpt
+                          ? constFoldThreadsOpt
+                          : std::max(1u, std::thread::hardware_concurrency());
+  auto batches = createBatches(roots, numThreads, interpreter);
+
+  auto evaluate = [](ConstantFoldingBatch *batch, Backend &backend) {
+    CompilationContext cctx;
+    // Do not recursively call constant folding.
+    cctx.optimizationOpts.enableConstantFolding = false;
+    cctx.backendOpts.collectConstants = true;
+    // Constant folding is a best effort, do not print out compilation errors.
+    cctx.verboseCompile = false;
+    batch->succeeded = !ERR_TO_BOOL(executeConstantFunction(
+        backend, *batch->F, batch->bindings, cctx,
+        /* enableQuantizeConstFolding */ false));
+  };
+  std::vector<std::unique_ptr<Backend>> backends;
+  for (auto &batch : batches) {
+    backends.push_back(getBatchBackend(*batch, interpreter));
+  }
+  if (batches.size() == 1) {
+    evaluate(batches.front().get(), *backends.front());
+  } else {
+    ThreadPool pool(batches.size(), "ConstantFolding");
+    std::vector<std::future<void>> futures;
+    for (size_t b = 0, e = batches.size(); b < e; b++) {
+      futures.push_back(pool.submit([&, b]() {
+        evaluate(batches[b].get(), *backends[b]);
+      }));
+    }
+    for (auto &future : futures) {
+      future.wait();
+    }
+  }
+
+  bool changed = false;
+  Module &mod = *F->getParent();
+  size_t numCompilations = batches.size();
+  for (size_t b = 0, e = batches.size(); b < e; b++) {
+    ConstantFoldingBatch &batch = *batches[b];
+    for (size_t i = 0, numRoots = batch.roots.size(); i < numRoots; i++) {
+      Node *N = batch.roots[i];
+      if (!batch.succeeded) {
+        // Fall back to folding the nodes of the batch one at a time.
+        std::vector<Constant *> constResults;
+        numCompilations++;
+        if (!constantFoldNodeImpl(interpreter, N, constResults)) {
+          continue;
+        }
+        for (size_t idx = 0, numResults = constResults.size();
+             idx < numResults; ++idx) {
+          N->getNthResult(idx).replaceAllUsesOfWith(constResults[idx]);
+        }
+        changed = true;
+        continue;
+      }
+      for (auto *SN : batch.savedResults[i]) {
+        Tensor *outputTensor = batch.bindings.get(SN->getPlaceholder());
+        auto *constResult =
+            mod.createConstant(SN->getName(), std::move(*outputTensor));
+        N->getNthResult(SN->getInput().getResNo())
+            .replaceAllUsesOfWith(constResult);
+        changed = true;
+      }
+    }
+  }
+
+  VLOG(1) << "Constant folding of " << F->getName().str() << " evaluated "
+          << roots.size() << " constant operations with " << numCompilations
+          << " compilations instead of " << roots.size() << " on "
+          << batches.size() << " threads in "
+          << std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::steady_clock::now() - startTime)
+                 .count()
+          << " ms";
+  return changed;
+}
+
 } // namespace
 
+uint64_t glow::getNumConstantFoldingCompilations() {
+  return numConstantFoldingCompilations;
+}
+
 Error glow::executeConstantFunction(Backend &backend, Function &F,
                                     PlaceholderBindings &bindings,
                                     CompilationContext &cctx,
@@ -324,13 +636,13 @@ static bool constantFoldFun(Function *F, const CompilationContext &cctx,
   const bool enableQuantizeConstFolding = record != nullptr;
 
   LOG_SCOPE(F->getLogContext(), "glow::constantFold")
-  bool changed = false;
   // Backend to be used for compile-time computations.
   std::unique_ptr<Backend> backend(new Interpreter());
   // Traverse nodes in post-order, so that children are seen before parents.
   GraphPostOrderVisitor postOrderVisitor(*F);
   auto nodes = postOrderVisitor.getPostOrder();
   // Collect all non-trivial constant operations.
+  std::vector<Node *> roots;
   for (auto *N : nodes) {
     // Skip trivial nodes/operations that do not require any constant
     // computations.
@@ -353,7 +665,21 @@ static bool constantFoldFun(Function *F, const CompilationContext &cctx,
     if (!hasNonConstantOperationUser(N, *backend, enableQuantizeConstFolding)) {
       continue;
     }
+    roots.push_back(N);
+  }
+  if (roots.empty()) {
+    return false;
+  }
 
+  // Without a record, evaluate all constant operations at once.
+  if (!record) {
+    return constantFoldBatched(F, roots, *backend);
+  }
+
+  // The record needs a separate Function per constant operation, so that the
+  // folding of each Constant can be replayed on its own.
+  bool changed = false;
+  for (auto *N : roots) {
     // Compute the constant value of the node.
     std::vector<Constant *> constResults;
     if (!constantFoldNodeImpl(*backend, N, constResults, record)) {
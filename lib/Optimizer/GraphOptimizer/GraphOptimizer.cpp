@@ -29,16 +29,20 @@
 #include "glow/Graph/VerifierHelper.h"
 #include "glow/Optimizer/GraphOptimizer/FunctionPassPipeline.h"
 #include "glow/Optimizer/GraphOptimizer/FunctionPasses.h"
+#include "glow/Optimizer/GraphOptimizer/GraphRewriter.h"
 #include "glow/Optimizer/Lower/Lower.h"
 #include "glow/PassManager/PassManager.h"
 #include "glow/Quantization/Base/Base.h"
 #include "glow/Quantization/Quantization.h"
 #include "glow/Runtime/RuntimeTypes.h"
 
+#include "llvm/ADT/SetVector.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
 
 #include <algorithm>
+#include <map>
+#include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -482,315 +486,312 @@ bool SinkConcatBelowQuantize::run(Function *F, const CompilationContext &cctx) {
   return changed;
 }
 
-/// Code Sinking.
-bool SinkCode::run(Function *F, const CompilationContext &cctx) {
-  LOG_SCOPE(F->getLogContext(), getName());
+/// Sink the operations feeding \p node in \p F below it, e.g. Transposes
+/// below elementwise operations, and cancel out the Transposes meeting there.
+/// \returns true if \p F was modified.
+static bool sinkCode(Node *node, Function *F) {
   bool changed = false;
-  auto &nodes = F->getNodes();
-  // For each node:
-  for (auto &N : nodes) {
-    auto *node = &N;
-
-    // Sink Reshape/Transpose below BatchNormalization.
-    if (auto *BN = dyn_cast<BatchNormalizationNode>(node)) {
 
-      // Sink Reshape below BatchNormalization.
-      if (auto *RS = dyn_cast<ReshapeNode>(BN->getInput())) {
-        auto inDims = RS->getInput().dims();
-        auto outDims = RS->getResult().dims();
-        unsigned_t newChannelIdx;
+  // Sink Reshape/Transpose below BatchNormalization.
+  if (auto *BN = dyn_cast<BatchNormalizationNode>(node)) {
 
-        // Skip sinking if the input was less than 3 dimensions, because we need
-        // spatial dimensions in addition to batch and channel.
-        if (RS->getInput().dims().size() < 3) {
-          continue;
-        }
+    // Sink Reshape below BatchNormalization.
+    if (auto *RS = dyn_cast<ReshapeNode>(BN->getInput())) {
+      auto inDims = RS->getInput().dims();
+      auto outDims = RS->getResult().dims();
+      unsigned_t newChannelIdx;
 
-        // Reshape should not change the BatchNorm ChannelIdx dimensions.
-        // Only NH[W]C and NCH[W] are allowed.
-        if (BN->getChannelIdx() == outDims.size() - 1) {
-          if (inDims[inDims.size() - 1] != outDims[outDims.size() - 1]) {
-            continue;
-          }
-          newChannelIdx = inDims.size() - 1;
-        } else if (BN->getChannelIdx() == 1) {
-          // Note: index '1' maps to C in NCH[W] layout.
-          if (inDims[1] != outDims[1]) {
-            continue;
-          }
-          newChannelIdx = 1;
-        } else {
-          continue;
-        }
+      // Skip sinking if the input was less than 3 dimensions, because we need
+      // spatial dimensions in addition to batch and channel.
+      if (RS->getInput().dims().size() < 3) {
+        return changed;
+      }
 
-        // Reshape should not change the batch dimension.
-        if (inDims[0] != outDims[0]) {
-          continue;
+      // Reshape should not change the BatchNorm ChannelIdx dimensions.
+      // Only NH[W]C and NCH[W] are allowed.
+      if (BN->getChannelIdx() == outDims.size() - 1) {
+        if (inDims[inDims.size() - 1] != outDims[outDims.size() - 1]) {
+          return changed;
         }
-
-        if (!RS->hasOneUse()) {
-          continue;
+        newChannelIdx = inDims.size() - 1;
+      } else if (BN->getChannelIdx() == 1) {
+        // Note: index '1' maps to C in NCH[W] layout.
+        if (inDims[1] != outDims[1]) {
+          return changed;
         }
-
-        auto *newBN = F->createBatchNormalization(
-            BN->getName(), RS->getInput(), BN->getBias(), BN->getScale(),
-            BN->getMean(), BN->getVar(), newChannelIdx, BN->getEpsilon(),
-            BN->getMomentum());
-        RS->setNthInput(ReshapeNode::InputIdx, newBN);
-        BN->getResult().replaceAllUsesOfWith(RS);
-        changed = true;
-        continue;
+        newChannelIdx = 1;
+      } else {
+        return changed;
       }
 
-      // Sink Transpose below batch normalization nodes:
-      if (auto *TR = dyn_cast<TransposeNode>(BN->getInput())) {
-
-        // Figure out where we transposed the channel index for batch
-        // normalization.
-        unsigned_t idx = BN->getChannelIdx();
-        unsigned_t newChannelIdx = TR->getShuffle()[idx];
-
-        auto *NewBN = F->createBatchNormalization(
-            BN->getName(), TR->getInput(), BN->getBias(), BN->getScale(),
-            BN->getMean(), BN->getVar(), newChannelIdx, BN->getEpsilon(),
-            BN->getMomentum());
-        NewBN->setPredicate(node->getPredicate());
-        auto *newTR = F->createTranspose(TR->getName(), NewBN, TR->getShuffle(),
-                                         TR->getLayout());
-        newTR->setPredicate(node->getPredicate());
-
-        BN->getResult().replaceAllUsesOfWith(newTR);
-        changed = true;
-        continue;
+      // Reshape should not change the batch dimension.
+      if (inDims[0] != outDims[0]) {
+        return changed;
       }
-    }
 
-    if (auto *RL = dyn_cast<ReluNode>(node)) {
-      // Sink Transpose below batch RELU nodes.
-      if (auto *TR = dyn_cast<TransposeNode>(RL->getInput())) {
-        // Keep the same quantization parameters for ReLU output, but
-        // change the shape to appropriate value.
-        auto reluOutTy = F->getParent()->uniqueTypeWithNewShape(
-            RL->getResult().getType(), TR->getInput().getType());
-        auto *NRL = F->createRELU(RL->getName(), TR->getInput(), reluOutTy);
-        NRL->setPredicate(node->getPredicate());
-        auto *newTR = F->createTranspose(TR->getName(), NRL, TR->getShuffle(),
-                                         TR->getLayout());
-        newTR->setPredicate(node->getPredicate());
-        RL->getResult().replaceAllUsesOfWith(newTR);
-        changed = true;
-        continue;
+      if (!RS->hasOneUse()) {
+        return changed;
       }
 
-      // Sink Clip below RELU nodes.
-      if (ClipNode *CN = dyn_cast<ClipNode>(RL->getInput())) {
-        assert(!RL->getResult().getType()->isQuantizedType() &&
-               "Relu(Clip) means Relu should not be quantized.");
-        ReluNode *newRL = F->createRELU(RL->getName(), CN->getInput());
-        ClipNode *newCN =
-            F->createClip(CN->getName(), newRL->getResult(),
-                          std::max(CN->getMin(), 0.0f), CN->getMax());
-        RL->getResult().replaceAllUsesOfWith(newCN);
-        changed = true;
-        continue;
-      }
+      auto *newBN = F->createBatchNormalization(
+          BN->getName(), RS->getInput(), BN->getBias(), BN->getScale(),
+          BN->getMean(), BN->getVar(), newChannelIdx, BN->getEpsilon(),
+          BN->getMomentum());
+      RS->setNthInput(ReshapeNode::InputIdx, newBN);
+      BN->getResult().replaceAllUsesOfWith(RS);
+      changed = true;
+      return changed;
     }
 
-    // Sink Transpose below Clip nodes.
-    if (auto *CL = dyn_cast<ClipNode>(node)) {
-      auto *TR = dyn_cast<TransposeNode>(CL->getInput());
+    // Sink Transpose below batch normalization nodes:
+    if (auto *TR = dyn_cast<TransposeNode>(BN->getInput())) {
 
-      if (!TR) {
-        continue;
-      }
+      // Figure out where we transposed the channel index for batch
+      // normalization.
+      unsigned_t idx = BN->getChannelIdx();
+      unsigned_t newChannelIdx = TR->getShuffle()[idx];
 
-      // Keep the same quantization parameters for Clip output, but
-      // change the shape to appropriate value.
-      auto clipOutTy = F->getParent()->uniqueTypeWithNewShape(
-          CL->getResult().getType(), TR->getInput().getType());
-      auto *NCL = F->createClip(CL->getName(), TR->getInput(), clipOutTy,
-                                CL->getMin(), CL->getMax());
-      NCL->setPredicate(node->getPredicate());
-      auto *newTR = F->createTranspose(TR->getName(), NCL, TR->getShuffle());
+      auto *NewBN = F->createBatchNormalization(
+          BN->getName(), TR->getInput(), BN->getBias(), BN->getScale(),
+          BN->getMean(), BN->getVar(), newChannelIdx, BN->getEpsilon(),
+          BN->getMomentum());
+      NewBN->setPredicate(node->getPredicate());
+      auto *newTR = F->createTranspose(TR->getName(), NewBN, TR->getShuffle(),
+                                       TR->getLayout());
       newTR->setPredicate(node->getPredicate());
-      CL->getResult().replaceAllUsesOfWith(newTR);
+
+      BN->getResult().replaceAllUsesOfWith(newTR);
       changed = true;
-      continue;
+      return changed;
     }
+  }
 
-    // Sink Transpose below Sigmoid nodes.
-    if (auto *SI = dyn_cast<SigmoidNode>(node)) {
-      auto *TR = dyn_cast<TransposeNode>(SI->getInput());
-
-      if (!TR) {
-        continue;
-      }
-
-      auto *NSI = F->createSigmoid(SI->getName(), TR->getInput());
-      NSI->setPredicate(node->getPredicate());
-      auto *newTR = F->createTranspose(TR->getName(), NSI, TR->getShuffle(),
+  if (auto *RL = dyn_cast<ReluNode>(node)) {
+    // Sink Transpose below batch RELU nodes.
+    if (auto *TR = dyn_cast<TransposeNode>(RL->getInput())) {
+      // Keep the same quantization parameters for ReLU output, but
+      // change the shape to appropriate value.
+      auto reluOutTy = F->getParent()->uniqueTypeWithNewShape(
+          RL->getResult().getType(), TR->getInput().getType());
+      auto *NRL = F->createRELU(RL->getName(), TR->getInput(), reluOutTy);
+      NRL->setPredicate(node->getPredicate());
+      auto *newTR = F->createTranspose(TR->getName(), NRL, TR->getShuffle(),
                                        TR->getLayout());
       newTR->setPredicate(node->getPredicate());
-      SI->getResult().replaceAllUsesOfWith(newTR);
+      RL->getResult().replaceAllUsesOfWith(newTR);
       changed = true;
-      continue;
+      return changed;
+    }
+
+    // Sink Clip below RELU nodes.
+    if (ClipNode *CN = dyn_cast<ClipNode>(RL->getInput())) {
+      assert(!RL->getResult().getType()->isQuantizedType() &&
+             "Relu(Clip) means Relu should not be quantized.");
+      ReluNode *newRL = F->createRELU(RL->getName(), CN->getInput());
+      ClipNode *newCN =
+          F->createClip(CN->getName(), newRL->getResult(),
+                        std::max(CN->getMin(), 0.0f), CN->getMax());
+      RL->getResult().replaceAllUsesOfWith(newCN);
+      changed = true;
+      return changed;
     }
+  }
 
-    // Sink Transpose below Pad nodes.
-    if (auto *padNode = dyn_cast<PadNode>(node)) {
-      auto *transposeNode = dyn_cast<TransposeNode>(padNode->getInput());
+  // Sink Transpose below Clip nodes.
+  if (auto *CL = dyn_cast<ClipNode>(node)) {
+    auto *TR = dyn_cast<TransposeNode>(CL->getInput());
 
-      if (!transposeNode) {
-        continue;
-      }
+    if (!TR) {
+      return changed;
+    }
+
+    // Keep the same quantization parameters for Clip output, but
+    // change the shape to appropriate value.
+    auto clipOutTy = F->getParent()->uniqueTypeWithNewShape(
+        CL->getResult().getType(), TR->getInput().getType());
+    auto *NCL = F->createClip(CL->getName(), TR->getInput(), clipOutTy,
+                              CL->getMin(), CL->getMax());
+    NCL->setPredicate(node->getPredicate());
+    auto *newTR = F->createTranspose(TR->getName(), NCL, TR->getShuffle());
+    newTR->setPredicate(node->getPredicate());
+    CL->getResult().replaceAllUsesOfWith(newTR);
+    changed = true;
+    return changed;
+  }
 
-      // The transpose shuffle specifies the source dimension.
-      // When sinking Transpose below Pad, shuffle describes the target
-      // dimension.
-      auto shuffle = transposeNode->getShuffle();
-
-      // Shuffle the Pad output type and the padding attribute.
-      auto outPadType = padNode->getResult().getType();
-      auto outPadShape = outPadType->dims();
-      auto pads = padNode->getPads();
-      size_t numDims = outPadShape.size();
-      std::vector<dim_t> newOutPadShape(numDims);
-      std::vector<int> newPads(2 * numDims);
-      for (size_t i = 0; i < outPadShape.size(); i++) {
-        newOutPadShape[shuffle[i]] = outPadShape[i];
-        newPads[shuffle[i]] = pads[i];
-        newPads[shuffle[i] + numDims] = pads[i + numDims];
-      }
-
-      // New pad
-      auto newOutPadType =
-          F->getParent()->uniqueTypeWithNewShape(outPadType, newOutPadShape);
-      auto *NewPadNode = F->createPad(
-          padNode->getName(), transposeNode->getInput(), newOutPadType,
-          padNode->getMode(), newPads, padNode->getValue());
-      NewPadNode->setPredicate(node->getPredicate());
-      auto *newTransposeNode =
-          F->createTranspose(transposeNode->getName(), NewPadNode, shuffle);
-      newTransposeNode->setPredicate(node->getPredicate());
-      padNode->getResult().replaceAllUsesOfWith(newTransposeNode);
-      changed = true;
-      continue;
+  // Sink Transpose below Sigmoid nodes.
+  if (auto *SI = dyn_cast<SigmoidNode>(node)) {
+    auto *TR = dyn_cast<TransposeNode>(SI->getInput());
+
+    if (!TR) {
+      return changed;
     }
 
-    // Sink Transpose below Tanh nodes.
-    if (auto *TN = dyn_cast<TanhNode>(node)) {
-      auto *TR = dyn_cast<TransposeNode>(TN->getInput());
+    auto *NSI = F->createSigmoid(SI->getName(), TR->getInput());
+    NSI->setPredicate(node->getPredicate());
+    auto *newTR = F->createTranspose(TR->getName(), NSI, TR->getShuffle(),
+                                     TR->getLayout());
+    newTR->setPredicate(node->getPredicate());
+    SI->getResult().replaceAllUsesOfWith(newTR);
+    changed = true;
+    return changed;
+  }
 
-      if (!TR) {
-        continue;
-      }
+  // Sink Transpose below Pad nodes.
+  if (auto *padNode = dyn_cast<PadNode>(node)) {
+    auto *transposeNode = dyn_cast<TransposeNode>(padNode->getInput());
+
+    if (!transposeNode) {
+      return changed;
+    }
+
+    // The transpose shuffle specifies the source dimension.
+    // When sinking Transpose below Pad, shuffle describes the target
+    // dimension.
+    auto shuffle = transposeNode->getShuffle();
+
+    // Shuffle the Pad output type and the padding attribute.
+    auto outPadType = padNode->getResult().getType();
+    auto outPadShape = outPadType->dims();
+    auto pads = padNode->getPads();
+    size_t numDims = outPadShape.size();
+    std::vector<dim_t> newOutPadShape(numDims);
+    std::vector<int> newPads(2 * numDims);
+    for (size_t i = 0; i < outPadShape.size(); i++) {
+      newOutPadShape[shuffle[i]] = outPadShape[i];
+      newPads[shuffle[i]] = pads[i];
+      newPads[shuffle[i] + numDims] = pads[i + numDims];
+    }
+
+    // New pad
+    auto newOutPadType =
+        F->getParent()->uniqueTypeWithNewShape(outPadType, newOutPadShape);
+    auto *NewPadNode = F->createPad(
+        padNode->getName(), transposeNode->getInput(), newOutPadType,
+        padNode->getMode(), newPads, padNode->getValue());
+    NewPadNode->setPredicate(node->getPredicate());
+    auto *newTransposeNode =
+        F->createTranspose(transposeNode->getName(), NewPadNode, shuffle);
+    newTransposeNode->setPredicate(node->getPredicate());
+    padNode->getResult().replaceAllUsesOfWith(newTransposeNode);
+    changed = true;
+    return changed;
+  }
 
-      auto *NTN = F->createTanh(TN->getName(), TR->getInput());
-      NTN->setPredicate(node->getPredicate());
-      auto *newTR = F->createTranspose(TR->getName(), NTN, TR->getShuffle(),
-                                       TR->getLayout());
-      newTR->setPredicate(node->getPredicate());
-      TN->getResult().replaceAllUsesOfWith(newTR);
-      changed = true;
-      continue;
+  // Sink Transpose below Tanh nodes.
+  if (auto *TN = dyn_cast<TanhNode>(node)) {
+    auto *TR = dyn_cast<TransposeNode>(TN->getInput());
+
+    if (!TR) {
+      return changed;
     }
 
-    // Remove 'identity' transpose operations.
-    if (auto *TR = dyn_cast<TransposeNode>(node)) {
-      auto mask = TR->getShuffle();
+    auto *NTN = F->createTanh(TN->getName(), TR->getInput());
+    NTN->setPredicate(node->getPredicate());
+    auto *newTR = F->createTranspose(TR->getName(), NTN, TR->getShuffle(),
+                                     TR->getLayout());
+    newTR->setPredicate(node->getPredicate());
+    TN->getResult().replaceAllUsesOfWith(newTR);
+    changed = true;
+    return changed;
+  }
+
+  // Remove 'identity' transpose operations.
+  if (auto *TR = dyn_cast<TransposeNode>(node)) {
+    auto mask = TR->getShuffle();
 
-      if (isIdentityShuffle(mask)) {
-        TR->getResult().replaceAllUsesOfWith(TR->getInput());
-        changed = true;
-        continue;
-      }
+    if (isIdentityShuffle(mask)) {
+      TR->getResult().replaceAllUsesOfWith(TR->getInput());
+      changed = true;
+      return changed;
     }
+  }
 
-    // Merge consecutive Transpose operations.
-    if (auto *TR1 = dyn_cast<TransposeNode>(node)) {
-      auto *TR2 = dyn_cast<TransposeNode>(TR1->getInput());
-
-      if (!TR2) {
-        continue;
-      }
+  // Merge consecutive Transpose operations.
+  if (auto *TR1 = dyn_cast<TransposeNode>(node)) {
+    auto *TR2 = dyn_cast<TransposeNode>(TR1->getInput());
 
-      auto mask1 = TR1->getShuffle();
-      auto mask2 = TR2->getShuffle();
-      assert(mask1.size() == mask2.size() && "Invalid mask size");
+    if (!TR2) {
+      return changed;
+    }
 
-      llvm::SmallVector<unsigned_t, max_tensor_dimensions> newMask;
-      newMask.resize(mask2.size());
+    auto mask1 = TR1->getShuffle();
+    auto mask2 = TR2->getShuffle();
+    assert(mask1.size() == mask2.size() && "Invalid mask size");
 
-      for (size_t i = 0, end = mask2.size(); i < end; i++) {
-        newMask[i] = mask2[mask1[i]];
-      }
+    llvm::SmallVector<unsigned_t, max_tensor_dimensions> newMask;
+    newMask.resize(mask2.size());
 
-      auto *newTR = F->createTranspose("tranpose", TR2->getInput(), newMask);
-      TR1->getResult().replaceAllUsesOfWith(newTR->getResult());
-      changed = true;
-      continue;
+    for (size_t i = 0, end = mask2.size(); i < end; i++) {
+      newMask[i] = mask2[mask1[i]];
     }
 
-    if (auto *CS = dyn_cast<ChannelShuffleNode>(node)) {
-      // Sink Transpose below ChannelShuffle.
-      if (sinkTranposeBelowChannelShuffle(F, CS)) {
+    auto *newTR = F->createTranspose("tranpose", TR2->getInput(), newMask);
+    TR1->getResult().replaceAllUsesOfWith(newTR->getResult());
+    changed = true;
+    return changed;
+  }
+
+  if (auto *CS = dyn_cast<ChannelShuffleNode>(node)) {
+    // Sink Transpose below ChannelShuffle.
+    if (sinkTranposeBelowChannelShuffle(F, CS)) {
+      changed = true;
+      return changed;
+    }
+  }
+
+  // Sink Transpose below Arithmetic nodes.
+  if (node->isArithmetic()) {
+    TransposeNode *LTR =
+        dyn_cast<TransposeNode>(node->getNthInput(ArithmeticNode::LHSIdx));
+    TransposeNode *RTR =
+        dyn_cast<TransposeNode>(node->getNthInput(ArithmeticNode::RHSIdx));
+
+    if (!LTR || !RTR) {
+      // If one of the sides is a splat, it can be seen as
+      // transpose (splat'). Similarly, if one of the sides is a Constant,
+      // it can be seen as tranpose (Constant').
+      if (isa<SplatNode>(node->getNthInput(ArithmeticNode::LHSIdx)) && RTR) {
+        // Build splat' for LHS.
+        auto *SN =
+            dyn_cast<SplatNode>(node->getNthInput(ArithmeticNode::LHSIdx));
+        auto *NS = F->createSplat("splat", RTR->getInput().getType(),
+                                  SN->getValue());
+        LTR = F->createTranspose("transpose", NS, RTR->getShuffle(),
+                                 RTR->getLayout());
         changed = true;
-        continue;
+      } else if (isa<SplatNode>(node->getNthInput(ArithmeticNode::RHSIdx)) &&
+                 LTR) {
+        // Build splat' for RHS.
+        auto *SN =
+            dyn_cast<SplatNode>(node->getNthInput(ArithmeticNode::RHSIdx));
+        auto *NS = F->createSplat("splat", LTR->getInput().getType(),
+                                  SN->getValue());
+        RTR = F->createTranspose("transpose", NS, LTR->getShuffle(),
+                                 LTR->getLayout());
+        changed = true;
+      } else if (isa<Constant>(node->getNthInput(ArithmeticNode::LHSIdx)) &&
+                 RTR) {
+        // Build Constant' for for LHS.
+        auto *C = cast<Constant>(node->getNthInput(ArithmeticNode::LHSIdx));
+        LTR = insertMatchingTransposeAfterConstant(F, C, RTR);
+        changed = true;
+      } else if (isa<Constant>(node->getNthInput(ArithmeticNode::RHSIdx)) &&
+                 LTR) {
+        // Build Constant' for for RHS.
+        auto *C = cast<Constant>(node->getNthInput(ArithmeticNode::RHSIdx));
+        RTR = insertMatchingTransposeAfterConstant(F, C, LTR);
+        changed = true;
+      } else {
+        return changed;
       }
     }
+    // The masks of the transposes on both sizes must match.
+    if (LTR->getShuffle() != RTR->getShuffle()) {
+      return changed;
+    }
 
-    // Sink Transpose below Arithmetic nodes.
-    if (node->isArithmetic()) {
-      TransposeNode *LTR =
-          dyn_cast<TransposeNode>(node->getNthInput(ArithmeticNode::LHSIdx));
-      TransposeNode *RTR =
-          dyn_cast<TransposeNode>(node->getNthInput(ArithmeticNode::RHSIdx));
-
-      if (!LTR || !RTR) {
-        // If one of the sides is a splat, it can be seen as
-        // transpose (splat'). Similarly, if one of the sides is a Constant,
-        // it can be seen as tranpose (Constant').
-        if (isa<SplatNode>(node->getNthInput(ArithmeticNode::LHSIdx)) && RTR) {
-          // Build splat' for LHS.
-          auto *SN =
-              dyn_cast<SplatNode>(node->getNthInput(ArithmeticNode::LHSIdx));
-          auto *NS = F->createSplat("splat", RTR->getInput().getType(),
-                                    SN->getValue());
-          LTR = F->createTranspose("transpose", NS, RTR->getShuffle(),
-                                   RTR->getLayout());
-          changed = true;
-        } else if (isa<SplatNode>(node->getNthInput(ArithmeticNode::RHSIdx)) &&
-                   LTR) {
-          // Build splat' for RHS.
-          auto *SN =
-              dyn_cast<SplatNode>(node->getNthInput(ArithmeticNode::RHSIdx));
-          auto *NS = F->createSplat("splat", LTR->getInput().getType(),
-                                    SN->getValue());
-          RTR = F->createTranspose("transpose", NS, LTR->getShuffle(),
-                                   LTR->getLayout());
-          changed = true;
-        } else if (isa<Constant>(node->getNthInput(ArithmeticNode::LHSIdx)) &&
-                   RTR) {
-          // Build Constant' for for LHS.
-          auto *C = cast<Constant>(node->getNthInput(ArithmeticNode::LHSIdx));
-          LTR = insertMatchingTransposeAfterConstant(F, C, RTR);
-          changed = true;
-        } else if (isa<Constant>(node->getNthInput(ArithmeticNode::RHSIdx)) &&
-                   LTR) {
-          // Build Constant' for for RHS.
-          auto *C = cast<Constant>(node->getNthInput(ArithmeticNode::RHSIdx));
-          RTR = insertMatchingTransposeAfterConstant(F, C, LTR);
-          changed = true;
-        } else {
-          continue;
-        }
-      }
-      // The masks of the transposes on both sizes must match.
-      if (LTR->getShuffle() != RTR->getShuffle()) {
-        continue;
-      }
-
-      Node *newAN = nullptr;
+    Node *newAN = nullptr;
 
 #define ARITHMETIC_CASE(NODE_NAME_)                                            \
   case glow::Kinded::Kind::NODE_NAME_##NodeKind:                               \
@@ -800,178 +801,184 @@ bool SinkCode::run(Function *F, const CompilationContext &cctx) {
                                   node->getType(ArithmeticNode::ResultIdx),    \
                                   LTR->getInput().getType()),                  \
                               LTR->getInput(), RTR->getInput());               \
-    break;
+  break;
 
 #define BOOLEAN_OP_CASE(NODE_NAME_)                                            \
   case glow::Kinded::Kind::NODE_NAME_##NodeKind:                               \
     newAN = F->create##NODE_NAME_(node->getName(), LTR->getInput(),            \
                                   RTR->getInput());                            \
-    break;
-
-      switch (node->getKind()) {
-        ARITHMETIC_CASE(Add);
-        ARITHMETIC_CASE(Mul);
-        ARITHMETIC_CASE(Sub);
-        ARITHMETIC_CASE(Div);
-        ARITHMETIC_CASE(Max);
-        ARITHMETIC_CASE(Min);
-        BOOLEAN_OP_CASE(CmpLTE);
-        BOOLEAN_OP_CASE(CmpEQ);
-      default:
-        llvm_unreachable("Unhandled node");
-      }
+  break;
+
+    switch (node->getKind()) {
+      ARITHMETIC_CASE(Add);
+      ARITHMETIC_CASE(Mul);
+      ARITHMETIC_CASE(Sub);
+      ARITHMETIC_CASE(Div);
+      ARITHMETIC_CASE(Max);
+      ARITHMETIC_CASE(Min);
+      BOOLEAN_OP_CASE(CmpLTE);
+      BOOLEAN_OP_CASE(CmpEQ);
+    default:
+      llvm_unreachable("Unhandled node");
+    }
 #undef BOOLEAN_OP_CASE
 #undef ARITHMETIC_CASE
 
-      newAN->setPredicate(node->getPredicate());
-      changed = true;
-      auto *newTR = F->createTranspose(LTR->getName(), newAN, LTR->getShuffle(),
-                                       LTR->getLayout());
-      newTR->setPredicate(node->getPredicate());
-      node->getNthResult(ArithmeticNode::ResultIdx).replaceAllUsesOfWith(newTR);
-    }
-
-    // Sink TransposeNode below QuantizedNode.
-    // If it doesn't work out it will be re-sinked later.
-    if (auto *Q = dyn_cast<QuantizeNode>(node)) {
-      auto *TR = dyn_cast<TransposeNode>(Q->getInput());
-      if (!TR) {
-        continue;
-      }
+    newAN->setPredicate(node->getPredicate());
+    changed = true;
+    auto *newTR = F->createTranspose(LTR->getName(), newAN, LTR->getShuffle(),
+                                     LTR->getLayout());
+    newTR->setPredicate(node->getPredicate());
+    node->getNthResult(ArithmeticNode::ResultIdx).replaceAllUsesOfWith(newTR);
+  }
 
-      auto newQType = F->getParent()->uniqueTypeWithNewShape(
-          Q->getResult().getType(), TR->getInput().dims());
-      auto *newQ = F->createQuantize(Q->getName(), TR->getInput(), newQType);
-      auto *newTR = F->createTranspose(TR->getName(), newQ, TR->getShuffle());
-      Q->getResult().replaceAllUsesOfWith(newTR);
-      changed = true;
+  // Sink TransposeNode below QuantizedNode.
+  // If it doesn't work out it will be re-sinked later.
+  if (auto *Q = dyn_cast<QuantizeNode>(node)) {
+    auto *TR = dyn_cast<TransposeNode>(Q->getInput());
+    if (!TR) {
+      return changed;
     }
 
-    // Sink TransposeNode below DequantizedNode.
-    // If it doesn't work out it will be re-sinked later.
-    if (auto *D = dyn_cast<DequantizeNode>(node)) {
-      auto *TR = dyn_cast<TransposeNode>(D->getInput());
-      if (!TR) {
-        continue;
-      }
+    auto newQType = F->getParent()->uniqueTypeWithNewShape(
+        Q->getResult().getType(), TR->getInput().dims());
+    auto *newQ = F->createQuantize(Q->getName(), TR->getInput(), newQType);
+    auto *newTR = F->createTranspose(TR->getName(), newQ, TR->getShuffle());
+    Q->getResult().replaceAllUsesOfWith(newTR);
+    changed = true;
+  }
 
-      auto newDType = F->getParent()->uniqueTypeWithNewShape(
-          D->getResult().getType(), TR->getInput().dims());
-      auto *newD = F->createDequantize(D->getName(), TR->getInput(), newDType);
-      auto *newTR = F->createTranspose(TR->getName(), newD, TR->getShuffle());
-      D->getResult().replaceAllUsesOfWith(newTR);
-      changed = true;
+  // Sink TransposeNode below DequantizedNode.
+  // If it doesn't work out it will be re-sinked later.
+  if (auto *D = dyn_cast<DequantizeNode>(node)) {
+    auto *TR = dyn_cast<TransposeNode>(D->getInput());
+    if (!TR) {
+      return changed;
     }
 
-    // Sink Transpose below RescaleQuantized.
-    // Potentially exposes opportunity to be combined up with Convolution.
-    // If it doesn't work out it will be re-sinked later.
-    if (auto *RQ = dyn_cast<RescaleQuantizedNode>(node)) {
-      auto *TR = dyn_cast<TransposeNode>(RQ->getInput());
-      if (!TR) {
-        continue;
-      }
+    auto newDType = F->getParent()->uniqueTypeWithNewShape(
+        D->getResult().getType(), TR->getInput().dims());
+    auto *newD = F->createDequantize(D->getName(), TR->getInput(), newDType);
+    auto *newTR = F->createTranspose(TR->getName(), newD, TR->getShuffle());
+    D->getResult().replaceAllUsesOfWith(newTR);
+    changed = true;
+  }
 
-      auto newRQType = F->getParent()->uniqueTypeWithNewShape(
-          RQ->getResult().getType(), TR->getInput().getType());
-      auto *newRQ =
-          F->createRescaleQuantized(RQ->getName(), TR->getInput(), newRQType);
-      auto *newTR = F->createTranspose(TR->getName(), newRQ, TR->getShuffle(),
-                                       TR->getLayout());
-      RQ->getResult().replaceAllUsesOfWith(newTR);
-      changed = true;
+  // Sink Transpose below RescaleQuantized.
+  // Potentially exposes opportunity to be combined up with Convolution.
+  // If it doesn't work out it will be re-sinked later.
+  if (auto *RQ = dyn_cast<RescaleQuantizedNode>(node)) {
+    auto *TR = dyn_cast<TransposeNode>(RQ->getInput());
+    if (!TR) {
+      return changed;
     }
 
-    if (auto *CN = dyn_cast<ConcatNode>(node)) {
-      const Node *firstNode = CN->getInputs().front().getNode();
-      // Sink RELU below batch concat nodes.
-      if (firstNode->getKind() == Kinded::Kind::ReluNodeKind) {
-        llvm::SmallVector<NodeValue, 6> CNInputs;
-        for (auto &input : CN->getInputs()) {
-          auto *inputRL = dyn_cast<ReluNode>(input);
-          if (!inputRL) {
-            break;
-          }
-          CNInputs.push_back(inputRL->getInput());
-        }
+    auto newRQType = F->getParent()->uniqueTypeWithNewShape(
+        RQ->getResult().getType(), TR->getInput().getType());
+    auto *newRQ =
+        F->createRescaleQuantized(RQ->getName(), TR->getInput(), newRQType);
+    auto *newTR = F->createTranspose(TR->getName(), newRQ, TR->getShuffle(),
+                                     TR->getLayout());
+    RQ->getResult().replaceAllUsesOfWith(newTR);
+    changed = true;
+  }
 
-        if (CNInputs.size() == CN->getNumInputs()) {
-          auto *newCN = F->createConcat(CN->getName(), CNInputs, CN->getDim());
-          newCN->setPredicate(node->getPredicate());
-          auto name = CN->getNthInput(0).getNode()->getName();
-          auto *newRL = F->createRELU(name, newCN, CN->getResult().getType());
-          newRL->setPredicate(node->getPredicate());
-          CN->getResult().replaceAllUsesOfWith(newRL);
-          changed = true;
+  if (auto *CN = dyn_cast<ConcatNode>(node)) {
+    const Node *firstNode = CN->getInputs().front().getNode();
+    // Sink RELU below batch concat nodes.
+    if (firstNode->getKind() == Kinded::Kind::ReluNodeKind) {
+      llvm::SmallVector<NodeValue, 6> CNInputs;
+      for (auto &input : CN->getInputs()) {
+        auto *inputRL = dyn_cast<ReluNode>(input);
+        if (!inputRL) {
+          break;
         }
-        continue;
+        CNInputs.push_back(inputRL->getInput());
       }
 
-      // Sink Transpose below concat nodes.
-      if (firstNode->getKind() == Kinded::Kind::TransposeNodeKind) {
-        llvm::SmallVector<NodeValue, 6> transVector;
-        auto inputIter = CN->getInputs().begin();
-        auto *firstInput = dyn_cast<TransposeNode>(*inputIter);
-        if (!firstInput) {
-          continue;
-        }
-
-        transVector.push_back(firstInput->getInput());
-        auto shuffle = firstInput->getShuffle();
-        // If the shuffle masks don't agree or not all inputs are Transpose then
-        // bail out.
-        for (++inputIter; inputIter != CN->getInputs().end(); ++inputIter) {
-          auto *tTR = dyn_cast<TransposeNode>(*inputIter);
-          if (!tTR || tTR->getShuffle() != shuffle) {
-            break;
-          }
-          transVector.push_back(tTR->getInput());
-        }
-
-        if (transVector.size() != CN->getNumInputs()) {
-          continue;
-        }
-
-        // Figure out where we transposed the channel index for batch
-        // normalization.
-        unsigned_t idx = CN->getDim();
-        unsigned_t newChannelIdx = shuffle[idx];
-
-        auto *newCN =
-            F->createConcat(CN->getName(), transVector, newChannelIdx);
+      if (CNInputs.size() == CN->getNumInputs()) {
+        auto *newCN = F->createConcat(CN->getName(), CNInputs, CN->getDim());
         newCN->setPredicate(node->getPredicate());
-        auto *newTR = F->createTranspose(firstInput->getName(), newCN,
-                                         firstInput->getShuffle(),
-                                         firstInput->getLayout());
-        newTR->setPredicate(node->getPredicate());
-        CN->getResult().replaceAllUsesOfWith(newTR);
+        auto name = CN->getNthInput(0).getNode()->getName();
+        auto *newRL = F->createRELU(name, newCN, CN->getResult().getType());
+        newRL->setPredicate(node->getPredicate());
+        CN->getResult().replaceAllUsesOfWith(newRL);
         changed = true;
-        continue;
       }
+      return changed;
     }
 
-    // Sink Clip below Reshape nodes.
-    if (auto *RN = dyn_cast<ReshapeNode>(node)) {
-      auto *CN = dyn_cast<ClipNode>(RN->getInput());
-      if (!CN) {
-        continue;
+    // Sink Transpose below concat nodes.
+    if (firstNode->getKind() == Kinded::Kind::TransposeNodeKind) {
+      llvm::SmallVector<NodeValue, 6> transVector;
+      auto inputIter = CN->getInputs().begin();
+      auto *firstInput = dyn_cast<TransposeNode>(*inputIter);
+      if (!firstInput) {
+        return changed;
       }
 
-      ReshapeNode *newRN = F->createReshape(RN->getName(), CN->getInput(),
-                                            RN->getDims(), RN->getLayout());
-      ClipNode *newCN = F->createClip(CN->getName(), newRN->getResult(),
-                                      CN->getMin(), CN->getMax());
-      RN->getResult().replaceAllUsesOfWith(newCN->getResult());
-      newRN->setPredicate(RN->getPredicate());
-      newCN->setPredicate(CN->getPredicate());
+      transVector.push_back(firstInput->getInput());
+      auto shuffle = firstInput->getShuffle();
+      // If the shuffle masks don't agree or not all inputs are Transpose then
+      // bail out.
+      for (++inputIter; inputIter != CN->getInputs().end(); ++inputIter) {
+        auto *tTR = dyn_cast<TransposeNode>(*inputIter);
+        if (!tTR || tTR->getShuffle() != shuffle) {
+          break;
+        }
+        transVector.push_back(tTR->getInput());
+      }
+
+      if (transVector.size() != CN->getNumInputs()) {
+        return changed;
+      }
+
+      // Figure out where we transposed the channel index for batch
+      // normalization.
+      unsigned_t idx = CN->getDim();
+      unsigned_t newChannelIdx = shuffle[idx];
+
+      auto *newCN =
+          F->createConcat(CN->getName(), transVector, newChannelIdx);
+      newCN->setPredicate(node->getPredicate());
+      auto *newTR = F->createTranspose(firstInput->getName(), newCN,
+                                       firstInput->getShuffle(),
+                                       firstInput->getLayout());
+      newTR->setPredicate(node->getPredicate());
+      CN->getResult().replaceAllUsesOfWith(newTR);
       changed = true;
-      continue;
+      return changed;
+    }
+  }
+
+  // Sink Clip below Reshape nodes.
+  if (auto *RN = dyn_cast<ReshapeNode>(node)) {
+    auto *CN = dyn_cast<ClipNode>(RN->getInput());
+    if (!CN) {
+      return changed;
     }
-  } // For all nodes in the graph.
 
+    ReshapeNode *newRN = F->createReshape(RN->getName(), CN->getInput(),
+                                          RN->getDims(), RN->getLayout());
+    ClipNode *newCN = F->createClip(CN->getName(), newRN->getResult(),
+                                    CN->getMin(), CN->getMax());
+    RN->getResult().replaceAllUsesOfWith(newCN->getResult());
+    newRN->setPredicate(RN->getPredicate());
+    newCN->setPredicate(CN->getPredicate());
+    changed = true;
+    return changed;
+  }
   return changed;
 }
 
+/// Code Sinking.
+bool SinkCode::run(Function *F, const CompilationContext &cctx) {
+  LOG_SCOPE(F->getLogContext(), getName());
+  GraphRewriter rewriter(F);
+  rewriter.addPattern("SinkCode", {}, sinkCode);
+  return rewriter.run();
+}
+
 /// \returns True if node A may depend on the result of B. The relationship
 /// between the nodes does not have to be direct. For example, A can depend on
 /// X which depends on B. In that case the method needs to return True.
@@ -1022,6 +1029,19 @@ static bool mayDependOnAny(llvm::ArrayRef<NodeValue> list, Node *N) {
   return false;
 }
 
+/// \returns true if any of the \p operands may depend on any of the \p nodes.
+static bool mayDependOnAnyNode(llvm::ArrayRef<NodeValue> operands,
+                               llvm::ArrayRef<Node *> nodes) {
+  for (auto &op : operands) {
+    for (auto *N : nodes) {
+      if (mayDepend(op.getNode(), N)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 // Merge several two or more multiple matrix multiplications into a single
 // large matmul. The large matmul is more likely to utilize the hardware. The
 // result of the big matmul is the concatenated results.
@@ -1040,7 +1060,9 @@ bool MergeMatMul::run(Function *F, const CompilationContext &cctx) {
   // These two maps record the list of matrix multipliers that use each node
   // value either as a right-hand-side user or a left-hand-user.
   llvm::DenseMap<Node *, std::vector<MatMulNode *>> rightMatrixUsers;
-  llvm::DenseMap<Node *, std::vector<MatMulNode *>> leftMatrixUsers;
+  std::unordered_map<NodeValue, std::vector<MatMulNode *>> leftMatrixUsers;
+  // The LHS values in the order of the nodes, for a deterministic merge.
+  std::vector<NodeValue> leftMatrices;
 
   // Collect the list of nodes that are used by the matrix multiplier.
   for (auto &node : nodes) {
@@ -1053,7 +1075,11 @@ bool MergeMatMul::run(Function *F, const CompilationContext &cctx) {
       }
 
       rightMatrixUsers[MM->getRHS().getNode()].push_back(MM);
-      leftMatrixUsers[MM->getLHS().getNode()].push_back(MM);
+      auto &leftUsers = leftMatrixUsers[MM->getLHS()];
+      if (leftUsers.empty()) {
+        leftMatrices.push_back(MM->getLHS());
+      }
+      leftUsers.push_back(MM);
     }
   }
 
@@ -1095,6 +1121,244 @@ bool MergeMatMul::run(Function *F, const CompilationContext &cctx) {
       changed = true;
     }
   }
+
+  // Merge the RHS matrices of the matmuls sharing their LHS, i.e. compute
+  // A * B and A * C as A * [B C] and extract the columns of each result. Like
+  // the merge of FullyConnected nodes, this is controlled by
+  // enableHorizontalFCFusion, and the float matmuls which are going to be
+  // profiled or quantized are kept apart.
+  if (!cctx.optimizationOpts.enableHorizontalFCFusion ||
+      cctx.precisionConfig.quantMode != QuantizationMode::None) {
+    return changed;
+  }
+  for (const auto &L : leftMatrices) {
+    std::vector<Node *> group;
+    std::vector<NodeValue> RHS;
+    for (auto *MM : leftMatrixUsers[L]) {
+      // Skip the matmuls which were merged above.
+      if (!MM->hasUsers()) {
+        continue;
+      }
+      NodeValue R = MM->getRHS();
+      if (mayDependOnAnyNode({R}, group) || mayDependOnAnyNode(RHS, {MM})) {
+        continue;
+      }
+      group.push_back(MM);
+      RHS.push_back(R);
+    }
+
+    // We need to have at least two matrices to merge.
+    if (RHS.size() < 2) {
+      continue;
+    }
+
+    auto *CC = F->createConcat("mergeRHS", RHS, 1);
+    auto *MM = F->createMatMul("wideMatMul", L, CC);
+
+    dim_t H = MM->getResult().dims()[0];
+    dim_t start = 0;
+    for (auto *origMM : group) {
+      auto *MMN = cast<MatMulNode>(origMM);
+      dim_t R = MMN->getResult().dims()[1];
+      auto *ex = F->createSlice("extract", MM, {0, start}, {H, start + R});
+      start += R;
+      MMN->getResult().replaceAllUsesOfWith(ex);
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+/// \returns a new Constant of the Module \p M named \p name, which holds the
+/// payloads of \p constants concatenated along their first dimension.
+static Constant *concatConstants(Module *M, llvm::StringRef name,
+                                 llvm::ArrayRef<Constant *> constants) {
+  std::vector<dim_t> dims = constants.front()->dims().vec();
+  dims[0] = 0;
+  for (auto *C : constants) {
+    dims[0] += C->dims()[0];
+  }
+  auto *res = M->createConstant(
+      M->uniqueTypeWithNewShape(constants.front()->getType(), dims), name);
+  char *dst = res->getPayloadMutable().getUnsafePtr();
+  for (auto *C : constants) {
+    const Tensor &T = C->getPayload();
+    size_t size = T.getUnpaddedSizeInBytes();
+    std::copy(T.getUnsafePtr(), T.getUnsafePtr() + size, dst);
+    dst += size;
+  }
+  return res;
+}
+
+/// \returns whether the FullyConnected or RowwiseQuantizedFullyConnected
+/// nodes \p A and \p B can be computed by a single wide node, i.e. whether
+/// their results, weights and biases have the same element types and
+/// quantization parameters.
+static bool areMergeableFCs(const Node *A, const Node *B) {
+  if (A->getKind() != B->getKind()) {
+    return false;
+  }
+  auto sameElemType = [](NodeValue lhs, NodeValue rhs) {
+    return lhs.getType()->isEqual(*rhs.getType(),
+                                  /* allowDifferentShape */ true);
+  };
+  if (auto *FCA = dyn_cast<FullyConnectedNode>(A)) {
+    auto *FCB = cast<FullyConnectedNode>(B);
+    return sameElemType(FCA->getResult(), FCB->getResult()) &&
+           sameElemType(FCA->getWeights(), FCB->getWeights()) &&
+           sameElemType(FCA->getBias(), FCB->getBias());
+  }
+  auto *RFCA = cast<RowwiseQuantizedFullyConnectedNode>(A);
+  auto *RFCB = cast<RowwiseQuantizedFullyConnectedNode>(B);
+  return sameElemType(RFCA->getResult(), RFCB->getResult()) &&
+         sameElemType(RFCA->getWeights(), RFCB->getWeights()) &&
+         sameElemType(RFCA->getBias(), RFCB->getBias());
+}
+
+// Merge the FullyConnected nodes sharing their input into a single wide
+// FullyConnected. The small GEMMs of the sibling FCs, e.g. the towers of a
+// multi-task model, become a single GEMM with better hardware utilization.
+// The results of the sibling FCs are slices of the wide result, which can
+// later fold into their users.
+//
+//             ____   ____        ____ ____        _______ _______
+//    ----    |    | |    |      |    |    |      |       |       |
+//  M| A  | * K| B  |,K| C  |  => K| B  | C  |  = M| A * B | A * C |
+//    ----    |____| |____|      |____|____|      |_______|_______|
+//     K        R1     R2         R1   R2            R1      R2
+bool MergeFullyConnected::run(Function *F, const CompilationContext &cctx) {
+  LOG_SCOPE(F->getLogContext(), getName());
+  if (!cctx.optimizationOpts.enableHorizontalFCFusion) {
+    return false;
+  }
+  // Float FCs which are going to be profiled or quantized are kept apart, so
+  // that each of them gets its own quantization parameters.
+  const bool mergeFloat =
+      cctx.precisionConfig.quantMode == QuantizationMode::None;
+
+  // Groups of mergeable FCs for each input, in the order of the nodes.
+  std::unordered_map<NodeValue, std::vector<std::vector<Node *>>> groups;
+  std::vector<NodeValue> inputs;
+  for (auto &node : F->getNodes()) {
+    NodeValue input;
+    if (auto *FC = dyn_cast<FullyConnectedNode>(&node)) {
+      if (!mergeFloat && !FC->getResult().getType()->isQuantizedType()) {
+        continue;
+      }
+      // Only merge the weights and biases which concatenate into Constants.
+      if (!isa<Constant>(FC->getWeights()) || !isa<Constant>(FC->getBias())) {
+        continue;
+      }
+      input = FC->getInput();
+    } else if (auto *RFC =
+                   dyn_cast<RowwiseQuantizedFullyConnectedNode>(&node)) {
+      if (!isa<Constant>(RFC->getWeights()) ||
+          !isa<Constant>(RFC->getScales()) ||
+          !isa<Constant>(RFC->getOffsets())) {
+        continue;
+      }
+      input = RFC->getInput();
+    } else {
+      continue;
+    }
+
+    auto it = groups.find(input);
+    if (it == groups.end()) {
+      inputs.push_back(input);
+      groups[input].push_back({&node});
+      continue;
+    }
+
+    // The operands of the merged FC must not depend on any merged FC.
+    std::vector<NodeValue> operands;
+    for (unsigned i = 1, e = node.getNumInputs(); i < e; i++) {
+      operands.push_back(node.getNthInput(i));
+    }
+    bool added = false;
+    for (auto &group : it->second) {
+      if (!areMergeableFCs(group.front(), &node) ||
+          mayDependOnAnyNode(operands, group)) {
+        continue;
+      }
+      bool dependsOnNode = false;
+      for (auto *N : group) {
+        for (unsigned i = 1, e = N->getNumInputs(); i < e; i++) {
+          dependsOnNode |= mayDepend(N->getNthInput(i).getNode(), &node);
+        }
+      }
+      if (dependsOnNode) {
+        continue;
+      }
+      group.push_back(&node);
+      added = true;
+      break;
+    }
+    if (!added) {
+      it->second.push_back({&node});
+    }
+  }
+
+  bool changed = false;
+  auto *M = F->getParent();
+  for (const auto &input : inputs) {
+    for (const auto &group : groups[input]) {
+      // We need to have at least two FCs to merge.
+      if (group.size() < 2) {
+        continue;
+      }
+
+      std::vector<NodeValue> results;
+      std::vector<NodeValue> biases;
+      dim_t width = 0;
+      for (auto *N : group) {
+        if (auto *FC = dyn_cast<FullyConnectedNode>(N)) {
+          results.push_back(FC->getResult());
+          biases.push_back(FC->getBias());
+        } else {
+          auto *RFC = cast<RowwiseQuantizedFullyConnectedNode>(N);
+          results.push_back(RFC->getResult());
+          biases.push_back(RFC->getBias());
+        }
+        width += results.back().dims()[1];
+      }
+      dim_t batch = results.front().dims()[0];
+      auto *outTy =
+          M->uniqueTypeWithNewShape(results.front().getType(), {batch, width});
+      auto *bias = F->createConcat("mergedFCBias", biases, 0);
+
+      Node *wideFC = nullptr;
+      if (isa<FullyConnectedNode>(group.front())) {
+        std::vector<NodeValue> weights;
+        for (auto *N : group) {
+          weights.push_back(cast<FullyConnectedNode>(N)->getWeights());
+        }
+        auto *W = F->createConcat("mergedFCWeights", weights, 1);
+        wideFC = F->createFullyConnected("mergedFC", input, W, bias, outTy);
+      } else {
+        std::vector<Constant *> weights, scales, offsets;
+        for (auto *N : group) {
+          auto *RFC = cast<RowwiseQuantizedFullyConnectedNode>(N);
+          weights.push_back(cast<Constant>(RFC->getWeights()));
+          scales.push_back(cast<Constant>(RFC->getScales()));
+          offsets.push_back(cast<Constant>(RFC->getOffsets()));
+        }
+        wideFC = F->createRowwiseQuantizedFullyConnected(
+            "mergedFC", input, concatConstants(M, "mergedFCWeights", weights),
+            concatConstants(M, "mergedFCScales", scales),
+            concatConstants(M, "mergedFCOffsets", offsets), bias, outTy);
+      }
+
+      dim_t start = 0;
+      for (size_t i = 0, e = group.size(); i < e; i++) {
+        dim_t R = results[i].dims()[1];
+        auto *ex = F->createSlice(group[i]->getName(), wideFC, {0, start},
+                                  {batch, start + R});
+        start += R;
+        results[i].replaceAllUsesOfWith(ex);
+      }
+      changed = true;
+    }
+  }
   return changed;
 }
 
@@ -2619,49 +2883,19 @@ bool FoldSlicesIntoConstants::run(Function *F, const CompilationContext &cctx) {
 /// identities.
 bool OptimizeArithmeticNodes::run(Function *F, const CompilationContext &cctx) {
   LOG_SCOPE(F->getLogContext(), getName());
-  bool changed = false;
-  // A worklist that contains the nodes to process.
-  std::vector<Node *> worklist;
-
-  // Add all of the arithmetic nodes to the worklist, with a node's
-  // dependencies added after itself so they are processed before the node.
-  GraphPreOrderVisitor visitor(*F);
-  worklist.reserve(visitor.getPreOrder().size());
-  for (auto *N : visitor.getPreOrder()) {
-    if (N->isArithmetic()) {
-      worklist.push_back(N);
+  GraphRewriter rewriter(F);
+  rewriter.addPattern("SimplifyArithmetic", {}, [](Node *N, Function *F) {
+    if (!N->isArithmetic()) {
+      return false;
     }
-  }
-  while (!worklist.empty()) {
-    Node *N = worklist.back();
-    assert(N->isArithmetic() && "Must be an Arithmetic node.");
-    worklist.pop_back();
-
     auto SNV = simplifyNode(N, F);
-    if (SNV.getNode() != N) {
-      N->getNthResult(ArithmeticNode::ResultIdx).replaceAllUsesOfWith(SNV);
-      changed = true;
-
-      auto *SN = SNV.getNode();
-
-      // The simplified node could be further simplified. Note that the
-      // simplified node might not be arithmetic; it could be a splat.
-      if (SN->isArithmetic()) {
-        worklist.push_back(SN);
-      }
-
-      // The simplified node's operands could be further simplified as well.
-      // Push them after the node so they are processed before the node.
-      for (size_t i = 0, e = SN->getNumInputs(); i < e; i++) {
-        Node *input = SN->getNthInput(i).getNode();
-        if (input->isArithmetic()) {
-          worklist.push_back(input);
-        }
-      }
-      continue;
+    if (SNV.getNode() == N) {
+      return false;
     }
-  }
-  return changed;
+    N->getNthResult(ArithmeticNode::ResultIdx).replaceAllUsesOfWith(SNV);
+    return true;
+  });
+  return rewriter.run();
 }
 
 /// Statically transpose Constants.
@@ -2759,21 +2993,29 @@ struct CSEVisitor : NodeWalker {
 
 /// A helper type for hashing Constant pointers when they are used as keys in
 /// hash maps for deduplication. The hash is based on the type of the Constant
-/// (element type, dimensions), as well as a constant number of elements from
-/// the backing Tensor to balance collisions with hash calclulation time.
+/// (element type, dimensions), as well as the content of the backing Tensor,
+/// which is hashed as a contiguous block of bytes. Payloads larger than
+/// kDedupMaxHashedBytes are only hashed on evenly spaced chunks of bytes, and
+/// left to the equality predicate to tell apart.
 struct ConstsHasherDedup {
+  static constexpr size_t kDedupMaxHashedBytes = 4096;
+  static constexpr size_t kDedupChunkBytes = 64;
+
   size_t operator()(Constant *V) const {
-    auto hash = llvm::hash_value(V->getType());
     auto &T = V->getPayload();
-    // Only use the first 8 elements in the hash. It's likely that if two
-    // tensors have different content they will diverge quickly. Fall back to
-    // full equality check in ConstsEqDedup.
-    constexpr dim_t maxNumEls = 8;
-    dim_t numEls = std::min((dim_t)T.getType().size(), maxNumEls);
-    dim_t bufSize = T.getType().getElementSize() * numEls;
-    auto *data = T.getUnsafePtr();
-    for (size_t i = 0; i < bufSize; i++) {
-      hash = llvm::hash_combine(hash, data[i]);
+    const char *data = T.getUnsafePtr();
+    size_t size = T.getSizeInBytes();
+    if (size <= kDedupMaxHashedBytes) {
+      return llvm::hash_combine(llvm::hash_value(V->getType()),
+                                llvm::hash_combine_range(data, data + size));
+    }
+    size_t numChunks = kDedupMaxHashedBytes / kDedupChunkBytes;
+    size_t stride = (size - kDedupChunkBytes) / (numChunks - 1);
+    llvm::hash_code hash = llvm::hash_value(V->getType());
+    for (size_t i = 0; i < numChunks; i++) {
+      const char *chunk = data + i * stride;
+      hash = llvm::hash_combine(
+          hash, llvm::hash_combine_range(chunk, chunk + kDedupChunkBytes));
     }
     return hash;
   }
@@ -2788,6 +3030,11 @@ struct ConstsEqDedup {
     if (lhs->getType() != rhs->getType()) {
       return false;
     }
+    // The layout tells how the payload is laid out, so Constants with the same
+    // bytes but different layouts are different.
+    if (lhs->getLayout() != rhs->getLayout()) {
+      return false;
+    }
     // Only dedup Constants if they're bit exact matches.
     return lhs->getPayload().isBitwiseEqual(rhs->getPayload());
   }
@@ -2795,23 +3042,35 @@ struct ConstsEqDedup {
 
 } // namespace
 
-/// Deduplicates Constants in the Module \p M. Applicable Constants for
-/// deduplication must have the same data. \returns whether any Constants were
-/// deduplicated.
-static bool deduplicateConstants(Module *M) {
+/// Deduplicates Constants in the Module \p M with at most \p maxNumEls
+/// elements, or of any size if \p maxNumEls is zero. Applicable Constants for
+/// deduplication must have the same data. The Constants whose uses were
+/// replaced are added to \p replaced if it is not null. \returns whether any
+/// Constants were deduplicated.
+static bool
+deduplicateModuleConstants(Module *M, size_t maxNumEls,
+                           std::vector<Constant *> *replaced = nullptr) {
   // Map from Constants to other Constants that are equivalent for purposes of
   // deduplication.
   std::unordered_map<Constant *, Constant *, ConstsHasherDedup, ConstsEqDedup>
       duplicateConstants;
 
+  // Constants can only be duplicates of Constants of the same type, so the
+  // ones with a type of their own are not even hashed.
+  std::unordered_map<TypeRef, unsigned> numConstantsOfType;
+  for (auto &C : M->getConstants()) {
+    numConstantsOfType[C->getType()]++;
+  }
+
   bool changed = false;
   for (auto &C : M->getConstants()) {
     // Only perform deduplication on consts of small enough size. Otherwise
-    // just skip them. constDedupSizeOpt defaults to 256 as a heuristic, to
-    // keep compile time reasonable.
-    size_t maxNumEls = constDedupSizeOpt;
+    // just skip them.
     size_t numEls = C->getType()->size();
-    if (numEls > maxNumEls) {
+    if (maxNumEls && numEls > maxNumEls) {
+      continue;
+    }
+    if (numConstantsOfType[C->getType()] < 2) {
       continue;
     }
 
@@ -2831,17 +3090,35 @@ static bool deduplicateConstants(Module *M) {
     // Replace current Constant by a found Constant, which is equivalent to
     // it.
     C->getOutput().replaceAllUsesOfWith(foundC);
+    if (replaced) {
+      replaced->push_back(C);
+    }
     changed = true;
   }
   return changed;
 }
 
+bool glow::deduplicateConstants(Module &mod) {
+  std::vector<Constant *> replaced;
+  bool changed =
+      deduplicateModuleConstants(&mod, /* maxNumEls */ 0, &replaced);
+  for (Constant *C : replaced) {
+    DCHECK(!C->hasUsers()) << "Replaced Constant " << C->getName().str()
+                           << " is still in use";
+    mod.eraseConstant(C);
+  }
+  return changed;
+}
+
 /// Common Subexpression Elimination.
 bool CSE::run(Function *F, const CompilationContext &cctx) {
   LOG_SCOPE(F->getLogContext(), getName());
   CSEVisitor visitor;
 
-  bool changed = deduplicateConstants(F->getParent());
+  // constDedupSizeOpt defaults to 256 as a heuristic, to keep compile time
+  // reasonable.
+  bool changed =
+      deduplicateModuleConstants(F->getParent(), constDedupSizeOpt);
 
   // Perform CSE on all nodes.
   for (auto &N : F->getNodes()) {
@@ -2872,82 +3149,471 @@ bool OptimizeSplat::run(Function *F, const CompilationContext &cctx) {
       continue;
     }
 
-    // Clip(Splat(args)) -> Splat(args')
-    if (ClipNode *clipNode = dyn_cast<ClipNode>(&node)) {
-      SplatNode *splatNode = dyn_cast<SplatNode>(clipNode->getInput());
-      if (!splatNode) {
-        continue;
+    // Clip(Splat(args)) -> Splat(args')
+    if (ClipNode *clipNode = dyn_cast<ClipNode>(&node)) {
+      SplatNode *splatNode = dyn_cast<SplatNode>(clipNode->getInput());
+      if (!splatNode) {
+        continue;
+      }
+      const float newSplatVal =
+          std::min(std::max(splatNode->getValue(), clipNode->getMin()),
+                   clipNode->getMax());
+
+      SplatNode *newSplatNode = nullptr;
+      if (newSplatVal == splatNode->getValue()) {
+        // No need to crate a new Splat.
+        newSplatNode = splatNode;
+      } else {
+        newSplatNode = F->createSplat(
+            splatNode->getName().str() + clipNode->getName().str(),
+            splatNode->getResult().getType(), newSplatVal);
+      }
+
+      clipNode->getResult().replaceAllUsesOfWith(newSplatNode->getResult());
+      changed = true;
+      continue;
+    }
+  }
+  return changed;
+}
+
+/// Optimize TransposeNode into ReshapeNode when it actually moves no data.
+bool OptimizeTransposeIntoReshape::run(Function *F,
+                                       const CompilationContext &cctx) {
+  LOG_SCOPE(F->getLogContext(), getName());
+  bool changed = false;
+
+  for (auto &node : F->getNodes()) {
+    auto *TR = dyn_cast<TransposeNode>(&node);
+    if (!TR) {
+      continue;
+    }
+    auto inputNode = TR->getInput();
+    auto inputDims = inputNode.dims();
+    auto outputDims = TR->getResult().dims();
+    // The transformation is not possible if alignments different from 1 are
+    // used for any dimension.
+    if (!inputNode.getType()->isEqual(F->getParent()->uniqueTypeWithNewShape(
+            inputNode.getType(), inputDims))) {
+      continue;
+    }
+    if (!TR->getResult().getType()->isEqual(
+            F->getParent()->uniqueTypeWithNewShape(TR->getResult().getType(),
+                                                   outputDims))) {
+      continue;
+    }
+    // Transpose moves no data if input/output dimensions match after they both
+    // drop dimensions of size 1. E.g. transposing [1 5 1 15] into [5 15 1 1]
+    // produces vectors (1, 3) for both dimensions so optimization is executed.
+    auto shuffle = TR->getShuffle();
+    ShapeVector inDims;
+    ShapeVector outDims;
+    for (size_t i = 0; i < inputDims.size(); i++) {
+      if (inputDims[i] != 1) {
+        inDims.push_back(i);
+      }
+      if (outputDims[i] != 1) {
+        outDims.push_back(shuffle[i]);
+      }
+    }
+    if (inDims != outDims) {
+      continue;
+    }
+    auto *RS =
+        F->createReshape(TR->getName(), inputNode, outputDims, TR->getLayout());
+    TR->getResult().replaceAllUsesOfWith(RS);
+    changed = true;
+  }
+
+  return changed;
+}
+
+/// \returns true if \p N computes every element of its result from the
+/// elements at the same position of its inputs, or concatenates its inputs,
+/// so that it can operate on its inputs in any layout.
+static bool isLayoutAgnostic(const Node *N) {
+  if (N->getNumResults() != 1) {
+    return false;
+  }
+  if (isa<ConcatNode>(N)) {
+    return true;
+  }
+  // CumSum is marked data parallel but accumulates along its innermost axis.
+  if (!N->isDataParallel() || isa<CumSumNode>(N)) {
+    return false;
+  }
+  auto dims = N->getNthResult(0).dims();
+  for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+    if (N->getNthInput(i).dims() != dims) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// \returns the composition of the shuffles \p first and \p second, i.e. the
+/// shuffle of a transpose equivalent to transposing with \p first and then
+/// with \p second.
+static llvm::SmallVector<unsigned_t, max_tensor_dimensions>
+composeShuffles(llvm::ArrayRef<unsigned_t> first,
+                llvm::ArrayRef<unsigned_t> second) {
+  llvm::SmallVector<unsigned_t, max_tensor_dimensions> shuffle(first.size());
+  for (size_t i = 0, e = first.size(); i < e; i++) {
+    shuffle[i] = first[second[i]];
+  }
+  return shuffle;
+}
+
+/// \returns the number of Transpose nodes in \p F.
+static unsigned countTransposes(const Function *F) {
+  unsigned count = 0;
+  for (const auto &N : F->getNodes()) {
+    count += isa<TransposeNode>(&N);
+  }
+  return count;
+}
+
+namespace {
+/// A connected region of layout agnostic nodes, which can be switched to any
+/// layout as a whole.
+class LayoutRegion {
+  /// The nodes of the region in topological order.
+  std::vector<Node *> nodes_;
+  /// The set of nodes of the region.
+  std::unordered_set<Node *> nodeSet_;
+  /// Whether a Transpose both consumes and feeds the region.
+  bool hasInnerTransposes_{false};
+
+public:
+  /// Collects the region of layout agnostic nodes containing \p root.
+  explicit LayoutRegion(Node *root) {
+    std::vector<Node *> worklist{root};
+    nodeSet_.insert(root);
+    while (!worklist.empty()) {
+      Node *N = worklist.back();
+      worklist.pop_back();
+      auto visit = [&](Node *M) {
+        if (isLayoutAgnostic(M) && nodeSet_.insert(M).second) {
+          worklist.push_back(M);
+        }
+      };
+      for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+        visit(N->getNthInput(i).getNode());
+      }
+      for (auto &U : N->getUsers()) {
+        visit(U.getUser());
+      }
+    }
+    // Order the nodes topologically with an explicit post order traversal.
+    std::unordered_set<Node *> visited;
+    for (Node *N : nodeSet_) {
+      std::vector<std::pair<Node *, unsigned>> stack;
+      if (visited.insert(N).second) {
+        stack.push_back({N, 0});
+      }
+      while (!stack.empty()) {
+        auto &top = stack.back();
+        if (top.second < top.first->getNumInputs()) {
+          Node *in = top.first->getNthInput(top.second++).getNode();
+          if (contains(in) && visited.insert(in).second) {
+            stack.push_back({in, 0});
+          }
+          continue;
+        }
+        nodes_.push_back(top.first);
+        stack.pop_back();
+      }
+    }
+    for (Node *N : nodes_) {
+      for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+        auto *TN = dyn_cast<TransposeNode>(N->getNthInput(i));
+        hasInnerTransposes_ |= TN && contains(TN->getInput().getNode());
+      }
+    }
+  }
+
+  /// \returns the nodes of the region in topological order.
+  llvm::ArrayRef<Node *> getNodes() const { return nodes_; }
+
+  /// \returns true if \p N belongs to the region.
+  bool contains(Node *N) const { return nodeSet_.count(N); }
+
+  /// \returns true if the region can be switched to another layout. Regions
+  /// feeding themselves through a Transpose are not supported.
+  bool canTranspose() const { return !hasInnerTransposes_; }
+
+  /// \returns the rank of the tensors the region operates on.
+  size_t getRank() const {
+    return nodes_.front()->getNthResult(0).dims().size();
+  }
+
+  /// \returns the shuffles worth trying for the region: the ones of the
+  /// Transposes feeding it and the inverses of the ones of the Transposes
+  /// consuming it.
+  std::vector<llvm::SmallVector<unsigned_t, max_tensor_dimensions>>
+  getCandidateShuffles() const {
+    std::vector<llvm::SmallVector<unsigned_t, max_tensor_dimensions>>
+        candidates;
+    auto addCandidate = [&](llvm::ArrayRef<unsigned_t> shuffle) {
+      if (shuffle.size() == getRank() &&
+          std::none_of(candidates.begin(), candidates.end(),
+                       [&](llvm::ArrayRef<unsigned_t> candidate) {
+                         return candidate == shuffle;
+                       })) {
+        candidates.emplace_back(shuffle.begin(), shuffle.end());
+      }
+    };
+    for (Node *N : nodes_) {
+      for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+        if (auto *TN = dyn_cast<TransposeNode>(N->getNthInput(i))) {
+          addCandidate(TN->getShuffle());
+        }
+      }
+      for (auto &U : N->getUsers()) {
+        if (auto *TN = dyn_cast<TransposeNode>(U.getUser())) {
+          addCandidate(invertShuffle(TN->getShuffle()));
+        }
+      }
+    }
+    return candidates;
+  }
+
+  /// \returns the number of Transposes saved by switching the region to the
+  /// layout its inputs have before being transposed with \p shuffle. The
+  /// result is negative if more Transposes would be needed.
+  int getGain(llvm::ArrayRef<unsigned_t> shuffle) const {
+    int gain = 0;
+    // Inputs transposed with the shuffle are used directly, which makes their
+    // Transposes dead unless they have other users. All other inputs need to
+    // be transposed, except for Splats, which are recreated in the new layout.
+    // Constants are counted as well, as transpose() inserts a Transpose for
+    // them, so that the gain of undoing a switch is the opposite of its own.
+    std::unordered_set<Node *> deadTransposes;
+    std::set<std::pair<Node *, unsigned>> transposedInputs;
+    for (Node *N : nodes_) {
+      for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+        NodeValue in = N->getNthInput(i);
+        if (contains(in.getNode())) {
+          continue;
+        }
+        auto *TN = dyn_cast<TransposeNode>(in);
+        if (TN && TN->getShuffle() == shuffle) {
+          bool allUsersInRegion = true;
+          for (auto &U : TN->getUsers()) {
+            allUsersInRegion &= contains(U.getUser());
+          }
+          if (allUsersInRegion) {
+            deadTransposes.insert(TN);
+          }
+          continue;
+        }
+        if (!isa<SplatNode>(in)) {
+          transposedInputs.insert({in.getNode(), in.getResNo()});
+        }
+      }
+    }
+    gain += deadTransposes.size();
+    gain -= transposedInputs.size();
+    // Transposes of results cancel out if they undo the shuffle. All other
+    // users need the result transposed back.
+    for (Node *N : nodes_) {
+      bool needsTransposeBack = false;
+      for (auto &U : N->getUsers()) {
+        Node *user = U.getUser();
+        if (contains(user)) {
+          continue;
+        }
+        if (auto *TN = dyn_cast<TransposeNode>(user)) {
+          gain += isIdentityShuffle(composeShuffles(shuffle, TN->getShuffle()));
+          continue;
+        }
+        needsTransposeBack = true;
+      }
+      gain -= needsTransposeBack;
+    }
+    return gain;
+  }
+
+  /// Switches the region to the layout its inputs have before being
+  /// transposed with \p shuffle. The nodes of the region and the Transposes
+  /// made dead are erased from \p F. \returns the nodes replacing the ones of
+  /// the region.
+  std::vector<Node *> transpose(Function *F,
+                                llvm::ArrayRef<unsigned_t> shuffle) {
+    auto inverse = invertShuffle(shuffle);
+    Module *M = F->getParent();
+    auto getTransposedType = [&](TypeRef T) {
+      ShapeVector dims(T->dims().size());
+      for (size_t i = 0, e = dims.size(); i < e; i++) {
+        dims[shuffle[i]] = T->dims()[i];
+      }
+      return M->uniqueTypeWithNewShape(T, dims);
+    };
+
+    std::unordered_map<Node *, Node *> newNodes;
+    std::map<std::pair<Node *, unsigned>, NodeValue> transposedInputs;
+    for (Node *N : nodes_) {
+      std::vector<NodeValue> inputs;
+      for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+        NodeValue in = N->getNthInput(i);
+        if (contains(in.getNode())) {
+          inputs.push_back(newNodes[in.getNode()]);
+          continue;
+        }
+        auto *TN = dyn_cast<TransposeNode>(in);
+        if (TN && TN->getShuffle() == shuffle) {
+          inputs.push_back(TN->getInput());
+          continue;
+        }
+        if (auto *SN = dyn_cast<SplatNode>(in)) {
+          inputs.push_back(F->createSplat(SN->getName(),
+                                          getTransposedType(SN->getType(0)),
+                                          SN->getValue()));
+          continue;
+        }
+        auto &transposed = transposedInputs[{in.getNode(), in.getResNo()}];
+        if (!transposed.getNode()) {
+          transposed = F->createTranspose(in.getNode()->getName().str() +
+                                              "_layout",
+                                          in, inverse);
+        }
+        inputs.push_back(transposed);
+      }
+
+      TypeRef newTy = getTransposedType(N->getNthResult(0).getType());
+      Node *newN;
+      if (auto *CN = dyn_cast<ConcatNode>(N)) {
+        newN = F->createConcat(CN->getName(), inputs, shuffle[CN->getDim()],
+                               newTy);
+      } else {
+        newN = F->addNode(N->clone());
+        for (unsigned i = 0, e = inputs.size(); i < e; i++) {
+          newN->setNthInput(i, inputs[i]);
+        }
+        newN->setTypeUnsafe(0, newTy);
+      }
+      newNodes[N] = newN;
+    }
+
+    std::vector<Node *> deadTransposes;
+    for (Node *N : nodes_) {
+      Node *newN = newNodes[N];
+      std::vector<NodeUse> users(N->getUsers().begin(), N->getUsers().end());
+      TransposeNode *transposeBack = nullptr;
+      for (auto &U : users) {
+        Node *user = U.getUser();
+        if (contains(user)) {
+          continue;
+        }
+        if (auto *TN = dyn_cast<TransposeNode>(user)) {
+          auto combined = composeShuffles(shuffle, TN->getShuffle());
+          if (isIdentityShuffle(combined)) {
+            TN->getResult().replaceAllUsesOfWith(newN);
+          } else {
+            TN->getResult().replaceAllUsesOfWith(F->createTranspose(
+                TN->getName(), newN, combined, TN->getLayout()));
+          }
+          deadTransposes.push_back(TN);
+          continue;
+        }
+        if (!transposeBack) {
+          transposeBack = F->createTranspose(N->getName().str() + "_layout",
+                                             newN, shuffle);
+        }
+        U.get()->setOperand(transposeBack, 0);
       }
-      const float newSplatVal =
-          std::min(std::max(splatNode->getValue(), clipNode->getMin()),
-                   clipNode->getMax());
+    }
 
-      SplatNode *newSplatNode = nullptr;
-      if (newSplatVal == splatNode->getValue()) {
-        // No need to crate a new Splat.
-        newSplatNode = splatNode;
-      } else {
-        newSplatNode = F->createSplat(
-            splatNode->getName().str() + clipNode->getName().str(),
-            splatNode->getResult().getType(), newSplatVal);
+    // Erase the old region along with the Transposes around it, which are
+    // not used anymore.
+    std::unordered_set<Node *> inputTransposes;
+    for (Node *N : nodes_) {
+      for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+        if (auto *TN = dyn_cast<TransposeNode>(N->getNthInput(i))) {
+          inputTransposes.insert(TN);
+        }
+      }
+    }
+    for (Node *TN : deadTransposes) {
+      F->eraseNode(TN);
+    }
+    for (auto it = nodes_.rbegin(), e = nodes_.rend(); it != e; ++it) {
+      F->eraseNode(*it);
+    }
+    for (Node *TN : inputTransposes) {
+      if (!TN->hasUsers()) {
+        F->eraseNode(TN);
       }
+    }
+    nodes_.clear();
+    nodeSet_.clear();
 
-      clipNode->getResult().replaceAllUsesOfWith(newSplatNode->getResult());
-      changed = true;
-      continue;
+    std::vector<Node *> result;
+    for (auto &it : newNodes) {
+      result.push_back(it.second);
     }
+    return result;
   }
-  return changed;
-}
+};
+} // namespace
 
-/// Optimize TransposeNode into ReshapeNode when it actually moves no data.
-bool OptimizeTransposeIntoReshape::run(Function *F,
-                                       const CompilationContext &cctx) {
+/// Propagate layouts through regions of layout agnostic nodes. Each region is
+/// switched to the layout of its transposed inputs or outputs whenever that
+/// reduces the total number of Transposes, so that Transposes around layout
+/// sensitive nodes cancel out across whole subgraphs instead of only
+/// locally.
+bool PropagateLayouts::run(Function *F, const CompilationContext &cctx) {
   LOG_SCOPE(F->getLogContext(), getName());
+  const unsigned numTransposesBefore = countTransposes(F);
+  if (numTransposesBefore == 0) {
+    return false;
+  }
+
+  // Nodes created by switching a region are never switched again, and each
+  // switch erases at least one of the original nodes, which bounds the number
+  // of iterations.
+  std::unordered_set<Node *> switched;
+  const size_t maxIterations = F->getNodes().size();
   bool changed = false;
+  bool changedLocally = true;
+  for (size_t iter = 0; changedLocally && iter < maxIterations; iter++) {
+    changedLocally = false;
+    std::unordered_set<Node *> visited;
+    for (auto &node : F->getNodes()) {
+      if (visited.count(&node) || !node.hasUsers() ||
+          !isLayoutAgnostic(&node)) {
+        continue;
+      }
+      LayoutRegion region(&node);
+      visited.insert(region.getNodes().begin(), region.getNodes().end());
+      if (!region.canTranspose() ||
+          std::any_of(region.getNodes().begin(), region.getNodes().end(),
+                      [&](Node *N) { return switched.count(N); })) {
+        continue;
+      }
 
-  for (auto &node : F->getNodes()) {
-    auto *TR = dyn_cast<TransposeNode>(&node);
-    if (!TR) {
-      continue;
-    }
-    auto inputNode = TR->getInput();
-    auto inputDims = inputNode.dims();
-    auto outputDims = TR->getResult().dims();
-    // The transformation is not possible if alignments different from 1 are
-    // used for any dimension.
-    if (!inputNode.getType()->isEqual(F->getParent()->uniqueTypeWithNewShape(
-            inputNode.getType(), inputDims))) {
-      continue;
-    }
-    if (!TR->getResult().getType()->isEqual(
-            F->getParent()->uniqueTypeWithNewShape(TR->getResult().getType(),
-                                                   outputDims))) {
-      continue;
-    }
-    // Transpose moves no data if input/output dimensions match after they both
-    // drop dimensions of size 1. E.g. transposing [1 5 1 15] into [5 15 1 1]
-    // produces vectors (1, 3) for both dimensions so optimization is executed.
-    auto shuffle = TR->getShuffle();
-    ShapeVector inDims;
-    ShapeVector outDims;
-    for (size_t i = 0; i < inputDims.size(); i++) {
-      if (inputDims[i] != 1) {
-        inDims.push_back(i);
+      llvm::SmallVector<unsigned_t, max_tensor_dimensions> bestShuffle;
+      int bestGain = 0;
+      for (const auto &shuffle : region.getCandidateShuffles()) {
+        int gain = region.getGain(shuffle);
+        if (gain > bestGain) {
+          bestGain = gain;
+          bestShuffle = shuffle;
+        }
       }
-      if (outputDims[i] != 1) {
-        outDims.push_back(shuffle[i]);
+      if (bestGain > 0) {
+        auto newNodes = region.transpose(F, bestShuffle);
+        switched.insert(newNodes.begin(), newNodes.end());
+        changedLocally = true;
+        break;
       }
     }
-    if (inDims != outDims) {
-      continue;
-    }
-    auto *RS =
-        F->createReshape(TR->getName(), inputNode, outputDims, TR->getLayout());
-    TR->getResult().replaceAllUsesOfWith(RS);
-    changed = true;
+    changed |= changedLocally;
   }
 
+  VLOG(1) << "Transposes in " << F->getName().str() << ": "
+          << numTransposesBefore << " before layout propagation, "
+          << countTransposes(F) << " after";
   return changed;
 }
 
@@ -4270,6 +4936,195 @@ bool FoldChannelShuffle::run(Function *F, const CompilationContext &cctx) {
   return changed;
 }
 
+namespace {
+/// The operands of a scaled dot-product attention matched in a Function.
+struct AttentionOperands {
+  NodeValue queries;
+  NodeValue keysT;
+  NodeValue mask;
+  float scale{1};
+};
+} // namespace
+
+/// \returns the input of the Reshape producing \p V if \p V is the only use
+/// of the Reshape, or else \p V.
+static NodeValue skipSingleUseReshape(NodeValue V) {
+  auto *RN = dyn_cast<ReshapeNode>(V);
+  if (RN && RN->getResult().hasOneUse()) {
+    return RN->getInput();
+  }
+  return V;
+}
+
+/// Match \p V against MatMul(Queries, KeysT) or BatchMatMul(Queries, KeysT),
+/// optionally multiplied or divided by a Splat, with each result having a
+/// single use. \returns whether \p V matched, in which case the queries, keys
+/// and scale of \p ops are set.
+static bool matchAttentionScores(NodeValue V, AttentionOperands &ops) {
+  if (!V.hasOneUse()) {
+    return false;
+  }
+  if (auto *MN = dyn_cast<MulNode>(V)) {
+    NodeValue other = MN->getLHS();
+    auto *SN = dyn_cast<SplatNode>(MN->getRHS());
+    if (!SN) {
+      other = MN->getRHS();
+      SN = dyn_cast<SplatNode>(MN->getLHS());
+    }
+    if (!SN) {
+      return false;
+    }
+    ops.scale = SN->getValue();
+    V = other;
+  } else if (auto *DN = dyn_cast<DivNode>(V)) {
+    auto *SN = dyn_cast<SplatNode>(DN->getRHS());
+    if (!SN || SN->getValue() == 0) {
+      return false;
+    }
+    ops.scale = 1 / SN->getValue();
+    V = DN->getLHS();
+  }
+  if (!V.hasOneUse()) {
+    return false;
+  }
+  if (auto *MMN = dyn_cast<MatMulNode>(V)) {
+    ops.queries = MMN->getLHS();
+    ops.keysT = MMN->getRHS();
+    return true;
+  }
+  if (auto *BMMN = dyn_cast<BatchMatMulNode>(V)) {
+    ops.queries = BMMN->getLHS();
+    ops.keysT = BMMN->getRHS();
+    return true;
+  }
+  return false;
+}
+
+// Fold the scaled dot-product attention of transformer models:
+//
+//   Queries  KeysT
+//       \    /
+//       MatMul
+//         |
+//   Mul/Div Splat (optional)
+//         |
+//   Add Mask (optional)
+//         |
+//      SoftMax   Values
+//            \   /
+//           MatMul
+//
+// into a ScaledDotProductAttention node. The MatMuls may be BatchMatMuls and
+// the SoftMax may be surrounded by Reshapes to and from 2D. Every result in
+// the pattern but the final one must have a single use, so that the scores
+// are not needed anymore once the pattern is folded.
+bool FoldScaledDotProductAttention::run(Function *F,
+                                        const CompilationContext &cctx) {
+  LOG_SCOPE(F->getLogContext(), getName());
+  // Profiling and quantization need the intermediate results.
+  if (!cctx.optimizationOpts.enableAttentionFusion ||
+      cctx.precisionConfig.quantMode != QuantizationMode::None) {
+    return false;
+  }
+
+  bool changed = false;
+  for (auto &node : F->getNodes()) {
+    NodeValue probs;
+    NodeValue values;
+    if (auto *MMN = dyn_cast<MatMulNode>(&node)) {
+      probs = MMN->getLHS();
+      values = MMN->getRHS();
+    } else if (auto *BMMN = dyn_cast<BatchMatMulNode>(&node)) {
+      probs = BMMN->getLHS();
+      values = BMMN->getRHS();
+    } else {
+      continue;
+    }
+    NodeValue result = node.getNthResult(0);
+    if (result.getElementType() != ElemKind::FloatTy || !probs.hasOneUse()) {
+      continue;
+    }
+
+    // The SoftMax must normalize the rows of the scores, i.e. their last
+    // dimension.
+    auto *SM = dyn_cast<SoftMaxNode>(skipSingleUseReshape(probs));
+    if (!SM || !SM->getResult().hasOneUse()) {
+      continue;
+    }
+    NodeValue scores = skipSingleUseReshape(SM->getInput());
+    auto smDims = SM->getInput().dims();
+    if (scores.dims() != probs.dims() || smDims.size() != 2 ||
+        smDims[1] != scores.dims().back()) {
+      continue;
+    }
+
+    AttentionOperands ops;
+    auto *AN = dyn_cast<AddNode>(scores);
+    if (AN && AN->getResult().hasOneUse()) {
+      if (matchAttentionScores(AN->getLHS(), ops)) {
+        ops.mask = AN->getRHS();
+      } else {
+        ops = AttentionOperands();
+        if (!matchAttentionScores(AN->getRHS(), ops)) {
+          continue;
+        }
+        ops.mask = AN->getLHS();
+      }
+    } else if (!matchAttentionScores(scores, ops)) {
+      continue;
+    }
+
+    // 2D attentions are folded as a batch of one.
+    const bool is2D = ops.queries.dims().size() == 2;
+    llvm::SmallVector<unsigned_t, 3> swapLast;
+    if (is2D) {
+      swapLast = {1, 0};
+    } else {
+      swapLast = {0, 2, 1};
+    }
+    NodeValue keys;
+    auto *TN = dyn_cast<TransposeNode>(ops.keysT);
+    if (TN && TN->getShuffle().equals(swapLast)) {
+      keys = TN->getInput();
+    } else {
+      keys = F->createTranspose(node.getName().str() + ".keys", ops.keysT,
+                                swapLast);
+    }
+
+    NodeValue queries = ops.queries;
+    NodeValue mask = ops.mask;
+    if (is2D) {
+      auto to3D = [&](NodeValue V, const char *suffix) -> NodeValue {
+        return F->createReshape(node.getName().str() + suffix, V,
+                                {1, V.dims()[0], V.dims()[1]});
+      };
+      queries = to3D(queries, ".queries3D");
+      keys = to3D(keys, ".keys3D");
+      values = to3D(values, ".values3D");
+      if (mask.getNode()) {
+        mask = to3D(mask, ".mask3D");
+      }
+    }
+
+    ScaledDotProductAttentionNode *SDPA;
+    if (mask.getNode()) {
+      SDPA = F->createScaledDotProductAttention(node.getName(), queries, keys,
+                                                values, mask, ops.scale);
+    } else {
+      SDPA = F->createScaledDotProductAttention(node.getName(), queries, keys,
+                                                values, ops.scale);
+    }
+    NodeValue newResult = SDPA->getResult();
+    if (is2D) {
+      newResult = F->createReshape(node.getName().str() + ".result",
+                                   newResult, result.dims());
+    }
+    result.replaceAllUsesOfWith(newResult);
+    changed = true;
+  }
+  return changed;
+}
+
 // Fold Tile -> Add into BatchedAdd wherever applicable.
 bool FoldTileAddIntoBatchedAdd::run(Function *F,
                                     const CompilationContext &cctx) {
@@ -4715,6 +5570,135 @@ void glow::transformForPrecisionMode(const Backend &B, Function *F,
   }
 }
 
+/// \returns true if \p N is cheap enough to be recomputed next to each of its
+/// users instead of keeping its result alive until the last one: it does
+/// about as much work as copying its result, and it only reads Storage, so
+/// recomputing it does not extend the lifetime of any other activation.
+static bool isCheapToRematerialize(const Node *N) {
+  if (N->getNumResults() != 1 || N->hasSideEffects()) {
+    return false;
+  }
+  switch (N->getKind()) {
+  case Kinded::Kind::SplatNodeKind:
+  case Kinded::Kind::TileNodeKind:
+  case Kinded::Kind::GatherNodeKind:
+    break;
+  default:
+    if (!N->isDataParallel()) {
+      return false;
+    }
+  }
+  for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+    if (!isa<Storage>(N->getNthInput(i).getNode())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// \returns an estimate of the peak activation memory of \p F, in bytes. The
+/// nodes are assumed to execute in depth-first post order, like the graph
+/// schedulers do, with each result being live from its node to its last user.
+static uint64_t estimatePeakActivationMemory(Function *F) {
+  GraphPostOrderVisitor visitor(*F);
+  auto order = visitor.getPostOrder();
+  std::unordered_map<const Node *, size_t> position;
+  for (size_t i = 0, e = order.size(); i < e; i++) {
+    position[order[i]] = i;
+  }
+  // Bytes released after executing the node at each position.
+  std::vector<uint64_t> released(order.size(), 0);
+  uint64_t live = 0;
+  uint64_t peak = 0;
+  for (size_t i = 0, e = order.size(); i < e; i++) {
+    const Node *N = order[i];
+    if (isa<Storage>(N)) {
+      continue;
+    }
+    size_t lastUse = i;
+    for (const auto &U : N->getUsers()) {
+      lastUse = std::max(lastUse, position[U.getUser()]);
+    }
+    uint64_t size = 0;
+    for (unsigned r = 0, re = N->getNumResults(); r < re; r++) {
+      size += N->getNthResult(r).getType()->getSizeInBytes();
+    }
+    live += size;
+    released[lastUse] += size;
+    peak = std::max(peak, live);
+    live -= released[i];
+  }
+  return peak;
+}
+
+/// Rematerialize cheap activations with several users, so that each user
+/// gets its own copy scheduled right before it instead of the result staying
+/// alive across the whole graph. This trades compute for activation memory
+/// and only runs until the estimated peak memory fits into
+/// OptimizationOptions::rematerializationMemoryBudget.
+bool Rematerialize::run(Function *F, const CompilationContext &cctx) {
+  LOG_SCOPE(F->getLogContext(), getName());
+  const uint64_t budget = cctx.optimizationOpts.rematerializationMemoryBudget;
+  if (budget == 0) {
+    return false;
+  }
+  uint64_t peak = estimatePeakActivationMemory(F);
+  if (peak <= budget) {
+    return false;
+  }
+
+  // Consider the largest activations first, as they free the most memory.
+  std::vector<Node *> candidates;
+  for (auto &N : F->getNodes()) {
+    if (isCheapToRematerialize(&N) && N.getNumUsers() > 1) {
+      candidates.push_back(&N);
+    }
+  }
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const Node *lhs, const Node *rhs) {
+                     return lhs->getType(0)->getSizeInBytes() >
+                            rhs->getType(0)->getSizeInBytes();
+                   });
+
+  bool changed = false;
+  for (Node *N : candidates) {
+    if (peak <= budget) {
+      break;
+    }
+    // Collect the distinct users. Cloning per use would make several copies
+    // live at the same time when a node uses the result more than once.
+    llvm::SetVector<Node *> users;
+    for (auto &U : N->getUsers()) {
+      users.insert(U.getUser());
+    }
+    // The original node is kept for the first user.
+    std::vector<Node *> clones;
+    for (size_t u = 1, e = users.size(); u < e; u++) {
+      Node *user = users[u];
+      Node *clone = F->addNode(N->clone());
+      for (unsigned i = 0, ie = user->getNumInputs(); i < ie; i++) {
+        if (user->getNthInput(i) == NodeValue(N, 0)) {
+          user->setNthInput(i, clone);
+        }
+      }
+      clones.push_back(clone);
+    }
+
+    uint64_t newPeak = estimatePeakActivationMemory(F);
+    if (newPeak >= peak) {
+      // The result was not what kept the peak high; undo.
+      for (Node *clone : clones) {
+        clone->getNthResult(0).replaceAllUsesOfWith(N);
+        F->eraseNode(clone);
+      }
+      continue;
+    }
+    peak = newPeak;
+    changed = true;
+  }
+  return changed;
+}
+
 Error glow::optimizeFunctionBeforeLowering(Function *F,
                                            CompilationContext &cctx) {
   LOG_SCOPE(F->getLogContext(), "glow::optimizeFunctionBeforeLowering")
@@ -4837,6 +5821,17 @@ Error glow::optimizeFunction(Function *F, const Backend &B,
   // In particular, DCE is very likely to be useful.
   ::glow::optimize(F, cctx, B);
 
+  // If the Function needs more activation memory than allowed, recompute
+  // cheap activations next to their users. This must come after the last CSE,
+  // which would merge the recomputed nodes again.
+  if (cctx.optimizationOpts.rematerializationMemoryBudget) {
+    std::unique_ptr<FunctionPassPipeline> pipeline =
+        glow::make_unique<FunctionPassPipeline>();
+    pipeline->pushBack({FunctionPassID::Rematerialize});
+    FunctionPassManager FPM("Rematerialize", std::move(pipeline));
+    FPM.run(F, cctx);
+  }
+
   // We already started using backend specific verification when the function
   // state became lowered. Do one more verification pass to make sure everything
   // is in order and to bail if it is not. Only do so if we are allowing
@@ -4852,6 +5847,282 @@ Error glow::optimizeFunction(Function *F, const Backend &B,
   return Error::success();
 }
 
+/// Replace the FusedRowwiseQuantizedSparseLengthsWeightedSum nodes \p group
+/// of \p F by a GroupedFusedRowwiseQuantizedSparseLengthsWeightedSum and a
+/// Slice of its result for each of them.
+static void groupFusedRowwiseQuantizedSLWSNodes(
+    Function *F,
+    llvm::ArrayRef<FusedRowwiseQuantizedSparseLengthsWeightedSumNode *> group) {
+  Module *M = F->getParent();
+  const dim_t numTables = group.size();
+  auto *tableOffsets = M->createConstant(ElemKind::Int64ITy, {numTables},
+                                         "groupedSLWSTableOffsets");
+  auto TH = tableOffsets->getPayloadMutable().getHandle<int64_t>();
+
+  // Nodes reading the same table share its rows in the packed data.
+  std::vector<Constant *> tables;
+  llvm::DenseMap<Constant *, int64_t> tableOffset;
+  std::vector<NodeValue> weights, indices, lengths;
+  int64_t numRows = 0;
+  for (dim_t t = 0; t < numTables; t++) {
+    auto *SLWS = group[t];
+    auto *table = cast<Constant>(SLWS->getData());
+    auto it = tableOffset.find(table);
+    if (it == tableOffset.end()) {
+      it = tableOffset.insert({table, numRows}).first;
+      tables.push_back(table);
+      numRows += table->dims()[0];
+    }
+    TH.raw(t) = it->second;
+    weights.push_back(SLWS->getWeights());
+    indices.push_back(SLWS->getIndices());
+    lengths.push_back(SLWS->getLengths());
+  }
+
+  auto *data = concatConstants(M, "groupedSLWSData", tables);
+  auto *grouped = F->createGroupedFusedRowwiseQuantizedSparseLengthsWeightedSum(
+      "groupedSLWS", data, F->createConcat("groupedSLWSWeights", weights, 0),
+      F->createConcat("groupedSLWSIndices", indices, 0),
+      F->createConcat("groupedSLWSLengths", lengths, 0), tableOffsets,
+      group.front()->getUseFP16Accumulation());
+
+  const dim_t numSegments = group.front()->getResult().dims()[0];
+  const dim_t lineSize = group.front()->getResult().dims()[1];
+  for (dim_t t = 0; t < numTables; t++) {
+    auto *slice =
+        F->createSlice(group[t]->getName(), grouped->getResult(),
+                       {t * numSegments, 0}, {(t + 1) * numSegments, lineSize});
+    group[t]->getResult().replaceAllUsesOfWith(slice->getResult());
+    F->eraseNode(group[t]);
+  }
+  // The tables are now packed in data.
+  for (auto *table : tables) {
+    if (!table->hasUsers()) {
+      M->eraseConstant(table);
+    }
+  }
+}
+
+bool glow::groupFusedRowwiseQuantizedSLWS(Function *F, uint64_t maxGroupBytes,
+                                          unsigned minNumTables) {
+  DCHECK(minNumTables > 1) << "minNumTables must be at least 2, given: "
+                           << minNumTables;
+  using SLWSNode = FusedRowwiseQuantizedSparseLengthsWeightedSumNode;
+  // The candidates for grouping, by element type and row size of their
+  // tables, types of their weights and indices, and types of their lengths
+  // and results, which implies the same number of segments.
+  using GroupKey =
+      std::tuple<ElemKind, dim_t, ElemKind, ElemKind, TypeRef, TypeRef, bool>;
+  std::map<GroupKey, std::vector<SLWSNode *>> candidates;
+  std::vector<GroupKey> keys;
+  for (auto &node : F->getNodes()) {
+    auto *SLWS = dyn_cast<SLWSNode>(&node);
+    if (!SLWS || !isa<Constant>(SLWS->getData()) ||
+        SLWS->getData().getType()->getSizeInBytes() > maxGroupBytes) {
+      continue;
+    }
+    GroupKey key{SLWS->getData().getElementType(),
+                 SLWS->getData().dims()[1],
+                 SLWS->getWeights().getElementType(),
+                 SLWS->getIndices().getElementType(),
+                 SLWS->getLengths().getType(),
+                 SLWS->getResult().getType(),
+                 SLWS->getUseFP16Accumulation()};
+    auto &nodes = candidates[key];
+    if (nodes.empty()) {
+      keys.push_back(key);
+    }
+    nodes.push_back(SLWS);
+  }
+
+  bool changed = false;
+  for (auto &key : keys) {
+    std::vector<SLWSNode *> nodes = std::move(candidates[key]);
+    while (nodes.size() >= minNumTables) {
+      // Group the nodes which do not depend on each other and whose tables
+      // fit into maxGroupBytes, and leave the others for the next round.
+      std::vector<SLWSNode *> group, rest;
+      std::vector<Node *> groupNodes;
+      std::vector<NodeValue> inputs;
+      llvm::SmallPtrSet<Node *, 8> groupTables;
+      uint64_t groupBytes = 0;
+      for (auto *SLWS : nodes) {
+        std::vector<NodeValue> ops = {SLWS->getWeights(), SLWS->getIndices(),
+                                      SLWS->getLengths()};
+        Node *table = SLWS->getData().getNode();
+        uint64_t tableBytes = groupTables.count(table)
+                                  ? 0
+                                  : SLWS->getData().getType()->getSizeInBytes();
+        if (groupBytes + tableBytes > maxGroupBytes ||
+            mayDependOnAnyNode(ops, groupNodes) ||
+            mayDependOnAnyNode(inputs, {SLWS})) {
+          rest.push_back(SLWS);
+          continue;
+        }
+        groupTables.insert(table);
+        groupBytes += tableBytes;
+        group.push_back(SLWS);
+        groupNodes.push_back(SLWS);
+        inputs.insert(inputs.end(), ops.begin(), ops.end());
+      }
+      if (group.size() >= minNumTables) {
+        groupFusedRowwiseQuantizedSLWSNodes(F, group);
+        changed = true;
+      }
+      nodes = std::move(rest);
+    }
+  }
+  return changed;
+}
+
+/// The block sizes tried by sparsifyFullyConnected(), in order. The CPU kernel
+/// keeps the 8 columns of a block in a float8 register across its rows, while
+/// 1x1 blocks store the weights as a plain CSR matrix.
+static const std::pair<dim_t, dim_t> sparseFCBlockSizes[] = {
+    {4, 8}, {1, 8}, {1, 1}};
+
+/// \returns a BlockSparseFullyConnected node named \p name multiplying
+/// \p input by the float \p weights and adding \p bias, if any, created in
+/// \p F if at least \p minBlockSparsity of the blocks of \p weights are zero
+/// for one of the sparseFCBlockSizes, or nullptr otherwise.
+static BlockSparseFullyConnectedNode *
+createSparseFCFromDense(Function *F, llvm::StringRef name, NodeValue input,
+                        Constant *weights, NodeValue bias,
+                        float minBlockSparsity) {
+  const dim_t K = weights->dims()[0];
+  const dim_t N = weights->dims()[1];
+  auto WH = weights->getPayload().getHandle<float>();
+  for (const auto &blockSize : sparseFCBlockSizes) {
+    const dim_t BR = blockSize.first;
+    const dim_t BC = blockSize.second;
+    if (K % BR || N % BC) {
+      continue;
+    }
+    // The (block row, block column) of the non-zero blocks, one block row
+    // after the other. Give up as soon as there are too many of them.
+    const dim_t maxNnzBlocks = (K / BR) * (N / BC) * (1 - minBlockSparsity);
+    std::vector<std::pair<dim_t, dim_t>> blocks;
+    for (dim_t br = 0; br < K / BR && blocks.size() <= maxNnzBlocks; br++) {
+      for (dim_t bc = 0; bc < N / BC && blocks.size() <= maxNnzBlocks; bc++) {
+        bool isZero = true;
+        for (dim_t i = 0; i < BR && isZero; i++) {
+          for (dim_t j = 0; j < BC && isZero; j++) {
+            isZero = WH.at({br * BR + i, bc * BC + j}) == 0;
+          }
+        }
+        if (!isZero) {
+          blocks.push_back({br, bc});
+        }
+      }
+    }
+    const dim_t nnzBlocks = blocks.size();
+    // A bias broadcast does not need a sparse node.
+    if (nnzBlocks == 0 || nnzBlocks > maxNnzBlocks) {
+      continue;
+    }
+
+    Module *M = F->getParent();
+    auto *values = M->createConstant(ElemKind::FloatTy, {nnzBlocks, BR, BC},
+                                     name.str() + ".values");
+    auto *colIndices = M->createConstant(ElemKind::Int32ITy, {nnzBlocks},
+                                         name.str() + ".colIndices");
+    auto *rowOffsets = M->createConstant(ElemKind::Int32ITy, {K / BR + 1},
+                                         name.str() + ".rowOffsets");
+    auto VH = values->getPayloadMutable().getHandle<float>();
+    auto CH = colIndices->getPayloadMutable().getHandle<int32_t>();
+    auto RH = rowOffsets->getPayloadMutable().getHandle<int32_t>();
+    RH.clear(0);
+    for (dim_t b = 0; b < nnzBlocks; b++) {
+      const dim_t br = blocks[b].first;
+      const dim_t bc = blocks[b].second;
+      CH.raw(b) = bc;
+      RH.raw(br + 1)++;
+      for (dim_t i = 0; i < BR; i++) {
+        for (dim_t j = 0; j < BC; j++) {
+          VH.at({b, i, j}) = WH.at({br * BR + i, bc * BC + j});
+        }
+      }
+    }
+    for (dim_t br = 0; br < K / BR; br++) {
+      RH.raw(br + 1) += RH.raw(br);
+    }
+    // MatMuls without a BatchedAdd have no bias.
+    if (!bias.getNode()) {
+      bias = F->createSplat(name.str() + ".bias",
+                            M->uniqueType(ElemKind::FloatTy, {N}), 0);
+    }
+    return F->createBlockSparseFullyConnected(name, input, values, colIndices,
+                                              rowOffsets, bias, BR, BC);
+  }
+  return nullptr;
+}
+
+bool glow::sparsifyFullyConnected(Function *F, float minBlockSparsity) {
+  DCHECK(minBlockSparsity > 0 && minBlockSparsity <= 1)
+      << "minBlockSparsity must be in (0, 1], given: " << minBlockSparsity;
+  // Collect the candidates first, as the nodes they replace are erased.
+  std::vector<Node *> candidates;
+  for (auto &node : F->getNodes()) {
+    if (isa<FullyConnectedNode>(&node) || isa<MatMulNode>(&node)) {
+      candidates.push_back(&node);
+    }
+  }
+
+  bool changed = false;
+  for (auto *node : candidates) {
+    NodeValue input, bias, result;
+    Constant *weights;
+    // The nodes replaced by the sparse one, users first.
+    std::vector<Node *> replaced;
+    if (auto *FC = dyn_cast<FullyConnectedNode>(node)) {
+      input = FC->getInput();
+      weights = dyn_cast<Constant>(FC->getWeights());
+      bias = FC->getBias();
+      result = FC->getResult();
+      replaced.push_back(FC);
+    } else {
+      auto *MM = cast<MatMulNode>(node);
+      input = MM->getLHS();
+      weights = dyn_cast<Constant>(MM->getRHS());
+      result = MM->getResult();
+      replaced.push_back(MM);
+      // Fold the bias of a lowered FullyConnected.
+      if (result.hasOneUse()) {
+        auto *BA = dyn_cast<BatchedAddNode>(
+            (*result.getUsers().begin()).getUser());
+        if (BA && BA->getBatch() == result &&
+            BA->getSlice().dims().size() == 1 &&
+            BA->getResult().getType() == result.getType()) {
+          bias = BA->getSlice();
+          result = BA->getResult();
+          replaced.insert(replaced.begin(), BA);
+        }
+      }
+    }
+    if (!weights || weights->dims().size() != 2 ||
+        input.getElementType() != ElemKind::FloatTy ||
+        weights->getElementType() != ElemKind::FloatTy ||
+        result.getElementType() != ElemKind::FloatTy ||
+        (bias.getNode() && bias.getElementType() != ElemKind::FloatTy)) {
+      continue;
+    }
+    auto *sparseFC = createSparseFCFromDense(
+        F, node->getName(), input, weights, bias, minBlockSparsity);
+    if (!sparseFC) {
+      continue;
+    }
+    result.replaceAllUsesOfWith(sparseFC->getResult());
+    for (auto *N : replaced) {
+      F->eraseNode(N);
+    }
+    if (!weights->hasUsers()) {
+      F->getParent()->eraseConstant(weights);
+    }
+    changed = true;
+  }
+  return changed;
+}
+
 bool glow::executeVerticalFCWeightsSplit(Function *F, unsigned numOfChunks,
                                          unsigned minKToSplit) {
   DCHECK(numOfChunks > 0) << "numOfChunks must be a positive number, given: "
@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/Optimizer/GraphOptimizer/GraphRewriter.h"
+
+#include "glow/Graph/Nodes.h"
+#include "glow/Graph/Utils.h"
+
+#include "llvm/Support/Casting.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <iterator>
+
+using namespace glow;
+using llvm::isa;
+
+void GraphRewriter::addPattern(RewritePattern pattern) {
+  patterns_.push_back(std::move(pattern));
+  patternsByKind_.clear();
+}
+
+void GraphRewriter::addPattern(llvm::StringRef name,
+                               llvm::ArrayRef<Kinded::Kind> kinds,
+                               RewritePattern::RewriteFn rewrite) {
+  addPattern({name.str(), kinds.vec(), std::move(rewrite)});
+}
+
+size_t GraphRewriter::getNumApplied(llvm::StringRef name) const {
+  size_t count = 0;
+  for (size_t i = 0, e = numApplied_.size(); i < e; i++) {
+    if (patterns_[i].name == name) {
+      count += numApplied_[i];
+    }
+  }
+  return count;
+}
+
+const std::vector<size_t> &GraphRewriter::getPatterns(Kinded::Kind kind) {
+  auto it = patternsByKind_.find(static_cast<unsigned>(kind));
+  if (it != patternsByKind_.end()) {
+    return it->second;
+  }
+  auto &indices = patternsByKind_[static_cast<unsigned>(kind)];
+  for (size_t i = 0, e = patterns_.size(); i < e; i++) {
+    const auto &kinds = patterns_[i].kinds;
+    if (kinds.empty() ||
+        std::find(kinds.begin(), kinds.end(), kind) != kinds.end()) {
+      indices.push_back(i);
+    }
+  }
+  return indices;
+}
+
+void GraphRewriter::enqueue(Node *N) {
+  if (isa<Storage>(N) || N->getParent() != F_) {
+    return;
+  }
+  if (queued_.insert(N).second) {
+    worklist_.push_back(N);
+  }
+}
+
+void GraphRewriter::eraseIfDead(Node *N, std::unordered_set<Node *> &erased) {
+  std::vector<Node *> stack = {N};
+  while (!stack.empty()) {
+    Node *cur = stack.back();
+    stack.pop_back();
+    if (erased.count(cur) || isa<Storage>(cur) || cur->getParent() != F_ ||
+        cur->hasUsers() || cur->hasSideEffects()) {
+      continue;
+    }
+    std::vector<Node *> inputs;
+    for (size_t i = 0, e = cur->getNumInputs(); i < e; i++) {
+      inputs.push_back(cur->getNthInput(i).getNode());
+    }
+    queued_.erase(cur);
+    erased.insert(cur);
+    F_->eraseNode(cur);
+    // The inputs lost a user, which may enable rewrites relying on the number
+    // of users, or leave them dead.
+    for (Node *input : inputs) {
+      if (!erased.count(input)) {
+        enqueue(input);
+        stack.push_back(input);
+      }
+    }
+  }
+}
+
+bool GraphRewriter::run() {
+  numApplied_.assign(patterns_.size(), 0);
+  numVisited_ = 0;
+  worklist_.clear();
+  queued_.clear();
+
+  // Visit the nodes in post-order, so that inputs are rewritten before their
+  // users. The worklist is a stack, so push the nodes in reverse order.
+  GraphPostOrderVisitor visitor(*F_);
+  auto postOrder = visitor.getPostOrder();
+  for (auto it = postOrder.rbegin(), e = postOrder.rend(); it != e; ++it) {
+    enqueue(*it);
+  }
+
+  bool changed = false;
+  while (!worklist_.empty()) {
+    Node *N = worklist_.back();
+    worklist_.pop_back();
+    // Skip the stale entries of nodes erased or visited in the meantime.
+    if (!queued_.erase(N)) {
+      continue;
+    }
+    // Dead nodes are left to DCE.
+    if (!N->hasUsers() && !N->hasSideEffects()) {
+      continue;
+    }
+    numVisited_++;
+
+    for (size_t idx : getPatterns(N->getKind())) {
+      // Remember the neighborhood of the node and where the nodes created by
+      // the rewrite start, since nodes are always added at the end.
+      std::vector<Node *> neighbors;
+      for (size_t i = 0, e = N->getNumInputs(); i < e; i++) {
+        neighbors.push_back(N->getNthInput(i).getNode());
+      }
+      for (auto &use : N->getUsers()) {
+        neighbors.push_back(use.getUser());
+      }
+      Node *last = &F_->getNodes().back();
+
+      if (!patterns_[idx].rewrite(N, F_)) {
+        continue;
+      }
+      changed = true;
+      numApplied_[idx]++;
+
+      std::vector<Node *> created;
+      for (auto it = std::next(last->getIterator()), e = F_->getNodes().end();
+           it != e; ++it) {
+        created.push_back(&*it);
+      }
+      enqueue(N);
+      for (Node *M : neighbors) {
+        enqueue(M);
+      }
+      for (Node *M : created) {
+        enqueue(M);
+        for (size_t i = 0, e = M->getNumInputs(); i < e; i++) {
+          enqueue(M->getNthInput(i).getNode());
+        }
+        for (auto &use : M->getUsers()) {
+          enqueue(use.getUser());
+        }
+      }
+
+      // Erase the nodes left dead by the rewrite.
+      std::unordered_set<Node *> erased;
+      eraseIfDead(N, erased);
+      for (Node *M : neighbors) {
+        eraseIfDead(M, erased);
+      }
+      for (Node *M : created) {
+        eraseIfDead(M, erased);
+      }
+      // The node is visited again if it is still alive.
+      break;
+    }
+  }
+
+  VLOG(1) << "GraphRewriter visited " << numVisited_ << " nodes of "
+          << F_->getName().str() << ", which has " << F_->getNodes().size()
+          << " nodes after rewriting";
+  return changed;
+}
@@ -15,6 +15,7 @@
  */
 
 #include "glow/Optimizer/GraphOptimizer/NodeSplitting.h"
+#include "glow/Runtime/RuntimeTypes.h"
 
 #include <algorithm>
 #include <numeric>
@@ -1577,3 +1578,174 @@ glow::splitNodes(Function *F, const SplitNodeConstraint &splitConstraint) {
   RETURN_ERR_IF_NOT(F->verify(), "Function is not valid after node splitting!");
   return splitMap;
 }
+
+///===---------------------------------------------------------------------===//
+///                               splitNodesAuto
+///===---------------------------------------------------------------------===//
+namespace {
+/// Candidate dimension of the output of a node for automatic splitting. When
+/// splitting along this dimension in k chunks each split node uses all the
+/// \ref sharedBytes of the operands which are not split (e.g. the filter when
+/// splitting a Conv2D along the batch) and a k-th of the \ref splitBytes of
+/// the operands which are split.
+struct AutoSplitCandidate {
+  size_t dim;
+  dim_t dimSize;
+  uint64_t sharedBytes;
+  uint64_t splitBytes;
+};
+} // namespace
+
+/// \returns the size in bytes of the tensor of \p nodeVal.
+static uint64_t getSizeInBytes(NodeValue nodeVal) {
+  return nodeVal.getType()->getSizeInBytes();
+}
+
+/// Get the dimensions along which the node \p node can be split automatically
+/// \p candidates, in the order of preference. \returns false if the node is
+/// not split automatically.
+static bool
+getAutoSplitCandidates(const Node *node,
+                       std::vector<AutoSplitCandidate> &candidates) {
+  if (auto *CN = dyn_cast<ConvolutionNode>(node)) {
+    if (CN->getLayout() != NHWC) {
+      return false;
+    }
+    auto outDims = CN->getResult().dims();
+    uint64_t inBytes = getSizeInBytes(CN->getInput());
+    uint64_t outBytes = getSizeInBytes(CN->getResult());
+    uint64_t weightBytes =
+        getSizeInBytes(CN->getFilter()) + getSizeInBytes(CN->getBias());
+    // Splitting along N or H reuses the weights for all the chunks. The halo
+    // of input rows shared by the chunks split along H is neglected.
+    candidates.push_back({0, outDims[0], weightBytes, inBytes + outBytes});
+    candidates.push_back({1, outDims[1], weightBytes, inBytes + outBytes});
+    // Splitting along C reuses the input for all the chunks.
+    if (CN->getGroup() == 1) {
+      candidates.push_back({3, outDims[3], inBytes, weightBytes + outBytes});
+    }
+    return true;
+  }
+
+  if (auto *FCN = dyn_cast<FullyConnectedNode>(node)) {
+    auto outDims = FCN->getResult().dims();
+    uint64_t inBytes = getSizeInBytes(FCN->getInput());
+    uint64_t outBytes = getSizeInBytes(FCN->getResult());
+    uint64_t weightBytes =
+        getSizeInBytes(FCN->getWeights()) + getSizeInBytes(FCN->getBias());
+    candidates.push_back({0, outDims[0], weightBytes, inBytes + outBytes});
+    candidates.push_back({1, outDims[1], inBytes, weightBytes + outBytes});
+    return true;
+  }
+
+  // FullyConnected nodes are lowered to MatMul nodes by most backends before
+  // they are split.
+  if (auto *MMN = dyn_cast<MatMulNode>(node)) {
+    auto outDims = MMN->getResult().dims();
+    uint64_t lhsBytes = getSizeInBytes(MMN->getLHS());
+    uint64_t rhsBytes = getSizeInBytes(MMN->getRHS());
+    uint64_t outBytes = getSizeInBytes(MMN->getResult());
+    candidates.push_back({0, outDims[0], rhsBytes, lhsBytes + outBytes});
+    candidates.push_back({1, outDims[1], lhsBytes, rhsBytes + outBytes});
+    return true;
+  }
+
+  const MaxPoolNode *MPN = dyn_cast<MaxPoolNode>(node);
+  const AvgPoolNode *APN = dyn_cast<AvgPoolNode>(node);
+  if (MPN || APN) {
+    // MaxPool nodes with used Argmax cannot be split.
+    if (MPN && (MPN->getLayout() != NHWC ||
+                MPN->getArgmax().getNumUsers() != 0)) {
+      return false;
+    }
+    if (APN && APN->getLayout() != NHWC) {
+      return false;
+    }
+    NodeValue input = MPN ? MPN->getInput() : APN->getInput();
+    NodeValue result = MPN ? MPN->getResult() : APN->getResult();
+    auto outDims = result.dims();
+    uint64_t bytes = getSizeInBytes(input) + getSizeInBytes(result);
+    candidates.push_back({0, outDims[0], 0, bytes});
+    candidates.push_back({1, outDims[1], 0, bytes});
+    candidates.push_back({3, outDims[3], 0, bytes});
+    return true;
+  }
+
+  return false;
+}
+
+std::unique_ptr<SplitNodeOption>
+glow::getAutoSplitNodeOption(const Node *node,
+                             const SplitNodeCostModel &costModel) {
+  std::vector<AutoSplitCandidate> candidates;
+  if (!getAutoSplitCandidates(node, candidates)) {
+    return nullptr;
+  }
+
+  // Choose the candidate dimension needing the fewest chunks for the operands
+  // of each chunk to fit in the cache. If no candidate fits, choose the one
+  // with the smallest chunks.
+  const AutoSplitCandidate *best = nullptr;
+  dim_t bestNumChunks = 1;
+  bool bestFits = false;
+  uint64_t bestChunkBytes = 0;
+  for (const auto &cand : candidates) {
+    dim_t maxNumChunks =
+        std::min<dim_t>(cand.dimSize, std::max(1u, costModel.maxNumChunks));
+    // If the shared operands do not fit, more chunks would not help.
+    dim_t numChunks = 1;
+    if (cand.sharedBytes < costModel.cacheCapacity) {
+      uint64_t space = costModel.cacheCapacity - cand.sharedBytes;
+      numChunks =
+          std::max<dim_t>(numChunks, (cand.splitBytes + space - 1) / space);
+    }
+    numChunks = std::min(numChunks, maxNumChunks);
+    uint64_t chunkBytes =
+        cand.sharedBytes + (cand.splitBytes + numChunks - 1) / numChunks;
+    bool fits = chunkBytes <= costModel.cacheCapacity;
+    bool better = false;
+    if (!best) {
+      better = true;
+    } else if (fits != bestFits) {
+      better = fits;
+    } else if (fits) {
+      better = numChunks < bestNumChunks;
+    } else {
+      better = chunkBytes < bestChunkBytes;
+    }
+    if (better) {
+      best = &cand;
+      bestNumChunks = numChunks;
+      bestFits = fits;
+      bestChunkBytes = chunkBytes;
+    }
+  }
+
+  if (bestNumChunks <= 1) {
+    return nullptr;
+  }
+  VLOG(1) << "Splitting node '" << node->getName().str() << "' along dimension "
+          << best->dim << " in " << bestNumChunks << " chunks of "
+          << bestChunkBytes << " bytes.\n";
+  return std::make_unique<SplitNodeByNumChunks>(
+      llvm::ArrayRef<size_t>(best->dim), llvm::ArrayRef<dim_t>(bestNumChunks));
+}
+
+Expected<SplitNodeMap>
+glow::splitNodesAuto(Function *F, const SplitNodeCostModel &costModel) {
+  // Since we will be transforming the original list of nodes, reverse iterate.
+  SplitNodeMap splitMap;
+  auto &nodes = F->getNodes();
+  for (auto it = nodes.rbegin(), e = nodes.rend(); it != e; it++) {
+    Node *node = &*it;
+    auto splitOption = getAutoSplitNodeOption(node, costModel);
+    if (!splitOption) {
+      continue;
+    }
+    ASSIGN_VALUE_OR_RETURN_ERR(splitMap[node],
+                               splitNode(node, splitOption.get(), nullptr));
+  }
+  // Verify function after splitting nodes.
+  RETURN_ERR_IF_NOT(F->verify(), "Function is not valid after node splitting!");
+  return splitMap;
+}
@@ -59,10 +59,13 @@ std::unique_ptr<FunctionPassPipeline>
 createDefaultGraphOptimizationPassPipeline() {
   std::initializer_list<FunctionPassConfig> configs{
       // Sink transpose operations in an attempt to cancel them out.
-      // Perform code sinking until a fixed-point is reached.
-      // On big functions, the number of iterations until the fixpoint
-      // is usually at most 2 or 3 iterations.
-      {FunctionPassID::SinkCode, ConvergenceMode::UntilFixedPoint},
+      // Code sinking revisits the nodes around every change by itself, so a
+      // single pass reaches the fixed-point.
+      {FunctionPassID::SinkCode},
+
+      // Propagate layouts through regions of layout agnostic nodes to remove
+      // the Transposes that sinking could not cancel out.
+      {FunctionPassID::PropagateLayouts},
 
       // ConvTranspose + BiasAdd
       {FunctionPassID::ConvTransposeBiasAddFold},
@@ -97,6 +100,11 @@ createDefaultGraphOptimizationPassPipeline() {
       // Merge multiple matmul nodes into a single large matmul.
       {FunctionPassID::MergeMatMul},
 
+      // Merge FullyConnected nodes sharing their input into a wide one.
+      {FunctionPassID::MergeFullyConnected,
+       ConvergenceMode::OnePass,
+       {CompilationMode::Infer}},
+
       // Merge multiple batched adds into a larger batched add.
       {FunctionPassID::MergeBatchedAdd},
 
@@ -194,6 +202,13 @@ std::unique_ptr<FunctionPassPipeline> createDefaultFoldPassPipeline() {
       // Fold Reshape->Transpose->Reshape into ChannelShuffle when applicable.
       {FunctionPassID::FoldChannelShuffle},
 
+      // Fold scaled dot-product attentions into ScaledDotProductAttention
+      // nodes. This must run before the MatMul of the scores is folded with
+      // the Add of the mask into a FullyConnected.
+      {FunctionPassID::FoldScaledDotProductAttention,
+       ConvergenceMode::OnePass,
+       {CompilationMode::Infer}},
+
       // Fold MatMul->Add into FullyConnected.
       {FunctionPassID::FoldMatMulAddIntoFullyConnected},
 
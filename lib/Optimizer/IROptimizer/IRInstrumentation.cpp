@@ -15,6 +15,7 @@
  */
 
 #include "glow/IR/IR.h"
+#include "glow/IR/IRUtils.h"
 #include "glow/IR/Instrs.h"
 #include "glow/Optimizer/IROptimizer/CommandLine.h"
 #include "glow/Optimizer/IROptimizer/IRFunctionPassManager.h"
@@ -30,6 +31,7 @@
 
 using namespace glow;
 
+using llvm::dyn_cast;
 using llvm::isa;
 
 static bool performDebugInstrumentation(IRFunction &M) {
@@ -115,7 +117,13 @@ static bool performDebugInstrumentation(IRFunction &M) {
 
     // Instrument debug operands for current instruction.
     for (unsigned opIdx = 0; opIdx < I->getNumOperands(); ++opIdx) {
-      const auto &op = I->getOperand(opIdx);
+      auto op = I->getOperand(opIdx);
+      // Broadcast views are larger than their sources, whose elements they
+      // repeat. Dump the sources, which are the memory actually accessed.
+      auto *TVI = dyn_cast<TensorViewInst>(op.first);
+      if (TVI && isBroadcastView(TVI)) {
+        op.first = TVI->getSrc();
+      }
       const std::string opName = I->getOperandName(opIdx).str();
       const std::string opValueName = op.first->getName();
       const std::string opTypeName = op.first->getType()->toString();
@@ -1108,6 +1108,15 @@ public:
 };
 } // namespace
 
+/// \returns true if a buffer of type \p T1 can be reused for a value of type
+/// \p T2 and vice versa. The types may differ in their shapes and
+/// quantization parameters, because the value is then accessed through a
+/// TensorView of the reused buffer.
+static bool areCompatibleForSharing(TypeRef T1, TypeRef T2) {
+  return T1 == T2 || (T1->getElementType() == T2->getElementType() &&
+                      T1->size() == T2->size());
+}
+
 /// Tries to share a buffer for two operands of the same instruction.
 /// An operand X cannot reuse the buffer of another operand Y,
 /// if the live interval of X overlaps with any live intervals of Y.
@@ -1133,8 +1142,9 @@ static bool tryToShareBuffersForInstr(
       if (!src) {
         src = srcOp.first;
       }
-      // Operands must be different, but of the same type.
-      if (destOp.first->getType() != srcOp.first->getType()) {
+      // Operands must be different, but of compatible types.
+      if (!areCompatibleForSharing(destOp.first->getType(),
+                                   srcOp.first->getType())) {
         continue;
       }
 
@@ -1167,6 +1177,20 @@ static bool tryToShareBuffersForInstr(
   return false;
 }
 
+#ifndef NDEBUG
+/// \returns the total size in bytes of the activations of \p M which are
+/// still used by anything else than their deallocation.
+static uint64_t getUsedActivationsSize(const IRFunction &M) {
+  uint64_t size = 0;
+  for (const auto &I : M.getInstrs()) {
+    if (isa<AllocActivationInst>(&I) && I.getNumUsers() > 1) {
+      size += I.getSizeInBytes();
+    }
+  }
+  return size;
+}
+#endif
+
 /// Sharing of buffers
 ///
 /// The purpose of this optimization is to reduce the memory usage by
@@ -1180,6 +1204,11 @@ static bool tryToShareBuffersForInstr(
 static bool shareBuffers(IRFunction &M) {
   bool changed = false;
   InstructionPtrSet erasedInstructions;
+  // The size of the activations before sharing is only needed for the debug
+  // output.
+  uint64_t activationsSize = 0;
+  (void)activationsSize;
+  DEBUG_GLOW(activationsSize = getUsedActivationsSize(M));
   // Build a list of live intervals for each memory location
   // which is either a WeightVar or a an Allocation.
   LiveIntervalsMap intervalsMap;
@@ -1210,6 +1239,10 @@ static bool shareBuffers(IRFunction &M) {
   // Fix eventual issues with tensorviews that shareBuffers may
   // introduce by extending live interval lifetimes.
   changed |= sinkTensorViews(M);
+  DEBUG_GLOW(llvm::dbgs() << "Sharing buffers of " << M.getName()
+                          << " reduced the activations from "
+                          << activationsSize << " to "
+                          << getUsedActivationsSize(M) << " bytes\n");
   return changed;
 }
 
@@ -1454,6 +1487,169 @@ bool optimizeExtracts(IRFunction &M) {
   return changed;
 }
 
+/// Minimal number of consecutive source elements repeated by a tile for the
+/// tile to be folded into a broadcast view. Data-parallel kernels reading
+/// broadcast views process their elements row by row, and very short rows do
+/// not pay off the saved copy.
+static constexpr dim_t kMinBroadcastRowLength = 8;
+
+/// \returns true if \p ITI tiles its source over the whole destination, i.e.
+/// if it is the IR of a TileNode and its destination could be represented as
+/// a broadcast view of its source.
+static bool isTileInsert(const InsertTensorInst *ITI) {
+  auto srcDims = ITI->getSrc()->dims();
+  auto destDims = ITI->getDest()->dims();
+  unsigned axis = ITI->getAxis();
+  if (srcDims.size() != destDims.size() || srcDims[axis] != 1 ||
+      ITI->getCount() < 2 || ITI->getCount() != destDims[axis]) {
+    return false;
+  }
+  for (size_t i = 0, e = srcDims.size(); i < e; i++) {
+    if (ITI->getOffsets()[i] != 0 ||
+        (i != axis && srcDims[i] != destDims[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Replace the reads of tiled buffers by data-parallel instructions with
+/// broadcast views of the tiled sources, so that the tiles are never
+/// materialized. This is only valid for backends that support broadcast views
+/// as operands of data-parallel instructions.
+static bool foldTilesIntoBroadcastViews(IRFunction &M) {
+  bool changed = false;
+  auto &instrs = M.getInstrs();
+  IRBuilder B(&M);
+
+  // Tiles are processed in reverse order, so that chains of tiles, e.g. those
+  // of multi-dimensional broadcasts, collapse into a single view of the
+  // source of the first tile.
+  llvm::SmallVector<InsertTensorInst *, 8> tiles;
+  for (auto &I : instrs) {
+    auto *ITI = dyn_cast<InsertTensorInst>(&I);
+    if (ITI && isTileInsert(ITI) && isa<AllocActivationInst>(ITI->getDest()) &&
+        getBroadcastRowLength(ITI->getSrc()->dims(), ITI->getDest()->dims()) >=
+            kMinBroadcastRowLength) {
+      tiles.push_back(ITI);
+    }
+  }
+
+  for (auto *ITI : llvm::reverse(tiles)) {
+    auto *tile = ITI->getDest();
+    auto *src = ITI->getSrc();
+
+    llvm::DenseMap<const Instruction *, size_t> position;
+    size_t numInstrs = 0;
+    for (auto &I : instrs) {
+      position[&I] = numInstrs++;
+    }
+    size_t insertPos = position[ITI];
+
+    // The only views of the tile may be broadcast views created for later
+    // tiles of a chain. All other uses of the tile after the insert must be
+    // reads of whole elements by data-parallel instructions. Uses before the
+    // insert are either reads of the previous contents or writes overwritten
+    // by the insert.
+    llvm::SmallVector<Use, 4> reads;
+    llvm::SmallVector<TensorViewInst *, 2> views;
+    Instruction *lastRead = ITI;
+    bool canFold = true;
+    auto recordRead = [&](Instruction *I) {
+      if (position[I] > position[lastRead]) {
+        lastRead = I;
+      }
+    };
+    for (const auto &U : tile->getUsers()) {
+      auto *I = U.get();
+      if (I == ITI || isa<DeallocActivationInst>(I)) {
+        continue;
+      }
+      if (auto *TVI = dyn_cast<TensorViewInst>(I)) {
+        if (!isBroadcastView(TVI) ||
+            getBroadcastRowLength(src->dims(), TVI->getType()->dims()) <
+                kMinBroadcastRowLength) {
+          canFold = false;
+          break;
+        }
+        views.push_back(TVI);
+        for (const auto &VU : TVI->getUsers()) {
+          recordRead(VU.get());
+        }
+        continue;
+      }
+      if (position[I] < insertPos) {
+        continue;
+      }
+      if (U.getOperand().second != OperandKind::In || !I->isDataParallel() ||
+          I->getOperand(0).first->size() != tile->size()) {
+        canFold = false;
+        break;
+      }
+      reads.push_back(U);
+      recordRead(I);
+    }
+    if (!canFold || (reads.empty() && views.empty())) {
+      continue;
+    }
+
+    // The source must not change while the tile is read.
+    auto *srcOrigin = getOrigin(src);
+    for (auto it = std::next(ITI->getIterator()),
+              e = std::next(lastRead->getIterator());
+         it != e && canFold; ++it) {
+      for (const auto &op : it->getOperands()) {
+        if (op.second != OperandKind::In && getOrigin(op.first) == srcOrigin) {
+          canFold = false;
+          break;
+        }
+      }
+    }
+    if (!canFold) {
+      continue;
+    }
+
+    // Extend the lifetime of the source up to the last read of the tile.
+    if (auto *srcAlloc = dyn_cast<AllocActivationInst>(srcOrigin)) {
+      for (const auto &U : srcAlloc->getUsers()) {
+        auto *DA = dyn_cast<DeallocActivationInst>(U.get());
+        if (DA && position[DA] < position[lastRead]) {
+          auto where = std::next(lastRead->getIterator());
+          if (where == instrs.end()) {
+            M.removeInstruction(DA);
+            M.insertInstruction(DA);
+          } else {
+            M.moveInstruction(&*where, DA);
+          }
+          break;
+        }
+      }
+    }
+
+    // Read the source through broadcast views instead of the tile.
+    std::vector<dim_t> offsets(src->dims().size(), 0);
+    llvm::DenseMap<Instruction *, TensorViewInst *> readerViews;
+    for (auto &U : reads) {
+      auto *&view = readerViews[U.get()];
+      if (!view) {
+        view = B.createTensorViewInst((ITI->getName() + ".broadcast").str(),
+                                      src, tile->getType(), offsets);
+        M.moveInstruction(U.get(), view);
+      }
+      U.setOperand(view);
+    }
+    for (auto *TVI : views) {
+      TVI->setOperand(0, src);
+    }
+
+    // The tile is not read anymore. Its other writers and the alloc are
+    // deleted by later passes.
+    M.eraseInstruction(ITI);
+    changed = true;
+  }
+  return changed;
+}
+
 /// Perform peephole optimizations.
 bool performPeepholeOptimizations(IRFunction &M) {
   bool changed = false;
@@ -1637,6 +1833,11 @@ bool OptimizeExtracts::run(IRFunction *M, const CompilationContext &cctx) {
   return optimizeExtracts(*M);
 }
 
+bool FoldTilesIntoBroadcastViews::run(IRFunction *M,
+                                      const CompilationContext &cctx) {
+  return foldTilesIntoBroadcastViews(*M);
+}
+
 bool IRVerify::run(IRFunction *M, const CompilationContext &cctx) {
   return M->verify();
 }
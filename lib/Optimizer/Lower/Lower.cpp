@@ -1113,6 +1113,54 @@ static void lowerBatchMatMulNode(Function *F, CompilationContext &cctx,
   replaceAllUsesOfWith(cctx.loweredInfoMap, BMMN.getResult(), RN);
 }
 
+static void
+lowerScaledDotProductAttentionNode(Function *F, CompilationContext &cctx,
+                                   const ScaledDotProductAttentionNode &SDPA) {
+  LOG_SCOPE(F->getLogContext(), "lowerScaledDotProductAttentionNode")
+
+  auto name = SDPA.getName().str();
+  NodeValue keys = SDPA.getKeys();
+  NodeValue mask = SDPA.getMask();
+
+  // Queries = {numBatches, queryLen, headDim}
+  // Keys = {numBatches, keyLen, headDim}
+  const dim_t numBatches = SDPA.getQueries().dims()[0];
+  const dim_t queryLen = SDPA.getQueries().dims()[1];
+  const dim_t keyLen = keys.dims()[1];
+
+  // Scores = Queries x Keys^T * Scale, {numBatches, queryLen, keyLen}.
+  auto *KT = F->createTranspose(name + ".keysT", keys, {0, 2, 1});
+  NodeValue scores =
+      F->createBatchMatMul(name + ".scores", SDPA.getQueries(), KT);
+  auto *scale =
+      F->createSplat(name + ".scale", scores.getType(), SDPA.getScale());
+  scores = F->createMul(name + ".scaled", scores, scale);
+
+  // Add the mask, unless it is known to be zero.
+  auto *maskSplat = llvm::dyn_cast<SplatNode>(mask);
+  if (!maskSplat || maskSplat->getValue() != 0) {
+    if (mask.dims()[1] != queryLen) {
+      mask = F->createBroadcast(name + ".broadcastMask", mask, scores.dims(),
+                                /* axis */ 0);
+    }
+    scores = F->createAdd(name + ".masked", scores, mask);
+  }
+
+  // SoftMax normalizes rows of a 2D tensor.
+  auto *scores2D = F->createReshape(name + ".reshapeScores", scores,
+                                    {numBatches * queryLen, keyLen});
+  auto selectedTy = F->getParent()->uniqueType(
+      ElemKind::Int64ITy, {numBatches * queryLen, 1});
+  auto *selected = F->createSplat(name + ".selected", selectedTy, 0);
+  auto *probs = F->createSoftMax(name + ".softmax", scores2D, selected);
+  auto *probs3D = F->createReshape(name + ".reshapeProbs", probs,
+                                   {numBatches, queryLen, keyLen});
+
+  auto *result =
+      F->createBatchMatMul(name + ".result", probs3D, SDPA.getValues());
+  replaceAllUsesOfWith(cctx.loweredInfoMap, SDPA.getResult(), result);
+}
+
 static void lowerSparseLengthsSumNode(Function *F, CompilationContext &cctx,
                                       const SparseLengthsSumNode &SLSN) {
   LOG_SCOPE(F->getLogContext(), "lowerSparseLengthsSumNode")
@@ -1407,6 +1455,7 @@ bool glow::lowerNode(Function *F, Node *node, CompilationContext &cctx) {
     CASE_LOWER(Tile);
     CASE_LOWER(ReplaceNaN);
     CASE_LOWER(BatchMatMul);
+    CASE_LOWER(ScaledDotProductAttention);
     CASE_LOWER(SparseLengthsSum);
     CASE_LOWER(FusedRowwiseQuantizedSparseLengthsSum);
     CASE_LOWER(BatchBoxCox);
@@ -18,12 +18,15 @@
 #include "glow/Backend/BackendUtils.h"
 #include "glow/Backend/CompiledFunction.h"
 #include "glow/Graph/Graph.h"
+#include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
 #include "glow/Runtime/DeferredWeightLoader.h"
 #include "glow/Support/Debug.h"
 
+#include "llvm/ADT/Hashing.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormatVariadic.h"
 
+#include <cstring>
 #include <future>
 #include <map>
 #include <queue>
@@ -255,6 +258,38 @@ static Error propagateBackendSpecificNodeInfo(
   return Error::success();
 }
 
+void Provisioner::shareConstants(CompiledFunction &compiled,
+                                 const Module &module) {
+  auto &bundle = compiled.getRuntimeBundle();
+  size_t size = bundle.getConstantWeightSize();
+  if (size == 0 || bundle.getConstants() != nullptr) {
+    return;
+  }
+  bundle.collectConstants(&module);
+  const uint8_t *data = bundle.getConstants();
+  size_t hash = llvm::hash_combine_range(data, data + size);
+
+  std::lock_guard<std::mutex> sharedConstantsLock(sharedConstantsLock_);
+  auto &candidates = sharedConstants_[hash];
+  // Forget the blocks freed since, along with their functions.
+  candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                  [](const SharedConstants &SC) {
+                                    return SC.block.expired();
+                                  }),
+                   candidates.end());
+  for (auto &candidate : candidates) {
+    if (candidate.size != size) {
+      continue;
+    }
+    auto block = candidate.block.lock();
+    if (block && memcmp(block.get(), data, size) == 0) {
+      bundle.shareConstants(std::move(block));
+      return;
+    }
+  }
+  candidates.push_back({size, bundle.getSharedConstants()});
+}
+
 Error Provisioner::provision(DAGListTy &networks, Module &module,
                              CompilationContext &cctx) {
 
@@ -281,6 +316,12 @@ Error Provisioner::provision(DAGListTy &networks, Module &module,
   // copy operation.
   cctx.backendOpts.collectConstants = false;
 
+  // Make all the partitions use a single Constant for each distinct payload,
+  // e.g. for the embedding tables shared by several Functions of the Module.
+  if (cctx.optimizationOpts.enableConstantDeduplication) {
+    deduplicateConstants(module);
+  }
+
   // Calculate the size of each logical device.
   auto logicalDeviceSize = calculateLogicalDeviceSize(logicalDevices);
 
@@ -399,6 +440,12 @@ Error Provisioner::provision(DAGListTy &networks, Module &module,
                               deviceBackendName);
         }
 
+        // Functions with bit-identical constants share a single block of
+        // constants on the device, across networks.
+        bool shareConstantsOnDevice =
+            cctx.optimizationOpts.enableConstantSharing &&
+            backends_[deviceBackendName]->supportsSharedConstants();
+
         std::unordered_map<std::string, std::unique_ptr<glow::CompiledFunction>>
             compiledReplications;
         // Before we compile clone the function so we can replicate it on the
@@ -419,6 +466,9 @@ Error Provisioner::provision(DAGListTy &networks, Module &module,
             return compiledOrErr2.takeError();
           }
           auto compiled2 = std::move(*compiledOrErr2);
+          if (shareConstantsOnDevice) {
+            shareConstants(*compiled2, module);
+          }
           functionMap.emplace(replicatedName, compiled2.get());
           compiledReplications.emplace(replicatedName, std::move(compiled2));
         }
@@ -464,6 +514,9 @@ Error Provisioner::provision(DAGListTy &networks, Module &module,
 
         node->runtimeBundle =
             glow::make_unique<RuntimeBundle>(compiled->getRuntimeBundle());
+        if (shareConstantsOnDevice) {
+          shareConstants(*compiled, module);
+        }
 
         functionMap.emplace(node->name, compiled.get());
         // If this function is in more than one logical device store it for
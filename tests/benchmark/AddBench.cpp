@@ -62,6 +62,9 @@ public:
     } else if (std::string(dtypeStr_) == "Float32") {
       dtype_ = ElemKind::FloatTy;
       elementSize_ = 4;
+    } else if (std::string(dtypeStr_) == "Int8") {
+      dtype_ = ElemKind::Int8QTy;
+      elementSize_ = 1;
     }
   }
 
@@ -84,22 +87,40 @@ public:
     std::vector<Placeholder *> B(numCores_);
     std::vector<Placeholder *> output(numCores_);
     std::vector<Node *> cur(numCores_);
+    // Quantized inputs and outputs use different scales and offsets, so that
+    // every Add has to rescale both of its operands.
+    bool isQuantized = isQuantizedElemKind(dtype_);
     for (size_t core = 0; core < numCores_; core++) {
-      A[core] = mod->createPlaceholder(dtype_, {n_}, "A" + std::to_string(core),
-                                       false);
-      B[core] = mod->createPlaceholder(dtype_, {n_}, "B" + std::to_string(core),
-                                       false);
-      output[core] = mod->createPlaceholder(
-          dtype_, {n_}, "output" + std::to_string(core), false);
+      if (isQuantized) {
+        A[core] = mod->createPlaceholder(dtype_, {n_}, 0.5, -3,
+                                         "A" + std::to_string(core), false);
+        B[core] = mod->createPlaceholder(dtype_, {n_}, 0.25, 7,
+                                         "B" + std::to_string(core), false);
+        output[core] =
+            mod->createPlaceholder(dtype_, {n_}, 0.75, 2,
+                                   "output" + std::to_string(core), false);
+      } else {
+        A[core] = mod->createPlaceholder(dtype_, {n_},
+                                         "A" + std::to_string(core), false);
+        B[core] = mod->createPlaceholder(dtype_, {n_},
+                                         "B" + std::to_string(core), false);
+        output[core] = mod->createPlaceholder(
+            dtype_, {n_}, "output" + std::to_string(core), false);
+      }
       cur[core] = A[core];
     }
 
     std::vector<Node *> eltwise(numCores_);
     for (size_t layer = 0; layer < numLayers_; layer++) {
       for (size_t core = 0; core < numCores_; core++) {
-        eltwise[core] = fn->createAdd("eltwise" + std::to_string(core) + "_" +
-                                          std::to_string(layer),
-                                      cur[core], B[core]);
+        auto name =
+            "eltwise" + std::to_string(core) + "_" + std::to_string(layer);
+        if (isQuantized) {
+          eltwise[core] = fn->createAdd(name, output[core]->getType(),
+                                        cur[core], B[core]);
+        } else {
+          eltwise[core] = fn->createAdd(name, cur[core], B[core]);
+        }
         cur[core] = eltwise[core];
       }
     }
@@ -142,7 +163,7 @@ int main(int argc, char *argv[]) {
   printf("Add Microbenchmark\n");
   printf("Usage: AddBench n(Int) numLayers(Int) numReps(Int) "
          "numAsyncLaunches(Int) numAddChains(Int) backendStr(String) "
-         "dtypeStr(\"Float16\"|\"Float32\") dev_id(Int)\n");
+         "dtypeStr(\"Float16\"|\"Float32\"|\"Int8\") dev_id(Int)\n");
   assert(argc == 8 || argc == 9);
   size_t n = atoi(argv[1]);
   size_t numLayers = atoi(argv[2]);
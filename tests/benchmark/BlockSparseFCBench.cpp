@@ -0,0 +1,161 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "Bench.h"
+
+#include "glow/ExecutionEngine/ExecutionEngine.h"
+#include "glow/Support/Random.h"
+
+using namespace glow;
+
+/*
+ * This class implements a benchmark of float FullyConnecteds with pruned
+ * weights on the CPU backend. It builds a chain of numLayers FullyConnecteds
+ * of an m x k input by k x k weights in which the given fraction of the
+ * blockRows x blockCols blocks are zero. The FullyConnecteds are computed by
+ * the block-sparse kernel or by the dense one, depending on the sparse
+ * argument.
+ */
+class BlockSparseFCBench : public Benchmark {
+  dim_t m_;
+  dim_t k_;
+  float sparsity_;
+  dim_t blockRows_;
+  dim_t blockCols_;
+  dim_t numLayers_;
+  bool sparse_;
+  dim_t nnzBlocks_{0};
+  PlaceholderBindings bindings_;
+  std::unique_ptr<ExecutionEngine> EE_;
+
+public:
+  BlockSparseFCBench(dim_t m, dim_t k, float sparsity, dim_t blockRows,
+                     dim_t blockCols, dim_t numLayers, bool sparse)
+      : m_(m), k_(k), sparsity_(sparsity), blockRows_(blockRows),
+        blockCols_(blockCols), numLayers_(numLayers), sparse_(sparse) {}
+
+  void setup() override {
+    PseudoRNG PRNG;
+    EE_.reset(new ExecutionEngine("CPU"));
+    auto &mod = EE_->getModule();
+    Function *F = mod.createFunction("singleNode");
+
+    auto *input =
+        mod.createPlaceholder(ElemKind::FloatTy, {m_, k_}, "input", false);
+    bindings_.allocate(input)->getHandle().randomize(-1.f, 1.f, PRNG);
+    NodeValue cur = input;
+    for (dim_t layer = 0; layer < numLayers_; layer++) {
+      auto suffix = std::to_string(layer);
+      auto *weights =
+          mod.createConstant(ElemKind::FloatTy, {k_, k_}, "weights" + suffix);
+      auto WH = weights->getPayloadMutable().getHandle();
+      WH.clear(0);
+      for (dim_t br = 0; br < k_ / blockRows_; br++) {
+        for (dim_t bc = 0; bc < k_ / blockCols_; bc++) {
+          if (PRNG.nextRandReal(0, 1) < sparsity_) {
+            continue;
+          }
+          nnzBlocks_++;
+          for (dim_t i = 0; i < blockRows_; i++) {
+            for (dim_t j = 0; j < blockCols_; j++) {
+              WH.at({br * blockRows_ + i, bc * blockCols_ + j}) =
+                  PRNG.nextRandReal(-0.1, 0.1);
+            }
+          }
+        }
+      }
+      auto *bias = mod.createConstant(ElemKind::FloatTy, {k_}, "bias" + suffix);
+      bias->getPayloadMutable().getHandle().randomize(-0.1f, 0.1f, PRNG);
+      cur = F->createFullyConnected("fc" + suffix, cur, weights, bias);
+    }
+    auto *save = F->createSave("save", cur);
+    bindings_.allocate(save->getPlaceholder());
+
+    CompilationContext cctx;
+    cctx.optimizationOpts.enableBlockSparseFC = sparse_;
+    // Convert the weights whatever their sparsity, to measure the break-even
+    // point of the sparse kernel, but keep larger blocks from being picked
+    // when they are much less sparse than the generated ones.
+    cctx.optimizationOpts.blockSparseFCMinSparsity =
+        std::max(0.9f * sparsity_, 0.01f);
+    EE_->compile(cctx);
+  }
+
+  void run() override { EE_->run(bindings_); }
+
+  void teardown() override {}
+
+  /// \returns the size in bytes of the dense weights of all the layers.
+  double denseBytes() const { return 4.0 * k_ * k_ * numLayers_; }
+
+  /// \returns the size in bytes of the block-CSR weights of all the layers:
+  /// the non-zero blocks, their column indices and the row offsets.
+  double sparseBytes() const {
+    return 4.0 * nnzBlocks_ * (blockRows_ * blockCols_ + 1) +
+           4.0 * (k_ / blockRows_ + 1) * numLayers_;
+  }
+
+  /// \returns the dense-equivalent GFLOP of a run.
+  double gflops() const { return 2.0 * m_ * k_ * k_ * numLayers_ / 1e9; }
+};
+
+int main(int argc, char *argv[]) {
+  printf("Block-Sparse FullyConnected Benchmark\n");
+  printf("Usage: BlockSparseFCBench m(Int) k(Int) sparsity(Float) "
+         "blockRows(Int) blockCols(Int) numLayers(Int) numReps(Int) "
+         "sparse(0|1)\n");
+  assert(argc == 9);
+  size_t m = atoi(argv[1]);
+  size_t k = atoi(argv[2]);
+  float sparsity = atof(argv[3]);
+  size_t blockRows = atoi(argv[4]);
+  size_t blockCols = atoi(argv[5]);
+  size_t numLayers = atoi(argv[6]);
+  size_t numReps = atoi(argv[7]);
+  bool sparse = atoi(argv[8]);
+  assert(sparsity >= 0 && sparsity < 1);
+  assert(blockRows > 0 && k % blockRows == 0);
+  assert(blockCols > 0 && k % blockCols == 0);
+  assert(numLayers > 0 && numReps > 0);
+
+  BlockSparseFCBench b(m, k, sparsity, blockRows, blockCols, numLayers,
+                       sparse);
+  auto times = bench(&b, numReps);
+  double gflops = b.gflops();
+  double weightBytes = sparse ? b.sparseBytes() : b.denseBytes();
+  printf("_,benchName,_,m,k,sparsity,blockRows,blockCols,numLayers,sparse,"
+         "numReps,weightBytes,runtime,gflopPerSec\n");
+  for (auto t : times) {
+    printf("BenchResult,BlockSparseFCBench,SW,%zu,%zu,%f,%zu,%zu,%zu,%d,%zu,"
+           "%.0f,%f,%f\n",
+           m, k, sparsity, blockRows, blockCols, numLayers, sparse, numReps,
+           weightBytes, t, gflops / t);
+  }
+  double min = *(std::min_element(times.begin(), times.end()));
+  size_t midElt = times.size() / 2;
+  std::nth_element(times.begin(), times.begin() + midElt, times.end());
+  double median = times[midElt];
+  printf("_,benchName,_,m,k,sparsity,blockRows,blockCols,numLayers,sparse,"
+         "numReps,denseBytes,sparseBytes,medianRuntime,minRuntime,"
+         "medianGflopPerSec\n");
+  printf("BenchSummary,BlockSparseFCBench,SW,%zu,%zu,%f,%zu,%zu,%zu,%d,%zu,"
+         "%.0f,%.0f,%f,%f,%f\n",
+         m, k, sparsity, blockRows, blockCols, numLayers, sparse, numReps,
+         b.denseBytes(), b.sparseBytes(), median, min, gflops / median);
+}
@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "Bench.h"
+
+#include "glow/Graph/Graph.h"
+
+using namespace glow;
+
+/*
+ * This class implements a graph construction benchmark, which measures the
+ * time spent building and verifying a large synthetic graph the way model
+ * loaders do. The graph is a chain of layers made of a FullyConnected, a Relu
+ * and an Add, whose widths cycle through numWidths values so that the Module
+ * uniques many types. In "build" mode each run builds and verifies a fresh
+ * graph. In "reverify" mode each run modifies a few nodes of the graph and
+ * verifies it again, which only verifies the modified nodes.
+ */
+class GraphConstructionBench : public Benchmark {
+  dim_t numLayers_;
+  dim_t numWidths_;
+  bool reverify_;
+  std::unique_ptr<Module> mod_;
+  Function *F_{nullptr};
+  std::vector<AddNode *> adds_;
+
+  void build() {
+    mod_.reset(new Module);
+    F_ = mod_->createFunction("graph");
+    adds_.clear();
+    const dim_t batch = 4;
+    dim_t width = 8;
+    NodeValue cur = mod_->createPlaceholder(ElemKind::FloatTy, {batch, width},
+                                            "input", false);
+    for (dim_t layer = 0; layer < numLayers_; layer++) {
+      auto suffix = std::to_string(layer);
+      dim_t nextWidth = 8 + (layer + 1) % numWidths_;
+      auto *W = mod_->createPlaceholder(ElemKind::FloatTy, {width, nextWidth},
+                                        "weights" + suffix, false);
+      auto *B = mod_->createPlaceholder(ElemKind::FloatTy, {nextWidth},
+                                        "bias" + suffix, false);
+      auto *FC = F_->createFullyConnected("fc" + suffix, cur, W, B);
+      auto *RL = F_->createRELU("relu" + suffix, FC);
+      auto *AD = F_->createAdd("add" + suffix, RL, FC);
+      adds_.push_back(AD);
+      cur = AD;
+      width = nextWidth;
+    }
+    F_->createSave("save", cur);
+  }
+
+  void verify() {
+    if (!F_->verify()) {
+      printf("Invalid graph\n");
+      exit(1);
+    }
+  }
+
+public:
+  GraphConstructionBench(dim_t numLayers, dim_t numWidths, bool reverify)
+      : numLayers_(numLayers), numWidths_(numWidths), reverify_(reverify) {}
+
+  void setup() override {
+    if (reverify_) {
+      build();
+      verify();
+    }
+  }
+
+  void run() override {
+    if (!reverify_) {
+      build();
+      verify();
+      return;
+    }
+    // Swap the operands of a few Adds.
+    for (dim_t i = 0; i < 16; i++) {
+      auto *AD = adds_[(i * adds_.size()) / 16];
+      NodeValue LHS = AD->getLHS();
+      NodeValue RHS = AD->getRHS();
+      AD->setNthInput(AddNode::LHSIdx, RHS);
+      AD->setNthInput(AddNode::RHSIdx, LHS);
+    }
+    verify();
+  }
+
+  void teardown() override {}
+
+  size_t getNumNodes() const { return F_->getNodes().size(); }
+};
+
+int main(int argc, char *argv[]) {
+  printf("Graph Construction Benchmark\n");
+  printf("Usage: GraphConstructionBench numLayers(Int) numWidths(Int) "
+         "numReps(Int) mode(build|reverify)\n");
+  assert(argc == 5);
+  size_t numLayers = atoi(argv[1]);
+  size_t numWidths = atoi(argv[2]);
+  size_t numReps = atoi(argv[3]);
+  const char *mode = argv[4];
+  assert(numLayers > 0 && numWidths > 0 && numReps > 0);
+  bool reverify = strcmp(mode, "reverify") == 0;
+  assert(reverify || strcmp(mode, "build") == 0);
+
+  GraphConstructionBench b(numLayers, numWidths, reverify);
+  auto times = bench(&b, numReps);
+  size_t numNodes = b.getNumNodes();
+  printf("_,benchName,_,numLayers,numWidths,mode,numNodes,numReps,runtime,"
+         "usPerNode\n");
+  for (auto t : times) {
+    printf("BenchResult,GraphConstructionBench,SW,%zu,%zu,%s,%zu,%zu,%f,%f\n",
+           numLayers, numWidths, mode, numNodes, numReps, t,
+           t * 1e6 / numNodes);
+  }
+  double min = *(std::min_element(times.begin(), times.end()));
+  size_t midElt = times.size() / 2;
+  std::nth_element(times.begin(), times.begin() + midElt, times.end());
+  double median = times[midElt];
+  printf("_,benchName,_,numLayers,numWidths,mode,numNodes,numReps,"
+         "medianRuntime,minRuntime,medianUsPerNode\n");
+  printf("BenchSummary,GraphConstructionBench,SW,%zu,%zu,%s,%zu,%zu,%f,%f,%f\n",
+         numLayers, numWidths, mode, numNodes, numReps, median, min,
+         median * 1e6 / numNodes);
+}
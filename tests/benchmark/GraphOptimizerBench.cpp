@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <cstdlib>
+
+#include "Bench.h"
+
+#include "glow/Graph/Graph.h"
+#include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
+
+using namespace glow;
+
+/*
+ * This class implements a graph optimizer compile-time benchmark. It builds a
+ * synthetic graph made of independent chains of layers, as found in unrolled
+ * sequence models, where every layer is a Transpose, a Relu, an Add of zero
+ * and the inverse Transpose. The optimizer cancels out the Transposes and
+ * removes the Adds. Each run optimizes a fresh clone of the graph, so that the
+ * scaling of the compile time with the size of the graph can be measured by
+ * varying the number of chains and layers.
+ */
+class GraphOptimizerBench : public Benchmark {
+  dim_t numChains_;
+  dim_t numLayers_;
+  std::unique_ptr<Module> mod_;
+  Function *F_{nullptr};
+
+public:
+  GraphOptimizerBench(dim_t numChains_, dim_t numLayers_)
+      : numChains_(numChains_), numLayers_(numLayers_) {}
+
+  void setup() override {
+    mod_.reset(new Module);
+    F_ = mod_->createFunction("graph");
+    auto *zero =
+        F_->createSplat("zero", mod_->uniqueType(ElemKind::FloatTy, {8, 16}),
+                        0.0f);
+    for (dim_t chain = 0; chain < numChains_; chain++) {
+      NodeValue cur = mod_->createPlaceholder(
+          ElemKind::FloatTy, {16, 8}, "input_" + std::to_string(chain), false);
+      for (dim_t layer = 0; layer < numLayers_; layer++) {
+        auto suffix = "_" + std::to_string(chain) + "_" + std::to_string(layer);
+        auto *TR = F_->createTranspose("transpose" + suffix, cur, {1, 0});
+        auto *RL = F_->createRELU("relu" + suffix, TR);
+        auto *AD = F_->createAdd("add" + suffix, RL, zero);
+        cur = F_->createTranspose("transposeBack" + suffix, AD, {1, 0});
+      }
+      F_->createSave("save_" + std::to_string(chain), cur);
+    }
+  }
+
+  void run() override {
+    Function *G = F_->clone("graph_optimized");
+    ::glow::optimize(G, CompilationMode::Infer);
+    mod_->eraseFunction(G);
+  }
+
+  void teardown() override {}
+};
+
+int main(int argc, char *argv[]) {
+  printf("Graph Optimizer Benchmark\n");
+  printf("Usage: GraphOptimizerBench numChains(Int) numLayers(Int) "
+         "numReps(Int)\n");
+  assert(argc == 4);
+  size_t numChains = atoi(argv[1]);
+  size_t numLayers = atoi(argv[2]);
+  size_t numReps = atoi(argv[3]);
+  assert(numReps > 0);
+
+  GraphOptimizerBench b(numChains, numLayers);
+  auto times = bench(&b, numReps);
+  size_t numNodes = 4 * numChains * numLayers + numChains + 1;
+  printf("_,benchName,_,numChains,numLayers,numNodes,numReps,runtime,"
+         "usPerNode\n");
+  for (auto t : times) {
+    printf("BenchResult,GraphOptimizerBench,SW,%zu,%zu,%zu,%zu,%f,%f\n",
+           numChains, numLayers, numNodes, numReps, t, t * 1e6 / numNodes);
+  }
+  double min = *(std::min_element(times.begin(), times.end()));
+  size_t midElt = times.size() / 2;
+  std::nth_element(times.begin(), times.begin() + midElt, times.end());
+  double median = times[midElt];
+  printf("_,benchName,_,numChains,numLayers,numNodes,numReps,medianRuntime,"
+         "minRuntime,medianUsPerNode\n");
+  printf("BenchSummary,GraphOptimizerBench,SW,%zu,%zu,%zu,%zu,%f,%f,%f\n",
+         numChains, numLayers, numNodes, numReps, median, min,
+         median * 1e6 / numNodes);
+}
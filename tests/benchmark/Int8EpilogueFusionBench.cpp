@@ -0,0 +1,167 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "Bench.h"
+
+#include "glow/ExecutionEngine/ExecutionEngine.h"
+#include "glow/Support/Random.h"
+
+using namespace glow;
+
+/*
+ * This class implements a benchmark of the activations following int8
+ * Convolutions and FullyConnecteds on the CPU backend. It builds a chain of
+ * numLayers int8 Convolutions (3x3 over 56x56x128) or FullyConnecteds
+ * (64x1024 by 1024x1024), each followed by a Relu, a Clip or a Sigmoid. The
+ * activations are fused into the epilogue of the kernels or computed by
+ * separate kernels, depending on the fuse argument.
+ */
+class Int8EpilogueFusionBench : public Benchmark {
+  bool isConv_;
+  const char *activation_;
+  dim_t numLayers_;
+  bool fuse_;
+  PlaceholderBindings bindings_;
+  std::unique_ptr<ExecutionEngine> EE_;
+
+  /// \returns a new int8 Constant of shape \p dims named \p name in \p mod
+  /// with random contents.
+  Constant *createRandomConstant(Module &mod, ElemKind kind,
+                                 llvm::ArrayRef<dim_t> dims, float scale,
+                                 llvm::StringRef name, PseudoRNG &PRNG) {
+    auto *C = mod.createConstant(kind, dims, scale, 0, name);
+    if (kind == ElemKind::Int32QTy) {
+      C->getPayloadMutable().getHandle<int32_t>().randomize(-1000, 1000, PRNG);
+    } else {
+      C->getPayloadMutable().getHandle<int8_t>().randomize(-128, 127, PRNG);
+    }
+    return C;
+  }
+
+  /// \returns \p input followed by the activation of the benchmark.
+  NodeValue createActivation(Function *F, NodeValue input,
+                             llvm::StringRef name) {
+    if (!strcmp(activation_, "relu")) {
+      return F->createRELU(name, input);
+    }
+    if (!strcmp(activation_, "clip")) {
+      return F->createClip(name, input, -1.f, 1.f);
+    }
+    auto *outTy =
+        F->getParent()->uniqueType(ElemKind::Int8QTy, input.dims(), 1.f / 256,
+                                   -128);
+    return F->createIntSigmoid(name, input, outTy);
+  }
+
+public:
+  Int8EpilogueFusionBench(bool isConv, const char *activation,
+                          dim_t numLayers, bool fuse)
+      : isConv_(isConv), activation_(activation), numLayers_(numLayers),
+        fuse_(fuse) {}
+
+  void setup() override {
+    PseudoRNG PRNG;
+    EE_.reset(new ExecutionEngine("CPU"));
+    auto &mod = EE_->getModule();
+    Function *F = mod.createFunction("singleNode");
+
+    std::vector<dim_t> dims = {1, 56, 56, 128};
+    if (!isConv_) {
+      dims = {64, 1024};
+    }
+    auto *input = mod.createPlaceholder(ElemKind::Int8QTy, dims, 0.05, 0,
+                                        "input", false);
+    bindings_.allocate(input)->getHandle<int8_t>().randomize(-128, 127, PRNG);
+    auto *outTy = mod.uniqueType(ElemKind::Int8QTy, dims, 0.05, 0);
+    NodeValue cur = input;
+    for (dim_t layer = 0; layer < numLayers_; layer++) {
+      auto suffix = std::to_string(layer);
+      if (isConv_) {
+        auto *filter = createRandomConstant(mod, ElemKind::Int8QTy,
+                                            {128, 3, 3, 128}, 0.001,
+                                            "filter" + suffix, PRNG);
+        auto *bias = createRandomConstant(mod, ElemKind::Int32QTy, {128},
+                                          0.00005, "bias" + suffix, PRNG);
+        cur = F->createConv("conv" + suffix, cur, filter, bias, outTy, 3, 1,
+                            1, 1);
+      } else {
+        auto *weights = createRandomConstant(mod, ElemKind::Int8QTy,
+                                             {1024, 1024}, 0.001,
+                                             "weights" + suffix, PRNG);
+        auto *bias = createRandomConstant(mod, ElemKind::Int32QTy, {1024},
+                                          0.00005, "bias" + suffix, PRNG);
+        cur = F->createFullyConnected("fc" + suffix, cur, weights, bias,
+                                      outTy);
+      }
+      cur = createActivation(F, cur, "act" + suffix);
+    }
+    auto *save = F->createSave("save", cur);
+    bindings_.allocate(save->getPlaceholder());
+
+    CompilationContext cctx;
+    cctx.optimizationOpts.enableQuantizedEpilogueFusion = fuse_;
+    EE_->compile(cctx);
+  }
+
+  void run() override { EE_->run(bindings_); }
+
+  void teardown() override {}
+
+  double gflops() const {
+    double flopsPerLayer = isConv_ ? 2.0 * 56 * 56 * 128 * 3 * 3 * 128
+                                   : 2.0 * 64 * 1024 * 1024;
+    return flopsPerLayer * numLayers_ / 1e9;
+  }
+};
+
+int main(int argc, char *argv[]) {
+  printf("Int8 Epilogue Fusion Benchmark\n");
+  printf("Usage: Int8EpilogueFusionBench op(conv|fc) "
+         "activation(relu|clip|sigmoid) numLayers(Int) numReps(Int) "
+         "fuse(0|1)\n");
+  assert(argc == 6);
+  const char *op = argv[1];
+  const char *activation = argv[2];
+  size_t numLayers = atoi(argv[3]);
+  size_t numReps = atoi(argv[4]);
+  bool fuse = atoi(argv[5]);
+  assert(!strcmp(op, "conv") || !strcmp(op, "fc"));
+  assert(!strcmp(activation, "relu") || !strcmp(activation, "clip") ||
+         !strcmp(activation, "sigmoid"));
+  assert(numLayers > 0 && numReps > 0);
+
+  Int8EpilogueFusionBench b(!strcmp(op, "conv"), activation, numLayers, fuse);
+  auto times = bench(&b, numReps);
+  double gflops = b.gflops();
+  printf("_,benchName,_,op,activation,numLayers,fuse,numReps,runtime,"
+         "gflopPerSec\n");
+  for (auto t : times) {
+    printf("BenchResult,Int8EpilogueFusionBench,SW,%s,%s,%zu,%d,%zu,%f,%f\n",
+           op, activation, numLayers, fuse, numReps, t, gflops / t);
+  }
+  double min = *(std::min_element(times.begin(), times.end()));
+  size_t midElt = times.size() / 2;
+  std::nth_element(times.begin(), times.begin() + midElt, times.end());
+  double median = times[midElt];
+  printf("_,benchName,_,op,activation,numLayers,fuse,numReps,medianRuntime,"
+         "minRuntime,medianGflopPerSec\n");
+  printf("BenchSummary,Int8EpilogueFusionBench,SW,%s,%s,%zu,%d,%zu,%f,%f,%f\n",
+         op, activation, numLayers, fuse, numReps, median, min,
+         gflops / median);
+}
@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <cstdlib>
+
+#include "Bench.h"
+#include "glow/ExecutionEngine/ExecutionEngine.h"
+#include "glow/Support/Random.h"
+
+using namespace glow;
+
+/*
+ * This class implements a benchmark of the parallel execution of the
+ * Interpreter. It runs a recommendation-system-like model made of numTables
+ * independent embedding tables, each followed by its own tower of three FCs,
+ * merged by a Concat and squared elementwise. The Interpreter device executes
+ * the independent instructions on numThreads threads and splits the kernels
+ * processing at least minParallelWork elements into chunks.
+ */
+class InterpreterParallelBench : public Benchmark {
+  dim_t numTables_;
+  dim_t batch_;
+  unsigned numThreads_;
+  unsigned minParallelWork_;
+  PlaceholderBindings bindings_;
+  std::unique_ptr<runtime::HostManager> hostManager_;
+
+public:
+  InterpreterParallelBench(dim_t numTables, dim_t batch, unsigned numThreads,
+                           unsigned minParallelWork)
+      : numTables_(numTables), batch_(batch), numThreads_(numThreads),
+        minParallelWork_(minParallelWork) {}
+
+  void addEmbeddingTowers(Module *mod, Function *F) {
+    constexpr dim_t numRows = 1000;
+    constexpr dim_t width = 64;
+    const dim_t numIndices = batch_ * 20;
+    PseudoRNG rng;
+    std::vector<NodeValue> towers;
+    for (dim_t t = 0; t < numTables_; t++) {
+      auto name = std::to_string(t);
+      auto *data = mod->createConstant(ElemKind::FloatTy, {numRows, width},
+                                       "data" + name);
+      data->getPayloadMutable().getHandle().randomize(-1, 1, rng);
+      auto *weights = mod->createPlaceholder(ElemKind::FloatTy, {numIndices},
+                                             "weights" + name, false);
+      auto *indices = mod->createPlaceholder(ElemKind::Int64ITy, {numIndices},
+                                             "indices" + name, false);
+      auto *lengths = mod->createPlaceholder(ElemKind::Int32ITy, {batch_},
+                                             "lengths" + name, false);
+      bindings_.allocate(weights)->getHandle().randomize(-1, 1, rng);
+      bindings_.allocate(indices)->getHandle<int64_t>().randomize(
+          0, numRows - 1, rng);
+      bindings_.allocate(lengths)->getHandle<int32_t>().clear(20);
+
+      NodeValue tower = F->createSparseLengthsWeightedSum(
+          "sls" + name, data, weights, indices, lengths);
+      for (unsigned l = 0; l < 3; l++) {
+        auto suffix = name + "_" + std::to_string(l);
+        auto *W = mod->createConstant(ElemKind::FloatTy, {width, width},
+                                      "W" + suffix);
+        auto *B = mod->createConstant(ElemKind::FloatTy, {width}, "B" + suffix);
+        W->getPayloadMutable().getHandle().randomize(-0.1, 0.1, rng);
+        B->getPayloadMutable().getHandle().randomize(-0.1, 0.1, rng);
+        tower =
+            F->createRELU("relu", F->createFullyConnected("fc", tower, W, B));
+      }
+      towers.push_back(tower);
+    }
+    auto *concat = F->createConcat("concat", towers, 1);
+    auto *square = F->createMul("square", concat, concat);
+    auto *save = F->createSave("save", square);
+    bindings_.allocate(save->getPlaceholder());
+  }
+
+  void setup() override {
+    std::vector<std::unique_ptr<runtime::DeviceConfig>> configs;
+    auto config = glow::make_unique<runtime::DeviceConfig>("Interpreter");
+    config->parameters["numThreads"] = std::to_string(numThreads_);
+    config->parameters["minParallelWork"] = std::to_string(minParallelWork_);
+    configs.push_back(std::move(config));
+    hostManager_ = glow::make_unique<runtime::HostManager>(std::move(configs));
+
+    std::unique_ptr<Module> mod(new Module);
+    auto *F = mod->createFunction("main");
+    addEmbeddingTowers(mod.get(), F);
+    CompilationContext cctx;
+    EXIT_ON_ERR(hostManager_->addNetwork(std::move(mod), cctx));
+  }
+
+  void run() override {
+    EXIT_ON_ERR(hostManager_->runNetworkBlocking("main", bindings_));
+  }
+
+  void teardown() override {}
+};
+
+int main(int argc, char *argv[]) {
+  printf("Interpreter Parallel Execution Benchmark\n");
+  printf("Usage: InterpreterParallelBench numTables(Int) batch(Int) "
+         "numThreads(Int) minParallelWork(Int) numReps(Int)\n");
+  assert(argc == 6);
+  size_t numTables = atoi(argv[1]);
+  size_t batch = atoi(argv[2]);
+  unsigned numThreads = atoi(argv[3]);
+  unsigned minParallelWork = atoi(argv[4]);
+  size_t numReps = atoi(argv[5]);
+  assert(numTables > 0 && batch > 0 && numReps > 0);
+  assert(numThreads > 0 && minParallelWork > 0);
+
+  InterpreterParallelBench b(numTables, batch, numThreads, minParallelWork);
+  auto times = bench(&b, numReps);
+  printf("_,benchName,_,numTables,batch,numThreads,minParallelWork,numReps,"
+         "runtime\n");
+  for (auto t : times) {
+    printf("BenchResult,InterpreterParallelBench,SW,%zu,%zu,%u,%u,%zu,%f\n",
+           numTables, batch, numThreads, minParallelWork, numReps, t);
+  }
+  double min = *(std::min_element(times.begin(), times.end()));
+  size_t midElt = times.size() / 2;
+  std::nth_element(times.begin(), times.begin() + midElt, times.end());
+  double median = times[midElt];
+  printf("_,benchName,_,numTables,batch,numThreads,minParallelWork,numReps,"
+         "medianRuntime,minRuntime\n");
+  printf("BenchSummary,InterpreterParallelBench,SW,%zu,%zu,%u,%u,%zu,%f,%f\n",
+         numTables, batch, numThreads, minParallelWork, numReps, median, min);
+}
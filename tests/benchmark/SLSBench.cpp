@@ -32,7 +32,9 @@ using namespace glow;
  * This class implements an SLS microbenchmark. There are a number of
  * parallel FusedRowwiseQuantizedSparseLengthsWeightedSum,
  * FusedRowwiseQuantizedSparseLengthsSum, SparseLengthsWeightedSum, or
- * SparseLengthsSum nodes which are created.
+ * SparseLengthsSum nodes which are created, each over its own table. Backends
+ * supporting it may compute the quantized nodes of all the tables with a
+ * single grouped kernel, which can be disabled to measure its benefit.
  *
  * Microbenchmarks are generally useful for understanding performance
  * through targeted experiementation and are not representative of
@@ -61,6 +63,7 @@ struct SLSParam {
   bool isSorted;
   bool addClip;
   bool useFP16Accumulation;
+  bool groupSLS;
   ElemKind fusedDtype;
   ElemKind dtype;
 };
@@ -118,6 +121,11 @@ public:
             (param.numSLSNodes * batchSize_ * param.numIndicesPerBatch *
              (param.numElementsPerRow + 2 * elementSize)) /
             1e9;
+      } else if (param.fusedDtype == ElemKind::UInt8FusedQTy) {
+        input_gbytes +=
+            (param.numSLSNodes * batchSize_ * param.numIndicesPerBatch *
+             (param.numElementsPerRow + 2 * sizeof(float))) /
+            1e9;
       } else { // Int4
         input_gbytes +=
             (param.numSLSNodes * batchSize_ * param.numIndicesPerBatch *
@@ -164,7 +172,10 @@ public:
         // For 4bit tables the number of bytes should be halved (rounded up).
         numBytePerRow = (numBytePerRow + 1) / 2;
       }
-      const dim_t numTotalColumns = numBytePerRow + 2 * sizeof(float16_t);
+      const dim_t scaleOffsetSize = param.fusedDtype == ElemKind::UInt8FusedQTy
+                                        ? sizeof(float)
+                                        : sizeof(float16_t);
+      const dim_t numTotalColumns = numBytePerRow + 2 * scaleOffsetSize;
       dataConstantTensor = Tensor(
           param.fusedDtype, {param.numTableEntries, numTotalColumns}, 1.0, 0);
     }
@@ -304,6 +315,7 @@ public:
 
     fn->dumpDAG("slsbench.dot");
     CompilationContext ctx;
+    ctx.optimizationOpts.enableSLSGrouping = params_.front().groupSLS;
     EXIT_ON_ERR(hostManager_->addNetwork(std::move(mod), ctx));
   }
 
@@ -351,6 +363,7 @@ public:
 #define ROWWISE_QUANT 14
 #define ACCUM_TYPE 15
 #define DEVICE_ID 16
+#define GROUP_SLS 17
 
 SLSParam parseArgs(int argc, char *argv[]) {
   SLSParam param;
@@ -412,6 +425,8 @@ SLSParam parseArgs(int argc, char *argv[]) {
     printf("fusedDtype%s\n", argv[ROWWISE_QUANT]);
     if (std::string(argv[ROWWISE_QUANT]) == "Int8") {
       param.fusedDtype = ElemKind::UInt8FusedFP16QTy;
+    } else if (std::string(argv[ROWWISE_QUANT]) == "Int8FP32") {
+      param.fusedDtype = ElemKind::UInt8FusedQTy;
     } else if (std::string(argv[ROWWISE_QUANT]) == "Int4") {
       param.fusedDtype = ElemKind::UInt4FusedFP16QTy;
     } else {
@@ -438,6 +453,18 @@ SLSParam parseArgs(int argc, char *argv[]) {
   } else {
     param.devId = std::string("");
   }
+  if (argc > GROUP_SLS) {
+    printf("groupSLS %s\n", argv[GROUP_SLS]);
+    if (std::string(argv[GROUP_SLS]) == "True") {
+      param.groupSLS = true;
+    } else if (std::string(argv[GROUP_SLS]) == "False") {
+      param.groupSLS = false;
+    } else {
+      llvm_unreachable("Invalid groupSLS");
+    }
+  } else {
+    param.groupSLS = false;
+  }
   printf("\n\n");
   return param;
 }
@@ -455,9 +482,12 @@ int main(int argc, char *argv[]) {
          "sortedStr(\"Sorted\"|\"Unsorted\") backendStr(String) "
          "dtypeStr(\"Float16\"|\"Float32\") "
          "addClipStr(\"True\"|\"False\")\nQuantized only options: "
-         "quantizationDtypeStr(\"Int8\"|\"Int4\") "
+         "quantizationDtypeStr(\"Int8\"|\"Int8FP32\"|\"Int4\") "
          "useFP16AccumulationStr(\"True\"|\"False\") \n"
-         "Optional: dev_id(Int)\n");
+         "Optional: dev_id(Int) groupSLSStr(\"True\"|\"False\")\n"
+         "Int8FP32 tables have float scales and offsets, as supported by the "
+         "CPU backend. The tables of the numSLSNodes nodes are grouped into a "
+         "single kernel if groupSLSStr is True.\n");
   printf("\n");
 
   std::vector<SLSParam> params;
@@ -499,16 +529,17 @@ int main(int argc, char *argv[]) {
         "numTableEntries,"
         "numElementsPerRow,numReps,numAsyncLaunches,numSLSNodes,slsKindStr,"
         "backendStr,dtypeStr,addClipStr,quantizationDtypeStr,"
-        "useFP16AccumulationStr");
+        "useFP16AccumulationStr,groupSLSStr");
     runPrefix = std::string(strFormat(
         "SLSBench,SW,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%s,%s,%s,%"
         "s,%s,%"
-        "s,%s",
+        "s,%s,%s",
         (size_t)param.batchSize, (size_t)param.numIndicesPerBatch,
         (size_t)param.numIndicesPerBatchPad, (size_t)param.numTableEntries,
         (size_t)param.numElementsPerRow, (size_t)param.numReps,
         (size_t)param.numAsyncLaunches, (size_t)param.numSLSNodes, argv[9],
-        argv[10], argv[11], argv[12], argv[13], argv[14], argv[15]));
+        argv[10], argv[11], argv[12], argv[13], argv[14], argv[15],
+        param.groupSLS ? "True" : "False"));
   } else {
     llvm_unreachable("Invalid command line");
   }
@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <future>
+
+#include "Bench.h"
+#include "glow/ExecutionEngine/ExecutionEngine.h"
+#include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
+
+using namespace glow;
+
+/*
+ * This class implements a microbenchmark of sibling FullyConnected nodes, as
+ * found in the towers of multi-task models. A set of numFCs FCs computing
+ * (m x k) * (k x n) = (m x n) all read the same input. With horizontal FC
+ * fusion enabled, the optimizer merges them into a single wide FC, i.e. a
+ * single (m x k) * (k x (numFCs * n)) GEMM, followed by Slices. The benchmark
+ * is meant for small m, where each of the sibling GEMMs underutilizes the
+ * hardware.
+ */
+
+struct SiblingFCParam {
+  dim_t m_;
+  dim_t n_;
+  dim_t k_;
+  dim_t numFCs_;
+  dim_t numReps_;
+  dim_t numAsyncLaunches_;
+  bool merge_;
+  bool rowwiseQuantized_;
+  std::string backendStr_;
+};
+
+class SiblingFCBench : public Benchmark {
+  SiblingFCParam param_;
+  std::unique_ptr<runtime::HostManager> hostManager_;
+
+public:
+  explicit SiblingFCBench(SiblingFCParam param_) : param_(param_) {}
+
+  void addSiblingFCNodes(Module *mod, Function *fn) {
+    Placeholder *input;
+    if (param_.rowwiseQuantized_) {
+      input = mod->createPlaceholder(
+          ElemKind::Int8QTy, {param_.m_, param_.k_}, 1.0, 0, "input", false);
+    } else {
+      input = mod->createPlaceholder(ElemKind::FloatTy, {param_.m_, param_.k_},
+                                     "input", false);
+    }
+
+    for (dim_t i = 0; i < param_.numFCs_; i++) {
+      auto suffix = std::to_string(i);
+      Node *fc;
+      if (param_.rowwiseQuantized_) {
+        auto *weights = mod->createConstant(
+            ElemKind::FloatTy, {param_.n_, param_.k_}, "weights" + suffix);
+        weights->getPayloadMutable().getHandle<float>().randomize(
+            -1.0, 1.0, mod->getPRNG());
+        auto *bias = mod->createConstant(ElemKind::Int32QTy, {param_.n_}, 1.0,
+                                         0, "bias" + suffix);
+        bias->getPayloadMutable().getHandle<int32_t>().clear(2);
+        auto *outTy =
+            mod->uniqueType(ElemKind::Int8QTy, {param_.m_, param_.n_}, 1.0, 0);
+        fc = fn->createRowwiseQuantizedFullyConnected(
+            "fc" + suffix, input, weights, bias, outTy,
+            quantization::Schema::Asymmetric);
+      } else {
+        auto *weights = mod->createConstant(
+            ElemKind::FloatTy, {param_.k_, param_.n_}, "weights" + suffix);
+        weights->getPayloadMutable().getHandle<float>().clear(1.0);
+        auto *bias = mod->createConstant(ElemKind::FloatTy, {param_.n_},
+                                         "bias" + suffix);
+        bias->getPayloadMutable().getHandle<float>().clear(32);
+        fc = fn->createFullyConnected("fc" + suffix, input, weights, bias);
+      }
+      fn->createSave("save" + suffix, fc);
+    }
+  }
+
+  void setup() override {
+    // Setup host manager
+    std::vector<std::unique_ptr<runtime::DeviceConfig>> configs;
+    auto config =
+        glow::make_unique<runtime::DeviceConfig>(param_.backendStr_.c_str());
+    configs.push_back(std::move(config));
+    hostManager_ = glow::make_unique<runtime::HostManager>(std::move(configs));
+
+    std::unique_ptr<Module> mod(new Module);
+    auto fn = mod->createFunction("singleNode");
+    addSiblingFCNodes(mod.get(), fn);
+
+    CompilationContext ctx;
+    ctx.optimizationOpts.enableHorizontalFCFusion = param_.merge_;
+    EXIT_ON_ERR(hostManager_->addNetwork(std::move(mod), ctx));
+  }
+
+  void run() override {
+    std::vector<std::promise<void>> promises(param_.numAsyncLaunches_);
+    std::vector<std::future<void>> futures;
+
+    // Launch a number of independent requests
+    for (auto &runPromise : promises) {
+      std::unique_ptr<ExecutionContext> contextPtr(new ExecutionContext);
+      futures.push_back(runPromise.get_future());
+      hostManager_->runNetwork(
+          "singleNode", std::move(contextPtr),
+          [&runPromise](runtime::RunIdentifierTy, Error err,
+                        std::unique_ptr<ExecutionContext> /* contextPtr */) {
+            EXIT_ON_ERR(std::move(err));
+            runPromise.set_value();
+          });
+    }
+    for (auto &fut : futures) {
+      fut.wait();
+    }
+  }
+
+  void teardown() override {}
+
+  double gflops() const {
+    return 2.0 * param_.m_ * param_.n_ * param_.k_ * param_.numFCs_ / 1e9;
+  }
+};
+
+int main(int argc, char *argv[]) {
+  printf("Sibling FC Microbenchmark\n");
+  printf("Usage: SiblingFCBench m(Int) n(Int) k(Int) numFCs(Int) numReps(Int) "
+         "numAsyncLaunches(Int) merge(0|1) backendStr(String) "
+         "dtypeStr(\"Float32\"|\"Int8Rowwise\")\n");
+  assert(argc == 10);
+
+  SiblingFCParam param;
+  param.m_ = atoi(argv[1]);
+  param.n_ = atoi(argv[2]);
+  param.k_ = atoi(argv[3]);
+  param.numFCs_ = atoi(argv[4]);
+  param.numReps_ = atoi(argv[5]);
+  param.numAsyncLaunches_ = atoi(argv[6]);
+  param.merge_ = atoi(argv[7]) != 0;
+  param.backendStr_ = std::string(argv[8]);
+  if (std::string(argv[9]) == "Float32") {
+    param.rowwiseQuantized_ = false;
+  } else if (std::string(argv[9]) == "Int8Rowwise") {
+    param.rowwiseQuantized_ = true;
+  } else {
+    llvm_unreachable("Invalid dtype");
+  }
+  assert(param.numReps_ > 0);
+
+  SiblingFCBench b(param);
+  auto times = bench(&b, param.numReps_);
+  std::string runPrefix = strFormat(
+      "SiblingFCBench,SW,%zu,%zu,%zu,%zu,%zu,%zu,%d,%s,%s", (size_t)param.m_,
+      (size_t)param.n_, (size_t)param.k_, (size_t)param.numFCs_,
+      (size_t)param.numReps_, (size_t)param.numAsyncLaunches_,
+      int(param.merge_), argv[8], argv[9]);
+
+  printf("_,benchName,_,m,n,k,numFCs,numReps,numAsyncLaunches,merge,"
+         "backendStr,dtypeStr,runtime,gflopPerSec\n");
+  for (auto t : times) {
+    printf("BenchResult,%s,%f,%f\n", runPrefix.c_str(),
+           t / param.numAsyncLaunches_,
+           b.gflops() * param.numAsyncLaunches_ / t);
+  }
+  double min = *(std::min_element(times.begin(), times.end()));
+  dim_t midElt = times.size() / 2;
+  std::nth_element(times.begin(), times.begin() + midElt, times.end());
+  double median = times[midElt];
+  double medianRuntime = median / ((double)param.numAsyncLaunches_);
+  double minRuntime = min / ((double)param.numAsyncLaunches_);
+  printf("_,benchName,_,m,n,k,numFCs,numReps,numAsyncLaunches,merge,"
+         "backendStr,dtypeStr,medianRuntime,minRuntime,medianGflopPerSec,"
+         "maxGflopPerSec\n");
+  printf("BenchSummary,%s,%f,%f,%f,%f\n", runPrefix.c_str(), medianRuntime,
+         minRuntime, b.gflops() / medianRuntime, b.gflops() / minRuntime);
+}
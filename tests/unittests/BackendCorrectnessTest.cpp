@@ -535,4 +535,96 @@ TEST_P(BackendCorrectnessTest, maxSplatTest) {
   EXPECT_TRUE(out1.isEqual(out2));
 }
 
+/// Compile and run \p F, whose input \p inputP is set to \p input, with
+/// the fusion of the quantized epilogues enabled if \p fuse, and \returns the
+/// result saved by \p save.
+static Tensor runQuantizedEpilogueNet(ExecutionEngine &EE, Placeholder *inputP,
+                                      Tensor *input, SaveNode *save,
+                                      bool fuse) {
+  PlaceholderBindings bindings;
+  auto *resultTensor = bindings.allocate(save->getPlaceholder());
+  CompilationContext cctx;
+  cctx.optimizationOpts.enableQuantizedEpilogueFusion = fuse;
+  EE.compile(cctx);
+  updateInputPlaceholders(bindings, {inputP}, {input});
+  EE.run(bindings);
+  return resultTensor->clone();
+}
+
+// Test the fusion of activations into the epilogue of quantized convolutions.
+TEST_P(BackendCorrectnessTest, quantizedConvActivationFusionTest) {
+  CHECK_IF_ENABLED();
+  PseudoRNG PRNG;
+  Tensor input(ElemKind::Int8QTy, {2, 9, 9, 16}, 0.025, -7);
+  Tensor filter(ElemKind::Int8QTy, {16, 3, 3, 16}, 0.003, 3);
+  Tensor bias(ElemKind::Int32QTy, {16}, 0.0001, 2);
+  input.getHandle<int8_t>().randomize(-128, 127, PRNG);
+  filter.getHandle<int8_t>().randomize(-128, 127, PRNG);
+  bias.getHandle<int32_t>().randomize(-1000, 1000, PRNG);
+
+  Tensor outs[2];
+  for (bool fuse : {false, true}) {
+    ExecutionEngine EE(backendName_);
+    auto &mod = EE.getModule();
+    Function *F = mod.createFunction("main");
+    auto *inputP = mod.createPlaceholder(&input.getType(), "input", false);
+    auto *filterC = mod.createConstant("filter", filter.clone());
+    auto *biasC = mod.createConstant("bias", bias.clone());
+    auto *convTy = mod.uniqueType(ElemKind::Int8QTy, {2, 9, 9, 16}, 0.05, -17);
+    auto *conv =
+        F->createConv("conv", inputP, filterC, biasC, convTy, 3, 1, 1, 1);
+    auto *clip = F->createClip("clip", conv, -2.f, 4.f);
+    auto *sigmoidTy =
+        mod.uniqueType(ElemKind::Int8QTy, convTy->dims(), 1.f / 256, -128);
+    auto *sigmoid = F->createIntSigmoid("sigmoid", clip, sigmoidTy);
+    auto *save = F->createSave("ret", sigmoid);
+    outs[fuse] = runQuantizedEpilogueNet(EE, inputP, &input, save, fuse);
+#ifdef GLOW_WITH_CPU
+    if (backendName_ == "CPU") {
+      EXPECT_EQ(
+          countNodeKind(F, Kinded::Kind::CPUFusedQuantizedConvNodeKind),
+          fuse ? 1 : 0);
+    }
+#endif
+  }
+
+  EXPECT_TRUE(outs[0].isEqual(outs[1]));
+}
+
+// Test the fusion of activations into the epilogue of quantized
+// FullyConnecteds, which also removes the rounding of the MatMul result.
+TEST_P(BackendCorrectnessTest, quantizedFCActivationFusionTest) {
+  CHECK_IF_ENABLED();
+  PseudoRNG PRNG;
+  Tensor input(ElemKind::Int8QTy, {4, 96}, 0.025, -7);
+  Tensor weights(ElemKind::Int8QTy, {96, 80}, 0.003, 3);
+  Tensor bias(ElemKind::Int32QTy, {80}, 0.0001, 2);
+  input.getHandle<int8_t>().randomize(-128, 127, PRNG);
+  weights.getHandle<int8_t>().randomize(-128, 127, PRNG);
+  bias.getHandle<int32_t>().randomize(-1000, 1000, PRNG);
+
+  Tensor outs[2];
+  for (bool fuse : {false, true}) {
+    ExecutionEngine EE(backendName_);
+    auto &mod = EE.getModule();
+    Function *F = mod.createFunction("main");
+    auto *inputP = mod.createPlaceholder(&input.getType(), "input", false);
+    auto *weightsC = mod.createConstant("weights", weights.clone());
+    auto *biasC = mod.createConstant("bias", bias.clone());
+    auto *fcTy = mod.uniqueType(ElemKind::Int8QTy, {4, 80}, 0.02, 5);
+    auto *FC = F->createFullyConnected("fc", inputP, weightsC, biasC, fcTy);
+    auto *relu = F->createRELU("relu", FC);
+    auto *save = F->createSave("ret", relu);
+    outs[fuse] = runQuantizedEpilogueNet(EE, inputP, &input, save, fuse);
+#ifdef GLOW_WITH_CPU
+    if (backendName_ == "CPU") {
+      EXPECT_EQ(countNodeKind(F, Kinded::Kind::CPUFusedQuantizedFCNodeKind),
+                fuse ? 1 : 0);
+    }
+#endif
+  }
+
+  EXPECT_TRUE(outs[0].isEqual(outs[1], 1.0));
+}
+
 INSTANTIATE_BACKEND_TEST(BackendCorrectnessTest);
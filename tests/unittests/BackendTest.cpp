@@ -17,6 +17,7 @@
 
 #include "glow/Backend/BackendUtils.h"
 #include "glow/Backends/Interpreter/Interpreter.h"
+#include "glow/Backends/Interpreter/InterpreterFunction.h"
 #include "glow/Base/TensorSerialization.h"
 #include "glow/ExecutionEngine/ExecutionEngine.h"
 #include "glow/Graph/Graph.h"
@@ -32,6 +33,7 @@
 #include "llvm/Support/FileSystem.h"
 
 #include <future>
+#include <thread>
 
 using namespace glow;
 
@@ -286,6 +288,100 @@ TEST(Interpreter, DynamicBackendFactory) {
   }
 }
 
+/// Check that the Interpreter carves activations out of arenas laid out by the
+/// activations memory plan, and that it reuses them across runs instead of
+/// allocating activations for every run.
+TEST(Interpreter, ActivationsArenaReuse) {
+  Module mod;
+  Function *F = mod.createFunction("main");
+  PseudoRNG rng;
+  auto *input =
+      mod.createPlaceholder(ElemKind::FloatTy, {8, 256}, "input", false);
+  NodeValue cur = input;
+  for (unsigned l = 0; l < 6; l++) {
+    auto *W = mod.createConstant(ElemKind::FloatTy, {256, 256},
+                                 "W" + std::to_string(l));
+    auto *B =
+        mod.createConstant(ElemKind::FloatTy, {256}, "B" + std::to_string(l));
+    W->getPayloadMutable().getHandle().randomize(-0.1, 0.1, rng);
+    B->getPayloadMutable().getHandle().randomize(-0.1, 0.1, rng);
+    cur = F->createRELU("relu", F->createFullyConnected("fc", cur, W, B));
+  }
+  auto *save = F->createSave("save", cur);
+
+  Interpreter backend;
+  CompilationContext cctx;
+  cctx.compMode = CompilationMode::Infer;
+  EXIT_ON_ERR(glow::optimizeFunction(F, backend, cctx));
+  auto IR = glow::generateAndOptimizeIR(F, backend, false);
+  uint64_t totalActivationsSize = 0;
+  for (const auto &I : IR->getInstrs()) {
+    if (auto *A = llvm::dyn_cast<AllocActivationInst>(&I)) {
+      totalActivationsSize += A->getSizeInBytes();
+    }
+  }
+  auto compiledF = backend.compileIR(std::move(IR));
+  auto *interpreterF = static_cast<InterpreterFunction *>(compiledF.get());
+  uint64_t activationsSize =
+      compiledF->getRuntimeBundle().getActivationsSize();
+
+  PlaceholderBindings bindings;
+  bindings.allocate(input)->getHandle().randomize(-1, 1, rng);
+  bindings.allocate(save->getPlaceholder());
+
+  // Sequential runs share a single arena.
+  std::vector<Tensor> results;
+  for (unsigned run = 0; run < 5; run++) {
+    ExecutionContext context(
+        glow::make_unique<PlaceholderBindings>(bindings.clone()));
+    FAIL_TEST_IF_ERR(compiledF->execute(&context));
+    results.push_back(
+        context.getPlaceholderBindings()->get(save->getPlaceholder())->clone());
+  }
+  EXPECT_EQ(interpreterF->getNumRunSlots(), 1u);
+  EXPECT_EQ(interpreterF->getPeakActivationsMemory(), activationsSize);
+  EXPECT_LT(activationsSize, totalActivationsSize);
+  // The layers form a chain, so at most the input and the output of an
+  // instruction, plus a broadcast operand of a lowered layer, are live at a
+  // time. The arena must not grow with the number of layers.
+  const uint64_t layerActivationSize = 8 * 256 * sizeof(float);
+  EXPECT_LE(activationsSize, 3 * layerActivationSize);
+  for (const auto &result : results) {
+    EXPECT_TRUE(results[0].isBitwiseEqual(result));
+  }
+
+  // Concurrent runs need one arena each.
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < 2; t++) {
+    threads.emplace_back([&]() {
+      ExecutionContext context(
+          glow::make_unique<PlaceholderBindings>(bindings.clone()));
+      FAIL_TEST_IF_ERR(compiledF->execute(&context));
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_LE(interpreterF->getNumRunSlots(), 2u);
+  EXPECT_LE(interpreterF->getPeakActivationsMemory(), 2 * activationsSize);
+}
+
+/// Check that compiling for the Interpreter fails if the interpreter-memory
+/// option is not a positive number of kilobytes.
+TEST(Interpreter, InvalidMemoryOption) {
+  Module mod;
+  Function *F = mod.createFunction("main");
+  auto *input = mod.createPlaceholder(ElemKind::FloatTy, {4}, "input", false);
+  F->createSave("save", F->createRELU("relu", input));
+
+  Interpreter backend;
+  for (const char *memory : {"0", "-4", "lots"}) {
+    BackendOptions opts;
+    opts.backendSpecificOpts["interpreter-memory"] = memory;
+    EXPECT_TRUE(ERR_TO_BOOL(backend.compile(F, opts).takeError())) << memory;
+  }
+}
+
 /// Test that the symbol category for a symbol is properly set.
 TEST(RuntimeBundle, BundleSymbolInfo) {
 
@@ -426,6 +522,195 @@ TEST(RuntimeBundle, ContiguousPlaceholder) {
   EXPECT_EQ(flag, true);
 }
 
+/// Test that constants saved into a weights file and memory-mapped back have
+/// the same layout and content as the constants collected into memory, and
+/// that the file is only valid for the constants it was saved from.
+TEST(RuntimeBundle, MapConstants) {
+  Module mod;
+  Function *F = mod.createFunction("main");
+  auto *input = mod.createPlaceholder(ElemKind::FloatTy, {4, 10}, "in", false);
+  auto *W = mod.createConstant(ElemKind::FloatTy, {10, 7}, "W");
+  auto *B = mod.createConstant(ElemKind::FloatTy, {7}, "B");
+  auto *idx = mod.createConstant(ElemKind::Int64ITy, {3}, "idx");
+  W->getPayloadMutable().getHandle().randomize(-1.0, 1.0, mod.getPRNG());
+  B->getPayloadMutable().getHandle().randomize(-1.0, 1.0, mod.getPRNG());
+  idx->getPayloadMutable().getHandle<int64_t>() = {2, 0, 1};
+  auto *FC = F->createFullyConnected("FC", input, W, B);
+  auto *G = F->createGather("gather", FC, idx);
+  F->createSave("ret", G);
+
+  auto collected = runtime::RuntimeBundle::create(*F);
+  auto mapped = runtime::RuntimeBundle::create(*F);
+  ASSERT_GT(collected.getConstantWeightSize(), 0);
+  collected.collectConstants(&mod);
+
+  llvm::SmallString<64> path;
+  ASSERT_FALSE(
+      llvm::sys::fs::createTemporaryFile("constants", "weights", path));
+  ASSERT_FALSE(ERR_TO_BOOL(mapped.saveConstants(&mod, path)));
+  ASSERT_FALSE(ERR_TO_BOOL(mapped.mapConstants(path)));
+  EXPECT_TRUE(mapped.isConstantsMapped());
+  EXPECT_FALSE(collected.isConstantsMapped());
+  ASSERT_NE(mapped.getConstants(), nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(mapped.getConstants()) %
+                TensorAlignment,
+            0);
+  for (const auto *C : {W, B, idx}) {
+    size_t offset = mapped.getValueOffset(C);
+    EXPECT_EQ(offset, collected.getValueOffset(C));
+    EXPECT_EQ(memcmp(mapped.getConstants() + offset,
+                     C->getPayload().getUnsafePtr(),
+                     C->getPayload().getSizeInBytes()),
+              0);
+  }
+  EXPECT_TRUE(mapped.isConstantsFileValid(&mod, path));
+
+  collected.freeConstants();
+  mapped.freeConstants();
+  EXPECT_FALSE(mapped.isConstantsMapped());
+  EXPECT_EQ(mapped.getConstants(), nullptr);
+
+  // The file no longer matches once a constant changes.
+  B->getPayloadMutable().getHandle().raw(3) += 1.0;
+  EXPECT_FALSE(mapped.isConstantsFileValid(&mod, path));
+  llvm::sys::fs::remove(path);
+}
+
+/// Create a convolution of \p input into \p outChannels channels with a 3x3
+/// kernel in \p F, whose filter and bias are Constants.
+static NodeValue createConvWithConstants(Function *F, NodeValue input,
+                                         dim_t outChannels) {
+  auto &mod = *F->getParent();
+  auto dims = input.dims();
+  auto *filter = mod.createConstant(ElemKind::FloatTy,
+                                    {outChannels, 3, 3, dims[3]}, "filter");
+  auto *bias = mod.createConstant(ElemKind::FloatTy, {outChannels}, "bias");
+  auto *outTy = mod.uniqueType(ElemKind::FloatTy,
+                               {dims[0], dims[1], dims[2], outChannels});
+  return F->createConv("conv", input, filter, bias, outTy, 3, 1, 1, 1);
+}
+
+/// Create a network of fully connected layers of varying widths in \p F.
+static void createMLP(Function *F) {
+  auto &mod = *F->getParent();
+  NodeValue cur =
+      mod.createPlaceholder(ElemKind::FloatTy, {8, 64}, "input", false);
+  for (dim_t width : {256, 1024, 64, 512, 128, 2048, 16}) {
+    auto *W =
+        mod.createConstant(ElemKind::FloatTy, {cur.dims()[1], width}, "W");
+    auto *B = mod.createConstant(ElemKind::FloatTy, {width}, "B");
+    cur = F->createRELU("relu", F->createFullyConnected("fc", cur, W, B));
+  }
+  F->createSave("save", cur);
+}
+
+/// Create a chain of residual blocks with expanded intermediate activations
+/// and downsampling in between in \p F.
+static void createResidualCNN(Function *F) {
+  auto &mod = *F->getParent();
+  NodeValue cur =
+      mod.createPlaceholder(ElemKind::FloatTy, {1, 32, 32, 8}, "input", false);
+  for (unsigned i = 0; i < 3; i++) {
+    auto *expanded = F->createRELU("relu", createConvWithConstants(F, cur, 48));
+    auto projected = createConvWithConstants(F, expanded, cur.dims()[3]);
+    cur = F->createRELU("relu", F->createAdd("add", cur, projected));
+    cur = F->createMaxPool("pool", cur, 2, 2, 0)->getResult();
+    cur = createConvWithConstants(F, cur, cur.dims()[3] * 2);
+  }
+  F->createSave("save", cur);
+}
+
+/// Create an inception-like network in \p F, whose modules concatenate
+/// branches of different depths and sizes.
+static void createBranchyCNN(Function *F) {
+  auto &mod = *F->getParent();
+  NodeValue cur =
+      mod.createPlaceholder(ElemKind::FloatTy, {1, 16, 16, 16}, "input", false);
+  for (unsigned i = 0; i < 3; i++) {
+    auto branch1 = createConvWithConstants(F, cur, 8);
+    auto branch2 = createConvWithConstants(
+        F, F->createRELU("relu", createConvWithConstants(F, cur, 64)), 16);
+    auto branch3 = createConvWithConstants(
+        F,
+        createConvWithConstants(
+            F, F->createRELU("relu", createConvWithConstants(F, cur, 4)), 32),
+        8);
+    cur = F->createConcat("concat", {branch1, branch2, branch3}, 3);
+  }
+  F->createSave("save", cur);
+}
+
+/// Compare the activation memory plans produced by the planning strategies
+/// for the IR of several networks: every plan must keep simultaneously live
+/// activations apart, and the best plan must be the smaller of the first-fit
+/// and greedy-by-size plans.
+TEST(RuntimeBundle, PlanActivationsMemoryOfModels) {
+  auto &options = llvm::cl::getRegisteredOptions();
+  ASSERT_TRUE(options.count("activations-memory-planner"));
+  auto *plannerOpt = static_cast<llvm::cl::opt<MemoryPlanningStrategy> *>(
+      options["activations-memory-planner"]);
+
+  for (auto *createModel : {createMLP, createResidualCNN, createBranchyCNN}) {
+    Module mod;
+    Function *F = mod.createFunction("main");
+    createModel(F);
+    Interpreter backend;
+    CompilationContext cctx;
+    cctx.compMode = CompilationMode::Infer;
+    EXIT_ON_ERR(glow::optimizeFunction(F, backend, cctx));
+    auto IR = glow::generateAndOptimizeIR(F, backend, true);
+    const auto &instrs = IR->getInstrs();
+
+    // Collect the lifetimes of the activations and their total size.
+    std::unordered_map<const AllocActivationInst *, std::pair<size_t, size_t>>
+        lifetimes;
+    uint64_t totalSize = 0;
+    size_t idx = 0;
+    for (const auto &I : instrs) {
+      if (auto *A = llvm::dyn_cast<AllocActivationInst>(&I)) {
+        lifetimes[A] = {idx, instrs.size()};
+        totalSize += A->getSizeInBytes();
+      } else if (auto *D = llvm::dyn_cast<DeallocActivationInst>(&I)) {
+        lifetimes[llvm::cast<AllocActivationInst>(D->getAlloc())].second = idx;
+      }
+      idx++;
+    }
+    ASSERT_GT(lifetimes.size(), 2);
+
+    std::map<MemoryPlanningStrategy, uint64_t> peaks;
+    for (auto strategy :
+         {MemoryPlanningStrategy::FirstFit,
+          MemoryPlanningStrategy::GreedyBySize, MemoryPlanningStrategy::Best}) {
+      *plannerOpt = strategy;
+      MemoryAllocator allocator("activations", 0);
+      auto addresses = planActivationsMemory(instrs, allocator);
+      ASSERT_EQ(addresses.size(), lifetimes.size());
+      for (const auto &a : lifetimes) {
+        for (const auto &b : lifetimes) {
+          if (a.first >= b.first || a.second.second < b.second.first ||
+              b.second.second < a.second.first) {
+            continue;
+          }
+          uint64_t addrA = addresses[a.first];
+          uint64_t addrB = addresses[b.first];
+          EXPECT_TRUE(addrA + a.first->getSizeInBytes() <= addrB ||
+                      addrB + b.first->getSizeInBytes() <= addrA)
+              << a.first->getName().str() << " overlaps "
+              << b.first->getName().str();
+        }
+      }
+      peaks[strategy] = allocator.getMaxMemoryUsage();
+    }
+    *plannerOpt = MemoryPlanningStrategy::Best;
+
+    EXPECT_EQ(peaks[MemoryPlanningStrategy::Best],
+              std::min(peaks[MemoryPlanningStrategy::FirstFit],
+                       peaks[MemoryPlanningStrategy::GreedyBySize]));
+    // Reusing memory of dead activations beats keeping all of them alive.
+    EXPECT_LT(peaks[MemoryPlanningStrategy::Best], totalSize);
+  }
+}
+
 TEST_P(BackendExecTest, simpleInference) {
   Tensor inputs(ElemKind::FloatTy, {1, 32, 32, 3});
   PlaceholderBindings bindings;
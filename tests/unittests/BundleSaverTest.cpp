@@ -23,6 +23,9 @@
 
 #include "gtest/gtest.h"
 
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+
 using namespace glow;
 
 /// Test BundleSaver. This unit test is for code coverage.
@@ -74,3 +77,55 @@ TEST(BundleSaver, testSaveMultipleFunctions) {
   bundleEntries.emplace_back(BundleEntry{"testMainEntry2", F2});
   backend->saveFunctions(bundleEntries, outputDir, bundleName);
 }
+
+/// \returns the content of the file \p fileName.
+static std::string readFile(llvm::StringRef fileName) {
+  auto buffer = llvm::MemoryBuffer::getFile(fileName);
+  EXPECT_TRUE(bool(buffer)) << "Could not read " << fileName.str();
+  return buffer ? (*buffer)->getBuffer().str() : "";
+}
+
+/// Test saving a bundle whose heavy kernels are split across a parallel-for
+/// callback, and that the BundleConfig of the other bundles is unchanged. The
+/// outputs of such a bundle are checked by the bundle_with_parallel_for
+/// example.
+TEST(BundleSaver, testParallelFor) {
+  auto &options = llvm::cl::getRegisteredOptions();
+  ASSERT_TRUE(options.count("bundle-parallel-for"));
+  ASSERT_TRUE(options.count("bundle-api"));
+  auto *parallelForOpt =
+      static_cast<llvm::cl::opt<bool> *>(options["bundle-parallel-for"]);
+  auto *bundleAPIOpt = options["bundle-api"];
+  bundleAPIOpt->addOccurrence(0, "bundle-api", "dynamic");
+
+  Module M;
+  Function *F = M.createFunction("F");
+  // Create a graph with a convolution and a big data-parallel kernel.
+  auto *input =
+      M.createPlaceholder(ElemKind::FloatTy, {1, 16, 16, 8}, "input", false);
+  auto *filter = M.createConstant(ElemKind::FloatTy, {64, 3, 3, 8}, "filter");
+  auto *bias = M.createConstant(ElemKind::FloatTy, {64}, "bias");
+  auto *outTy = M.uniqueType(ElemKind::FloatTy, {1, 16, 16, 64});
+  auto *conv = F->createConv("conv", input, filter, bias, outTy, 3, 1, 1, 1);
+  auto *relu = F->createRELU("relu", conv);
+  F->createSave("output", relu);
+
+  // Save the bundle without and with the parallel-for callback. Only the
+  // latter has the parallel-for fields in its config.
+  llvm::StringRef outputDir = ".";
+  llvm::StringRef bundleName = "testBundle";
+  llvm::StringRef mainEntryName = "testMainEntry";
+  std::unique_ptr<Backend> backend(createBackend("CPU"));
+  for (bool parallelFor : {false, true}) {
+    *parallelForOpt = parallelFor;
+    backend->save(F, outputDir, bundleName, mainEntryName);
+    std::string header = readFile("./testBundle.h");
+    EXPECT_NE(header.find("const SymbolTableEntry *symbolTable;"),
+              std::string::npos);
+    EXPECT_EQ(header.find("GlowParallelFor parallelFor;") != std::string::npos,
+              parallelFor);
+  }
+
+  *parallelForOpt = false;
+  bundleAPIOpt->addOccurrence(0, "bundle-api", "static");
+}
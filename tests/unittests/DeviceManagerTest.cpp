@@ -21,6 +21,10 @@
 #include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
 #include "glow/Runtime/RuntimeTypes.h"
 
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
 #include "gtest/gtest.h"
 
 #include <chrono>
@@ -968,4 +972,240 @@ TEST_P(DeviceManagerTest, TensorCopyRawToDevice) {
   }
 }
 
+/// Creates a recommendation-system-like module: a number of independent
+/// embedding tables, each followed by its own FC tower, merged by a Concat
+/// and squared elementwise. The inputs of the module are allocated and
+/// randomized in \p bindings.
+static std::unique_ptr<Module>
+makeEmbeddingTowersModule(PlaceholderBindings &bindings) {
+  constexpr unsigned numTables = 8;
+  constexpr dim_t numRows = 1000;
+  constexpr dim_t width = 64;
+  constexpr dim_t batch = 16;
+  constexpr dim_t numIndices = batch * 20;
+
+  auto module = glow::make_unique<Module>();
+  Function *F = module->createFunction("main");
+  PseudoRNG rng;
+  std::vector<NodeValue> towers;
+  for (unsigned t = 0; t < numTables; t++) {
+    auto name = std::to_string(t);
+    auto *data = module->createConstant(ElemKind::FloatTy, {numRows, width},
+                                        "data" + name);
+    data->getPayloadMutable().getHandle().randomize(-1, 1, rng);
+    auto *weights = module->createPlaceholder(
+        ElemKind::FloatTy, {numIndices}, "weights" + name, false);
+    auto *indices = module->createPlaceholder(
+        ElemKind::Int64ITy, {numIndices}, "indices" + name, false);
+    auto *lengths = module->createPlaceholder(ElemKind::Int32ITy, {batch},
+                                              "lengths" + name, false);
+    bindings.allocate(weights)->getHandle().randomize(-1, 1, rng);
+    bindings.allocate(indices)->getHandle<int64_t>().randomize(0, numRows - 1,
+                                                              rng);
+    bindings.allocate(lengths)->getHandle<int32_t>().clear(20);
+
+    NodeValue tower = F->createSparseLengthsWeightedSum(
+        "sls" + name, data, weights, indices, lengths);
+    for (unsigned l = 0; l < 3; l++) {
+      auto *W = module->createConstant(ElemKind::FloatTy, {width, width},
+                                       "W" + name + "_" + std::to_string(l));
+      auto *B = module->createConstant(ElemKind::FloatTy, {width},
+                                       "B" + name + "_" + std::to_string(l));
+      W->getPayloadMutable().getHandle().randomize(-0.1, 0.1, rng);
+      B->getPayloadMutable().getHandle().randomize(-0.1, 0.1, rng);
+      tower = F->createRELU("relu", F->createFullyConnected("fc", tower, W, B));
+    }
+    towers.push_back(tower);
+  }
+  auto *concat = F->createConcat("concat", towers, 1);
+  auto *square = F->createMul("square", concat, concat);
+  auto *output = module->createPlaceholder(
+      ElemKind::FloatTy, square->getResult().dims(), "output", false);
+  F->createSave("save", square, output);
+  bindings.allocate(output);
+  return module;
+}
+
+/// Check that executing independent instructions in parallel on the
+/// Interpreter, and splitting data parallel kernels into chunks, produces
+/// exactly the same results as executing them in order.
+TEST(DeviceManagerTest, InterpreterParallelInstructions) {
+  PlaceholderBindings inputs;
+  auto module = makeEmbeddingTowersModule(inputs);
+  std::vector<std::unique_ptr<CompiledFunction>> backing;
+  auto functions = compileFunctions("Interpreter", module.get(), backing);
+  auto *output = module->getPlaceholderByNameSlow("output");
+
+  std::vector<Tensor> results;
+  // The last configuration splits every SLS and elementwise kernel.
+  const std::vector<std::pair<const char *, const char *>> configs = {
+      {"1", "65536"}, {"4", "65536"}, {"4", "1"}};
+  for (const auto &threadsAndMinWork : configs) {
+    DeviceConfig config("Interpreter");
+    config.parameters["numThreads"] = threadsAndMinWork.first;
+    config.parameters["minParallelWork"] = threadsAndMinWork.second;
+    std::unique_ptr<DeviceManager> device(
+        DeviceManager::createDeviceManager(config));
+    ASSERT_FALSE(ERR_TO_BOOL(device->init()));
+
+    std::promise<const Module *> addPromise;
+    std::future<const Module *> addFuture;
+    std::tie(addPromise, addFuture) = getFutureHelper<const Module *>();
+    device->addNetwork(module.get(), functions,
+                       [&addPromise](const Module *module, Error err) {
+                         callbackHelper(addPromise, module, std::move(err));
+                       });
+    EXPECT_EQ(addFuture.get(), module.get());
+
+    // Run several times to check that the results do not depend on the
+    // scheduling of the threads.
+    constexpr unsigned numRuns = 5;
+    std::unique_ptr<ExecutionContext> context;
+    for (unsigned run = 0; run < numRuns; run++) {
+      context = glow::make_unique<ExecutionContext>(
+          glow::make_unique<PlaceholderBindings>(inputs.clone()));
+      std::promise<std::unique_ptr<ExecutionContext>> runPromise;
+      std::future<std::unique_ptr<ExecutionContext>> runFuture;
+      std::tie(runPromise, runFuture) =
+          getFutureHelper<std::unique_ptr<ExecutionContext>>();
+      device->runFunction("main", std::move(context),
+                          [&runPromise](RunIdentifierTy, Error err,
+                                        std::unique_ptr<ExecutionContext> ctx) {
+                            callbackHelper(runPromise, std::move(ctx),
+                                           std::move(err));
+                          });
+      context = runFuture.get();
+      ASSERT_TRUE(context);
+      Tensor *result = context->getPlaceholderBindings()->get(output);
+      if (run == 0) {
+        results.push_back(result->clone());
+      } else {
+        EXPECT_TRUE(result->isBitwiseEqual(results.back()));
+      }
+    }
+    EXPECT_FALSE(ERR_TO_BOOL(device->stop()));
+  }
+  EXPECT_TRUE(results[0].isBitwiseEqual(results[1]));
+  EXPECT_TRUE(results[0].isBitwiseEqual(results[2]));
+}
+
+/// Check that the Interpreter device fails to initialize with a number of
+/// threads or a minimum parallel work which is not a positive integer.
+TEST(DeviceManagerTest, InterpreterInvalidParallelParameters) {
+  const std::vector<std::pair<const char *, const char *>> params = {
+      {"numThreads", "0"},      {"numThreads", "-2"},
+      {"numThreads", "four"},   {"minParallelWork", "0"},
+      {"minParallelWork", ""}};
+  for (const auto &param : params) {
+    DeviceConfig config("Interpreter");
+    config.parameters[param.first] = param.second;
+    std::unique_ptr<DeviceManager> device(
+        DeviceManager::createDeviceManager(config));
+    EXPECT_TRUE(ERR_TO_BOOL(device->init()))
+        << param.first << "=" << param.second;
+  }
+}
+
+#ifdef GLOW_WITH_CPU
+/// Add the basic network with its constant set to \p value to a new CPU device
+/// without collecting its constants at compile time, and run it on an input
+/// for which the network returns the constant. \returns the result and sets
+/// \p mapped to whether the constants were memory-mapped from a weights file.
+static float addAndRunBasicModuleOnCPU(float value, bool &mapped) {
+  auto module = makeBasicModule();
+  auto *c = module->getConstantByName("main_const");
+  c->getPayloadMutable().getHandle().clear(value);
+  std::unique_ptr<Backend> backend(createBackend("CPU"));
+  CompilationContext cctx;
+  cctx.compMode = CompilationMode::Infer;
+  cctx.backendOpts.collectConstants = false;
+  Function *F = module->getFunction("main");
+  EXIT_ON_ERR(::glow::optimizeFunction(F, *backend, cctx));
+  auto compiledF = EXIT_ON_ERR(backend->compile(F, cctx.backendOpts));
+  FunctionMapTy functions;
+  functions.emplace("main", compiledF.get());
+
+  std::unique_ptr<DeviceManager> device(
+      DeviceManager::createDeviceManager(DeviceConfig("CPU")));
+  EXPECT_FALSE(ERR_TO_BOOL(device->init()));
+  std::promise<const Module *> promise;
+  std::future<const Module *> future;
+  std::tie(promise, future) = getFutureHelper<const Module *>();
+  device->addNetwork(module.get(), functions,
+                     [&promise](const Module *module, Error err) {
+                       callbackHelper(promise, module, std::move(err));
+                     });
+  future.wait_for(std::chrono::seconds(2));
+  EXPECT_EQ(future.get(), module.get());
+  mapped = compiledF->getRuntimeBundle().isConstantsMapped();
+
+  auto context = glow::make_unique<ExecutionContext>();
+  context->getPlaceholderBindings()->allocate(module->getPlaceholders());
+  context->getPlaceholderBindings()
+      ->get(module->getPlaceholderByNameSlow("main_input"))
+      ->getHandle()
+      .clear(-1.0f);
+  std::promise<std::unique_ptr<ExecutionContext>> runPromise;
+  std::future<std::unique_ptr<ExecutionContext>> runFuture;
+  std::tie(runPromise, runFuture) =
+      getFutureHelper<std::unique_ptr<ExecutionContext>>();
+  device->runFunction("main", std::move(context),
+                      [&runPromise](RunIdentifierTy, Error err,
+                                    std::unique_ptr<ExecutionContext> context) {
+                        callbackHelper(runPromise, std::move(context),
+                                       std::move(err));
+                      });
+  runFuture.wait_for(std::chrono::seconds(2));
+  context = runFuture.get();
+  EXPECT_FALSE(ERR_TO_BOOL(device->stop()));
+  if (!context) {
+    ADD_FAILURE() << "Running the network failed";
+    return 0;
+  }
+  return context->getPlaceholderBindings()
+      ->get(module->getPlaceholderByNameSlow("main_output"))
+      ->getHandle()
+      .at({0});
+}
+
+/// Check that the CPU device writes the constants of a network into the
+/// weights file of -cpu-weights-dir when the network is first added and maps
+/// them from it, and that it copies the constants instead if the file is stale
+/// or the directory is unusable.
+TEST(DeviceManagerTest, CPUWeightsDir) {
+  auto &options = llvm::cl::getRegisteredOptions();
+  ASSERT_TRUE(options.count("cpu-weights-dir"));
+  auto *weightsDirOpt =
+      static_cast<llvm::cl::opt<std::string> *>(options["cpu-weights-dir"]);
+  llvm::SmallString<64> weightsDir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("cpu-weights", weightsDir));
+  *weightsDirOpt = weightsDir.str().str();
+  llvm::SmallString<64> weightsFile(weightsDir);
+  llvm::sys::path::append(weightsFile, "main.weights");
+
+  // The first device writes the weights file and maps it.
+  bool mapped = false;
+  EXPECT_FLOAT_EQ(addAndRunBasicModuleOnCPU(0.25f, mapped), 0.25f);
+  EXPECT_TRUE(mapped);
+  EXPECT_TRUE(llvm::sys::fs::exists(weightsFile));
+
+  // The next device maps the existing file.
+  EXPECT_FLOAT_EQ(addAndRunBasicModuleOnCPU(0.25f, mapped), 0.25f);
+  EXPECT_TRUE(mapped);
+
+  // The file is stale once the constant changes, so it is copied instead.
+  EXPECT_FLOAT_EQ(addAndRunBasicModuleOnCPU(0.75f, mapped), 0.75f);
+  EXPECT_FALSE(mapped);
+
+  llvm::sys::fs::remove(weightsFile);
+  llvm::sys::fs::remove(weightsDir);
+
+  // A missing directory makes the device copy the constants as well.
+  EXPECT_FLOAT_EQ(addAndRunBasicModuleOnCPU(0.5f, mapped), 0.5f);
+  EXPECT_FALSE(mapped);
+  EXPECT_FALSE(llvm::sys::fs::exists(weightsFile));
+  *weightsDirOpt = "";
+}
+#endif // GLOW_WITH_CPU
+
 INSTANTIATE_BACKEND_TEST(DeviceManagerTest);
@@ -22,6 +22,7 @@
 #include "glow/IR/IR.h"
 #include "glow/Optimizer/GraphOptimizer/FunctionPassPipeline.h"
 #include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
+#include "glow/Optimizer/GraphOptimizer/GraphRewriter.h"
 
 #include "gtest/gtest.h"
 
@@ -1672,6 +1673,162 @@ TEST_F(GraphOptz, sinkTransposeBelowRelu) {
   ASSERT_TRUE(F_->verify());
 }
 
+/// Test that layouts are propagated through a region of elementwise nodes and
+/// concats with several inputs, removing all transposes around it.
+TEST_F(GraphOptz, propagateLayoutsThroughRegion) {
+  auto *A = mod_.createPlaceholder(ElemKind::FloatTy, {1, 3, 4, 5}, "A", false);
+  auto *B = mod_.createPlaceholder(ElemKind::FloatTy, {1, 3, 4, 5}, "B", false);
+  auto *C = mod_.createPlaceholder(ElemKind::FloatTy, {1, 2, 4, 5}, "C", false);
+  auto *TA = F_->createTranspose("transposeA", A, NCHW2NHWC);
+  auto *TB = F_->createTranspose("transposeB", B, NCHW2NHWC);
+  auto *TC = F_->createTranspose("transposeC", C, NCHW2NHWC);
+  auto *add = F_->createAdd("add", TA, TB);
+  auto *concat = F_->createConcat("concat", {add, TC}, 3);
+  auto *tanh = F_->createTanh("tanh", concat);
+  auto *TO = F_->createTranspose("transposeOut", tanh, NHWC2NCHW);
+  SaveNode *save = F_->createSave("ret", TO);
+
+  EXPECT_EQ(countNodeKind(F_, Kinded::Kind::TransposeNodeKind), 4);
+
+  optimizedF_ = optimizeFunction(F_, {FunctionPassID::PropagateLayouts});
+
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::TransposeNodeKind), 0);
+  const SaveNode *optSave =
+      findFunctionNodeByName<SaveNode>(optimizedF_, save->getName());
+  ASSERT_TRUE(optSave);
+  auto *optTanh = llvm::dyn_cast<TanhNode>(optSave->getInput());
+  ASSERT_TRUE(optTanh);
+  auto *optConcat = llvm::dyn_cast<ConcatNode>(optTanh->getInput());
+  ASSERT_TRUE(optConcat);
+  EXPECT_EQ(optConcat->getDim(), 1);
+  EXPECT_EQ(optConcat->getResult().dims(), llvm::ArrayRef<dim_t>({1, 5, 4, 5}));
+  ASSERT_TRUE(optimizedF_->verify());
+
+  bindings_.allocate(mod_.getPlaceholders());
+  bindings_.get(A)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  bindings_.get(B)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  bindings_.get(C)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  checkNumericalEquivalence();
+}
+
+/// Test that a transpose is inserted for users of a region that cannot take
+/// the new layout, and that the region is still transposed when it pays off.
+TEST_F(GraphOptz, propagateLayoutsWithExternalUser) {
+  auto *A = mod_.createPlaceholder(ElemKind::FloatTy, {1, 3, 4, 5}, "A", false);
+  auto *B = mod_.createPlaceholder(ElemKind::FloatTy, {1, 3, 4, 5}, "B", false);
+  auto *TA = F_->createTranspose("transposeA", A, NCHW2NHWC);
+  auto *TB = F_->createTranspose("transposeB", B, NCHW2NHWC);
+  auto *mul = F_->createMul("mul", TA, TB);
+  auto *relu = F_->createRELU("relu", mul);
+  auto *TO = F_->createTranspose("transposeOut", relu, NHWC2NCHW);
+  F_->createSave("ret", TO);
+  F_->createSave("retNHWC", relu);
+
+  EXPECT_EQ(countNodeKind(F_, Kinded::Kind::TransposeNodeKind), 3);
+
+  optimizedF_ = optimizeFunction(F_, {FunctionPassID::PropagateLayouts});
+
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::TransposeNodeKind), 1);
+  ASSERT_TRUE(optimizedF_->verify());
+
+  bindings_.allocate(mod_.getPlaceholders());
+  bindings_.get(A)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  bindings_.get(B)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  checkNumericalEquivalence();
+}
+
+/// Test that a region whose switch would transpose more Constants than it
+/// saves Transposes is left alone, instead of being switched back and forth
+/// forever.
+TEST_F(GraphOptz, propagateLayoutsTerminatesWithConstants) {
+  auto *A = mod_.createPlaceholder(ElemKind::FloatTy, {1, 3, 4, 5}, "A", false);
+  auto *TA = F_->createTranspose("transposeA", A, NCHW2NHWC);
+  NodeValue chain = F_->createExp("exp", TA);
+  for (unsigned i = 0; i < 3; i++) {
+    auto *C = mod_.createConstant(ElemKind::FloatTy, {1, 4, 5, 3},
+                                  "C" + std::to_string(i));
+    C->getPayloadMutable().getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+    chain = F_->createAdd("add" + std::to_string(i), chain, C);
+  }
+  auto *TO = F_->createTranspose("transposeOut", chain, NHWC2NCHW);
+  F_->createSave("ret", TO);
+
+  optimizedF_ = optimizeFunction(F_, {FunctionPassID::PropagateLayouts});
+
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::TransposeNodeKind), 2);
+  ASSERT_TRUE(optimizedF_->verify());
+
+  bindings_.allocate(mod_.getPlaceholders());
+  bindings_.get(A)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  checkNumericalEquivalence();
+}
+
+/// Test that SinkCode cancels out Transposes around a long chain of nodes in a
+/// single pass.
+TEST_F(GraphOptz, sinkTransposeThroughLongChainInOnePass) {
+  constexpr unsigned numLayers = 50;
+  auto *A =
+      mod_.createPlaceholder(ElemKind::FloatTy, {1, 5, 10, 15}, "A", false);
+  NodeValue chain = F_->createTranspose("transpose", A, NHWC2NCHW);
+  for (unsigned i = 0; i < numLayers; i++) {
+    chain = F_->createRELU("relu", chain);
+    chain = F_->createTanh("tanh", chain);
+    chain = F_->createSigmoid("sigmoid", chain);
+  }
+  chain = F_->createTranspose("transposeBack", chain, NCHW2NHWC);
+  F_->createSave("ret", chain);
+
+  optimizedF_ =
+      optimizeFunction(F_, {FunctionPassID::SinkCode, getDCEPassConfig()});
+
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::TransposeNodeKind), 0);
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::ReluNodeKind), numLayers);
+  ASSERT_TRUE(optimizedF_->verify());
+
+  bindings_.allocate(mod_.getPlaceholders());
+  bindings_.get(A)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  checkNumericalEquivalence();
+}
+
+/// Test that the GraphRewriter only revisits the nodes around a rewrite, and
+/// erases the nodes left dead by it.
+TEST_F(GraphOptz, graphRewriterRevisitsChangedNodes) {
+  constexpr unsigned numClips = 100;
+  auto *A = mod_.createPlaceholder(ElemKind::FloatTy, {10}, "A", false);
+  NodeValue chain = A;
+  for (unsigned i = 0; i < numClips; i++) {
+    chain = F_->createClip("clip", chain, -10.0f + i * 0.05f, 10.0f);
+  }
+  SaveNode *save = F_->createSave("ret", chain);
+
+  GraphRewriter rewriter(F_);
+  rewriter.addPattern(
+      "MergeClips", {Kinded::Kind::ClipNodeKind}, [](Node *N, Function *F) {
+        auto *CN = llvm::cast<ClipNode>(N);
+        auto *inputCN = llvm::dyn_cast<ClipNode>(CN->getInput());
+        if (!inputCN) {
+          return false;
+        }
+        auto *newCN = F->createClip(
+            CN->getName(), inputCN->getInput(),
+            std::max(CN->getMin(), inputCN->getMin()),
+            std::min(CN->getMax(), inputCN->getMax()));
+        CN->getResult().replaceAllUsesOfWith(newCN);
+        return true;
+      });
+  EXPECT_TRUE(rewriter.run());
+
+  EXPECT_EQ(rewriter.getNumApplied("MergeClips"), numClips - 1);
+  // Every merge visits the new Clip and its user once more.
+  EXPECT_LE(rewriter.getNumVisited(), 3 * numClips);
+  EXPECT_EQ(F_->getNodes().size(), 2);
+  auto *CN = llvm::dyn_cast<ClipNode>(save->getInput());
+  ASSERT_TRUE(CN);
+  EXPECT_EQ(CN->getInput().getNode(), A);
+  EXPECT_EQ(CN->getMin(), -10.0f + (numClips - 1) * 0.05f);
+  EXPECT_FALSE(rewriter.run());
+}
+
 TEST_F(GraphOptz, mergeConcatNodes) {
   Node *A1 = mod_.createPlaceholder(ElemKind::FloatTy, {1, 5, 10, 15}, "input1",
                                     false);
@@ -2974,6 +3131,290 @@ TEST_F(GraphOptz, mergeMatMulNodes) {
   EXPECT_EQ(countNodeKind(F_, Kinded::Kind::MatMulNodeKind), 1);
 }
 
+/// Check that matmuls sharing their LHS are merged into a single matmul.
+TEST_F(GraphOptz, mergeMatMulNodesSharingLHS) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {4, 8}, "input", false);
+  bindings_.allocate(input)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  for (dim_t i = 0; i < 3; i++) {
+    auto *weights = mod_.createConstant(ElemKind::FloatTy, {8, 2 + 2 * i},
+                                        "weights" + std::to_string(i));
+    weights->getPayloadMutable().getHandle().randomize(-1.0, 1.0,
+                                                       mod_.getPRNG());
+    auto *MM = F_->createMatMul("mm" + std::to_string(i), input, weights);
+    F_->createSave("save" + std::to_string(i), MM);
+  }
+
+  optimizedF_ = optimizeFunction(
+      F_, {FunctionPassID::MergeMatMul, getDCEPassConfig()});
+
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::MatMulNodeKind), 1);
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::SliceNodeKind), 3);
+
+  // The matmuls are kept apart when the merge is disabled, and when they are
+  // going to be profiled.
+  CompilationContext cctx;
+  cctx.optimizationOpts.enableHorizontalFCFusion = false;
+  Function *G = optimizeFunction(
+      F_, {FunctionPassID::MergeMatMul, getDCEPassConfig()}, cctx);
+  EXPECT_EQ(countNodeKind(G, Kinded::Kind::MatMulNodeKind), 3);
+  CompilationContext profileCctx;
+  profileCctx.precisionConfig.quantMode = QuantizationMode::Profile;
+  G = optimizeFunction(
+      F_, {FunctionPassID::MergeMatMul, getDCEPassConfig()}, profileCctx);
+  EXPECT_EQ(countNodeKind(G, Kinded::Kind::MatMulNodeKind), 3);
+
+  checkNumericalEquivalence();
+}
+
+/// Check that FullyConnected nodes sharing their input are merged into a
+/// single wide FullyConnected, while FCs reading another input or having
+/// non-Constant weights are not.
+TEST_F(GraphOptz, mergeFullyConnectedSharingInput) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {2, 16}, "input", false);
+  bindings_.allocate(input)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  auto *other =
+      mod_.createPlaceholder(ElemKind::FloatTy, {2, 16}, "other", false);
+  bindings_.allocate(other)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  for (dim_t i = 0; i < 4; i++) {
+    auto suffix = std::to_string(i);
+    auto *weights =
+        mod_.createConstant(ElemKind::FloatTy, {16, 4 * (i + 1)}, "w" + suffix);
+    weights->getPayloadMutable().getHandle().randomize(-1.0, 1.0,
+                                                       mod_.getPRNG());
+    auto *bias = mod_.createConstant(ElemKind::FloatTy, {4 * (i + 1)},
+                                     "b" + suffix);
+    bias->getPayloadMutable().getHandle().randomize(-1.0, 1.0,
+                                                    mod_.getPRNG());
+    auto *FC = F_->createFullyConnected("fc" + suffix, i < 3 ? input : other,
+                                        weights, bias);
+    auto *RL = F_->createRELU("relu" + suffix, FC);
+    F_->createSave("save" + suffix, RL);
+  }
+  // An FC whose weights are not a Constant is not merged.
+  auto *weightsP =
+      mod_.createPlaceholder(ElemKind::FloatTy, {16, 4}, "weightsP", false);
+  bindings_.allocate(weightsP)->getHandle().randomize(-1.0, 1.0,
+                                                      mod_.getPRNG());
+  auto *biasP = mod_.createConstant(ElemKind::FloatTy, {4}, "biasP");
+  biasP->getPayloadMutable().getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  auto *FCP = F_->createFullyConnected("fcP", input, weightsP, biasP);
+  F_->createSave("saveP", FCP);
+
+  optimizedF_ = optimizeFunction(
+      F_, {FunctionPassID::MergeFullyConnected, getDCEPassConfig()});
+
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::FullyConnectedNodeKind),
+            3);
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::SliceNodeKind), 3);
+  auto *wideFC =
+      findFunctionNodeByName<FullyConnectedNode>(optimizedF_, "mergedFC");
+  ASSERT_TRUE(wideFC);
+  EXPECT_EQ(wideFC->getResult().dims()[1], 4 + 8 + 12);
+
+  // The FCs are kept apart when the merge is disabled.
+  CompilationContext cctx;
+  cctx.optimizationOpts.enableHorizontalFCFusion = false;
+  Function *G = optimizeFunction(
+      F_, {FunctionPassID::MergeFullyConnected, getDCEPassConfig()}, cctx);
+  EXPECT_EQ(countNodeKind(G, Kinded::Kind::FullyConnectedNodeKind), 5);
+
+  checkNumericalEquivalence();
+}
+
+/// Check that rowwise-quantized FullyConnected nodes sharing their input and
+/// their output quantization parameters are merged, while the ones with other
+/// output quantization parameters are not.
+TEST_F(GraphOptz, mergeRowwiseQuantizedFullyConnectedSharingInput) {
+  auto *input = mod_.createPlaceholder(ElemKind::Int8QTy, {2, 16}, 0.05, 0,
+                                       "input", false);
+  bindings_.allocate(input)->getHandle<int8_t>().randomize(-100, 100,
+                                                           mod_.getPRNG());
+  for (dim_t i = 0; i < 3; i++) {
+    auto suffix = std::to_string(i);
+    dim_t width = 4 * (i + 1);
+    auto *weights = mod_.createConstant(ElemKind::Int8QTy, {width, 16}, 1.0, 0,
+                                        "w" + suffix);
+    weights->getPayloadMutable().getHandle<int8_t>().randomize(
+        -100, 100, mod_.getPRNG());
+    auto *scales =
+        mod_.createConstant(ElemKind::FloatTy, {width}, "scales" + suffix);
+    scales->getPayloadMutable().getHandle().randomize(0.001, 0.01,
+                                                      mod_.getPRNG());
+    auto *offsets =
+        mod_.createConstant(ElemKind::Int32ITy, {width}, "offsets" + suffix);
+    offsets->getPayloadMutable().getHandle<int32_t>().randomize(
+        -10, 10, mod_.getPRNG());
+    auto *bias = mod_.createConstant(ElemKind::Int32QTy, {width}, 1.0, 0,
+                                     "b" + suffix);
+    bias->getPayloadMutable().getHandle<int32_t>().randomize(-10, 10,
+                                                             mod_.getPRNG());
+    auto *outTy = mod_.uniqueType(ElemKind::Int8QTy, {2, width},
+                                  i < 2 ? 0.1 : 0.2, 0);
+    auto *FC = F_->createRowwiseQuantizedFullyConnected(
+        "fc" + suffix, input, weights, scales, offsets, bias, outTy);
+    F_->createSave("save" + suffix, FC);
+  }
+
+  optimizedF_ = optimizeFunction(
+      F_, {FunctionPassID::MergeFullyConnected, getDCEPassConfig()});
+
+  EXPECT_EQ(countNodeKind(optimizedF_,
+                          Kinded::Kind::RowwiseQuantizedFullyConnectedNodeKind),
+            2);
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::SliceNodeKind), 2);
+  checkNumericalEquivalence(0);
+}
+
+/// Check that FusedRowwiseQuantizedSparseLengthsWeightedSum nodes over
+/// different tables are grouped when they have the same number of segments,
+/// and that tables shared by several nodes are only packed once.
+TEST_F(GraphOptz, groupFusedRowwiseQuantizedSLWS) {
+  const std::vector<dim_t> tableRows = {10, 20, 30};
+  std::vector<NodeValue> tables;
+  auto createSLWS = [&](const std::string &suffix, dim_t table,
+                        dim_t numSegments) {
+    const dim_t numIndices = 2 * numSegments;
+    auto *weights = mod_.createPlaceholder(ElemKind::FloatTy, {numIndices},
+                                           "weights" + suffix, false);
+    auto *indices = mod_.createPlaceholder(ElemKind::Int64ITy, {numIndices},
+                                           "indices" + suffix, false);
+    auto *lengths = mod_.createPlaceholder(ElemKind::Int32ITy, {numSegments},
+                                           "lengths" + suffix, false);
+    bindings_.allocate(weights)->getHandle().randomize(-1.0, 1.0,
+                                                       mod_.getPRNG());
+    bindings_.allocate(indices)->getHandle<int64_t>().randomize(
+        0, tableRows[table] - 1, mod_.getPRNG());
+    bindings_.allocate(lengths)->getHandle<int32_t>().clear(2);
+    FusedRowwiseQuantizedSparseLengthsWeightedSumNode *SLWS;
+    if (table < tables.size()) {
+      SLWS = F_->createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+          "slws" + suffix, tables[table], weights, indices, lengths);
+    } else {
+      Tensor data(ElemKind::FloatTy, {tableRows[table], 8});
+      data.getHandle().randomize(-10.0, 10.0, mod_.getPRNG());
+      SLWS = F_->createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+          "slws" + suffix, data, weights, indices, lengths);
+      tables.push_back(SLWS->getData());
+    }
+    F_->createSave("save" + suffix, SLWS);
+  };
+  createSLWS("0", 0, 4);
+  createSLWS("1", 1, 4);
+  // Shares the table of the first node.
+  createSLWS("2", 0, 4);
+  // Has a different number of segments.
+  createSLWS("3", 2, 3);
+
+  // The tables of the first three nodes take 160 and 320 bytes. Below the
+  // size of both, only the nodes sharing the first table are grouped.
+  Function *cappedF = F_->clone(F_->getName().str() + "_capped");
+  EXPECT_TRUE(groupFusedRowwiseQuantizedSLWS(cappedF, 200));
+  auto *cappedGrouped = findFunctionNodeByName<
+      GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumNode>(cappedF,
+                                                              "groupedSLWS");
+  ASSERT_TRUE(cappedGrouped);
+  EXPECT_EQ(cappedGrouped->getTableOffsets().dims()[0], 2);
+  EXPECT_EQ(cappedGrouped->getData().dims()[0], tableRows[0]);
+  mod_.eraseFunction(cappedF);
+
+  optimizedF_ = F_->clone(F_->getName().str() + "_optimized");
+  EXPECT_TRUE(groupFusedRowwiseQuantizedSLWS(
+      optimizedF_, cctx_.optimizationOpts.slsGroupingMaxBytes));
+
+  auto *grouped = findFunctionNodeByName<
+      GroupedFusedRowwiseQuantizedSparseLengthsWeightedSumNode>(optimizedF_,
+                                                              "groupedSLWS");
+  ASSERT_TRUE(grouped);
+  EXPECT_EQ(grouped->getTableOffsets().dims()[0], 3);
+  EXPECT_EQ(grouped->getData().dims()[0], tableRows[0] + tableRows[1]);
+  EXPECT_EQ(grouped->getResult().dims()[0], 12);
+  EXPECT_EQ(
+      countNodeKind(
+          optimizedF_,
+          Kinded::Kind::FusedRowwiseQuantizedSparseLengthsWeightedSumNodeKind),
+      1);
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::SliceNodeKind), 3);
+
+  // Keep the backend from grouping the nodes of the reference Function.
+  cctx_.optimizationOpts.enableSLSGrouping = false;
+  checkNumericalEquivalence(0);
+}
+
+/// Check that FullyConnecteds and MatMuls with sparse constant weights are
+/// converted to BlockSparseFullyConnected nodes, with the largest block size
+/// at which the weights are sparse enough, and that dense ones are kept.
+TEST_F(GraphOptz, sparsifyFullyConnected) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {6, 32}, "input", false);
+  bindings_.allocate(input)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+
+  // One non-zero 4x8 block out of 16.
+  auto *blockWeights = mod_.createConstant(ElemKind::FloatTy, {32, 32}, "bw");
+  auto BWH = blockWeights->getPayloadMutable().getHandle();
+  BWH.clear(0);
+  for (dim_t i = 8; i < 12; i++) {
+    for (dim_t j = 16; j < 24; j++) {
+      BWH.at({i, j}) = mod_.getPRNG().nextRandReal(-1.0, 1.0);
+    }
+  }
+  auto *bias = mod_.createConstant(ElemKind::FloatTy, {32}, "bias");
+  bias->getPayloadMutable().getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  auto *MM = F_->createMatMul("blockMM", input, blockWeights);
+  auto *BA = F_->createBatchedAdd("blockBA", MM, bias);
+  F_->createSave("saveBlock", BA);
+
+  // Scattered non-zero elements, without bias.
+  auto *scatteredWeights =
+      mod_.createConstant(ElemKind::FloatTy, {32, 32}, "sw");
+  auto SWH = scatteredWeights->getPayloadMutable().getHandle();
+  SWH.clear(0);
+  for (dim_t i = 0; i < 32; i++) {
+    SWH.at({i, (i * 7) % 32}) = mod_.getPRNG().nextRandReal(-1.0, 1.0);
+  }
+  auto *scatteredMM = F_->createMatMul("scatteredMM", input, scatteredWeights);
+  F_->createSave("saveScattered", scatteredMM);
+
+  // Dense weights.
+  auto *denseWeights = mod_.createConstant(ElemKind::FloatTy, {32, 16}, "dw");
+  denseWeights->getPayloadMutable().getHandle().randomize(-1.0, 1.0,
+                                                           mod_.getPRNG());
+  auto *denseBias = mod_.createConstant(ElemKind::FloatTy, {16}, "denseBias");
+  denseBias->getPayloadMutable().getHandle().randomize(-1.0, 1.0,
+                                                       mod_.getPRNG());
+  auto *FC =
+      F_->createFullyConnected("denseFC", input, denseWeights, denseBias);
+  F_->createSave("saveDense", FC);
+
+  optimizedF_ = F_->clone(F_->getName().str() + "_optimized");
+  EXPECT_TRUE(sparsifyFullyConnected(optimizedF_, 0.8));
+
+  auto *blockFC = findFunctionNodeByName<BlockSparseFullyConnectedNode>(
+      optimizedF_, "blockMM");
+  ASSERT_TRUE(blockFC);
+  EXPECT_EQ(blockFC->getBlockRows(), 4);
+  EXPECT_EQ(blockFC->getBlockCols(), 8);
+  EXPECT_EQ(blockFC->getValues().dims()[0], 1);
+  EXPECT_TRUE(llvm::isa<Constant>(blockFC->getBias()));
+
+  auto *scatteredFC = findFunctionNodeByName<BlockSparseFullyConnectedNode>(
+      optimizedF_, "scatteredMM");
+  ASSERT_TRUE(scatteredFC);
+  EXPECT_EQ(scatteredFC->getBlockRows(), 1);
+  EXPECT_EQ(scatteredFC->getBlockCols(), 1);
+  EXPECT_EQ(scatteredFC->getValues().dims()[0], 32);
+
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::MatMulNodeKind), 0);
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::BatchedAddNodeKind), 0);
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::FullyConnectedNodeKind),
+            1);
+
+  // Keep the backend from converting the nodes of the reference Function.
+  cctx_.optimizationOpts.enableBlockSparseFC = false;
+  checkNumericalEquivalence();
+}
+
 // Check that we are able to merge batched adds.
 TEST_F(GraphOptz, mergeBANodes) {
   Node *input =
@@ -3418,6 +3859,46 @@ TEST_F(GraphOptz, VarsCSENaN) {
   }
 }
 
+/// Check that deduplicateConstants() merges bit-identical Constants of any
+/// size and of the same layout used by different Functions of the Module, and
+/// erases the duplicates.
+TEST_F(GraphOptz, deduplicateConstantsAcrossFunctions) {
+  // Larger than const_dedup_size, so that CSE would not merge them.
+  auto *table1 = mod_.createConstant(ElemKind::FloatTy, {64, 32}, "table1");
+  auto *table2 = mod_.createConstant(ElemKind::FloatTy, {64, 32}, "table2");
+  auto *table3 = mod_.createConstant(ElemKind::FloatTy, {64, 32}, "table3");
+  table1->getPayloadMutable().getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  table2->getPayloadMutable().assign(&table1->getPayload());
+  table3->getPayloadMutable().assign(&table1->getPayload());
+  table3->getPayloadMutable().getHandle().raw(64 * 32 - 1) += 1.0;
+
+  Function *G = mod_.createFunction("G");
+  auto *RN1 = F_->createRELU("relu1", table1);
+  auto *RN2 = G->createRELU("relu2", table2);
+  auto *RN3 = G->createRELU("relu3", table3);
+  F_->createSave("save1", RN1);
+  G->createSave("save2", RN2);
+  G->createSave("save3", RN3);
+
+  // The same bytes laid out differently are different Constants.
+  auto *nhwc = mod_.createConstant(ElemKind::FloatTy, {2, 4, 8, 32}, "nhwc",
+                                   "NHWC");
+  nhwc->getPayloadMutable().getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  auto *nchw = mod_.createConstant("nchw", nhwc->getPayload().clone(), "NCHW");
+
+  EXPECT_TRUE(::glow::deduplicateConstants(mod_));
+  EXPECT_EQ(mod_.getConstants().size(), 4);
+  EXPECT_EQ(mod_.getConstantByName("nhwc"), nhwc);
+  EXPECT_EQ(mod_.getConstantByName("nchw"), nchw);
+  EXPECT_EQ(RN1->getInput().getNode(), RN2->getInput().getNode());
+  EXPECT_EQ(RN3->getInput().getNode(), table3);
+  EXPECT_TRUE(F_->verify());
+  EXPECT_TRUE(G->verify());
+
+  // Nothing is left to deduplicate.
+  EXPECT_FALSE(::glow::deduplicateConstants(mod_));
+}
+
 // Verify that constant input canonicalization works correctly when the
 // arithmetic nodes have multiple users.
 TEST_F(GraphOptz, simplifyArithmeticMultipleUsers) {
@@ -4228,6 +4709,59 @@ TEST_F(GraphOptz, constantFoldWholeFunction) {
   EXPECT_EQ(CH.at({1, 1}), 76.0f);
 }
 
+/// Test constant folding of many independent constant subgraphs, which are
+/// evaluated in batches, along with subgraphs sharing nodes.
+TEST_F(GraphOptz, constantFoldIndependentSubgraphs) {
+  constexpr unsigned numChains = 16;
+  constexpr unsigned chainLength = 8;
+  auto *A = mod_.createConstant(ElemKind::FloatTy, {4}, "A");
+  auto *B = mod_.createConstant(ElemKind::FloatTy, {4}, "B");
+  setConstValue(A, 2.0f);
+  setConstValue(B, 3.0f);
+  auto *shared = F_->createMul("shared", A, B);
+  auto *splat = F_->createSplat(
+      "splat", mod_.uniqueType(ElemKind::FloatTy, {4}), 1.0f);
+  std::vector<SaveNode *> saves;
+  for (unsigned i = 0; i < numChains; i++) {
+    auto *C = mod_.createConstant(ElemKind::FloatTy, {4},
+                                  "const" + std::to_string(i));
+    setConstValue(C, float(i));
+    NodeValue chain = C;
+    // The first two chains share a node.
+    if (i < 2) {
+      chain = F_->createAdd("addShared", chain, shared);
+    }
+    for (unsigned j = 0; j < chainLength; j++) {
+      chain = F_->createAdd("add", chain, splat);
+    }
+    saves.push_back(F_->createSave("save", chain));
+  }
+
+  uint64_t numCompilations = getNumConstantFoldingCompilations();
+  optimizedF_ = optimizeFunction(F_, {FunctionPassID::ConstantFold,
+                                      getDCEPassConfig()});
+  numCompilations = getNumConstantFoldingCompilations() - numCompilations;
+
+  // The 131 nodes fit into at most two batches of -const_fold_min_batch_nodes
+  // nodes, instead of one compilation per chain.
+  EXPECT_GE(numCompilations, 1);
+  EXPECT_LE(numCompilations, 2);
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::AddNodeKind), 0);
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::MulNodeKind), 0);
+  for (unsigned i = 0; i < numChains; i++) {
+    const SaveNode *SN =
+        findFunctionNodeByName<SaveNode>(optimizedF_, saves[i]->getName());
+    ASSERT_TRUE(SN);
+    const Constant *C = llvm::dyn_cast<Constant>(SN->getInput());
+    ASSERT_TRUE(C);
+    float expected = float(i) + chainLength + (i < 2 ? 6.0f : 0.0f);
+    auto CH = C->getPayload().getHandle<float>();
+    for (dim_t k = 0, e = CH.size(); k < e; k++) {
+      EXPECT_EQ(CH.raw(k), expected);
+    }
+  }
+}
+
 /// Test constant folding for operators which are lowered in Interpreter
 /// backend.
 TEST_F(GraphOptz, constantFoldWithLowering) {
@@ -4579,6 +5113,93 @@ TEST_F(GraphOptz, FoldMatMulAddIntoFullyConnected) {
   EXPECT_EQ(1, countNodeKind(F_, Kinded::Kind::ReshapeNodeKind));
 }
 
+/// Test that a batched attention with a mask, whose SoftMax is applied on 2D
+/// scores, is folded into a ScaledDotProductAttention.
+TEST_F(GraphOptz, FoldScaledDotProductAttention) {
+  const dim_t B = 2, Lq = 3, Lk = 5, D = 4, Dv = 6;
+  auto *Q = mod_.createPlaceholder(ElemKind::FloatTy, {B, Lq, D}, "Q", false);
+  auto *K = mod_.createPlaceholder(ElemKind::FloatTy, {B, Lk, D}, "K", false);
+  auto *V = mod_.createPlaceholder(ElemKind::FloatTy, {B, Lk, Dv}, "V", false);
+  auto *mask =
+      mod_.createPlaceholder(ElemKind::FloatTy, {B, Lq, Lk}, "mask", false);
+  for (auto *PH : {Q, K, V, mask}) {
+    bindings_.allocate(PH)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  }
+
+  auto *KT = F_->createTranspose("KT", K, {0, 2, 1});
+  auto *scores = F_->createBatchMatMul("scores", Q, KT);
+  auto *sqrtD = F_->createSplat("sqrtD", scores->getResult().getType(), 2.0);
+  auto *scaled = F_->createDiv("scaled", scores, sqrtD);
+  auto *masked = F_->createAdd("masked", mask, scaled);
+  auto *scores2D = F_->createReshape("scores2D", masked, {B * Lq, Lk});
+  auto *selected = mod_.createPlaceholder(ElemKind::Int64ITy, {B * Lq, 1},
+                                          "selected", false);
+  bindings_.allocate(selected)->zero();
+  auto *SM = F_->createSoftMax("softmax", scores2D, selected);
+  auto *probs = F_->createReshape("probs", SM, {B, Lq, Lk});
+  auto *result = F_->createBatchMatMul("result", probs, V);
+  F_->createSave("save", result);
+
+  optimizedF_ = F_->clone(F_->getName().str() + "_optimized");
+  ::glow::fold(optimizedF_, cctx_);
+
+  EXPECT_EQ(1, countNodeKind(optimizedF_,
+                             Kinded::Kind::ScaledDotProductAttentionNodeKind));
+  EXPECT_EQ(0, countNodeKind(optimizedF_, Kinded::Kind::SoftMaxNodeKind));
+  EXPECT_EQ(0, countNodeKind(optimizedF_, Kinded::Kind::BatchMatMulNodeKind));
+  EXPECT_EQ(0, countNodeKind(optimizedF_, Kinded::Kind::TransposeNodeKind));
+  for (auto &N : optimizedF_->getNodes()) {
+    if (auto *SDPA = llvm::dyn_cast<ScaledDotProductAttentionNode>(&N)) {
+      EXPECT_EQ(SDPA->getKeys().getNode(), K);
+      EXPECT_EQ(SDPA->getMask().getNode(), mask);
+      EXPECT_FLOAT_EQ(SDPA->getScale(), 0.5);
+    }
+  }
+
+  checkNumericalEquivalence();
+}
+
+/// Test that the per-head 2D attention of BERT without mask is folded into a
+/// ScaledDotProductAttention, and that it is not folded when the scores are
+/// used by another node.
+TEST_F(GraphOptz, FoldScaledDotProductAttention2D) {
+  const dim_t Lq = 4, Lk = 7, D = 8;
+  auto *Q = mod_.createPlaceholder(ElemKind::FloatTy, {Lq, D}, "Q", false);
+  auto *K = mod_.createPlaceholder(ElemKind::FloatTy, {Lk, D}, "K", false);
+  auto *V = mod_.createPlaceholder(ElemKind::FloatTy, {Lk, D}, "V", false);
+  for (auto *PH : {Q, K, V}) {
+    bindings_.allocate(PH)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  }
+  auto *selected =
+      mod_.createPlaceholder(ElemKind::Int64ITy, {Lq, 1}, "selected", false);
+  bindings_.allocate(selected)->zero();
+
+  auto createAttention = [&](const std::string &name) {
+    auto *KT = F_->createTranspose(name + ".KT", K, {1, 0});
+    auto *scores = F_->createMatMul(name + ".scores", Q, KT);
+    auto *scale = F_->createSplat(name + ".scale",
+                                  scores->getResult().getType(), 0.125);
+    auto *scaled = F_->createMul(name + ".scaled", scores, scale);
+    auto *SM = F_->createSoftMax(name + ".softmax", scaled, selected);
+    auto *result = F_->createMatMul(name + ".result", SM, V);
+    F_->createSave(name + ".save", result);
+    return scaled;
+  };
+  createAttention("fused");
+  auto *scaled = createAttention("unfused");
+  F_->createSave("saveScores", scaled);
+
+  optimizedF_ = F_->clone(F_->getName().str() + "_optimized");
+  ::glow::fold(optimizedF_, cctx_);
+
+  EXPECT_EQ(1, countNodeKind(optimizedF_,
+                             Kinded::Kind::ScaledDotProductAttentionNodeKind));
+  EXPECT_EQ(1, countNodeKind(optimizedF_, Kinded::Kind::SoftMaxNodeKind));
+  EXPECT_EQ(2, countNodeKind(optimizedF_, Kinded::Kind::MatMulNodeKind));
+
+  checkNumericalEquivalence();
+}
+
 /// Test that FoldSlicesIntoConstants pass works as expected.
 TEST_F(GraphOptz, FoldSlicesIntoConstantsTest) {
   Constant *C = mod_.createConstant(ElemKind::FloatTy, {3, 4}, "C");
@@ -5297,3 +5918,57 @@ TEST_F(GraphOptz, constantFoldPreventedNoop) {
                                                         mod_.getPRNG());
   checkNumericalEquivalence();
 }
+
+/// Creates a Function in which a Splat is used at the beginning and at the
+/// end, so that it is live while a much larger Tile is computed in between.
+/// \returns the input Placeholder.
+static Placeholder *createLongLivedSplatGraph(Module &mod, Function *F) {
+  auto *input =
+      mod.createPlaceholder(ElemKind::FloatTy, {64, 64}, "input", false);
+  auto *splat =
+      F->createSplat("splat", mod.uniqueType(ElemKind::FloatTy, {64, 64}), 3);
+  auto *add1 = F->createAdd("add1", input, splat);
+  auto *tile = F->createTile("tile", add1, 4, 0);
+  auto *slice = F->createSlice("slice", tile, {64, 0}, {128, 64});
+  auto *add2 = F->createAdd("add2", slice, splat);
+  F->createSave("save", add2);
+  return input;
+}
+
+/// Test that a long lived Splat is recomputed next to its users when the
+/// Function does not fit into the memory budget.
+TEST_F(GraphOptz, RematerializeLongLivedSplat) {
+  auto *input = createLongLivedSplatGraph(mod_, F_);
+
+  // The peak is reached while the Splat, the first Add and the Tile are live:
+  // (1 + 1 + 4) * 64 * 64 * 4 bytes. Without the Splat it drops to 5 * 16KB.
+  CompilationContext cctx;
+  cctx.optimizationOpts.rematerializationMemoryBudget = 90000;
+  optimizedF_ = optimizeFunction(F_, {FunctionPassID::Rematerialize}, cctx);
+
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::SplatNodeKind), 2);
+  for (auto &N : optimizedF_->getNodes()) {
+    if (auto *SN = llvm::dyn_cast<SplatNode>(&N)) {
+      EXPECT_EQ(SN->getNumUsers(), 1);
+    }
+  }
+
+  bindings_.allocate(input)->getHandle<float>().randomize(-10.0, 10.0,
+                                                          mod_.getPRNG());
+  checkNumericalEquivalence();
+}
+
+/// Test that nothing is rematerialized if the Function fits into the memory
+/// budget, or if no budget is given at all.
+TEST_F(GraphOptz, RematerializeWithinBudget) {
+  createLongLivedSplatGraph(mod_, F_);
+
+  CompilationContext cctx;
+  cctx.optimizationOpts.rematerializationMemoryBudget = 1 << 20;
+  optimizedF_ = optimizeFunction(F_, {FunctionPassID::Rematerialize}, cctx);
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::SplatNodeKind), 1);
+
+  mod_.eraseFunction(optimizedF_);
+  optimizedF_ = optimizeFunction(F_, {FunctionPassID::Rematerialize});
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::SplatNodeKind), 1);
+}
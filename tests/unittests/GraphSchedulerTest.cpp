@@ -23,6 +23,10 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
 using namespace glow;
 
 /// Tests a case in which the memory required to store a node's
@@ -161,3 +165,240 @@ TEST(GraphScheduler, ScheduleQuantizationProfileRightAfterNodeBeingProfiled) {
   // Expect the save node to be the last in the schedule.
   EXPECT_EQ(save, schedule.back());
 }
+
+/// \returns the schedule of \p F computed by a scheduler of kind \p kind,
+/// after checking that every node is scheduled once after its operands.
+static NodesPtrList getSchedule(SchedulerKind kind, Function *F) {
+  NodesPtrList schedule;
+  std::unique_ptr<Scheduler> scheduler(createScheduler(kind, *F, schedule));
+  scheduler->schedule();
+  EXPECT_EQ(schedule.size(), F->getNodes().size());
+  std::unordered_map<const Node *, size_t> position;
+  for (const Node *N : schedule) {
+    EXPECT_TRUE(position.emplace(N, position.size()).second);
+  }
+  for (const Node *N : schedule) {
+    for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+      const Node *input = N->getNthInput(i).getNode();
+      if (!llvm::isa<Storage>(input)) {
+        EXPECT_LT(position[input], position[N]);
+      }
+    }
+  }
+  return schedule;
+}
+
+/// \returns the largest number of bytes any node of \p F needs to hold its
+/// operands and its results at once, which no schedule can go below.
+static uint64_t getMaxWorkingSet(Function *F) {
+  uint64_t maxWorkingSet = 0;
+  for (auto &N : F->getNodes()) {
+    uint64_t workingSet = 0;
+    for (unsigned res = 0, e = N.getNumResults(); res < e; res++) {
+      workingSet += N.getType(res)->getSizeInBytes();
+    }
+    std::unordered_set<const Node *> operands;
+    for (unsigned i = 0, e = N.getNumInputs(); i < e; i++) {
+      const Node *input = N.getNthInput(i).getNode();
+      if (llvm::isa<Storage>(input) || !operands.insert(input).second) {
+        continue;
+      }
+      for (unsigned res = 0, e = input->getNumResults(); res < e; res++) {
+        workingSet += input->getType(res)->getSizeInBytes();
+      }
+    }
+    maxWorkingSet = std::max(maxWorkingSet, workingSet);
+  }
+  return maxWorkingSet;
+}
+
+/// Check the schedules of all schedulers for \p F and their peak memory
+/// against the working set of the nodes of \p F. The liveness based scheduler
+/// picks the best of its candidate schedules, which include the schedules of
+/// the other memory oriented schedulers, so it is never worse than those.
+static void checkPeakMemory(Function *F) {
+  uint64_t minPeak = getMaxWorkingSet(F);
+  for (auto kind :
+       {SchedulerKind::ChildMemSizeBased, SchedulerKind::TopologicalSortBased,
+        SchedulerKind::LivenessBased, SchedulerKind::ParallelismBased}) {
+    EXPECT_GE(getPeakLiveMemory(*F, getSchedule(kind, F)), minPeak);
+  }
+}
+
+/// Creates an Inception-like network: blocks of parallel convolution branches
+/// of different sizes, merged by a Concat.
+static Function *createInceptionNet(Module &MD, PlaceholderBindings &bindings) {
+  Function *F = MD.createFunction("inception");
+  auto *input =
+      MD.createPlaceholder(ElemKind::FloatTy, {1, 28, 28, 64}, "input", false);
+  NodeValue cur = input;
+  for (unsigned block = 0; block < 3; block++) {
+    auto *b1 = F->createConv(bindings, "b1", cur, 64, 1, 1, 0, 1);
+    auto *b3r = F->createConv(bindings, "b3r", cur, 96, 1, 1, 0, 1);
+    auto *b3 = F->createConv(bindings, "b3", F->createRELU("b3r", b3r), 128,
+                             3, 1, 1, 1);
+    auto *b5r = F->createConv(bindings, "b5r", cur, 16, 1, 1, 0, 1);
+    auto *b5 = F->createConv(bindings, "b5", F->createRELU("b5r", b5r), 32, 5,
+                             1, 2, 1);
+    auto *pool = F->createMaxPool("pool", cur, 3, 1, 1);
+    auto *bp = F->createConv(bindings, "bp", pool->getResult(), 32, 1, 1, 0, 1);
+    cur = F->createConcat("concat",
+                          {F->createRELU("b1", b1), F->createRELU("b3", b3),
+                           F->createRELU("b5", b5), F->createRELU("bp", bp)},
+                          3);
+  }
+  F->createSave("save", cur);
+  return F;
+}
+
+/// Creates a ResNet-like network: a chain of bottleneck blocks with residual
+/// connections, some of which downsample their input.
+static Function *createResNet(Module &MD, PlaceholderBindings &bindings) {
+  Function *F = MD.createFunction("resnet");
+  auto *input =
+      MD.createPlaceholder(ElemKind::FloatTy, {1, 56, 56, 64}, "input", false);
+  NodeValue cur = input;
+  for (unsigned block = 0; block < 4; block++) {
+    unsigned_t stride = block % 2 ? 2 : 1;
+    dim_t channels = cur.dims()[3];
+    auto *c1 = F->createConv(bindings, "c1", cur, channels / 4, 1, 1, 0, 1);
+    auto *c2 = F->createConv(bindings, "c2", F->createRELU("r1", c1),
+                             channels / 4, 3, stride, 1, 1);
+    auto *c3 = F->createConv(bindings, "c3", F->createRELU("r2", c2),
+                             channels * 2, 1, 1, 0, 1);
+    auto *shortcut =
+        F->createConv(bindings, "shortcut", cur, channels * 2, 1, stride, 0, 1);
+    cur = F->createRELU("r3", F->createAdd("add", c3, shortcut));
+  }
+  F->createSave("save", cur);
+  return F;
+}
+
+/// Creates a recommendation-system-like network: independent embedding
+/// tables, each followed by its own FC tower, merged by a Concat.
+static Function *createEmbeddingTowers(Module &MD,
+                                       PlaceholderBindings &bindings) {
+  Function *F = MD.createFunction("towers");
+  std::vector<NodeValue> towers;
+  for (unsigned t = 0; t < 6; t++) {
+    auto *data = MD.createPlaceholder(ElemKind::FloatTy, {1000, 64}, "data",
+                                      false);
+    auto *weights =
+        MD.createPlaceholder(ElemKind::FloatTy, {320}, "weights", false);
+    auto *indices =
+        MD.createPlaceholder(ElemKind::Int64ITy, {320}, "indices", false);
+    auto *lengths =
+        MD.createPlaceholder(ElemKind::Int32ITy, {16}, "lengths", false);
+    NodeValue tower = F->createSparseLengthsWeightedSum("sls", data, weights,
+                                                        indices, lengths);
+    for (unsigned l = 0; l < 3; l++) {
+      tower = F->createRELU(
+          "relu", F->createFullyConnected(bindings, "fc", tower, 64 << l));
+    }
+    towers.push_back(tower);
+  }
+  F->createSave("save", F->createConcat("concat", towers, 1));
+  return F;
+}
+
+/// Check the peak memory of the schedulers on model-like graphs.
+TEST(GraphScheduler, PeakMemoryOfModels) {
+  Module MD;
+  PlaceholderBindings bindings;
+  checkPeakMemory(createInceptionNet(MD, bindings));
+  checkPeakMemory(createResNet(MD, bindings));
+  checkPeakMemory(createEmbeddingTowers(MD, bindings));
+}
+
+/// ChildMemSizeBased does not account for the result of a node in the memory
+/// it needs, so it computes the operand whose small input is expanded into a
+/// big result last, while the other operand is live. The liveness based
+/// scheduler computes it first and reaches the working set of the MatMul.
+TEST(GraphScheduler, LivenessBasedBeatsChildMemSizeBased) {
+  Module MD;
+  Function *F = MD.createFunction("F");
+  auto *small =
+      MD.createPlaceholder(ElemKind::FloatTy, {2, 25}, "small", false);
+  auto *rhs = MD.createPlaceholder(ElemKind::FloatTy, {100, 1}, "rhs", false);
+  // 50 floats expanded into 200 floats.
+  Node *expanded = F->createTile("tile", F->createRELU("relu", small), 4, 1);
+  // 100 floats.
+  Node *other = F->createRELU("other", rhs);
+  Node *matMul = F->createMatMul("matmul", expanded, other);
+  F->createSave("save", matMul);
+
+  uint64_t childMemSizePeak = getPeakLiveMemory(
+      *F, getSchedule(SchedulerKind::ChildMemSizeBased, F));
+  uint64_t livenessPeak =
+      getPeakLiveMemory(*F, getSchedule(SchedulerKind::LivenessBased, F));
+  EXPECT_EQ(childMemSizePeak, (100 + 50 + 200) * sizeof(float));
+  EXPECT_EQ(livenessPeak, (200 + 100 + 2) * sizeof(float));
+  EXPECT_EQ(livenessPeak, getMaxWorkingSet(F));
+  EXPECT_LT(livenessPeak, childMemSizePeak);
+}
+
+/// The liveness based scheduler should find the better order of the
+/// testMaxSizeLessThanResultSize graph, like ChildMemSizeBased.
+TEST(GraphScheduler, LivenessBasedSchedulesFreeingNodesFirst) {
+  Module MD;
+  auto *smallTensorA =
+      MD.createPlaceholder(ElemKind::FloatTy, {1, 4, 4}, "small_1", false);
+  auto *smallTensorB =
+      MD.createPlaceholder(ElemKind::FloatTy, {1, 4, 4}, "small_2", false);
+  auto *bigTensor =
+      MD.createPlaceholder(ElemKind::FloatTy, {100, 4, 4}, "big", false);
+  Function *F = MD.createFunction("F");
+  Node *transposeBig = F->createTranspose("transposeBig", bigTensor, {0, 2, 1});
+  Node *sliceBig =
+      F->createSlice("sliceBig", transposeBig, {0, 0, 0}, {1, 4, 4});
+  Node *concatSmall =
+      F->createConcat("concatSmall", {smallTensorA, smallTensorB}, 0);
+  F->createConcat("concat", {concatSmall, sliceBig}, 0);
+
+  auto schedule = getSchedule(SchedulerKind::LivenessBased, F);
+  auto concatSmallIt = std::find(schedule.begin(), schedule.end(), concatSmall);
+  auto sliceBigIt = std::find(schedule.begin(), schedule.end(), sliceBig);
+  EXPECT_LT(std::distance(schedule.begin(), sliceBigIt),
+            std::distance(schedule.begin(), concatSmallIt));
+  EXPECT_EQ(getPeakLiveMemory(*F, schedule),
+            getPeakLiveMemory(
+                *F, getSchedule(SchedulerKind::ChildMemSizeBased, F)));
+}
+
+/// The parallelism based scheduler should interleave independent branches:
+/// all embedding lookups come before any FC of the towers.
+TEST(GraphScheduler, ParallelismBasedInterleavesBranches) {
+  Module MD;
+  PlaceholderBindings bindings;
+  Function *F = createEmbeddingTowers(MD, bindings);
+  auto schedule = getSchedule(SchedulerKind::ParallelismBased, F);
+
+  size_t lastSLS = 0;
+  size_t firstFC = schedule.size();
+  size_t pos = 0;
+  for (const Node *N : schedule) {
+    if (llvm::isa<SparseLengthsWeightedSumNode>(N)) {
+      lastSLS = pos;
+    } else if (llvm::isa<FullyConnectedNode>(N)) {
+      firstFC = std::min(firstFC, pos);
+    }
+    pos++;
+  }
+  EXPECT_LT(lastSLS, firstFC);
+
+  // The towers do not share anything, so a depth-first schedule runs them one
+  // after another.
+  auto depthFirst = getSchedule(SchedulerKind::TopologicalSortBased, F);
+  pos = 0;
+  lastSLS = 0;
+  firstFC = depthFirst.size();
+  for (const Node *N : depthFirst) {
+    if (llvm::isa<SparseLengthsWeightedSumNode>(N)) {
+      lastSLS = pos;
+    } else if (llvm::isa<FullyConnectedNode>(N)) {
+      firstFC = std::min(firstFC, pos);
+    }
+    pos++;
+  }
+  EXPECT_GT(lastSLS, firstFC);
+}
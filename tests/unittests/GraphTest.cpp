@@ -1538,6 +1538,61 @@ TEST(Graph, verifyConstantNoWriters) {
   EXPECT_FALSE(M.verify());
 }
 
+/// Check that types are uniqued by value, including the strides and, for
+/// quantized types only, the scale and offset.
+TEST(Graph, uniqueType) {
+  Module M;
+  auto *T1 = M.uniqueType(ElemKind::FloatTy, {3, 4});
+  auto *T2 = M.uniqueType(Type(ElemKind::FloatTy, {3, 4}));
+  EXPECT_EQ(T1, T2);
+  EXPECT_NE(T1, M.uniqueType(ElemKind::FloatTy, {4, 3}));
+  EXPECT_NE(T1, M.uniqueType(ElemKind::Float16Ty, {3, 4}));
+  EXPECT_NE(T1, M.uniqueTypeWithNewShape(T1, {3, 4}, {32, 1}));
+  EXPECT_EQ(T1, M.uniqueTypeWithNewShape(M.uniqueType(ElemKind::FloatTy, {12}),
+                                         {3, 4}));
+
+  auto *Q1 = M.uniqueType(ElemKind::Int8QTy, {3, 4}, 0.5, 1);
+  EXPECT_EQ(Q1, M.uniqueType(ElemKind::Int8QTy, {3, 4}, 0.5, 1));
+  EXPECT_NE(Q1, M.uniqueType(ElemKind::Int8QTy, {3, 4}, 0.25, 1));
+  EXPECT_NE(Q1, M.uniqueType(ElemKind::Int8QTy, {3, 4}, 0.5, 2));
+
+  EXPECT_TRUE(M.hasType(Type(ElemKind::Int8QTy, {3, 4}, 0.5, 2)));
+  EXPECT_FALSE(M.hasType(Type(ElemKind::Int8QTy, {3, 4}, 0.5, 3)));
+}
+
+/// Check that verify catches nodes made invalid after a previous verification,
+/// which did not verify them again.
+TEST(Graph, verifyIncrementally) {
+  Module M;
+  auto *F = M.createFunction("main");
+
+  auto *A = M.createPlaceholder(ElemKind::FloatTy, {3, 4}, "A", false);
+  auto *B = M.createPlaceholder(ElemKind::FloatTy, {3, 4}, "B", false);
+  auto *C = M.createPlaceholder(ElemKind::FloatTy, {4, 3}, "C", false);
+  auto *add = F->createAdd("add", A, B);
+  F->createSave("save", add);
+  EXPECT_TRUE(F->verify());
+  EXPECT_TRUE(F->verify());
+
+  // The Add is not valid anymore.
+  add->setNthInput(AddNode::RHSIdx, C);
+  EXPECT_FALSE(F->verify());
+  EXPECT_FALSE(F->verify());
+
+  add->setNthInput(AddNode::RHSIdx, B);
+  EXPECT_TRUE(F->verify());
+  EXPECT_TRUE(F->verify(nullptr, /* full */ true));
+
+  // The predicate of the Add must be a vector.
+  add->setPredicate(A);
+  EXPECT_FALSE(F->verify());
+  EXPECT_FALSE(F->verify());
+
+  auto *P = M.createPlaceholder(ElemKind::BoolTy, {3}, "P", false);
+  add->setPredicate(P);
+  EXPECT_TRUE(F->verify());
+}
+
 TEST(Graph, typeUnsafeReplaceAllUsesOfWith) {
   Module M;
   auto *F = M.createFunction("main");
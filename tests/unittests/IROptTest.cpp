@@ -129,6 +129,88 @@ TEST(Optimizer, shareBuffers) {
   EXPECT_EQ(M.getInstrs().size(), 2);
 }
 
+/// \returns the number of activations allocated by \p M.
+static size_t countActivations(const IRFunction &M) {
+  const auto &instrs = M.getInstrs();
+  return std::count_if(instrs.begin(), instrs.end(), [](const Instruction &I) {
+    return isa<AllocActivationInst>(&I);
+  });
+}
+
+/// Check that buffers are shared along a chain of in-place instructions whose
+/// operands only differ in their quantization parameters.
+TEST(Optimizer, shareBuffersWithDifferentQuantizationParams) {
+  Module mod;
+  Function *F = mod.createFunction("ShareBuffers");
+  IRFunction M(F);
+  IRBuilder bb(&M);
+
+  auto *input =
+      bb.createWeightVar(glow::ElemKind::Int8QTy, {16}, 0.1, 0, "input",
+                         WeightVar::MutabilityKind::Constant);
+  auto *output = bb.createWeightVar(glow::ElemKind::FloatTy, {16}, "output",
+                                    WeightVar::MutabilityKind::Mutable);
+
+  auto *alloc1 = bb.createAllocActivationInst(
+      "alloc1", mod.uniqueType(glow::ElemKind::Int8QTy, {16}, 0.1, 0));
+  auto *alloc2 = bb.createAllocActivationInst(
+      "alloc2", mod.uniqueType(glow::ElemKind::Int8QTy, {16}, 0.2, 0));
+  auto *alloc3 = bb.createAllocActivationInst(
+      "alloc3", mod.uniqueType(glow::ElemKind::Int8QTy, {16}, 0.4, -3));
+  bb.createElementAddInst("add", alloc1, input, input);
+  bb.createReluInst("relu", alloc2, alloc1);
+  bb.createRescaleQuantizedInst("rescale", alloc3, alloc2);
+  bb.createDequantizeInst("dequantize", output, alloc3);
+  bb.createDeallocActivationInst("dealloc3", alloc3);
+  bb.createDeallocActivationInst("dealloc2", alloc2);
+  bb.createDeallocActivationInst("dealloc1", alloc1);
+
+  optimize(M, MockBackend().shouldShareBuffers());
+
+  // All instructions operate in-place on a single buffer, which is accessed
+  // through views of the other types.
+  EXPECT_EQ(countActivations(M), 1);
+}
+
+/// Check that intermediate results of in-place instructions are written into
+/// the output, even if their types have different quantization parameters.
+TEST(Optimizer, shareOutputBufferWithDifferentQuantizationParams) {
+  Module mod;
+  Function *F = mod.createFunction("ShareBuffers");
+  IRFunction M(F);
+  IRBuilder bb(&M);
+
+  auto *input =
+      bb.createWeightVar(glow::ElemKind::Int8QTy, {16}, 0.1, 0, "input",
+                         WeightVar::MutabilityKind::Constant);
+  auto *output =
+      bb.createWeightVar(glow::ElemKind::Int8QTy, {16}, 0.4, -3, "output",
+                         WeightVar::MutabilityKind::Mutable);
+
+  auto *alloc1 = bb.createAllocActivationInst(
+      "alloc1", mod.uniqueType(glow::ElemKind::Int8QTy, {16}, 0.1, 0));
+  auto *alloc2 = bb.createAllocActivationInst(
+      "alloc2", mod.uniqueType(glow::ElemKind::Int8QTy, {16}, 0.2, 0));
+  auto *alloc3 = bb.createAllocActivationInst(
+      "alloc3", mod.uniqueType(glow::ElemKind::Int8QTy, {16}, 0.4, -3));
+  bb.createElementAddInst("add", alloc1, input, input);
+  bb.createReluInst("relu", alloc2, alloc1);
+  bb.createRescaleQuantizedInst("rescale", alloc3, alloc2);
+  bb.createCopyInst("copy", output, alloc3);
+  bb.createDeallocActivationInst("dealloc3", alloc3);
+  bb.createDeallocActivationInst("dealloc2", alloc2);
+  bb.createDeallocActivationInst("dealloc1", alloc1);
+
+  optimize(M, MockBackend().shouldShareBuffers());
+
+  EXPECT_EQ(countActivations(M), 0);
+  auto &instrs = M.getInstrs();
+  EXPECT_TRUE(std::none_of(
+      instrs.begin(), instrs.end(), [](const Instruction &I) -> bool {
+        return I.getKind() == Instruction::Kind::CopyInstKind;
+      }));
+}
+
 TEST(Optimizer, deleteDeadViews) {
   Module mod;
   Function *F = mod.createFunction("DeleteDeadViews");
@@ -1040,6 +1122,85 @@ TEST(Optimizer, copyEliminationTensorViewBuffer) {
       [](const Instruction &I) -> bool { return isa<TensorViewInst>(&I); }));
 }
 
+/// Runs the FoldTilesIntoBroadcastViews pass followed by the removal of dead
+/// allocations on \p M.
+static void foldTilesIntoBroadcastViews(IRFunction &M) {
+  IRFunctionPassManager IRFPM(
+      "opt", glow::make_unique<IRFunctionPassPipeline>(
+                 std::initializer_list<IRFunctionPassConfig>(
+                     {{IRFunctionPassID::FoldTilesIntoBroadcastViews},
+                      {IRFunctionPassID::DeleteDeadAllocs}})));
+  IRFPM.run(&M, CompilationContext());
+}
+
+/// Check that a chain of tiles read by a data-parallel instruction is replaced
+/// with a single broadcast view of the source of the first tile.
+TEST(Optimizer, foldTilesIntoBroadcastViews) {
+  Module mod;
+  Function *F = mod.createFunction("foldTiles");
+  IRFunction M(F);
+  IRBuilder bb(&M);
+
+  auto *x = bb.createWeightVar(glow::ElemKind::FloatTy, {1, 1, 16}, "x",
+                               WeightVar::MutabilityKind::Constant);
+  auto *y = bb.createWeightVar(glow::ElemKind::FloatTy, {4, 3, 16}, "y",
+                               WeightVar::MutabilityKind::Constant);
+  auto *out = bb.createWeightVar(glow::ElemKind::FloatTy, {4, 3, 16}, "out",
+                                 WeightVar::MutabilityKind::Mutable);
+  auto *tile1 = bb.createAllocActivationInst("tile1", glow::ElemKind::FloatTy,
+                                             {1, 3, 16});
+  bb.createInsertTensorInst("insert1", tile1, x, {0, 0, 0}, 3, 1);
+  auto *tile2 = bb.createAllocActivationInst("tile2", glow::ElemKind::FloatTy,
+                                             {4, 3, 16});
+  bb.createInsertTensorInst("insert2", tile2, tile1, {0, 0, 0}, 4, 0);
+  auto *add = bb.createElementAddInst("add", out, tile2, y);
+  bb.createDeallocActivationInst("deallocTile2", tile2);
+  bb.createDeallocActivationInst("deallocTile1", tile1);
+
+  foldTilesIntoBroadcastViews(M);
+  ASSERT_TRUE(M.verify());
+
+  // Only the view and the add should remain.
+  auto &instrs = M.getInstrs();
+  EXPECT_EQ(instrs.size(), 2);
+  auto *view = dyn_cast<TensorViewInst>(add->getLHS());
+  ASSERT_TRUE(view);
+  EXPECT_TRUE(isBroadcastView(view));
+  EXPECT_EQ(view->getSrc(), x);
+  EXPECT_EQ(view->getType(), out->getType());
+}
+
+/// Check that a tile is not folded into a broadcast view if its source is
+/// overwritten before the tile is read.
+TEST(Optimizer, foldTilesIntoBroadcastViewsOverwrittenSource) {
+  Module mod;
+  Function *F = mod.createFunction("foldTiles");
+  IRFunction M(F);
+  IRBuilder bb(&M);
+
+  auto *y = bb.createWeightVar(glow::ElemKind::FloatTy, {4, 16}, "y",
+                               WeightVar::MutabilityKind::Constant);
+  auto *out = bb.createWeightVar(glow::ElemKind::FloatTy, {4, 16}, "out",
+                                 WeightVar::MutabilityKind::Mutable);
+  auto *x = bb.createAllocActivationInst("x", glow::ElemKind::FloatTy, {1, 16});
+  bb.createSplatInst("splat1", x, 1.0);
+  auto *tile =
+      bb.createAllocActivationInst("tile", glow::ElemKind::FloatTy, {4, 16});
+  bb.createInsertTensorInst("insert", tile, x, {0, 0}, 4, 0);
+  bb.createSplatInst("splat2", x, 2.0);
+  auto *add = bb.createElementAddInst("add", out, tile, y);
+  bb.createDeallocActivationInst("deallocTile", tile);
+  bb.createDeallocActivationInst("deallocX", x);
+
+  foldTilesIntoBroadcastViews(M);
+  ASSERT_TRUE(M.verify());
+
+  EXPECT_EQ(add->getLHS(), tile);
+  EXPECT_TRUE(std::any_of(
+      M.getInstrs().begin(), M.getInstrs().end(),
+      [](const Instruction &I) -> bool { return isa<InsertTensorInst>(&I); }));
+}
+
 /// Check if dump functions work for Value and IRFunction.
 TEST(Optimizer, dumpDataStructure) {
   Module mod;
@@ -17,7 +17,19 @@
 #include "glow/LLVMIRCodeGen/LLVMIRGen.h"
 #include "glow/LLVMIRCodeGen/AllocationsInfo.h"
 
+#include "../../lib/Backends/CPU/CPUBackend.h"
+#include "../../lib/Backends/CPU/CPULLVMIRGen.h"
+#include "glow/ExecutionContext/KernelProfile.h"
+#include "glow/Graph/Graph.h"
 #include "glow/IR/IR.h"
+#include "glow/IR/Instrs.h"
+#include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
+#include "glow/Optimizer/IROptimizer/IROptimizer.h"
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 
 #include "gtest/gtest.h"
 
@@ -41,3 +53,208 @@ TEST(LLVMIRGen, getEntryName) {
   llvmIRGen.setMainEntryName("");
   EXPECT_EQ(llvmIRGen.getMainEntryName(), "main");
 }
+
+namespace {
+
+/// Describes how the kernel emitted for an IR instruction was specialized.
+struct KernelSpecialization {
+  /// Whether the call of the kernel was specialized.
+  bool specialized{false};
+  /// Whether the specialization can be inlined into its caller.
+  bool inlinable{false};
+  /// Whether the loops of the specialization are requested to be unrolled.
+  bool unrolled{false};
+};
+
+/// Maps names of IR instructions to the specializations of their kernels.
+using KernelSpecializations = llvm::StringMap<KernelSpecialization>;
+
+/// \returns true if any loop of \p F carries an llvm.loop.unroll.count hint.
+bool hasUnrollHints(const llvm::Function &F) {
+  for (const auto &BB : F) {
+    const auto *loopID =
+        BB.getTerminator()->getMetadata(llvm::LLVMContext::MD_loop);
+    if (!loopID) {
+      continue;
+    }
+    for (unsigned i = 1, e = loopID->getNumOperands(); i < e; ++i) {
+      const auto *hint = llvm::dyn_cast<llvm::MDNode>(loopID->getOperand(i));
+      if (!hint || hint->getNumOperands() == 0) {
+        continue;
+      }
+      const auto *name = llvm::dyn_cast<llvm::MDString>(hint->getOperand(0));
+      if (name && name->getString() == "llvm.loop.unroll.count") {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/// CPU LLVMIRGen which records how the kernels of IR instructions were
+/// specialized by the FunctionSpecializer.
+class SpecializationRecordingIRGen : public CPULLVMIRGen {
+  KernelSpecializations &specializations_;
+
+public:
+  SpecializationRecordingIRGen(const IRFunction *F,
+                               AllocationsInfo &allocationsInfo,
+                               llvm::StringRef libjitBC,
+                               KernelSpecializations &specializations)
+      : CPULLVMIRGen(F, allocationsInfo, "", libjitBC),
+        specializations_(specializations) {}
+
+  void performSpecialization() override {
+    // Remember the kernel called for every IR instruction, specializations
+    // are named after the kernel they were cloned from.
+    llvm::StringMap<std::string> kernelToInstr;
+    for (auto *F : emittedLLVMFunctions_) {
+      for (auto &BB : *F) {
+        for (auto &I : BB) {
+          auto *call = llvm::dyn_cast<llvm::CallInst>(&I);
+          auto *instr = call ? getInstrForCall(call) : nullptr;
+          if (!instr || !call->getCalledFunction()) {
+            continue;
+          }
+          kernelToInstr[call->getCalledFunction()->getName()] =
+              instr->getName();
+          specializations_[instr->getName()] = KernelSpecialization();
+        }
+      }
+    }
+    LLVMIRGen::performSpecialization();
+    llvm::StringRef suffix = "_specialized";
+    for (auto &F : getModule()) {
+      if (!F.getName().endswith(suffix)) {
+        continue;
+      }
+      // Specializations are named <kernel>_<index>_specialized.
+      auto kernel = F.getName().drop_back(suffix.size()).rsplit('_').first;
+      auto it = kernelToInstr.find(kernel);
+      if (it == kernelToInstr.end()) {
+        continue;
+      }
+      auto &spec = specializations_[it->second];
+      spec.specialized = true;
+      spec.inlinable = !F.hasFnAttribute(llvm::Attribute::AttrKind::NoInline);
+      spec.unrolled = hasUnrollHints(F);
+    }
+  }
+};
+
+/// CPU backend compiling with a SpecializationRecordingIRGen.
+class SpecializationRecordingCPUBackend : public CPUBackend {
+  KernelSpecializations &specializations_;
+
+public:
+  explicit SpecializationRecordingCPUBackend(
+      KernelSpecializations &specializations)
+      : specializations_(specializations) {}
+
+  std::unique_ptr<LLVMIRGen>
+  createIRGen(const IRFunction *IR,
+              AllocationsInfo &allocationsInfo) const override {
+    return glow::make_unique<SpecializationRecordingIRGen>(
+        IR, allocationsInfo, getLibjitBitcode(), specializations_);
+  }
+};
+
+/// Compile a convolution followed by a max pool for the CPU backend. If
+/// \p useProfile is set, compile with a kernel profile in which the kernels
+/// took \p convTime and \p poolTime microseconds. \returns how the kernels of
+/// the convolution and the max pool, keyed by "conv" and "pool", were
+/// specialized.
+KernelSpecializations compileWithKernelProfile(bool useProfile,
+                                               uint64_t convTime,
+                                               uint64_t poolTime) {
+  Module mod;
+  Function *F = mod.createFunction("main");
+  auto *input =
+      mod.createPlaceholder(ElemKind::FloatTy, {1, 8, 8, 8}, "input", false);
+  auto *filter = mod.createConstant(ElemKind::FloatTy, {8, 3, 3, 8}, "filter");
+  auto *bias = mod.createConstant(ElemKind::FloatTy, {8}, "bias");
+  filter->getPayloadMutable().getHandle().clear(0.5);
+  bias->getPayloadMutable().getHandle().clear(1);
+  auto *outTy = mod.uniqueType(ElemKind::FloatTy, {1, 8, 8, 8});
+  auto *conv = F->createConv("conv", input, filter, bias, outTy, 3, 1, 1, 1);
+  auto *pool = F->createMaxPool("pool", conv, 2, 2, 0);
+  F->createSave("save", pool->getResult());
+
+  KernelSpecializations specializations;
+  SpecializationRecordingCPUBackend backend(specializations);
+  CompilationContext cctx;
+  cctx.compMode = CompilationMode::Infer;
+  EXIT_ON_ERR(glow::optimizeFunction(F, backend, cctx));
+  auto IR = glow::generateAndOptimizeIR(F, backend, false);
+
+  // Find the IR instructions emitted for the convolution and the max pool.
+  std::string convName;
+  std::string poolName;
+  for (const auto &I : IR->getInstrs()) {
+    if (llvm::isa<AllocActivationInst>(&I) ||
+        llvm::isa<DeallocActivationInst>(&I) || llvm::isa<TensorViewInst>(&I)) {
+      continue;
+    }
+    if (I.getName().startswith("conv")) {
+      convName = I.getName();
+    } else if (I.getName().startswith("pool")) {
+      poolName = I.getName();
+    }
+  }
+  EXPECT_FALSE(convName.empty());
+  EXPECT_FALSE(poolName.empty());
+
+  auto &options = llvm::cl::getRegisteredOptions();
+  EXPECT_TRUE(options.count("llvm-kernel-profile"));
+  auto *profileOpt =
+      static_cast<llvm::cl::opt<std::string> *>(options["llvm-kernel-profile"]);
+  llvm::SmallString<64> path;
+  if (useProfile) {
+    KernelProfile profile;
+    profile.add(convName, "convolution", 1, convTime);
+    profile.add(poolName, "maxpool", 1, poolTime);
+    EXPECT_FALSE(
+        llvm::sys::fs::createTemporaryFile("kernel_profile", "yaml", path));
+    profile.serialize(path);
+    *profileOpt = path.str().str();
+  }
+  backend.compileIR(std::move(IR));
+  if (useProfile) {
+    *profileOpt = "";
+    llvm::sys::fs::remove(path);
+  }
+
+  KernelSpecializations result;
+  result["conv"] = specializations.lookup(convName);
+  result["pool"] = specializations.lookup(poolName);
+  return result;
+}
+
+} // namespace
+
+/// Check that a kernel profile makes the FunctionSpecializer specialize,
+/// inline and unroll the hot kernels and leave the cold ones alone.
+TEST(LLVMIRGen, kernelProfileGuidedSpecialization) {
+  // Without a profile all kernels are specialized, but neither inlined nor
+  // unrolled.
+  auto noProfile = compileWithKernelProfile(false, 0, 0);
+  for (auto *kernel : {"conv", "pool"}) {
+    EXPECT_TRUE(noProfile[kernel].specialized);
+    EXPECT_FALSE(noProfile[kernel].inlinable);
+    EXPECT_FALSE(noProfile[kernel].unrolled);
+  }
+
+  // The convolution is hot and the max pool is cold.
+  auto hotConv = compileWithKernelProfile(true, 1000, 1);
+  EXPECT_TRUE(hotConv["conv"].specialized);
+  EXPECT_TRUE(hotConv["conv"].inlinable);
+  EXPECT_TRUE(hotConv["conv"].unrolled);
+  EXPECT_FALSE(hotConv["pool"].specialized);
+
+  // The max pool is hot and the convolution is cold.
+  auto hotPool = compileWithKernelProfile(true, 1, 1000);
+  EXPECT_FALSE(hotPool["conv"].specialized);
+  EXPECT_TRUE(hotPool["pool"].specialized);
+  EXPECT_TRUE(hotPool["pool"].inlinable);
+  EXPECT_TRUE(hotPool["pool"].unrolled);
+}
@@ -342,3 +342,116 @@ TEST(MemAlloc, testAlignment) {
   EXPECT_EQ(p2, 128);
   EXPECT_EQ(p3, 256);
 }
+
+/// Check that the buffers of \p requests with overlapping lifetimes were not
+/// placed into overlapping memory regions at \p addresses.
+static void checkNoConflicts(const std::vector<AllocationRequest> &requests,
+                             const std::vector<uint64_t> &addresses) {
+  ASSERT_EQ(requests.size(), addresses.size());
+  for (size_t i = 0; i < requests.size(); i++) {
+    for (size_t j = i + 1; j < requests.size(); j++) {
+      const auto &a = requests[i];
+      const auto &b = requests[j];
+      if (a.end < b.begin || b.end < a.begin) {
+        continue;
+      }
+      EXPECT_TRUE(addresses[i] + a.size <= addresses[j] ||
+                  addresses[j] + b.size <= addresses[i]);
+    }
+  }
+}
+
+/// \returns the activation lifetimes of a chain of \p numBlocks residual
+/// blocks, each with a wide intermediate activation.
+static std::vector<AllocationRequest> getResidualChain(unsigned numBlocks) {
+  std::vector<AllocationRequest> requests;
+  uint64_t t = 0;
+  for (unsigned i = 0; i < numBlocks; i++) {
+    const void *handle = reinterpret_cast<void *>(uintptr_t(requests.size()));
+    // The block input stays live till the residual add.
+    requests.push_back({handle, 1000, t, t + 3});
+    // The expanded intermediate activation.
+    requests.push_back({handle, 4000 + 100 * i, t + 1, t + 2});
+    // The projected activation consumed by the residual add.
+    requests.push_back({handle, 1000, t + 2, t + 3});
+    t += 3;
+  }
+  return requests;
+}
+
+TEST(MemAlloc, planNoConflicts) {
+  auto requests = getResidualChain(8);
+  for (auto strategy :
+       {MemoryPlanningStrategy::FirstFit, MemoryPlanningStrategy::GreedyBySize,
+        MemoryPlanningStrategy::Best}) {
+    MemoryAllocator MA("test", 0);
+    std::vector<uint64_t> addresses;
+    ASSERT_TRUE(MA.allocateAll(requests, addresses, strategy));
+    checkNoConflicts(requests, addresses);
+    // No placement can beat the maximum size of simultaneously live buffers.
+    EXPECT_GE(MA.getMaxMemoryUsage(), MA.getMaxLiveSize(requests));
+  }
+}
+
+TEST(MemAlloc, planFragmentation) {
+  // A small buffer freed early leaves a hole which is too small for the big
+  // buffer allocated right after it.
+  const void *handle = nullptr;
+  std::vector<AllocationRequest> requests = {
+      {handle, 64, 0, 0}, {handle, 64, 0, 2}, {handle, 128, 1, 2}};
+
+  MemoryAllocator firstFit("test", 0);
+  std::vector<uint64_t> addresses;
+  ASSERT_TRUE(firstFit.allocateAll(requests, addresses,
+                                   MemoryPlanningStrategy::FirstFit));
+  checkNoConflicts(requests, addresses);
+  EXPECT_EQ(firstFit.getMaxMemoryUsage(), 256);
+
+  MemoryAllocator greedy("test", 0);
+  ASSERT_TRUE(greedy.allocateAll(requests, addresses,
+                                 MemoryPlanningStrategy::GreedyBySize));
+  checkNoConflicts(requests, addresses);
+  EXPECT_EQ(greedy.getMaxMemoryUsage(), 192);
+
+  // The best plan reaches the lower bound here.
+  MemoryAllocator best("test", 0);
+  ASSERT_TRUE(best.allocateAll(requests, addresses));
+  EXPECT_EQ(best.getMaxMemoryUsage(), best.getMaxLiveSize(requests));
+  EXPECT_EQ(best.getMaxMemoryUsage(), 192);
+}
+
+TEST(MemAlloc, planBestIsNeverWorse) {
+  auto requests = getResidualChain(16);
+  MemoryAllocator firstFit("test", 0);
+  MemoryAllocator best("test", 0);
+  std::vector<uint64_t> addresses;
+  ASSERT_TRUE(firstFit.allocateAll(requests, addresses,
+                                   MemoryPlanningStrategy::FirstFit));
+  ASSERT_TRUE(best.allocateAll(requests, addresses));
+  EXPECT_LE(best.getMaxMemoryUsage(), firstFit.getMaxMemoryUsage());
+}
+
+TEST(MemAlloc, planAboveLiveAllocations) {
+  MemoryAllocator MA("test", 0, 64);
+  void *handle = reinterpret_cast<void *>(1);
+  EXPECT_EQ(MA.allocate(100, handle), 0);
+
+  std::vector<AllocationRequest> requests = {{nullptr, 10, 0, 1},
+                                             {nullptr, 10, 1, 2}};
+  std::vector<uint64_t> addresses;
+  ASSERT_TRUE(MA.allocateAll(requests, addresses));
+  EXPECT_EQ(addresses[0], 128);
+  EXPECT_EQ(addresses[1], 192);
+  EXPECT_EQ(MA.getMaxMemoryUsage(), 256);
+}
+
+TEST(MemAlloc, planPoolSize) {
+  MemoryAllocator MA("test", 128, 64);
+  std::vector<AllocationRequest> requests = {
+      {nullptr, 64, 0, 1}, {nullptr, 64, 1, 2}, {nullptr, 64, 2, 3}};
+  std::vector<uint64_t> addresses;
+  // Only two of the buffers are live at the same time.
+  EXPECT_TRUE(MA.allocateAll(requests, addresses));
+  requests[2].begin = 1;
+  EXPECT_FALSE(MA.allocateAll(requests, addresses));
+}
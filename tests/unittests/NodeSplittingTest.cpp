@@ -24,6 +24,8 @@
 
 #include "gtest/gtest.h"
 
+#include "llvm/Support/CommandLine.h"
+
 using namespace glow;
 
 class NodeSplitting : public GraphOptz {};
@@ -1507,3 +1509,126 @@ TEST_F(NodeSplitting, UnaryOps) {
   EXPECT_EQ(countNodeKind(F_, Kinded::Kind::TouchNodeKind), 10);
   checkNumericalEquivalence(0);
 }
+
+///===---------------------------------------------------------------------===//
+///                               splitNodesAuto
+///===---------------------------------------------------------------------===//
+/// Test that a FullyConnected whose weights do not fit in the cache is split
+/// along its output channels in the fewest chunks fitting in the cache.
+TEST_F(NodeSplitting, AutoSplit_FullyConnected_Cache) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {4, 256}, "input", false);
+  bindings_.allocate(input)->getHandle<float>().randomize(-1.0, 1.0,
+                                                          mod_.getPRNG());
+  auto *weights = mod_.createConstant(ElemKind::FloatTy, {256, 256}, "weights");
+  weights->getPayloadMutable().getHandle<float>().randomize(-1.0, 1.0,
+                                                            mod_.getPRNG());
+  auto *bias = mod_.createConstant(ElemKind::FloatTy, {256}, "bias");
+  bias->getPayloadMutable().getHandle<float>().randomize(-1.0, 1.0,
+                                                         mod_.getPRNG());
+  Node *node = F_->createFullyConnected("fc", input, weights, bias);
+  SaveNode *output = F_->createSave("output", node);
+  bindings_.allocate(output->getPlaceholder());
+
+  // Save current function state as reference.
+  optimizedF_ = F_->clone(F_->getName().str() + "_optimized");
+
+  // The weights alone take 256KB, so splitting along the batch cannot fit the
+  // chunks in 64KB. Splitting along the output channels needs 5 chunks.
+  SplitNodeCostModel costModel;
+  costModel.cacheCapacity = 64 * 1024;
+  auto splitOption = getAutoSplitNodeOption(node, costModel);
+  ASSERT_TRUE(splitOption);
+  ASSERT_EQ(splitOption->getSplitDims().size(), 1);
+  EXPECT_EQ(splitOption->getSplitDims()[0], ShapeHW::DimW);
+  EXPECT_EQ(splitOption->splitAlongDim(ShapeHW::DimW, 256).size(), 5);
+
+  SplitNodeMap splitMap;
+  ASSIGN_VALUE_OR_FAIL_TEST(splitMap, ::glow::splitNodesAuto(F_, costModel));
+  runDCEPass(F_, cctx_);
+  EXPECT_EQ(splitMap[node].size(), 5);
+  EXPECT_EQ(countNodeKind(F_, Kinded::Kind::FullyConnectedNodeKind), 5);
+  for (auto &N : F_->getNodes()) {
+    if (N.getKind() == Kinded::Kind::FullyConnectedNodeKind) {
+      EXPECT_LE(N.getTotMemSize(), costModel.cacheCapacity);
+    }
+  }
+  checkNumericalEquivalence(0);
+}
+
+/// Test that nodes whose operands fit in the cache are not split.
+TEST_F(NodeSplitting, AutoSplit_SmallNode) {
+  auto *input = mod_.createPlaceholder(ElemKind::FloatTy, {4, 8}, "input",
+                                       false);
+  auto *weights = mod_.createConstant(ElemKind::FloatTy, {8, 8}, "weights");
+  auto *bias = mod_.createConstant(ElemKind::FloatTy, {8}, "bias");
+  Node *node = F_->createFullyConnected("fc", input, weights, bias);
+  F_->createSave("output", node);
+
+  SplitNodeCostModel costModel;
+  EXPECT_FALSE(getAutoSplitNodeOption(node, costModel));
+}
+
+#ifdef GLOW_WITH_CPU
+/// Compiles for the backend of \p EE a FullyConnected of \p input by
+/// \p weights and \p bias, and runs it. Sets \p numMatMuls to the number of
+/// MatMul nodes in the compiled Function. \returns the result.
+static Tensor runFullyConnected(ExecutionEngine &EE, Tensor &input,
+                                const Tensor &weights, const Tensor &bias,
+                                unsigned &numMatMuls) {
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+  auto *inputP = mod.createPlaceholder(&input.getType(), "input", false);
+  auto *weightsC = mod.createConstant("weights", weights.clone());
+  auto *biasC = mod.createConstant("bias", bias.clone());
+  auto *FC = F->createFullyConnected("fc", inputP, weightsC, biasC);
+  auto *save = F->createSave("ret", FC);
+  PlaceholderBindings bindings;
+  auto *resultT = bindings.allocate(save->getPlaceholder());
+  EE.setSkipModuleStrip(true);
+  EE.compile(CompilationMode::Infer);
+  numMatMuls = countNodeKind(F, Kinded::Kind::MatMulNodeKind);
+  updateInputPlaceholders(bindings, {inputP}, {&input});
+  EE.run(bindings);
+  return resultT->clone();
+}
+
+/// Test that -cpu-auto-split-nodes splits the MatMul lowered from a
+/// FullyConnected whose weights do not fit in the cache of a core, and that
+/// the chunks compute the same result as the Interpreter.
+TEST(NodeSplittingCPU, AutoSplitLoweredFullyConnected) {
+  auto &options = llvm::cl::getRegisteredOptions();
+  ASSERT_TRUE(options.count("cpu-auto-split-nodes"));
+  ASSERT_TRUE(options.count("cpu-auto-split-cache-size"));
+  auto *autoSplitOpt =
+      static_cast<llvm::cl::opt<bool> *>(options["cpu-auto-split-nodes"]);
+  auto *cacheSizeOpt = static_cast<llvm::cl::opt<unsigned> *>(
+      options["cpu-auto-split-cache-size"]);
+  unsigned oldCacheSize = *cacheSizeOpt;
+
+  PseudoRNG PRNG;
+  Tensor input(ElemKind::FloatTy, {4, 256});
+  Tensor weights(ElemKind::FloatTy, {256, 256});
+  Tensor bias(ElemKind::FloatTy, {256});
+  input.getHandle().randomize(-1.0, 1.0, PRNG);
+  weights.getHandle().randomize(-1.0, 1.0, PRNG);
+  bias.getHandle().randomize(-1.0, 1.0, PRNG);
+
+  unsigned numMatMuls = 0;
+  ExecutionEngine interpEE("Interpreter");
+  Tensor expected =
+      runFullyConnected(interpEE, input, weights, bias, numMatMuls);
+
+  // The weights alone take 256KB, so the MatMul is split along its output
+  // columns in 5 chunks fitting in 64KB.
+  *autoSplitOpt = true;
+  *cacheSizeOpt = 64;
+  ExecutionEngine cpuEE("CPU");
+  Tensor result = runFullyConnected(cpuEE, input, weights, bias, numMatMuls);
+  *autoSplitOpt = false;
+  *cacheSizeOpt = oldCacheSize;
+
+  EXPECT_EQ(numMatMuls, 5);
+  EXPECT_TRUE(result.isEqual(expected, 1e-4));
+}
+#endif // GLOW_WITH_CPU
@@ -764,6 +764,46 @@ TEST(exporter, RowwiseQuantizedFullyConnected) {
       *rwqFC->getOffsets().getType()));
 }
 
+/// Test that ScaledDotProductAttention is exported as the subgraph it is
+/// folded from.
+TEST(exporter, ScaledDotProductAttention) {
+  ExecutionEngine EE{};
+  auto &mod = EE.getModule();
+  auto *F = mod.createFunction("F");
+
+  auto *Q = mod.createPlaceholder(ElemKind::FloatTy, {2, 4, 8}, "Q", false);
+  auto *K = mod.createPlaceholder(ElemKind::FloatTy, {2, 6, 8}, "K", false);
+  auto *V = mod.createPlaceholder(ElemKind::FloatTy, {2, 6, 3}, "V", false);
+  auto *M = mod.createPlaceholder(ElemKind::FloatTy, {2, 1, 6}, "M", false);
+  auto *SDPA = F->createScaledDotProductAttention("attention", Q, K, V, M,
+                                                  0.125);
+  auto *save = F->createSave("save_out", SDPA);
+  ASSERT_TRUE(F->verify());
+
+  PlaceholderBindings bindings;
+  bindings.allocate({Q, K, V, M, save->getPlaceholder()});
+
+  // Save and reload F.
+  Function *R;
+  Module reloadMod;
+  ASSIGN_VALUE_OR_FAIL_TEST(
+      R, saveAndReloadFunction(
+             reloadMod, F, {"Q", "K", "V", "M"},
+             {Q->getType(), K->getType(), V->getType(), M->getType()}));
+
+  EXPECT_EQ(getNodesByType(R, Kinded::Kind::BatchMatMulNodeKind).size(), 2);
+  EXPECT_EQ(getNodesByType(R, Kinded::Kind::SoftMaxNodeKind).size(), 1);
+  EXPECT_EQ(
+      getNodesByType(R, Kinded::Kind::ScaledDotProductAttentionNodeKind).size(),
+      0);
+
+  SaveNode *saveReloaded;
+  ASSIGN_VALUE_OR_FAIL_TEST(saveReloaded, getSingleNodeWithKind<SaveNode>(
+                                              R, Kinded::Kind::SaveNodeKind));
+  EXPECT_TRUE(saveReloaded->getInput().getType()->isEqual(
+      *SDPA->getResult().getType()));
+}
+
 TEST_F(ConstFoldReloadTest, exportGraphWithOneConstFoldingRecord) {
   Placeholder *I =
       mod_.createPlaceholder(ElemKind::Float16Ty, {2, 100}, "input",
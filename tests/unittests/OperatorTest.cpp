@@ -2212,6 +2212,107 @@ TEST_P(OperatorTest, ParallelBatchMatMul) {
   EXPECT_NEAR(H.at({1, 2, 0}), -54, 0.001);
 }
 
+/// Helper to test ScaledDotProductAttention against a reference computed in
+/// double precision. The mask has \p maskQueryLen rows per batch. The queries
+/// and the keys span several tiles and blocks of the CPU kernel. If
+/// \p maskRow, the keys of the last query of the last batch are all masked
+/// out, which gives NaN like the SoftMax.
+static void testScaledDotProductAttention(PlaceholderBindings &bindings,
+                                          Module &mod, Function *F,
+                                          ExecutionEngine &EE,
+                                          dim_t maskQueryLen, bool maskRow) {
+  const dim_t B = 2, Lq = 11, Lk = 70, D = 5, Dv = 3;
+  const float scale = 0.4;
+  auto *Q = mod.createPlaceholder(ElemKind::FloatTy, {B, Lq, D}, "Q", false);
+  auto *K = mod.createPlaceholder(ElemKind::FloatTy, {B, Lk, D}, "K", false);
+  auto *V = mod.createPlaceholder(ElemKind::FloatTy, {B, Lk, Dv}, "V", false);
+  auto *M = mod.createPlaceholder(ElemKind::FloatTy, {B, maskQueryLen, Lk},
+                                  "M", false);
+  auto QH = bindings.allocate(Q)->getHandle();
+  auto KH = bindings.allocate(K)->getHandle();
+  auto VH = bindings.allocate(V)->getHandle();
+  auto MH = bindings.allocate(M)->getHandle();
+  QH.randomize(-1.0, 1.0, mod.getPRNG());
+  KH.randomize(-1.0, 1.0, mod.getPRNG());
+  VH.randomize(-1.0, 1.0, mod.getPRNG());
+  MH.randomize(-2.0, 2.0, mod.getPRNG());
+  // Mask out every third key of the first batch.
+  for (dim_t q = 0; q < maskQueryLen; q++) {
+    for (dim_t k = 0; k < Lk; k += 3) {
+      MH.at({0, q, k}) = -INFINITY;
+    }
+  }
+  if (maskRow) {
+    for (dim_t k = 0; k < Lk; k++) {
+      MH.at({B - 1, maskQueryLen - 1, k}) = -INFINITY;
+    }
+  }
+
+  auto *SDPA = F->createScaledDotProductAttention("attention", Q, K, V, M,
+                                                  scale);
+  auto *save = F->createSave("save", SDPA);
+  auto *result = bindings.allocate(save->getPlaceholder());
+
+  EE.compile(CompilationMode::Infer);
+  EE.run(bindings);
+
+  auto H = result->getHandle();
+  std::vector<double> probs(Lk);
+  for (dim_t b = 0; b < B; b++) {
+    for (dim_t q = 0; q < Lq; q++) {
+      const dim_t maskRowIdx = maskQueryLen == 1 ? 0 : q;
+      double max = -INFINITY;
+      for (dim_t k = 0; k < Lk; k++) {
+        double score = 0;
+        for (dim_t d = 0; d < D; d++) {
+          score += QH.at({b, q, d}) * KH.at({b, k, d});
+        }
+        probs[k] = score * scale + MH.at({b, maskRowIdx, k});
+        max = std::max(max, probs[k]);
+      }
+      double sum = 0;
+      for (dim_t k = 0; k < Lk; k++) {
+        probs[k] = std::exp(probs[k] - max);
+        sum += probs[k];
+      }
+      for (dim_t v = 0; v < Dv; v++) {
+        double expected = 0;
+        for (dim_t k = 0; k < Lk; k++) {
+          expected += probs[k] * VH.at({b, k, v});
+        }
+        expected /= sum;
+        if (std::isnan(expected)) {
+          EXPECT_TRUE(std::isnan(H.at({b, q, v})));
+        } else {
+          EXPECT_NEAR(H.at({b, q, v}), expected, 1e-5);
+        }
+      }
+    }
+  }
+}
+
+/// Test ScaledDotProductAttention with a mask per query.
+TEST_P(OperatorTest, ScaledDotProductAttention) {
+  CHECK_IF_ENABLED();
+  testScaledDotProductAttention(bindings_, mod_, F_, EE_, /* maskQueryLen */ 11,
+                                /* maskRow */ false);
+}
+
+/// Test ScaledDotProductAttention with a mask broadcast over the queries.
+TEST_P(OperatorTest, ScaledDotProductAttentionBroadcastMask) {
+  CHECK_IF_ENABLED();
+  testScaledDotProductAttention(bindings_, mod_, F_, EE_, /* maskQueryLen */ 1,
+                                /* maskRow */ false);
+}
+
+/// Test that the rows of ScaledDotProductAttention whose keys are all masked
+/// out are NaN, like the SoftMax of the scores.
+TEST_P(OperatorTest, ScaledDotProductAttentionFullyMaskedRow) {
+  CHECK_IF_ENABLED();
+  testScaledDotProductAttention(bindings_, mod_, F_, EE_, /* maskQueryLen */ 11,
+                                /* maskRow */ true);
+}
+
 static FunctionTensorPair
 createAndInitParallelBatchMatMulTest(glow::PlaceholderBindings &bindings,
                                      glow::ExecutionEngine &EE) {
@@ -5307,6 +5408,99 @@ TEST_P(OperatorTest, FCWithFlatten) {
   }
 }
 
+/// Helper to test a FullyConnected whose {32, 32} \p weights are mostly zero
+/// against a reference computed with the dense weights. The CPU backend must
+/// store the weights in blocks of \p blockRows x \p blockCols, which the
+/// sparsity pattern of \p weights forces. The input has a number of rows that
+/// is not a multiple of the tile of the kernel.
+static void testBlockSparseFC(PlaceholderBindings &bindings, Module &mod,
+                              Function *F, ExecutionEngine &EE,
+                              llvm::StringRef backendName, Constant *weights,
+                              dim_t blockRows, dim_t blockCols) {
+  const dim_t M = 6, K = 32, N = 32;
+  auto *input =
+      mod.createPlaceholder(ElemKind::FloatTy, {M, K}, "input", false);
+  auto *bias = mod.createConstant(ElemKind::FloatTy, {N}, "bias");
+  auto IH = bindings.allocate(input)->getHandle();
+  IH.randomize(-1.0, 1.0, mod.getPRNG());
+  auto BH = bias->getPayloadMutable().getHandle();
+  BH.randomize(-1.0, 1.0, mod.getPRNG());
+
+  auto *FC = F->createFullyConnected("fc", input, weights, bias);
+  auto *save = F->createSave("save", FC);
+  auto *result = bindings.allocate(save->getPlaceholder());
+
+  EE.compile(CompilationMode::Infer);
+  EE.run(bindings);
+
+  if (backendName == "CPU") {
+    unsigned numSparseFCs = 0;
+    for (auto &node : F->getNodes()) {
+      if (auto *BSFC = llvm::dyn_cast<BlockSparseFullyConnectedNode>(&node)) {
+        EXPECT_EQ(BSFC->getBlockRows(), blockRows);
+        EXPECT_EQ(BSFC->getBlockCols(), blockCols);
+        numSparseFCs++;
+      }
+    }
+    EXPECT_EQ(numSparseFCs, 1);
+  }
+
+  auto WH = weights->getPayload().getHandle();
+  auto H = result->getHandle();
+  for (dim_t m = 0; m < M; m++) {
+    for (dim_t n = 0; n < N; n++) {
+      double expected = BH.at({n});
+      for (dim_t k = 0; k < K; k++) {
+        expected += IH.at({m, k}) * WH.at({k, n});
+      }
+      EXPECT_NEAR(H.at({m, n}), expected, 1e-5);
+    }
+  }
+}
+
+/// Test a FullyConnected whose weights have a single non-zero 4x8 block.
+TEST_P(OperatorTest, BlockSparseFC4x8) {
+  CHECK_IF_ENABLED();
+  auto *weights = mod_.createConstant(ElemKind::FloatTy, {32, 32}, "weights");
+  auto WH = weights->getPayloadMutable().getHandle();
+  WH.clear(0);
+  for (dim_t i = 0; i < 4; i++) {
+    for (dim_t j = 0; j < 8; j++) {
+      WH.at({8 + i, 8 + j}) = 0.1 * (i * 8 + j + 1);
+    }
+  }
+  testBlockSparseFC(bindings_, mod_, F_, EE_, getBackendName(), weights,
+                    /* blockRows */ 4, /* blockCols */ 8);
+}
+
+/// Test a FullyConnected whose weights have 16 non-zero 1x8 blocks, each one
+/// in a different 4x8 block.
+TEST_P(OperatorTest, BlockSparseFC1x8) {
+  CHECK_IF_ENABLED();
+  auto *weights = mod_.createConstant(ElemKind::FloatTy, {32, 32}, "weights");
+  auto WH = weights->getPayloadMutable().getHandle();
+  WH.clear(0);
+  for (dim_t i = 0; i < 16; i++) {
+    WH.at({2 * i, (i % 4) * 8 + i % 8}) = 0.1 * (i + 1);
+  }
+  testBlockSparseFC(bindings_, mod_, F_, EE_, getBackendName(), weights,
+                    /* blockRows */ 1, /* blockCols */ 8);
+}
+
+/// Test a FullyConnected whose weights have one non-zero element per row,
+/// spread over too many 1x8 blocks.
+TEST_P(OperatorTest, BlockSparseFC1x1) {
+  CHECK_IF_ENABLED();
+  auto *weights = mod_.createConstant(ElemKind::FloatTy, {32, 32}, "weights");
+  auto WH = weights->getPayloadMutable().getHandle();
+  WH.clear(0);
+  for (dim_t i = 0; i < 32; i++) {
+    WH.at({i, (i * 7) % 32}) = 0.1 * (i + 1);
+  }
+  testBlockSparseFC(bindings_, mod_, F_, EE_, getBackendName(), weights,
+                    /* blockRows */ 1, /* blockCols */ 1);
+}
+
 static FunctionTensorPair
 createAndInitBasicFCTest(glow::PlaceholderBindings &bindings,
                          glow::ExecutionEngine &EE) {
@@ -5516,6 +5710,86 @@ TEST_P(OperatorTest, RescaleNode) {
   EXPECT_NEAR(RO.raw(0), 40, 1);
 }
 
+/// Check that a quantized SparseLengthsSum reading the result of a
+/// RescaleQuantized, which may share the buffer of its input, uses the scale
+/// and offset of the rescaled type.
+TEST_P(OperatorTest, SLSOfRescaledSharedBuffer) {
+  CHECK_IF_ENABLED();
+
+  auto *input = mod_.createPlaceholder(ElemKind::Int8QTy, {4, 8}, 0.02, 0,
+                                       "input", false);
+  auto IH = bindings_.allocate(input)->getHandle<int8_t>();
+  IH.randomize(-128, 127, mod_.getPRNG());
+  auto *indices =
+      mod_.createPlaceholder(ElemKind::Int64ITy, {6}, "indices", false);
+  auto *lengths =
+      mod_.createPlaceholder(ElemKind::Int32ITy, {2}, "lengths", false);
+  bindings_.allocate(indices)->getHandle<int64_t>() = {0, 1, 2, 3, 1, 3};
+  bindings_.allocate(lengths)->getHandle<int32_t>() = {2, 4};
+
+  auto *tanh = F_->createIntTanh(
+      "tanh", input, mod_.uniqueType(ElemKind::Int8QTy, {4, 8}, 1.f / 128, 0));
+  auto *rescale = F_->createRescaleQuantized(
+      "rescale", tanh, mod_.uniqueType(ElemKind::Int8QTy, {4, 8}, 0.04, 10));
+  auto *SLS = F_->createSparseLengthsSum("SLS", rescale, indices, lengths);
+  auto *DQ = F_->createDequantize("dequantize", SLS, ElemKind::FloatTy);
+  auto *save = F_->createSave("save", DQ);
+  bindings_.allocate(save->getPlaceholder());
+
+  EE_.compile(CompilationMode::Infer);
+  EE_.run(bindings_);
+
+  auto RH = bindings_.get(save->getPlaceholder())->getHandle();
+  const std::vector<std::vector<dim_t>> segments = {{0, 1}, {2, 3, 1, 3}};
+  for (dim_t i = 0; i < 2; i++) {
+    for (dim_t j = 0; j < 8; j++) {
+      float expected = 0;
+      for (dim_t row : segments[i]) {
+        expected += std::tanh(IH.at({row, j}) * 0.02f);
+      }
+      EXPECT_NEAR(RH.at({i, j}), expected, 0.15);
+    }
+  }
+}
+
+/// Check a lookup table with as many entries as there are elements, applied
+/// within a data-parallel kernel that also reads a broadcast operand.
+TEST_P(OperatorTest, IntLookupTableAfterBroadcast256) {
+  CHECK_IF_ENABLED();
+
+  auto *input = mod_.createPlaceholder(ElemKind::Int8QTy, {16, 16}, 1.0, 0,
+                                       "input", false);
+  auto *bias =
+      mod_.createPlaceholder(ElemKind::Int8QTy, {1, 16}, 1.0, 0, "bias", false);
+  auto IH = bindings_.allocate(input)->getHandle<int8_t>();
+  auto BH = bindings_.allocate(bias)->getHandle<int8_t>();
+  IH.randomize(-50, 50, mod_.getPRNG());
+  BH.randomize(-50, 50, mod_.getPRNG());
+
+  // Negates its input.
+  std::vector<int8_t> mapping(256);
+  for (int i = 0; i < 256; i++) {
+    mapping[i] = std::min(127, 128 - i);
+  }
+
+  auto qTy = mod_.uniqueType(ElemKind::Int8QTy, {16, 16}, 1.0, 0);
+  auto *tile = F_->createTile("tile", bias, 16, 0);
+  auto *add = F_->createAdd("add", qTy, input, tile);
+  auto *LUT = F_->createIntLookupTable("lut", add, mapping, qTy);
+  auto *save = F_->createSave("save", LUT);
+  bindings_.allocate(save->getPlaceholder());
+
+  EE_.compile(CompilationMode::Infer);
+  EE_.run(bindings_);
+
+  auto RH = bindings_.get(save->getPlaceholder())->getHandle<int8_t>();
+  for (dim_t i = 0; i < 16; i++) {
+    for (dim_t j = 0; j < 16; j++) {
+      EXPECT_EQ(RH.at({i, j}), -(IH.at({i, j}) + BH.at({0, j})));
+    }
+  }
+}
+
 TEST_P(OperatorTest, QuantizedArithmeticRescaled) {
   CHECK_IF_ENABLED();
 
@@ -5626,6 +5900,80 @@ TEST_P(OperatorTest, QuantizedArithmeticRescaled) {
   }
 }
 
+/// Check a chain of quantized elementwise operations with different scales and
+/// offsets. The length is not a multiple of the vector width used by the LLVM
+/// backends for quantized data-parallel kernels, so that both their vectorized
+/// and their scalar loops are exercised.
+TEST_P(OperatorTest, QuantizedElementwiseChain) {
+  CHECK_IF_ENABLED();
+
+  const dim_t len = 1003;
+  auto TQA = mod_.uniqueType(ElemKind::Int8QTy, {len}, 0.5, -3);
+  auto TQB = mod_.uniqueType(ElemKind::Int8QTy, {len}, 0.25, 7);
+  auto TAdd = mod_.uniqueType(ElemKind::Int8QTy, {len}, 0.7, 2);
+  auto TSub = mod_.uniqueType(ElemKind::Int8QTy, {len}, 0.6, -1);
+  auto TMax = mod_.uniqueType(ElemKind::Int8QTy, {len}, 0.5, 0);
+  auto TMin = mod_.uniqueType(ElemKind::Int8QTy, {len}, 0.4, 4);
+  auto TMul = mod_.uniqueType(ElemKind::Int8QTy, {len}, 10.0, -5);
+
+  auto *QA = mod_.createPlaceholder(ElemKind::Int8QTy, {len}, TQA->getScale(),
+                                    TQA->getOffset(), "QA", false);
+  auto *QB = mod_.createPlaceholder(ElemKind::Int8QTy, {len}, TQB->getScale(),
+                                    TQB->getOffset(), "QB", false);
+  bindings_.allocate(QA)->getHandle<int8_t>().randomize(-100, 100,
+                                                        mod_.getPRNG());
+  bindings_.allocate(QB)->getHandle<int8_t>().randomize(-100, 100,
+                                                        mod_.getPRNG());
+
+  Node *add = F_->createAdd("add", TAdd, QA, QB);
+  Node *sub = F_->createSub("sub", TSub, add, QA);
+  Node *max = F_->createMax("max", TMax, sub, QB);
+  Node *min = F_->createMin("min", TMin, max, QA);
+  Node *mul = F_->createMul("mul", TMul, min, QB);
+  auto *addPH = F_->createSave("saveAdd", add)->getPlaceholder();
+  auto *subPH = F_->createSave("saveSub", sub)->getPlaceholder();
+  auto *maxPH = F_->createSave("saveMax", max)->getPlaceholder();
+  auto *minPH = F_->createSave("saveMin", min)->getPlaceholder();
+  auto *mulPH = F_->createSave("saveMul", mul)->getPlaceholder();
+  for (auto *PH : {addPH, subPH, maxPH, minPH, mulPH}) {
+    bindings_.allocate(PH);
+  }
+
+  EE_.compile(CompilationMode::Infer);
+  EE_.run(bindings_);
+
+  auto dequantize = [](TypeRef T, int8_t val) {
+    return T->getScale() * (val - T->getOffset());
+  };
+  // Check that each element of the result \p outPH of the type \p TO is the
+  // float result of \p op applied to the inputs \p lhsPH and \p rhsPH of the
+  // types \p TL and \p TR, clipped to the range of \p TO.
+  auto check = [&](Placeholder *lhsPH, TypeRef TL, Placeholder *rhsPH,
+                   TypeRef TR, Placeholder *outPH, TypeRef TO,
+                   std::function<float(float, float)> op) {
+    auto LH = bindings_.get(lhsPH)->getHandle<int8_t>();
+    auto RH = bindings_.get(rhsPH)->getHandle<int8_t>();
+    auto OH = bindings_.get(outPH)->getHandle<int8_t>();
+    float lo = dequantize(TO, -128);
+    float hi = dequantize(TO, 127);
+    for (dim_t i = 0; i < len; i++) {
+      float expected =
+          op(dequantize(TL, LH.at({i})), dequantize(TR, RH.at({i})));
+      expected = std::min(std::max(expected, lo), hi);
+      EXPECT_NEAR(dequantize(TO, OH.at({i})), expected, 1.5 * TO->getScale());
+    }
+  };
+  check(QA, TQA, QB, TQB, addPH, TAdd, [](float a, float b) { return a + b; });
+  check(addPH, TAdd, QA, TQA, subPH, TSub,
+        [](float a, float b) { return a - b; });
+  check(subPH, TSub, QB, TQB, maxPH, TMax,
+        [](float a, float b) { return std::max(a, b); });
+  check(maxPH, TMax, QA, TQA, minPH, TMin,
+        [](float a, float b) { return std::min(a, b); });
+  check(minPH, TMin, QB, TQB, mulPH, TMul,
+        [](float a, float b) { return a * b; });
+}
+
 static FunctionTensorPair
 createAndInitTransposeNet(glow::PlaceholderBindings &bindings,
                           glow::ExecutionEngine &EE) {
@@ -11620,6 +11968,84 @@ static void testFusedRowwiseQuantizedSparseLengthsWeightedSum(
   EXPECT_TRUE(expected.isEqual(result, allowedError));
 }
 
+/// Helper to test FusedRowwiseQuantizedSparseLengthsWeightedSums over
+/// different tables with the same number of segments, which backends may
+/// compute with a single grouped kernel, using index type \p ITy.
+template <typename IndexType>
+static void testGroupedFusedRowwiseQuantizedSparseLengthsWeightedSum(
+    glow::PlaceholderBindings &bindings, glow::Module &mod, glow::Function *F,
+    glow::ExecutionEngine &EE, ElemKind ITy) {
+  const std::vector<dim_t> tableRows = {5, 7, 3};
+  const std::vector<int32_t> lengthsData = {2, 0, 3};
+  const dim_t numIndices = 5;
+  const dim_t lineSize = 4;
+
+  std::vector<Tensor> tables;
+  std::vector<Placeholder *> weights, indices;
+  std::vector<SaveNode *> saves;
+  for (dim_t t = 0; t < tableRows.size(); t++) {
+    auto suffix = std::to_string(t);
+    Tensor data(ElemKind::FloatTy, {tableRows[t], lineSize});
+    data.getHandle().randomize(-1.0, 2.0, mod.getPRNG());
+    weights.push_back(mod.createPlaceholder(ElemKind::FloatTy, {numIndices},
+                                            "weights" + suffix, false));
+    indices.push_back(
+        mod.createPlaceholder(ITy, {numIndices}, "indices" + suffix, false));
+    auto *lengths = mod.createPlaceholder(ElemKind::Int32ITy, {3},
+                                          "lengths" + suffix, false);
+    bindings.allocate(weights.back())
+        ->getHandle()
+        .randomize(-1.0, 1.0, mod.getPRNG());
+    bindings.allocate(indices.back())
+        ->getHandle<IndexType>()
+        .randomize(0, tableRows[t] - 1, mod.getPRNG());
+    bindings.allocate(lengths)->getHandle<int32_t>() = lengthsData;
+
+    auto *SLWS = F->createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+        "slws" + suffix, data, weights.back(), indices.back(), lengths);
+    saves.push_back(F->createSave("save" + suffix, SLWS));
+    bindings.allocate(saves.back()->getPlaceholder());
+    tables.push_back(std::move(data));
+  }
+
+  EE.compile(CompilationMode::Infer);
+  EE.run(bindings);
+
+  for (dim_t t = 0; t < tableRows.size(); t++) {
+    auto DH = tables[t].getHandle();
+    auto WH = bindings.get(weights[t])->getHandle();
+    auto IH = bindings.get(indices[t])->getHandle<IndexType>();
+    auto RH = bindings.get(saves[t]->getPlaceholder())->getHandle();
+    dim_t idx = 0;
+    for (dim_t seg = 0; seg < lengthsData.size(); seg++) {
+      std::vector<float> expected(lineSize, 0);
+      for (int32_t i = 0; i < lengthsData[seg]; i++, idx++) {
+        for (dim_t j = 0; j < lineSize; j++) {
+          expected[j] += WH.raw(idx) * DH.at({dim_t(IH.raw(idx)), j});
+        }
+      }
+      for (dim_t j = 0; j < lineSize; j++) {
+        EXPECT_NEAR(RH.at({seg, j}), expected[j], 0.05);
+      }
+    }
+  }
+}
+
+/// Test Fused-RWQ-SLWS over several tables in Float.
+TEST_P(OperatorTest, GroupedFusedRowwiseQuantizedSparseLengthsWeightedSum) {
+  CHECK_IF_ENABLED();
+  testGroupedFusedRowwiseQuantizedSparseLengthsWeightedSum<int64_t>(
+      bindings_, mod_, F_, EE_, ElemKind::Int64ITy);
+}
+
+/// Test Fused-RWQ-SLWS over several tables in Float. Int32 indices.
+TEST_P(OperatorTest,
+       GroupedFusedRowwiseQuantizedSparseLengthsWeightedSum_Int32) {
+  CHECK_IF_ENABLED();
+  testGroupedFusedRowwiseQuantizedSparseLengthsWeightedSum<int32_t>(
+      bindings_, mod_, F_, EE_, ElemKind::Int32ITy);
+}
+
 /// Test Fused-RWQ-SLWS in Float.
 TEST_P(OperatorTest, FusedRowwiseQuantizedSparseLengthsWeightedSum_Float) {
   CHECK_IF_ENABLED();
@@ -19,6 +19,12 @@
 
 #include "gtest/gtest.h"
 
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+#include <future>
+
 using namespace glow;
 using namespace glow::runtime;
 
@@ -217,3 +223,166 @@ TEST_F(ProvisionerTest, provisionReplicateWithBackendSpecificNodeInfo) {
   ASSERT_EQ(cloneNodeInfoFinal[cloneMM]["CPU_OptionB"].size(), 1);
   EXPECT_EQ(cloneNodeInfoFinal[cloneMM]["CPU_OptionB"][0], "val2");
 }
+
+/// Create in \p mod the function \p name of a network computing a
+/// FullyConnected with constant weights, lowered for the CPU, and \returns the
+/// DAG of the network placed on device 0.
+static DAGListTy setupConstantsNetwork(Module &mod, llvm::StringRef name) {
+  auto *F = mod.createFunction(name);
+  auto *X = mod.createPlaceholder(ElemKind::FloatTy, {16, 256}, "X", false);
+  auto *W = mod.createConstant(ElemKind::FloatTy, {256, 256}, "W");
+  auto *B = mod.createConstant(ElemKind::FloatTy, {256}, "B");
+  W->getPayloadMutable().getHandle().clear(0.5);
+  B->getPayloadMutable().getHandle().clear(0.25);
+  auto *FC = F->createFullyConnected("FC", X, W, B);
+  F->createSave("save", FC);
+  CompilationContext cctx;
+  lower(F, cctx);
+
+  DAGListTy networks;
+  DAGNodePtrVec nodes;
+  auto rootNode = glow::make_unique<DAGNode>();
+  auto node = glow::make_unique<DAGNode>();
+  rootNode->name = "root_" + name.str();
+  rootNode->children.push_back(node.get());
+  node->name = name;
+  node->logicalDevices = {0};
+  node->backendName = "CPU";
+  nodes.push_back(std::move(node));
+  networks.push_back({std::move(rootNode), std::move(nodes)});
+  return networks;
+}
+
+/// Run the function \p name of \p mod, created by setupConstantsNetwork(), on
+/// \p device and check its output.
+static void runConstantsNetwork(DeviceManager *device, Module &mod,
+                                llvm::StringRef name) {
+  auto context = glow::make_unique<ExecutionContext>();
+  auto *bindings = context->getPlaceholderBindings();
+  bindings->allocate(mod.getPlaceholders());
+  auto XH = bindings->get(mod.getPlaceholderByNameSlow("X"))->getHandle();
+  for (dim_t i = 0; i < XH.size(); i++) {
+    XH.raw(i) = (i % 7) * 0.125f;
+  }
+
+  std::promise<std::unique_ptr<ExecutionContext>> promise;
+  auto future = promise.get_future();
+  device->runFunction(name, std::move(context),
+                      [&promise](RunIdentifierTy, Error err,
+                                 std::unique_ptr<ExecutionContext> ctx) {
+                        EXIT_ON_ERR(std::move(err));
+                        promise.set_value(std::move(ctx));
+                      });
+  context = future.get();
+
+  bindings = context->getPlaceholderBindings();
+  auto XHOut = bindings->get(mod.getPlaceholderByNameSlow("X"))->getHandle();
+  auto RH = bindings->get(mod.getPlaceholderByNameSlow("save"))->getHandle();
+  for (dim_t i = 0; i < 16; i++) {
+    float sum = 0;
+    for (dim_t k = 0; k < 256; k++) {
+      sum += XHOut.at({i, k});
+    }
+    for (dim_t j = 0; j < 256; j++) {
+      EXPECT_FLOAT_EQ(RH.at({i, j}), 0.5f * sum + 0.25f);
+    }
+  }
+}
+
+/// Check that the functions of networks provisioned separately share a single
+/// constants memory block on the device when their constants are
+/// bit-identical, and compute the same results out of it.
+TEST_F(ProvisionerTest, shareConstantsAcrossNetworks) {
+  DeviceManagerMapTy devices;
+  std::unique_ptr<DeviceManager> device(
+      new CPUDeviceManager(DeviceConfig("CPU")));
+  DeviceManager *CPU = device.get();
+  devices.emplace(0, std::move(device));
+  Provisioner provisioner(devices);
+
+  std::vector<std::unique_ptr<Module>> modules;
+  std::vector<uint64_t> usedMemory;
+  for (unsigned i = 0; i < 2; i++) {
+    auto mod = glow::make_unique<Module>();
+    auto networks = setupConstantsNetwork(*mod, "network" + std::to_string(i));
+    CompilationContext cctx;
+    EXPECT_FALSE(ERR_TO_BOOL(provisioner.provision(networks, *mod, cctx)));
+    usedMemory.push_back(CPU->getMaximumMemory() - CPU->getAvailableMemory());
+    modules.push_back(std::move(mod));
+  }
+
+  // The constants of the second network take no extra memory.
+  EXPECT_GE(usedMemory[0], 256 * 256 * sizeof(float));
+  EXPECT_EQ(usedMemory[1], usedMemory[0]);
+
+  for (unsigned i = 0; i < 2; i++) {
+    runConstantsNetwork(CPU, *modules[i], "network" + std::to_string(i));
+  }
+}
+
+/// Check that provisioning a network only erases the duplicate Constants of
+/// the Module if constant deduplication is enabled.
+TEST_F(ProvisionerTest, deduplicateConstantsOnlyIfEnabled) {
+  for (bool deduplicate : {false, true}) {
+    DeviceManagerMapTy devices;
+    std::unique_ptr<DeviceManager> device(
+        new CPUDeviceManager(DeviceConfig("CPU")));
+    DeviceManager *CPU = device.get();
+    devices.emplace(0, std::move(device));
+    Provisioner provisioner(devices);
+
+    Module mod;
+    auto networks = setupConstantsNetwork(mod, "network");
+    // A copy of the weights used by a Function the caller keeps.
+    auto *W = mod.getConstantByName("W");
+    auto *W2 = mod.createConstant("W2", W->getPayload().clone());
+    auto *G = mod.createFunction("other");
+    G->createSave("save_other", G->createRELU("relu", W2));
+
+    CompilationContext cctx;
+    cctx.optimizationOpts.enableConstantDeduplication = deduplicate;
+    EXPECT_FALSE(ERR_TO_BOOL(provisioner.provision(networks, mod, cctx)));
+    if (deduplicate) {
+      EXPECT_EQ(mod.getConstants().size(), 2);
+    } else {
+      EXPECT_EQ(mod.getConstants().size(), 3);
+      EXPECT_EQ(mod.getConstantByName("W"), W);
+      EXPECT_EQ(mod.getConstantByName("W2"), W2);
+    }
+    EXPECT_TRUE(G->verify());
+    runConstantsNetwork(CPU, mod, "network");
+  }
+}
+
+/// Check that the constants of a network are memory-mapped from the weights
+/// file of -cpu-weights-dir when constant sharing is enabled as well.
+TEST_F(ProvisionerTest, shareConstantsWithCPUWeightsDir) {
+  auto &options = llvm::cl::getRegisteredOptions();
+  ASSERT_TRUE(options.count("cpu-weights-dir"));
+  auto *weightsDirOpt =
+      static_cast<llvm::cl::opt<std::string> *>(options["cpu-weights-dir"]);
+  llvm::SmallString<64> weightsDir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("cpu-weights", weightsDir));
+  *weightsDirOpt = weightsDir.str().str();
+
+  DeviceManagerMapTy devices;
+  std::unique_ptr<DeviceManager> device(
+      new CPUDeviceManager(DeviceConfig("CPU")));
+  DeviceManager *CPU = device.get();
+  devices.emplace(0, std::move(device));
+  Provisioner provisioner(devices);
+
+  Module mod;
+  auto networks = setupConstantsNetwork(mod, "network");
+  CompilationContext cctx;
+  ASSERT_TRUE(cctx.optimizationOpts.enableConstantSharing);
+  EXPECT_FALSE(ERR_TO_BOOL(provisioner.provision(networks, mod, cctx)));
+  runConstantsNetwork(CPU, mod, "network");
+
+  llvm::SmallString<64> weightsFile(weightsDir);
+  llvm::sys::path::append(weightsFile, "network.weights");
+  EXPECT_TRUE(llvm::sys::fs::exists(weightsFile));
+
+  *weightsDirOpt = "";
+  llvm::sys::fs::remove_directories(weightsDir);
+}
@@ -18,6 +18,7 @@
 
 #include "glow/Backends/DeviceManager.h"
 #include "glow/ExecutionContext/ExecutionContext.h"
+#include "glow/ExecutionContext/KernelProfile.h"
 #include "glow/ExecutionEngine/ExecutionEngine.h"
 #include "glow/Graph/Graph.h"
 #include "glow/IR/IRBuilder.h"
@@ -27,6 +28,7 @@
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include <chrono>
@@ -846,4 +848,58 @@ TEST(TraceEventsTest, MergeEvents) {
   ASSERT_EQ(tc2->getTraceEvents().size(), 4);
 }
 
+/// Check that a KernelProfile aggregates auto-instrumentation events, selects
+/// the hottest kernels and survives a serialization round-trip.
+TEST(TraceEventsTest, KernelProfile) {
+  std::list<TraceEvent> events;
+  auto addEvent = [&events](llvm::StringRef name, TraceLevel level,
+                            uint64_t duration, llvm::StringRef kind) {
+    std::map<std::string, std::string> args;
+    if (!kind.empty()) {
+      args["kind"] = kind.str();
+    }
+    events.emplace_back(name, level, TraceEvent::now(), duration, 0, args);
+  };
+  addEvent("conv", TraceLevel::OPERATOR, 70, "convolution");
+  addEvent("conv", TraceLevel::OPERATOR, 80, "convolution");
+  addEvent("fc", TraceLevel::OPERATOR, 40, "matmul");
+  addEvent("relu", TraceLevel::OPERATOR, 10, "max");
+  // Manual and non-operator events are not part of the profile.
+  addEvent("manual", TraceLevel::OPERATOR, 1000, "");
+  addEvent("runtime", TraceLevel::RUNTIME, 1000, "copy");
+
+  KernelProfile profile;
+  profile.addTraceEvents(events);
+  ASSERT_EQ(profile.getEntries().size(), 3);
+  EXPECT_EQ(profile.getTotalTime(), 200);
+  const auto *conv = profile.getEntry("conv");
+  ASSERT_TRUE(conv);
+  EXPECT_EQ(conv->kind, "convolution");
+  EXPECT_EQ(conv->count, 2);
+  EXPECT_EQ(conv->time, 150);
+  EXPECT_FALSE(profile.getEntry("manual"));
+
+  auto hot = profile.getHotKernels(0.9);
+  EXPECT_EQ(hot.size(), 2);
+  EXPECT_TRUE(hot.count("conv"));
+  EXPECT_TRUE(hot.count("fc"));
+  EXPECT_FALSE(hot.count("relu"));
+
+  llvm::SmallString<64> path;
+  auto tempFileRes =
+      llvm::sys::fs::createTemporaryFile("kernel_profile", "yaml", path);
+  ASSERT_FALSE(tempFileRes);
+  profile.serialize(path);
+  auto loaded = KernelProfile::deserialize(path);
+  llvm::sys::fs::remove(path);
+  ASSERT_EQ(loaded.getEntries().size(), 3);
+  for (const auto &entry : profile.getEntries()) {
+    const auto *loadedEntry = loaded.getEntry(entry.name);
+    ASSERT_TRUE(loadedEntry);
+    EXPECT_EQ(loadedEntry->kind, entry.kind);
+    EXPECT_EQ(loadedEntry->count, entry.count);
+    EXPECT_EQ(loadedEntry->time, entry.time);
+  }
+}
+
 INSTANTIATE_BACKEND_TEST(TraceEventsTest);
@@ -187,7 +187,10 @@ public:
 
   /// Adds a list of inplace operands. The instruction may use the memory
   /// read by any of the operands in \p lst[1 .. n] for writing the result of
-  /// the operand \p lst[0].
+  /// the operand \p lst[0]. The kernel must read each element of the source
+  /// before writing the element at the same position of the destination, as
+  /// the optimizer may share buffers of operands whose types only differ in
+  /// their shapes or quantization parameters.
   InstrBuilder &inplaceOperand(llvm::ArrayRef<llvm::StringRef> lst) {
     assert(lst.size() > 1 && "Not enough operands");
     inplaceOperands_.emplace_back(lst.begin(), lst.end());
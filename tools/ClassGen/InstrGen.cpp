@@ -215,6 +215,23 @@ int main(int argc, char **argv) {
       .autoVerify(VerifyKind::SameElementType,
                   {"Dest", "Src", "ElemKind::Int8QTy"});
 
+  BB.newInstr("BlockSparseFullyConnected")
+      .addOperand("Dest", OperandKind::Out)
+      .addOperand("Src", OperandKind::In)
+      .addOperand("Values", OperandKind::In)
+      .addOperand("ColIndices", OperandKind::In)
+      .addOperand("RowOffsets", OperandKind::In)
+      .addOperand("Bias", OperandKind::In)
+      .addMember(MemberType::Unsigned, "BlockRows")
+      .addMember(MemberType::Unsigned, "BlockCols")
+      .autoIRGen()
+      .autoVerify(VerifyKind::SameElementType,
+                  {"Dest", "Src", "Values", "Bias"})
+      .autoVerify(VerifyKind::SameElementType,
+                  {"ColIndices", "ElemKind::Int32ITy"})
+      .autoVerify(VerifyKind::SameElementType,
+                  {"RowOffsets", "ElemKind::Int32ITy"});
+
   //===--------------------------------------------------------------------===//
   //                     Normalization
   //===--------------------------------------------------------------------===//
@@ -285,6 +302,17 @@ int main(int argc, char **argv) {
       .autoIRGen()
       .autoVerify(VerifyKind::SameElementType, {"Dest", "LHS", "RHS"});
 
+  BB.newInstr("ScaledDotProductAttention")
+      .addOperand("Dest", OperandKind::Out)
+      .addOperand("Queries", OperandKind::In)
+      .addOperand("Keys", OperandKind::In)
+      .addOperand("Values", OperandKind::In)
+      .addOperand("Mask", OperandKind::In)
+      .addMember(MemberType::Float, "Scale")
+      .autoIRGen()
+      .autoVerify(VerifyKind::SameElementType,
+                  {"Dest", "Queries", "Keys", "Values", "Mask"});
+
   /// Accumulates all of the layers in the batch along the Axis dimension and
   /// produce a tensor that has the same dimensions as the input tensor without
   /// the Axis dimension.
@@ -404,6 +432,21 @@ int main(int argc, char **argv) {
                   {"Lengths", "ElemKind::Int32ITy"})
       .autoVerify(VerifyKind::SameShape, {"Weights", "Indices"});
 
+  BB.newInstr("GroupedFusedRowwiseQuantizedSparseLengthsWeightedSum")
+      .addOperand("Dest", OperandKind::Out)
+      .addOperand("Data", OperandKind::In)
+      .addOperand("Weights", OperandKind::In)
+      .addOperand("Indices", OperandKind::In)
+      .addOperand("Lengths", OperandKind::In)
+      .addOperand("TableOffsets", OperandKind::In)
+      .addMember(MemberType::Boolean, "UseFP16Accumulation")
+      .autoIRGen()
+      .autoVerify(VerifyKind::SameElementType,
+                  {"Lengths", "ElemKind::Int32ITy"})
+      .autoVerify(VerifyKind::SameElementType,
+                  {"TableOffsets", "ElemKind::Int64ITy"})
+      .autoVerify(VerifyKind::SameShape, {"Weights", "Indices"});
+
   BB.newInstr("EmbeddingBagByteRowwiseOffsets")
       .addOperand("Dest", OperandKind::Out)
       .addOperand("Data", OperandKind::In)
@@ -944,6 +987,7 @@ int main(int argc, char **argv) {
       .addOperand("Dest", OperandKind::Out)
       .addOperand("Src", OperandKind::In)
       .addOperand("Mapping", OperandKind::In)
+      .inplaceOperand({"Dest", "Src"})
       .autoVerify(VerifyKind::SameElementType, {"Dest", "Src"})
       .autoVerify(VerifyKind::TypeCheck, {"Dest", "isQuantizedType()"})
       .dataParallel()
@@ -969,6 +1013,7 @@ int main(int argc, char **argv) {
   BB.newInstr("RescaleQuantized")
       .addOperand("Dest", OperandKind::Out)
       .addOperand("Src", OperandKind::In)
+      .inplaceOperand({"Dest", "Src"})
       .autoVerify(VerifyKind::SameElementType, {"Dest", "Src"})
       .autoVerify(VerifyKind::TypeCheck, {"Dest", "isQuantizedType()"})
       .autoVerify(VerifyKind::SameShape, {"Dest", "Src"})
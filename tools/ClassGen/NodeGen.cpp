@@ -226,6 +226,25 @@ int main(int argc, char **argv) {
           "Bias and Result are regularly quantized, while Weights use row-wise"
           "quantization.");
 
+  BB.newNode("BlockSparseFullyConnected")
+      .addInput("Input")
+      .addInput("Values")
+      .addInput("ColIndices")
+      .addInput("RowOffsets")
+      .addInput("Bias")
+      .addMember(MemberType::Unsigned, "BlockRows")
+      .addMember(MemberType::Unsigned, "BlockCols")
+      .addResultFromCtorArg()
+      .setDocstring(
+          "Creates a FullyConnected node whose Weights of shape [K, N] are "
+          "stored in block-CSR format, with blocks of BlockRows x BlockCols. "
+          "Values holds the non-zero blocks of shape [BlockRows, BlockCols] "
+          "one block row after the other, ColIndices the index of the block "
+          "column of each of them, and RowOffsets the index in Values of "
+          "the first block of each of the K / BlockRows block rows, followed "
+          "by the number of blocks. The Input matrix is multiplied by the "
+          "Weights and the Bias vector is broadcast-added to the result.");
+
   //===--------------------------------------------------------------------===//
   //                     Normalization
   //===--------------------------------------------------------------------===//
@@ -575,6 +594,23 @@ int main(int argc, char **argv) {
                     "RHS. The operands are a stack of two dimensional "
                     "matrices. Example: (N, A, Z) x (N, Z, B) => (N, A, B)");
 
+  BB.newNode("ScaledDotProductAttention")
+      .addInput("Queries")
+      .addInput("Keys")
+      .addInput("Values")
+      .addInput("Mask")
+      .addMember(MemberType::Float, "Scale")
+      .addResultFromCtorArg()
+      .setDocstring("Computes the scaled dot-product attention "
+                    "SoftMax(Queries x Keys^T * Scale + Mask) x Values for a "
+                    "batch of heads. Queries is (B, Lq, D), Keys is "
+                    "(B, Lk, D), Values is (B, Lk, Dv) and the result is "
+                    "(B, Lq, Dv). Mask is added to the scores and has shape "
+                    "(B, Lq, Lk) or (B, 1, Lk), in which case it is broadcast "
+                    "over the queries. Like the SoftMax, the rows of the "
+                    "result whose keys are all masked out by -infinity are "
+                    "NaN.");
+
   BB.newNode("BatchedReduceAdd")
       .addInput("Batch")
       .addMember(MemberType::Unsigned, "Axis")
@@ -742,6 +778,27 @@ int main(int argc, char **argv) {
                     "Offsets are appended to the end of each row. Thus, Data "
                     "must be a two-dimensional tensor.");
 
+  BB.newNode("GroupedFusedRowwiseQuantizedSparseLengthsWeightedSum")
+      .addInput("Data")
+      .addInput("Weights")
+      .addInput("Indices")
+      .addInput("Lengths")
+      .addInput("TableOffsets")
+      .addMember(MemberType::Boolean, "UseFP16Accumulation",
+                 /* addSetter */ true)
+      .addResultFromCtorArg()
+      .setDocstring("Performs several FusedRowwiseQuantizedSparseLengths"
+                    "WeightedSum over different tables at once. Data holds "
+                    "the rows of all the tables one after the other, and "
+                    "TableOffsets the index of the first row of each table "
+                    "in Data. Weights, Indices and Lengths are the "
+                    "concatenated inputs of each table, where every table "
+                    "has the same number of segments, i.e. the first "
+                    "len(Lengths) / len(TableOffsets) segments belong to the "
+                    "first table, etc. Indices are relative to the first row "
+                    "of their table, and Result holds the results of the "
+                    "tables one after the other.");
+
   BB.newNode("FusedRowwiseQuantizedSparseLengthsSum")
       .addInput("Data")
       .addInput("Indices")
@@ -18,6 +18,7 @@
 
 #include "glow/Base/Tensor.h"
 #include "glow/Converter/TypeAToTypeBFunctionConverter.h"
+#include "glow/ExecutionContext/KernelProfile.h"
 #include "glow/IR/IR.h"
 #include "glow/Importer/Caffe2ModelLoader.h"
 #include "glow/Importer/ONNXModelLoader.h"
@@ -100,6 +101,15 @@ llvm::cl::opt<std::string> dumpProfileFileOpt(
     llvm::cl::value_desc("profile.yaml"), llvm::cl::Optional,
     llvm::cl::cat(loaderCat));
 
+llvm::cl::opt<std::string> dumpKernelProfileFileOpt(
+    "dump-kernel-profile",
+    llvm::cl::desc("Run the model with auto-instrumentation on zero-filled "
+                   "inputs and dump the kernel profile to the file. The "
+                   "profile can be used to guide the LLVM backends code "
+                   "generation via -llvm-kernel-profile."),
+    llvm::cl::value_desc("kernel-profile.yaml"), llvm::cl::Optional,
+    llvm::cl::cat(loaderCat));
+
 llvm::cl::opt<quantization::Schema> quantizationSchema(
     "quantization-schema",
     llvm::cl::desc("Specify which quantization schema to use"),
@@ -316,6 +326,8 @@ bool glow::emittingBundle() { return !emitBundle.empty(); }
 
 bool glow::profilingGraph() { return !dumpProfileFileOpt.empty(); }
 
+bool glow::dumpingKernelProfile() { return !dumpKernelProfileFileOpt.empty(); }
+
 /// Parse the 'modelInputsOpt' option and get the model input names and types.
 /// The expected format is one of the following:
 /// - <name> (default type is 'float', default shape is '[1]')
@@ -740,6 +752,35 @@ void Loader::generateAndSerializeProfilingInfos(PlaceholderBindings &bindings) {
   serializeProfilingInfosToYaml(dumpProfileFileOpt, PI);
 }
 
+void Loader::generateAndSerializeKernelProfile() {
+  assert(dumpingKernelProfile() &&
+         "Filename to dump the kernel profile to must not be empty.");
+  // Compile the model for the execution backend with auto-instrumentation, so
+  // that every instruction gets timed.
+  CompilationContext cctx = getCompilationContext();
+  cctx.backendOpts.autoInstrument = true;
+  auto module = M_.get();
+  auto error = hostManager_->addNetwork(std::move(M_), cctx);
+  EXIT_ON_ERR(std::move(error));
+  F_ = module->getFunctions().front();
+
+  KernelProfile profile;
+  unsigned iterations = iterationsOpt == 0 ? 1 : iterationsOpt;
+  for (unsigned i = 0; i < iterations; i++) {
+    auto context = glow::make_unique<ExecutionContext>();
+    context->setTraceContext(
+        glow::make_unique<TraceContext>(TraceLevel::OPERATOR));
+    // Zero-filled inputs keep indices of e.g. gathers in range.
+    for (auto *PH : module->getPlaceholders()) {
+      context->getPlaceholderBindings()->allocate(PH)->zero();
+    }
+    auto runErr = hostManager_->runNetworkBlocking(functionName_, context);
+    EXIT_ON_ERR(std::move(runErr));
+    profile.addTraceEvents(context->getTraceContext()->getTraceEvents());
+  }
+  profile.serialize(dumpKernelProfileFileOpt);
+}
+
 Loader &Loader::registerExtension(std::unique_ptr<LoaderExtension> extension) {
   loaderExtensionList_.push_back(std::move(extension));
   return *this;
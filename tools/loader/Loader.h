@@ -51,6 +51,9 @@ bool emittingBundle();
 /// \return true if profiling the graph.
 bool profilingGraph();
 
+/// \return true if dumping a kernel profile for profile-guided code generation.
+bool dumpingKernelProfile();
+
 /// Parse/verify command line parameters.
 void parseCommandLine(int argc, char **argv);
 
@@ -197,6 +200,13 @@ public:
   /// include quantization profile guided information.
   void generateAndSerializeProfilingInfos(PlaceholderBindings &bindings);
 
+  /// Compiles the Function F_ with auto-instrumentation, runs it on
+  /// zero-filled inputs and serializes the resulting kernel profile (see
+  /// KernelProfile). The number of runs is given by -iterations. As the
+  /// compilation is destructive, the Loader cannot be used to compile the
+  /// model again afterwards.
+  void generateAndSerializeKernelProfile();
+
   /// Create the Loader driver object. If \p configDeviceIDs is empty then \ref
   /// numDevices DeviceConfigs are created for each device, otherwise
   /// configDeviceIDs is used to create DeviceConfigs with specified IDs.
@@ -31,6 +31,14 @@ int main(int argc, char **argv) {
   CHECK(emittingBundle())
       << "Bundle output directory not provided. Use the -emit-bundle option!";
 
+  // Collect a kernel profile first if requested. The model is loaded by a
+  // separate Loader since the profiling compilation is destructive.
+  if (dumpingKernelProfile()) {
+    Loader profilingLoader;
+    profilingLoader.loadModel();
+    profilingLoader.generateAndSerializeKernelProfile();
+  }
+
   // Load the model.
   loader.loadModel();
 